@@ -0,0 +1,167 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include "util/util_path.h"
+
+#include "app/cycles_binary.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct BinaryFileHeader {
+	char magic[8];
+	uint version;
+	uint num_arrays;
+};
+
+static const char binary_file_magic[8] = {'C', 'Y', 'C', 'L', 'E', 'S', 'B', 'N'};
+
+BinaryFile::BinaryFile()
+  : data(NULL),
+    size(0),
+    arrays(NULL),
+    num_arrays(0),
+    mapped_data(NULL)
+{
+}
+
+BinaryFile::~BinaryFile()
+{
+	close();
+}
+
+bool BinaryFile::open(const string& filepath)
+{
+	close();
+
+#ifndef _WIN32
+	int fd = ::open(filepath.c_str(), O_RDONLY);
+	if(fd != -1) {
+		struct stat st;
+		if(fstat(fd, &st) == 0 && st.st_size > 0) {
+			void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mem != MAP_FAILED) {
+				mapped_data = mem;
+				data = (const uint8_t*)mem;
+				size = st.st_size;
+			}
+		}
+		::close(fd);
+	}
+#endif
+
+	if(data == NULL) {
+		if(!path_read_binary(filepath, buffer)) {
+			fprintf(stderr, "%s read error.\n", filepath.c_str());
+			return false;
+		}
+		data = &buffer[0];
+		size = buffer.size();
+	}
+
+	/* Validate header and array table, so lookups don't have to. */
+	const BinaryFileHeader *header = (const BinaryFileHeader*)data;
+	if(size < sizeof(BinaryFileHeader) ||
+	   memcmp(header->magic, binary_file_magic, sizeof(binary_file_magic)) != 0)
+	{
+		fprintf(stderr, "%s is not a Cycles binary file.\n", filepath.c_str());
+		close();
+		return false;
+	}
+
+	if(header->version != BINARY_FILE_VERSION) {
+		fprintf(stderr, "%s has unsupported version %u.\n",
+		        filepath.c_str(), header->version);
+		close();
+		return false;
+	}
+
+	num_arrays = header->num_arrays;
+	arrays = (const Array*)(data + sizeof(BinaryFileHeader));
+
+	if((size - sizeof(BinaryFileHeader)) / sizeof(Array) < num_arrays) {
+		fprintf(stderr, "%s is truncated.\n", filepath.c_str());
+		close();
+		return false;
+	}
+
+	for(uint i = 0; i < num_arrays; i++) {
+		const Array& array = arrays[i];
+		if(array.offset % 16 != 0 ||
+		   array.offset > size ||
+		   array.count > (size - array.offset) / 4 ||
+		   memchr(array.name, 0, sizeof(array.name)) == NULL)
+		{
+			fprintf(stderr, "%s has invalid array %u.\n", filepath.c_str(), i);
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void BinaryFile::close()
+{
+#ifndef _WIN32
+	if(mapped_data) {
+		munmap(mapped_data, size);
+	}
+#endif
+	mapped_data = NULL;
+	buffer.free_memory();
+	data = NULL;
+	size = 0;
+	arrays = NULL;
+	num_arrays = 0;
+}
+
+const void *BinaryFile::find_array(const char *name,
+                                   BinaryArrayType type,
+                                   size_t *count) const
+{
+	for(uint i = 0; i < num_arrays; i++) {
+		const Array& array = arrays[i];
+		if(strcmp(array.name, name) == 0 && array.type == type) {
+			*count = array.count;
+			return data + array.offset;
+		}
+	}
+
+	*count = 0;
+	return NULL;
+}
+
+const int *BinaryFile::int_array(const char *name, size_t *count) const
+{
+	return (const int*)find_array(name, BINARY_ARRAY_INT, count);
+}
+
+const float *BinaryFile::float_array(const char *name, size_t *count) const
+{
+	return (const float*)find_array(name, BINARY_ARRAY_FLOAT, count);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CYCLES_BINARY_H__
+#define __CYCLES_BINARY_H__
+
+#include "util/util_string.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Binary container for large arrays of scene data, referenced from XML files
+ * with the src attribute of mesh nodes, so that big meshes don't have to be
+ * parsed from text.
+ *
+ * File layout, all values little endian:
+ *
+ *   char     magic[8]        "CYCLESBN"
+ *   uint32   version         BINARY_FILE_VERSION
+ *   uint32   num_arrays
+ *   then num_arrays entries of:
+ *     char   name[16]        zero terminated, e.g. "P", "verts", "nverts", "UV"
+ *     uint32 type            BINARY_ARRAY_INT or BINARY_ARRAY_FLOAT
+ *     uint32 pad
+ *     uint64 count           number of 32 bit elements
+ *     uint64 offset          from the start of the file, 16 byte aligned
+ *
+ * Array data is stored as is, so the file can be mapped into memory and
+ * used without any parsing. */
+
+#define BINARY_FILE_VERSION 1
+
+typedef enum BinaryArrayType {
+	BINARY_ARRAY_INT = 0,
+	BINARY_ARRAY_FLOAT = 1,
+} BinaryArrayType;
+
+class BinaryFile {
+public:
+	BinaryFile();
+	~BinaryFile();
+
+	bool open(const string& filepath);
+	void close();
+
+	/* Find array by name, returns NULL if it does not exist or has a
+	 * different type. */
+	const int *int_array(const char *name, size_t *count) const;
+	const float *float_array(const char *name, size_t *count) const;
+
+protected:
+	struct Array {
+		char name[16];
+		uint type;
+		uint pad;
+		uint64_t count;
+		uint64_t offset;
+	};
+
+	const void *find_array(const char *name,
+	                       BinaryArrayType type,
+	                       size_t *count) const;
+
+	const uint8_t *data;
+	size_t size;
+	const Array *arrays;
+	uint num_arrays;
+
+	/* Mapped file, or file contents when mapping is not available. */
+	void *mapped_data;
+	vector<uint8_t> buffer;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __CYCLES_BINARY_H__ */
@@ -38,6 +38,7 @@ int main(int argc, const char **argv)
 	string devicename = "cpu";
 	bool list = false, debug = false;
 	int threads = 0, verbosity = 1;
+	int port = 5120, cache_size = 1024;
 
 	vector<DeviceType>& types = Device::available_types();
 
@@ -55,6 +56,8 @@ int main(int argc, const char **argv)
 		"--device %s", &devicename, ("Devices to use: " + devicelist).c_str(),
 		"--list-devices", &list, "List information about all available devices",
 		"--threads %d", &threads, "Number of threads to use for CPU device",
+		"--port %d", &port, "Port to listen on, use different ports to run multiple servers on one machine",
+		"--cache-size %d", &cache_size, "Megabytes of scene data to keep for following renders",
 #ifdef WITH_CYCLES_LOGGING
 		"--debug", &debug, "Enable debug logging",
 		"--verbose %d", &verbosity, "Set verbosity of the logger",
@@ -102,9 +105,10 @@ int main(int argc, const char **argv)
 
 	while(1) {
 		Stats stats;
-		Device *device = Device::create(device_info, stats, true);
+		Profiler profiler;
+		Device *device = Device::create(device_info, stats, profiler, true);
 		printf("Cycles Server with device: %s\n", device->info.description.c_str());
-		device->server_run();
+		device->server_run(port, (size_t)cache_size * 1024 * 1024);
 		delete device;
 	}
 
@@ -18,9 +18,12 @@
 
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/denoising.h"
 #include "device/device.h"
+#include "render/film.h"
 #include "render/scene.h"
 #include "render/session.h"
+#include "render/stats.h"
 #include "render/integrator.h"
 
 #include "util/util_args.h"
@@ -47,12 +50,18 @@ struct Options {
 	Session *session;
 	Scene *scene;
 	string filepath;
+	vector<string> filepaths;
 	int width, height;
 	SceneParams scene_params;
 	SessionParams session_params;
 	bool quiet;
 	bool show_help, interactive, pause;
 	string output_path;
+	bool output_tiles;
+	unique_ptr<ImageOutput> tile_output;
+	bool denoise;
+	int denoise_frame_radius;
+	bool print_stats;
 } options;
 
 static void session_print(const string& str)
@@ -126,6 +135,117 @@ static BufferParams& session_buffer_params()
 	return buffer_params;
 }
 
+/* Tile Output
+ *
+ * With --output-tiles, finished tiles are written to a tiled multilayer EXR
+ * and freed right away, so only tiles in progress are kept in memory. Cycles
+ * tiles are aligned to the bottom of the image and EXR tiles to the top, so
+ * the data window is padded at the top to a multiple of the tile height. */
+
+static string tile_output_pass_name(const Pass& pass)
+{
+	if(pass.name != "")
+		return pass.name;
+	else if(pass.type == PASS_COMBINED)
+		return "Combined";
+
+	return string_printf("Pass%d", (int)pass.type);
+}
+
+static bool tile_output_open()
+{
+	BufferParams& buffer_params = session_buffer_params();
+	int2 tile_size = options.session_params.tile_size;
+	int padded_height = align_up(options.height, tile_size.y);
+
+	vector<string> channels;
+	foreach(const Pass& pass, buffer_params.passes) {
+		string name = tile_output_pass_name(pass);
+
+		if(pass.components == 1) {
+			channels.push_back(name + ".V");
+			continue;
+		}
+
+		for(int c = 0; c < pass.components; c++) {
+			channels.push_back(name + "." + "RGBA"[c]);
+		}
+	}
+
+	options.tile_output.reset(ImageOutput::create(options.output_path));
+	if(!options.tile_output || !options.tile_output->supports("tiles")) {
+		fprintf(stderr, "Can't write tiled image %s\n", options.output_path.c_str());
+		options.tile_output.reset();
+		return false;
+	}
+
+	ImageSpec spec(options.width, padded_height, channels.size(), TypeDesc::FLOAT);
+	spec.y = options.height - padded_height;
+	spec.full_x = 0;
+	spec.full_y = 0;
+	spec.full_width = options.width;
+	spec.full_height = options.height;
+	spec.tile_width = tile_size.x;
+	spec.tile_height = tile_size.y;
+	spec.channelnames = channels;
+	/* Write tiles in the order they finish, instead of buffering them. */
+	spec.attribute("openexr:lineOrder", "randomY");
+
+	if(!options.tile_output->open(options.output_path, spec)) {
+		fprintf(stderr, "Can't open %s for writing\n", options.output_path.c_str());
+		options.tile_output.reset();
+		return false;
+	}
+
+	return true;
+}
+
+static void write_render_tile(RenderTile& rtile)
+{
+	RenderBuffers *buffers = rtile.buffers;
+
+	if(!options.tile_output || !buffers->copy_from_device())
+		return;
+
+	BufferParams& params = buffers->params;
+	int w = params.width;
+	int h = params.height;
+	int tile_h = options.session_params.tile_size.y;
+	int num_channels = options.tile_output->spec().nchannels;
+	float exposure = options.scene->film->exposure;
+
+	vector<float> pass_pixels(w*h*4);
+	vector<float> pixels(w*tile_h*num_channels, 0.0f);
+	int channel = 0;
+
+	foreach(Pass& pass, params.passes) {
+		int components = pass.components;
+
+		if(buffers->get_pass_rect(pass.type, exposure, rtile.sample, components, &pass_pixels[0], pass.name)) {
+			/* flip rows, image rows go from top to bottom */
+			for(int y = 0; y < h; y++) {
+				const float *in = &pass_pixels[y*w*components];
+				float *out = &pixels[(tile_h - 1 - y)*w*num_channels + channel];
+
+				for(int x = 0; x < w; x++, in += components, out += num_channels) {
+					for(int c = 0; c < components; c++) {
+						out[c] = in[c];
+					}
+				}
+			}
+		}
+
+		channel += components;
+	}
+
+	int x = rtile.x;
+	int y = options.height - rtile.y - tile_h;
+
+	if(!options.tile_output->write_tiles(x, x + w, y, y + tile_h, 0, 1, TypeDesc::FLOAT, &pixels[0])) {
+		fprintf(stderr, "Failed to write tile to %s\n", options.output_path.c_str());
+	}
+}
+
 static void scene_init()
 {
 	options.scene = new Scene(options.scene_params, options.session->device);
@@ -149,7 +269,8 @@ static void scene_init()
 
 static void session_init()
 {
-	options.session_params.write_render_cb = write_render;
+	if(!options.output_tiles)
+		options.session_params.write_render_cb = write_render;
 	options.session = new Session(options.session_params);
 
 	if(options.session_params.background && !options.quiet)
@@ -163,6 +284,13 @@ static void session_init()
 	scene_init();
 	options.session->scene = options.scene;
 
+	if(options.output_tiles) {
+		if(!tile_output_open())
+			exit(EXIT_FAILURE);
+
+		options.session->write_render_tile_cb = function_bind(&write_render_tile, _1);
+	}
+
 	options.session->reset(session_buffer_params(), options.session_params.samples);
 	options.session->start();
 }
@@ -170,10 +298,21 @@ static void session_init()
 static void session_exit()
 {
 	if(options.session) {
+		if(options.print_stats) {
+			RenderStats stats;
+			options.session->collect_statistics(&stats);
+			printf("\nRender statistics:\n%s\n", stats.full_report().c_str());
+		}
+
 		delete options.session;
 		options.session = NULL;
 	}
 
+	if(options.tile_output) {
+		options.tile_output->close();
+		options.tile_output.reset();
+	}
+
 	if(options.session_params.background && !options.quiet) {
 		session_print("Finished Rendering.");
 		printf("\n");
@@ -344,9 +483,12 @@ static void keyboard(unsigned char key)
 
 static int files_parse(int argc, const char *argv[])
 {
-	if(argc > 0)
+	if(argc > 0 && options.filepath == "")
 		options.filepath = argv[0];
 
+	for(int i = 0; i < argc; i++)
+		options.filepaths.push_back(argv[i]);
+
 	return 0;
 }
 
@@ -357,6 +499,10 @@ static void options_parse(int argc, const char **argv)
 	options.filepath = "";
 	options.session = NULL;
 	options.quiet = false;
+	options.output_tiles = false;
+	options.denoise = false;
+	options.denoise_frame_radius = 2;
+	options.print_stats = false;
 
 	/* device names */
 	string device_names = "";
@@ -385,7 +531,8 @@ static void options_parse(int argc, const char **argv)
 	bool help = false, debug = false, version = false;
 	int verbosity = 1;
 
-	ap.options ("Usage: cycles [options] file.xml",
+	ap.options ("Usage: cycles [options] file.xml\n"
+	            "       cycles --denoise [options] frame.exr ...",
 		"%*", files_parse, "",
 		"--device %s", &devicename, ("Devices to use: " + device_names).c_str(),
 #ifdef WITH_OSL
@@ -393,9 +540,13 @@ static void options_parse(int argc, const char **argv)
 #endif
 		"--background", &options.session_params.background, "Render in background, without user interface",
 		"--quiet", &options.quiet, "In background mode, don't print progress messages",
+		"--stats", &options.print_stats, "Print render statistics after rendering, including BVH build statistics",
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
 		"--output %s", &options.output_path, "File path to write output image",
+		"--output-tiles", &options.output_tiles, "Write tiles to the output image as they finish, as tiled multilayer EXR with all passes, instead of keeping the full image in memory (background only)",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--denoise", &options.denoise, "Denoise the given sequence of multilayer EXR frames, which need to contain the denoising data passes, instead of rendering",
+		"--denoise-frames %d", &options.denoise_frame_radius, "Number of frames before and after each frame to use for temporal denoising",
 		"--width  %d", &options.width, "Window width in pixel",
 		"--height %d", &options.height, "Window height in pixel",
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
@@ -451,8 +602,8 @@ static void options_parse(int argc, const char **argv)
 	options.session_params.background = true;
 #endif
 
-	/* Use progressive rendering */
-	options.session_params.progressive = true;
+	/* Use progressive rendering, unless tiles are written as they finish */
+	options.session_params.progressive = !options.output_tiles;
 
 	/* find matching device */
 	DeviceType device_type = Device::type_from_string(devicename.c_str());
@@ -467,6 +618,22 @@ static void options_parse(int argc, const char **argv)
 		}
 	}
 
+	/* render on all listed network servers, tiles are handed out to
+	 * whichever server asks for the next one */
+	if(device_type == DEVICE_NETWORK) {
+		vector<DeviceInfo> network_devices;
+		foreach(DeviceInfo& device, devices) {
+			if(device.type == DEVICE_NETWORK) {
+				network_devices.push_back(device);
+			}
+		}
+		if(network_devices.size() > 1) {
+			options.session_params.device = Device::get_multi_device(network_devices,
+			                                                         options.session_params.threads,
+			                                                         options.session_params.background);
+		}
+	}
+
 	/* handle invalid configurations */
 	if(options.session_params.device.type == DEVICE_NONE || !device_available) {
 		fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
@@ -490,11 +657,56 @@ static void options_parse(int argc, const char **argv)
 		fprintf(stderr, "No file path specified\n");
 		exit(EXIT_FAILURE);
 	}
+	else if(options.output_tiles && (options.output_path == "" || !options.session_params.background)) {
+		fprintf(stderr, "Tile output needs --output and --background\n");
+		exit(EXIT_FAILURE);
+	}
+	else if(options.denoise && options.output_path != "" && options.filepaths.size() > 1) {
+		fprintf(stderr, "Denoising multiple frames can't write to a single --output\n");
+		exit(EXIT_FAILURE);
+	}
+	else if(options.denoise && options.denoise_frame_radius < 0) {
+		fprintf(stderr, "Invalid number of denoising frames: %d\n", options.denoise_frame_radius);
+		exit(EXIT_FAILURE);
+	}
 
 	/* For smoother Viewport */
 	options.session_params.start_resolution = 64;
 }
 
+static void denoise_frames()
+{
+	Denoiser denoiser(options.session_params.device);
+
+	foreach(const string& filepath, options.filepaths) {
+		denoiser.input.push_back(filepath);
+
+		if(options.output_path != "") {
+			denoiser.output.push_back(options.output_path);
+		}
+		else {
+			string filename = path_filename(filepath);
+			filename = filename.substr(0, filename.rfind('.'));
+			denoiser.output.push_back(path_join(path_dirname(filepath), filename + "_denoised.exr"));
+		}
+	}
+
+	denoiser.frame_radius = options.denoise_frame_radius;
+	if(options.session_params.samples != INT_MAX) {
+		denoiser.samples = options.session_params.samples;
+	}
+	denoiser.tile_size = options.session_params.tile_size.x;
+
+	if(!options.quiet) {
+		printf("Denoising %d frames\n", (int)options.filepaths.size());
+	}
+
+	if(!denoiser.run()) {
+		fprintf(stderr, "%s\n", denoiser.error.c_str());
+		exit(EXIT_FAILURE);
+	}
+}
+
 CCL_NAMESPACE_END
 
 using namespace ccl;
@@ -505,6 +717,11 @@ int main(int argc, const char **argv)
 	path_init();
 	options_parse(argc, argv);
 
+	if(options.denoise) {
+		denoise_frames();
+		return 0;
+	}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 	if(options.session_params.background) {
 #endif
@@ -44,6 +44,7 @@
 #include "util/util_transform.h"
 #include "util/util_xml.h"
 
+#include "app/cycles_binary.h"
 #include "app/cycles_xml.h"
 
 CCL_NAMESPACE_BEGIN
@@ -385,6 +386,66 @@ static Mesh *xml_add_mesh(Scene *scene, const Transform& tfm)
 	return mesh;
 }
 
+static bool xml_read_mesh_binary(const string& filepath,
+                                 vector<float3>& P,
+                                 vector<float>& UV,
+                                 vector<int>& verts,
+                                 vector<int>& nverts)
+{
+	BinaryFile file;
+
+	if(!file.open(filepath)) {
+		return false;
+	}
+
+	size_t num_P, num_UV, num_verts, num_nverts;
+	const float *P_data = file.float_array("P", &num_P);
+	const float *UV_data = file.float_array("UV", &num_UV);
+	const int *verts_data = file.int_array("verts", &num_verts);
+	const int *nverts_data = file.int_array("nverts", &num_nverts);
+
+	if(!P_data || !verts_data || !nverts_data || num_P % 3 != 0) {
+		fprintf(stderr, "%s does not contain a valid mesh.\n", filepath.c_str());
+		return false;
+	}
+
+	P.resize(num_P / 3);
+	for(size_t i = 0; i < P.size(); i++) {
+		P[i] = make_float3(P_data[i*3], P_data[i*3+1], P_data[i*3+2]);
+	}
+
+	verts.assign(verts_data, verts_data + num_verts);
+	nverts.assign(nverts_data, nverts_data + num_nverts);
+	if(UV_data) {
+		UV.assign(UV_data, UV_data + num_UV);
+	}
+
+	/* unlike XML these files are usually generated by other tools, so
+	 * check indices instead of only asserting */
+	size_t num_corners = 0;
+	for(size_t i = 0; i < nverts.size(); i++) {
+		if(nverts[i] < 3) {
+			fprintf(stderr, "%s has polygon with less than 3 vertices.\n", filepath.c_str());
+			return false;
+		}
+		num_corners += nverts[i];
+	}
+
+	if(num_corners != verts.size() || (UV_data && UV.size() < num_corners*2)) {
+		fprintf(stderr, "%s has wrong number of polygon corners.\n", filepath.c_str());
+		return false;
+	}
+
+	for(size_t i = 0; i < verts.size(); i++) {
+		if(verts[i] < 0 || verts[i] >= (int)P.size()) {
+			fprintf(stderr, "%s has invalid vertex index.\n", filepath.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static void xml_read_mesh(const XMLReadState& state, xml_node node)
 {
 	/* add mesh */
@@ -400,9 +461,22 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 	vector<float> UV;
 	vector<int> verts, nverts;
 
-	xml_read_float3_array(P, node, "P");
-	xml_read_int_array(verts, node, "verts");
-	xml_read_int_array(nverts, node, "nverts");
+	bool have_UV;
+	string src;
+
+	if(xml_read_string(&src, node, "src")) {
+		/* arrays are stored in a binary file */
+		if(!xml_read_mesh_binary(path_join(state.base, src), P, UV, verts, nverts)) {
+			return;
+		}
+		have_UV = !UV.empty();
+	}
+	else {
+		xml_read_float3_array(P, node, "P");
+		xml_read_int_array(verts, node, "verts");
+		xml_read_int_array(nverts, node, "nverts");
+		have_UV = xml_read_float_array(UV, node, "UV");
+	}
 
 	if(xml_equal_string(node, "subdivision", "catmull-clark")) {
 		mesh->subdivision_type = Mesh::SUBDIVISION_CATMULL_CLARK;
@@ -439,7 +513,7 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 			index_offset += nverts[i];
 		}
 
-		if(xml_read_float_array(UV, node, "UV")) {
+		if(have_UV) {
 			ustring name = ustring("UVMap");
 			Attribute *attr = mesh->attributes.add(ATTR_STD_UV, name);
 			float3 *fdata = attr->data_float3();
@@ -487,7 +561,7 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 		}
 
 		/* uv map */
-		if(xml_read_float_array(UV, node, "UV")) {
+		if(have_UV) {
 			ustring name = ustring("UVMap");
 			Attribute *attr = mesh->subd_attributes.add(ATTR_STD_UV, name);
 			float3 *fdata = attr->data_float3();
@@ -17,12 +17,13 @@
 # XML exporter for generating test files, not intended for end users
 
 import os
+import struct
 import xml.etree.ElementTree as etree
 import xml.dom.minidom as dom
 
 import bpy
 from bpy_extras.io_utils import ExportHelper
-from bpy.props import PointerProperty, StringProperty
+from bpy.props import BoolProperty, PointerProperty, StringProperty
 
 def strip(root):
     root.text = None
@@ -40,6 +41,27 @@ def write(node, fname):
     f = open(fname, "w")
     f.write(s)
 
+def write_binary(arrays, fname):
+    # Layout must match BinaryFile in cycles_binary.h: header, array table
+    # and 16 byte aligned array data.
+    def align(offset):
+        return (offset + 15) & ~15
+
+    offset = align(16 + 40 * len(arrays))
+    table = b""
+    data = b""
+    for name, fmt, values in arrays:
+        table += struct.pack("<16sIIQQ", name.encode(), 0 if fmt == "i" else 1, 0,
+                             len(values), offset + len(data))
+        data += struct.pack("<%d%s" % (len(values), fmt), *values)
+        data += b"\0" * (align(len(data)) - len(data))
+
+    header = struct.pack("<8sII", b"CYCLESBN", 1, len(arrays))
+    padding = b"\0" * (offset - len(header) - len(table))
+
+    f = open(fname, "wb")
+    f.write(header + table + padding + data)
+
 class CyclesXMLSettings(bpy.types.PropertyGroup):
     @classmethod
     def register(cls):
@@ -89,6 +111,12 @@ class ExportCyclesXML(bpy.types.Operator, ExportHelper):
 
     filename_ext = ".xml"
 
+    use_binary = BoolProperty(
+            name="Binary Mesh",
+            description="Write mesh arrays to a binary file next to the .xml file, which is much faster to load",
+            default=False,
+            )
+
     @classmethod
     def poll(cls, context):
         return (context.active_object is not None)
@@ -109,31 +137,42 @@ class ExportCyclesXML(bpy.types.Operator, ExportHelper):
             raise Exception("No mesh data in active object")
 
         # generate mesh node
-        nverts = ""
-        verts = ""
-        uvs = ""
-        P = ""
+        nverts = []
+        verts = []
+        uvs = []
+        P = []
 
         for v in mesh.vertices:
-            P += "%f %f %f  " % (v.co[0], v.co[1], v.co[2])
+            P += [v.co[0], v.co[1], v.co[2]]
 
         verts_and_uvs = zip(mesh.tessfaces, mesh.tessface_uv_textures.active.data)
 
         for f, uvf in verts_and_uvs:
             vcount = len(f.vertices)
-            nverts += str(vcount) + " "
+            nverts.append(vcount)
 
             for v in f.vertices:
-                verts += str(v) + " "
+                verts.append(v)
 
-            uvs += str(uvf.uv1[0]) + " " + str(uvf.uv1[1]) + " "
-            uvs += str(uvf.uv2[0]) + " " + str(uvf.uv2[1]) + " "
-            uvs += str(uvf.uv3[0]) + " " + str(uvf.uv3[1]) + " "
+            uvs += [uvf.uv1[0], uvf.uv1[1]]
+            uvs += [uvf.uv2[0], uvf.uv2[1]]
+            uvs += [uvf.uv3[0], uvf.uv3[1]]
             if vcount==4:
-                uvs += " " + str(uvf.uv4[0]) + " " + str(uvf.uv4[1]) + " "
-
-
-        node = etree.Element('mesh', attrib={'nverts': nverts.strip(), 'verts': verts.strip(), 'P': P, 'UV' : uvs.strip()})
+                uvs += [uvf.uv4[0], uvf.uv4[1]]
+
+        if self.use_binary:
+            binary_filepath = os.path.splitext(filepath)[0] + ".bin"
+            write_binary([("P", "f", P),
+                          ("verts", "i", verts),
+                          ("nverts", "i", nverts),
+                          ("UV", "f", uvs)], binary_filepath)
+
+            node = etree.Element('mesh', attrib={'src': os.path.basename(binary_filepath)})
+        else:
+            node = etree.Element('mesh', attrib={'nverts': " ".join(str(n) for n in nverts),
+                                                 'verts': " ".join(str(v) for v in verts),
+                                                 'P': " ".join("%f" % p for p in P),
+                                                 'UV' : " ".join(str(uv) for uv in uvs)})
 
         # write to file
         write(node, filepath)
@@ -246,6 +246,9 @@ def register_passes(engine, scene, srl):
 
     crl = srl.cycles
     if crl.pass_debug_render_time:             engine.register_pass(scene, srl, "Debug Render Time",             1, "X",   'VALUE')
+    if crl.pass_debug_render_cost:             engine.register_pass(scene, srl, "Debug Render Cost",             3, "XYZ", 'VECTOR')
+    if crl.pass_debug_sample_count and scene.cycles.use_adaptive_sampling:
+        engine.register_pass(scene, srl, "Debug Sample Count", 1, "X", 'VALUE')
     if crl.pass_debug_bvh_traversed_nodes:     engine.register_pass(scene, srl, "Debug BVH Traversed Nodes",     1, "X",   'VALUE')
     if crl.pass_debug_bvh_traversed_instances: engine.register_pass(scene, srl, "Debug BVH Traversed Instances", 1, "X",   'VALUE')
     if crl.pass_debug_bvh_intersections:       engine.register_pass(scene, srl, "Debug BVH Intersections",       1, "X",   'VALUE')
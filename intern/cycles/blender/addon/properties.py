@@ -303,6 +303,34 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             min=0.0, max=1.0,
             default=0.01,
         )
+        cls.use_light_tree = BoolProperty(
+            name="Light Tree",
+            description="Pick lights based on their distance and orientation to the shading point, "
+            "reduces noise in scenes with many lights (CPU only, not used when sampling all lights)",
+            default=False,
+        )
+
+        cls.use_adaptive_sampling = BoolProperty(
+            name="Adaptive Sampling",
+            description="Automatically stop sampling pixels that have converged, "
+            "only used for final renders without progressive refine",
+            default=False,
+        )
+        cls.adaptive_threshold = FloatProperty(
+            name="Adaptive Threshold",
+            description="Noise level at which a pixel stops being sampled, "
+            "zero for automatic setting based on the number of samples",
+            min=0.0, max=1.0,
+            default=0.0,
+            precision=4,
+        )
+        cls.adaptive_min_samples = IntProperty(
+            name="Adaptive Min Samples",
+            description="Minimum number of samples before a pixel can be stopped, "
+            "zero for automatic setting based on the number of samples",
+            min=0, max=4096,
+            default=0,
+        )
 
         cls.caustics_reflective = BoolProperty(
             name="Reflective Caustics",
@@ -401,6 +429,14 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             default=12,
         )
 
+        cls.use_dicing_cache = BoolProperty(
+            name="Dicing Cache",
+            description="Keep diced geometry of adaptively subdivided meshes, and reuse it for faces that "
+            "are diced the same in the next update. Edge tessellation is rounded up slightly so small "
+            "camera changes don't change it, at the cost of more memory",
+            default=False,
+        )
+
         cls.dicing_camera = PointerProperty(
             name="Dicing Camera",
             description="Camera to use as reference point when subdividing geometry, useful to avoid crawling "
@@ -558,6 +594,35 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             default=0,
             min=0, max=16,
         )
+        cls.use_bvh_compression = BoolProperty(
+            name="Compress BVH",
+            description="Store BVH bounds at reduced precision, to fit larger scenes in memory "
+            "at the cost of slightly slower rendering (CPU only)",
+            default=False,
+        )
+        cls.use_packed_normals = BoolProperty(
+            name="Pack Normals",
+            description="Store smooth vertex normals at reduced precision, to fit larger scenes in memory",
+            default=False,
+        )
+        cls.use_bvh_cache = BoolProperty(
+            name="Cache BVH",
+            description="Reuse the BVH of meshes with unchanged geometry between frames, "
+            "speeds up scene updates of animations with static meshes at the cost of memory",
+            default=False,
+        )
+        cls.use_bvh_disk_cache = BoolProperty(
+            name="Store on Disk",
+            description="Also store cached BVHs in the user cache directory, to reuse them in later sessions",
+            default=False,
+        )
+        cls.bvh_disk_cache_size = IntProperty(
+            name="Disk Cache Size",
+            description="Maximum size of the BVH cache files on disk, in megabytes. "
+            "Least recently used files are removed first",
+            min=64, max=1048576,
+            default=4096,
+        )
         cls.tile_order = EnumProperty(
             name="Tile Order",
             description="Tile order for rendering",
@@ -663,6 +728,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             items=enum_texture_limit
         )
 
+        cls.use_texture_cache = BoolProperty(
+            name="Texture Cache",
+            description="Load image textures on demand while rendering, instead of fully loading them beforehand "
+                        "(CPU only, only for image files)",
+            default=False,
+        )
+        cls.texture_cache_size = IntProperty(
+            name="Cache Size",
+            description="Maximum amount of memory used by the texture cache, in megabytes",
+            min=64, max=1048576,
+            default=4096,
+        )
+
         cls.ao_bounces = IntProperty(
             name="AO Bounces",
             default=0,
@@ -1256,6 +1334,19 @@ class CyclesRenderLayerSettings(bpy.types.PropertyGroup):
             default=False,
             update=update_render_passes,
         )
+        cls.pass_debug_render_cost = BoolProperty(
+            name="Debug Render Cost",
+            description="Per pixel and sample cost of rendering on the CPU: thousands of CPU cycles, "
+                        "ray bounces and shader evaluations",
+            default=False,
+            update=update_render_passes,
+        )
+        cls.pass_debug_sample_count = BoolProperty(
+            name="Debug Sample Count",
+            description="Number of samples taken per pixel with adaptive sampling",
+            default=False,
+            update=update_render_passes,
+        )
         cls.use_pass_volume_direct = BoolProperty(
             name="Volume Direct",
             description="Deliver direct volumetric scattering pass",
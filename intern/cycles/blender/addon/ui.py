@@ -174,6 +174,7 @@ class CYCLES_RENDER_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
         sub.prop(cscene, "light_sampling_threshold")
+        sub.prop(cscene, "use_light_tree")
 
         if cscene.progressive == 'PATH' or use_branched_path(context) is False:
             col = split.column()
@@ -207,6 +208,13 @@ class CYCLES_RENDER_PT_sampling(CyclesButtonsPanel, Panel):
 
         layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
+        row = layout.row(align=True)
+        row.prop(cscene, "use_adaptive_sampling", text="Adaptive")
+        sub = row.row(align=True)
+        sub.active = cscene.use_adaptive_sampling
+        sub.prop(cscene, "adaptive_threshold", text="Threshold")
+        sub.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         for rl in scene.render.layers:
             if rl.samples > 0:
                 layout.separator()
@@ -247,6 +255,7 @@ class CYCLES_RENDER_PT_geometry(CyclesButtonsPanel, Panel):
             col = split.column()
             col.prop(cscene, "offscreen_dicing_scale", text="Offscreen Scale")
             col.prop(cscene, "max_subdivisions")
+            col.prop(cscene, "use_dicing_cache")
 
             layout.prop(cscene, "dicing_camera")
 
@@ -427,6 +436,12 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
         col.label(text="Final Render:")
         col.prop(rd, "use_save_buffers")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
+        row = col.row()
+        row.active = use_cpu(context)
+        row.prop(cscene, "use_texture_cache")
+        sub = col.row()
+        sub.active = use_cpu(context) and cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size")
 
         col.separator()
 
@@ -445,6 +460,21 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
         row.active = not cscene.debug_use_spatial_splits and not cscene.use_bvh_embree
         row.prop(cscene, "debug_bvh_time_steps")
 
+        row = col.row()
+        row.active = use_cpu(context) and (not cscene.use_bvh_embree or not _cycles.with_embree)
+        row.prop(cscene, "use_bvh_compression")
+        col.prop(cscene, "use_packed_normals")
+
+        row = col.row()
+        row.active = not cscene.use_bvh_embree or not _cycles.with_embree
+        row.prop(cscene, "use_bvh_cache")
+        sub = row.row()
+        sub.active = cscene.use_bvh_cache
+        sub.prop(cscene, "use_bvh_disk_cache")
+        row = col.row()
+        row.active = cscene.use_bvh_cache and cscene.use_bvh_disk_cache
+        row.prop(cscene, "bvh_disk_cache_size")
+
         col = layout.column()
         col.label(text="Viewport Resolution:")
         split = col.split()
@@ -559,6 +589,10 @@ class CYCLES_RENDER_PT_layer_passes(CyclesButtonsPanel, Panel):
 
         col = layout.column()
         col.prop(crl, "pass_debug_render_time")
+        col.prop(crl, "pass_debug_render_cost")
+        sub = col.column()
+        sub.active = scene.cycles.use_adaptive_sampling
+        sub.prop(crl, "pass_debug_sample_count")
         if _cycles.with_cycles_debug:
             col.prop(crl, "pass_debug_bvh_traversed_nodes")
             col.prop(crl, "pass_debug_bvh_traversed_instances")
@@ -986,7 +986,8 @@ static void create_subd_mesh(Scene *scene,
                              BL::Mesh& b_mesh,
                              const vector<Shader*>& used_shaders,
                              float dicing_rate,
-                             int max_subdivisions)
+                             int max_subdivisions,
+                             bool use_dicing_cache)
 {
 	BL::SubsurfModifier subsurf_mod(b_ob.modifiers[b_ob.modifiers.length()-1]);
 	bool subdivide_uvs = subsurf_mod.use_subsurf_uv();
@@ -1026,6 +1027,7 @@ static void create_subd_mesh(Scene *scene,
 
 	sdparams.dicing_rate = max(0.1f, RNA_float_get(&cobj, "dicing_rate") * dicing_rate);
 	sdparams.max_level = max_subdivisions;
+	sdparams.use_dicing_cache = use_dicing_cache;
 
 	scene->dicing_camera->update(scene);
 	sdparams.camera = scene->dicing_camera;
@@ -1198,7 +1200,8 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 			if(render_layer.use_surfaces && !hide_tris) {
 				if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
 					create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders,
-					                 dicing_rate, max_subdivisions);
+					                 dicing_rate, max_subdivisions,
+					                 use_dicing_cache);
 				else
 					create_mesh(scene, mesh, b_mesh, used_shaders, false);
 
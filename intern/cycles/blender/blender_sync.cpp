@@ -65,11 +65,13 @@ BlenderSync::BlenderSync(BL::RenderEngine& b_engine,
   experimental(false),
   dicing_rate(1.0f),
   max_subdivisions(12),
+  use_dicing_cache(false),
   progress(progress)
 {
 	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
 	dicing_rate = preview ? RNA_float_get(&cscene, "preview_dicing_rate") : RNA_float_get(&cscene, "dicing_rate");
 	max_subdivisions = RNA_int_get(&cscene, "max_subdivisions");
+	use_dicing_cache = get_boolean(cscene, "use_dicing_cache");
 }
 
 BlenderSync::~BlenderSync()
@@ -122,6 +124,13 @@ bool BlenderSync::sync_recalc()
 			max_subdivisions = updated_max_subdivisions;
 			dicing_prop_changed = true;
 		}
+
+		bool updated_use_dicing_cache = get_boolean(cscene, "use_dicing_cache");
+
+		if(use_dicing_cache != updated_use_dicing_cache) {
+			use_dicing_cache = updated_use_dicing_cache;
+			dicing_prop_changed = true;
+		}
 	}
 
 	BL::BlendData::objects_iterator b_ob;
@@ -286,6 +295,10 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
 
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
@@ -519,6 +532,8 @@ PassType BlenderSync::get_pass_type(BL::RenderPass& b_pass)
 	MAP_PASS("Debug Ray Bounces", PASS_RAY_BOUNCES);
 #endif
 	MAP_PASS("Debug Render Time", PASS_RENDER_TIME);
+	MAP_PASS("Debug Sample Count", PASS_SAMPLE_COUNT);
+	MAP_PASS("Debug Render Cost", PASS_RENDER_COST);
 	if(string_startswith(name, cryptomatte_prefix)) {
 		return PASS_CRYPTOMATTE;
 	}
@@ -633,6 +648,17 @@ vector<Pass> BlenderSync::sync_render_passes(BL::RenderLayer& b_rlay,
 		b_engine.add_pass("Debug Render Time", 1, "X", b_srlay.name().c_str());
 		Pass::add(PASS_RENDER_TIME, passes);
 	}
+	if(get_boolean(crp, "pass_debug_render_cost")) {
+		b_engine.add_pass("Debug Render Cost", 3, "XYZ", b_srlay.name().c_str());
+		Pass::add(PASS_RENDER_COST, passes);
+	}
+	if(session_params.adaptive_sampling) {
+		Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+		if(get_boolean(crp, "pass_debug_sample_count")) {
+			b_engine.add_pass("Debug Sample Count", 1, "X", b_srlay.name().c_str());
+		}
+		Pass::add(PASS_SAMPLE_COUNT, passes);
+	}
 	if(get_boolean(crp, "use_pass_volume_direct")) {
 		b_engine.add_pass("VolumeDir", 3, "RGB", b_srlay.name().c_str());
 		Pass::add(PASS_VOLUME_DIRECT, passes);
@@ -701,6 +727,11 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
 	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
 	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
+	params.use_bvh_compressed_nodes = RNA_boolean_get(&cscene, "use_bvh_compression");
+	params.use_packed_normals = RNA_boolean_get(&cscene, "use_packed_normals");
+	params.use_bvh_cache = RNA_boolean_get(&cscene, "use_bvh_cache");
+	params.use_bvh_disk_cache = RNA_boolean_get(&cscene, "use_bvh_disk_cache");
+	params.bvh_disk_cache_size = RNA_int_get(&cscene, "bvh_disk_cache_size");
 
 	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
 		params.persistent_data = r.use_persistent_data();
@@ -721,6 +752,9 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	params.use_texture_cache = get_boolean(cscene, "use_texture_cache");
+	params.texture_cache_size = get_int(cscene, "texture_cache_size");
+
 	/* TODO(sergey): Once OSL supports per-microarchitecture optimization get
 	 * rid of this.
 	 */
@@ -921,6 +955,12 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine& b_engine,
 		}
 	}
 
+	/* Adaptive sampling stops pixels within a tile, which only works when
+	 * tiles are rendered to completion one at a time. */
+	params.adaptive_sampling = get_boolean(cscene, "use_adaptive_sampling") &&
+	                           background &&
+	                           !params.progressive_refine;
+
 	if(background) {
 		if(params.progressive_refine)
 			params.progressive = true;
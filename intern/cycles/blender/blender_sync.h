@@ -179,6 +179,7 @@ private:
 
 	float dicing_rate;
 	int max_subdivisions;
+	bool use_dicing_cache;
 
 	struct RenderLayerInfo {
 		RenderLayerInfo()
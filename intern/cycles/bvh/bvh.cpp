@@ -73,6 +73,61 @@ BVHLayout BVHParams::best_bvh_layout(BVHLayout requested_layout,
 	return (BVHLayout)(1 << widest_allowed_layout_mask);
 }
 
+/* BVH Statistics. */
+
+BVHBuildStats::BVHBuildStats()
+: build_time(0.0),
+  sah_cost(0.0f),
+  num_inner_nodes(0),
+  num_leaf_nodes(0),
+  num_unaligned_nodes(0),
+  num_primitives(0),
+  num_references(0),
+  num_object_splits(0),
+  num_spatial_splits(0),
+  num_unaligned_splits(0),
+  packed_size(0)
+{
+}
+
+void BVHBuildStats::add_subtree(const BVHNode *node, int depth)
+{
+	if((size_t)depth >= depth_nodes.size()) {
+		depth_nodes.resize(depth + 1, 0);
+		depth_leaves.resize(depth + 1, 0);
+		depth_size.resize(depth + 1, 0);
+	}
+
+	depth_nodes[depth]++;
+	if(node->is_unaligned) {
+		num_unaligned_nodes++;
+	}
+
+	if(node->is_leaf()) {
+		size_t num_leaf_primitives = node->num_triangles();
+		if(num_leaf_primitives >= leaf_primitives.size()) {
+			leaf_primitives.resize(num_leaf_primitives + 1, 0);
+		}
+		leaf_primitives[num_leaf_primitives]++;
+
+		num_references += num_leaf_primitives;
+		num_leaf_nodes++;
+		depth_leaves[depth]++;
+		depth_size[depth] += BVH_NODE_LEAF_SIZE*sizeof(int4);
+		return;
+	}
+
+	/* Same as BVH2 packing, nodes with unaligned children store their transforms. */
+	bool unaligned = node->get_child(0)->is_unaligned || node->get_child(1)->is_unaligned;
+
+	num_inner_nodes++;
+	depth_size[depth] += (unaligned? BVH_UNALIGNED_NODE_SIZE: BVH_NODE_SIZE)*sizeof(int4);
+
+	for(int i = 0; i < node->num_children(); i++) {
+		add_subtree(node->get_child(i), depth + 1);
+	}
+}
+
 /* Pack Utility */
 
 BVHStackEntry::BVHStackEntry(const BVHNode *n, int i)
@@ -88,7 +143,7 @@ int BVHStackEntry::encodeIdx() const
 /* BVH */
 
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
-: params(params_), objects(objects_)
+: params(params_), objects(objects_), num_top_level_prims(0)
 {
 }
 
@@ -134,6 +189,8 @@ void BVH::build(Progress& progress, Stats*)
 		return;
 	}
 
+	build_stats = bvh_build.stats;
+
 	/* pack triangles */
 	progress.set_substatus("Packing BVH triangles and strands");
 	pack_primitives();
@@ -147,6 +204,8 @@ void BVH::build(Progress& progress, Stats*)
 	progress.set_substatus("Packing BVH nodes");
 	pack_nodes(root);
 
+	build_stats.packed_size = (pack.nodes.size() + pack.leaf_nodes.size())*sizeof(int4);
+
 	/* free build nodes */
 	root->deleteSubtree();
 }
@@ -156,7 +215,12 @@ void BVH::build(Progress& progress, Stats*)
 void BVH::refit(Progress& progress)
 {
 	progress.set_substatus("Packing BVH primitives");
-	pack_primitives();
+	if(params.top_level) {
+		refit_top_level_primitives();
+	}
+	else {
+		pack_primitives();
+	}
 
 	if(progress.get_cancel()) return;
 
@@ -328,6 +392,41 @@ void BVH::pack_primitives()
 	}
 }
 
+/* Update the triangle vertices and visibility of the top level primitives
+ * in place. Unlike pack_primitives() this keeps the instance primitives that
+ * were merged in, they are in object space and don't change. The primitive
+ * indices were already offset into the global arrays by pack_instances(). */
+void BVH::refit_top_level_primitives()
+{
+	assert(params.top_level);
+
+	for(size_t i = 0; i < num_top_level_prims; i++) {
+		const int pidx = pack.prim_index[i];
+
+		if(pidx == -1) {
+			continue;
+		}
+
+		Object *ob = objects[pack.prim_object[i]];
+		const Mesh *mesh = ob->mesh;
+
+		if(pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) {
+			Mesh::Triangle t = mesh->get_triangle(pidx - mesh->tri_offset);
+			const float3 *vpos = &mesh->verts[0];
+			float4 *tri_verts = &pack.prim_tri_verts[pack.prim_tri_index[i]];
+
+			tri_verts[0] = float3_to_float4(vpos[t.v[0]]);
+			tri_verts[1] = float3_to_float4(vpos[t.v[1]]);
+			tri_verts[2] = float3_to_float4(vpos[t.v[2]]);
+		}
+
+		pack.prim_visibility[i] = ob->visibility_for_tracing();
+		if(pack.prim_type[i] & PRIMITIVE_ALL_CURVE) {
+			pack.prim_visibility[i] |= PATH_RAY_CURVE;
+		}
+	}
+}
+
 /* Pack Instances */
 
 void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
@@ -352,6 +451,7 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 
 	/* track offsets of instanced BVH data in global array */
 	size_t prim_offset = pack.prim_index.size();
+	num_top_level_prims = prim_offset;
 	size_t nodes_offset = nodes_size;
 	size_t nodes_leaf_offset = leaf_nodes_size;
 
@@ -525,6 +625,12 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 						nsize_bbox = (use_qbvh) ? BVH_UNALIGNED_QNODE_SIZE-1 : 0;
 					}
 				}
+				else if((use_qbvh || use_obvh) &&
+				        (bvh_nodes[i].x & PATH_RAY_NODE_COMPRESSED))
+				{
+					nsize = (use_obvh)? BVH_COMPRESSED_ONODE_SIZE: BVH_COMPRESSED_QNODE_SIZE;
+					nsize_bbox = nsize-1;
+				}
 				else {
 					if(use_obvh) {
 						nsize = BVH_ONODE_SIZE;
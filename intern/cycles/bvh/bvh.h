@@ -73,6 +73,43 @@ struct PackedBVH {
 	}
 };
 
+/* Statistics of a BVH build, to compare the quality of BVHs built with
+ * different settings. Gathered from the binary tree, before packing. */
+
+struct BVHBuildStats {
+	/* Build time in seconds. */
+	double build_time;
+	/* SAH cost of the tree, with the root node hit probability being one. */
+	float sah_cost;
+
+	size_t num_inner_nodes;
+	size_t num_leaf_nodes;
+	size_t num_unaligned_nodes;
+	/* Spatial splits reference primitives multiple times. */
+	size_t num_primitives;
+	size_t num_references;
+
+	/* Kind of split used for every inner node. */
+	size_t num_object_splits;
+	size_t num_spatial_splits;
+	size_t num_unaligned_splits;
+
+	/* Node count and memory at every depth of the tree, for the binary
+	 * BVH2 layout since wider layouts collapse levels. */
+	vector<size_t> depth_nodes;
+	vector<size_t> depth_leaves;
+	vector<size_t> depth_size;
+	/* Number of leaves by primitive count. */
+	vector<size_t> leaf_primitives;
+
+	/* Memory of the packed nodes in the actual layout. */
+	size_t packed_size;
+
+	BVHBuildStats();
+
+	void add_subtree(const BVHNode *node, int depth = 0);
+};
+
 enum BVH_TYPE {
 	bvh2,
 	bvh4,
@@ -87,6 +124,11 @@ public:
 	PackedBVH pack;
 	BVHParams params;
 	vector<Object*> objects;
+	BVHBuildStats build_stats;
+
+	/* Number of primitives of the top level BVH itself, the primitives of
+	 * the instance BVHs merged by pack_instances() follow them. */
+	size_t num_top_level_prims;
 
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
@@ -105,6 +147,7 @@ protected:
 	/* triangles and strands */
 	void pack_primitives();
 	void pack_triangle(int idx, float4 storage[3]);
+	void refit_top_level_primitives();
 
 	/* merge instance BVH's */
 	void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
@@ -86,8 +86,8 @@ void BVH2::pack_aligned_node(int idx,
 	assert(c1 < 0 || c1 < pack.nodes.size());
 
 	int4 data[BVH_NODE_SIZE] = {
-		make_int4(visibility0 & ~PATH_RAY_NODE_UNALIGNED,
-		          visibility1 & ~PATH_RAY_NODE_UNALIGNED,
+		make_int4(visibility0 & ~(PATH_RAY_NODE_UNALIGNED | PATH_RAY_NODE_COMPRESSED),
+		          visibility1 & ~(PATH_RAY_NODE_UNALIGNED | PATH_RAY_NODE_COMPRESSED),
 		          c0, c1),
 		make_int4(__float_as_int(b0.min.x),
 		          __float_as_int(b1.min.x),
@@ -136,8 +136,10 @@ void BVH2::pack_unaligned_node(int idx,
 	                                                        aligned_space0);
 	Transform space1 = BVHUnaligned::compute_node_transform(bounds1,
 	                                                        aligned_space1);
-	data[0] = make_float4(__int_as_float(visibility0 | PATH_RAY_NODE_UNALIGNED),
-	                      __int_as_float(visibility1 | PATH_RAY_NODE_UNALIGNED),
+	data[0] = make_float4(__int_as_float((visibility0 & ~PATH_RAY_NODE_COMPRESSED) |
+	                                     PATH_RAY_NODE_UNALIGNED),
+	                      __int_as_float((visibility1 & ~PATH_RAY_NODE_COMPRESSED) |
+	                                     PATH_RAY_NODE_UNALIGNED),
 	                      __int_as_float(c0),
 	                      __int_as_float(c1));
 
@@ -230,8 +232,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -246,7 +246,14 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		const int c0 = data[0].x;
 		const int c1 = data[0].y;
 
-		BVH::refit_primitives(c0, c1, bbox, visibility);
+		/* Object leaves of the top level BVH store the inverted index of
+		 * their only primitive. */
+		if(c0 < 0) {
+			BVH::refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+		}
+		else {
+			BVH::refit_primitives(c0, c1, bbox, visibility);
+		}
 
 		/* TODO(sergey): De-duplicate with pack_leaf(). */
 		float4 leaf_data[BVH_NODE_LEAF_SIZE];
@@ -20,6 +20,7 @@
 #include "render/mesh.h"
 #include "render/object.h"
 
+#include "bvh/bvh_compressed.h"
 #include "bvh/bvh_node.h"
 #include "bvh/bvh_unaligned.h"
 
@@ -114,10 +115,22 @@ void BVH4::pack_aligned_node(int idx,
                              const float time_to,
                              const int num)
 {
+	if(params.use_compressed_nodes) {
+		pack_compressed_node(idx,
+		                     bounds,
+		                     child,
+		                     visibility,
+		                     time_from,
+		                     time_to,
+		                     num);
+		return;
+	}
+
 	float4 data[BVH_QNODE_SIZE];
 	memset(data, 0, sizeof(data));
 
-	data[0].x = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+	data[0].x = __uint_as_float(visibility & ~(PATH_RAY_NODE_UNALIGNED |
+	                                            PATH_RAY_NODE_COMPRESSED));
 	data[0].y = time_from;
 	data[0].z = time_to;
 
@@ -154,6 +167,39 @@ void BVH4::pack_aligned_node(int idx,
 	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_QNODE_SIZE);
 }
 
+void BVH4::pack_compressed_node(int idx,
+                                const BoundBox *bounds,
+                                const int *child,
+                                const uint visibility,
+                                const float time_from,
+                                const float time_to,
+                                const int num)
+{
+	float4 data[BVH_COMPRESSED_QNODE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	data[0].x = __uint_as_float((visibility & ~PATH_RAY_NODE_UNALIGNED) |
+	                            PATH_RAY_NODE_COMPRESSED);
+	data[0].y = time_from;
+	data[0].z = time_to;
+
+	BVHCompressedBounds cbounds(bounds, num);
+	float *words = &data[1].x;
+
+	for(int axis = 0; axis < 3; axis++) {
+		words[axis] = cbounds.origin[axis];
+		words[3 + axis] = cbounds.scale[axis];
+		words[6 + axis*2 + 0] = __uint_as_float(cbounds.pack(axis, 0, 0));
+		words[6 + axis*2 + 1] = __uint_as_float(cbounds.pack(axis, 1, 0));
+	}
+
+	for(int i = 0; i < 4; i++) {
+		data[4][i] = __int_as_float((i < num)? child[i]: 0);
+	}
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_COMPRESSED_QNODE_SIZE);
+}
+
 void BVH4::pack_unaligned_inner(const BVHStackEntry& e,
                                 const BVHStackEntry *en,
                                 int num)
@@ -188,7 +234,8 @@ void BVH4::pack_unaligned_node(int idx,
 	float4 data[BVH_UNALIGNED_QNODE_SIZE];
 	memset(data, 0, sizeof(data));
 
-	data[0].x = __uint_as_float(visibility | PATH_RAY_NODE_UNALIGNED);
+	data[0].x = __uint_as_float((visibility & ~PATH_RAY_NODE_COMPRESSED) |
+	                            PATH_RAY_NODE_UNALIGNED);
 	data[0].y = time_from;
 	data[0].z = time_to;
 
@@ -257,10 +304,10 @@ void BVH4::pack_nodes(const BVHNode *root)
 		const size_t num_unaligned_nodes =
 		        root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_QNODE_COUNT);
 		node_size = (num_unaligned_nodes * BVH_UNALIGNED_QNODE_SIZE) +
-		            (num_inner_nodes - num_unaligned_nodes) * BVH_QNODE_SIZE;
+		            (num_inner_nodes - num_unaligned_nodes) * aligned_node_size();
 	}
 	else {
-		node_size = num_inner_nodes * BVH_QNODE_SIZE;
+		node_size = num_inner_nodes * aligned_node_size();
 	}
 	/* Resize arrays. */
 	pack.nodes.clear();
@@ -285,7 +332,7 @@ void BVH4::pack_nodes(const BVHNode *root)
 		stack.push_back(BVHStackEntry(root, nextNodeIdx));
 		nextNodeIdx += node_is_unaligned(root, bvh4)
 		                       ? BVH_UNALIGNED_QNODE_SIZE
-		                       : BVH_QNODE_SIZE;
+		                       : aligned_node_size();
 	}
 
 	while(stack.size()) {
@@ -329,7 +376,7 @@ void BVH4::pack_nodes(const BVHNode *root)
 					idx = nextNodeIdx;
 					nextNodeIdx += node_is_unaligned(nodes[i], bvh4)
 					                       ? BVH_UNALIGNED_QNODE_SIZE
-					                       : BVH_QNODE_SIZE;
+					                       : aligned_node_size();
 				}
 				stack.push_back(BVHStackEntry(nodes[i], idx));
 			}
@@ -342,10 +389,13 @@ void BVH4::pack_nodes(const BVHNode *root)
 	pack.root_index = (root->is_leaf())? -1: 0;
 }
 
-void BVH4::refit_nodes()
+int BVH4::aligned_node_size() const
 {
-	assert(!params.top_level);
+	return (params.use_compressed_nodes)? BVH_COMPRESSED_QNODE_SIZE: BVH_QNODE_SIZE;
+}
 
+void BVH4::refit_nodes()
+{
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -358,7 +408,14 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		int4 *data = &pack.leaf_nodes[idx];
 		int4 c = data[0];
 
-		BVH::refit_primitives(c.x, c.y, bbox, visibility);
+		/* Object leaves of the top level BVH store the inverted index of
+		 * their only primitive. */
+		if(c.x < 0) {
+			BVH::refit_primitives(~c.x, ~c.x + 1, bbox, visibility);
+		}
+		else {
+			BVH::refit_primitives(c.x, c.y, bbox, visibility);
+		}
 
 		/* TODO(sergey): This is actually a copy of pack_leaf(),
 		 * but this chunk of code only knows actual data and has
@@ -384,6 +441,9 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		if(is_unaligned) {
 			c = data[13];
 		}
+		else if(data[0].x & PATH_RAY_NODE_COMPRESSED) {
+			c = data[4];
+		}
 		else {
 			c = data[7];
 		}
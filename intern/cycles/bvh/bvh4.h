@@ -37,6 +37,7 @@ class Progress;
 #define BVH_QNODE_SIZE           8
 #define BVH_QNODE_LEAF_SIZE      1
 #define BVH_UNALIGNED_QNODE_SIZE 14
+#define BVH_COMPRESSED_QNODE_SIZE 5
 
 /* BVH4
  *
@@ -65,6 +66,14 @@ protected:
 	                       const float time_to,
 	                       const int num);
 
+	void pack_compressed_node(int idx,
+	                          const BoundBox *bounds,
+	                          const int *child,
+	                          const uint visibility,
+	                          const float time_from,
+	                          const float time_to,
+	                          const int num);
+
 	void pack_unaligned_inner(const BVHStackEntry& e,
 	                          const BVHStackEntry *en,
 	                          int num);
@@ -77,6 +86,9 @@ protected:
 	                         const float time_to,
 	                         const int num);
 
+	/* Size of an aligned inner node in the nodes array. */
+	int aligned_node_size() const;
+
 	/* refit */
 	void refit_nodes();
 	void refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility);
@@ -31,6 +31,7 @@
 #include "render/mesh.h"
 #include "render/object.h"
 
+#include "bvh/bvh_compressed.h"
 #include "bvh/bvh_node.h"
 #include "bvh/bvh_unaligned.h"
 
@@ -118,10 +119,22 @@ void BVH8::pack_aligned_node(int idx,
                              const float time_to,
                              const int num)
 {
+	if(params.use_compressed_nodes) {
+		pack_compressed_node(idx,
+		                     bounds,
+		                     child,
+		                     visibility,
+		                     time_from,
+		                     time_to,
+		                     num);
+		return;
+	}
+
 	float8 data[8];
 	memset(data, 0, sizeof(data));
 
-	data[0].a = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+	data[0].a = __uint_as_float(visibility & ~(PATH_RAY_NODE_UNALIGNED |
+	                                            PATH_RAY_NODE_COMPRESSED));
 	data[0].b = time_from;
 	data[0].c = time_to;
 
@@ -158,6 +171,42 @@ void BVH8::pack_aligned_node(int idx,
 	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_ONODE_SIZE);
 }
 
+void BVH8::pack_compressed_node(int idx,
+                                const BoundBox *bounds,
+                                const int *child,
+                                const uint visibility,
+                                const float time_from,
+                                const float time_to,
+                                const int num)
+{
+	float8 data[BVH_COMPRESSED_ONODE_SIZE/2];
+	memset(data, 0, sizeof(data));
+
+	data[0].a = __uint_as_float((visibility & ~PATH_RAY_NODE_UNALIGNED) |
+	                            PATH_RAY_NODE_COMPRESSED);
+	data[0].b = time_from;
+	data[0].c = time_to;
+
+	BVHCompressedBounds cbounds(bounds, num);
+	float *words = &data[0].e;
+
+	for(int axis = 0; axis < 3; axis++) {
+		words[axis] = cbounds.origin[axis];
+		words[3 + axis] = cbounds.scale[axis];
+		for(int side = 0; side < 2; side++) {
+			const int k = axis*2 + side;
+			words[6 + k*2 + 0] = __uint_as_float(cbounds.pack(axis, side, 0));
+			words[6 + k*2 + 1] = __uint_as_float(cbounds.pack(axis, side, 4));
+		}
+	}
+
+	for(int i = 0; i < 8; i++) {
+		data[3][i] = __int_as_float((i < num)? child[i]: 0);
+	}
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_COMPRESSED_ONODE_SIZE);
+}
+
 void BVH8::pack_unaligned_inner(const BVHStackEntry& e,
                                 const BVHStackEntry *en,
                                 int num)
@@ -192,7 +241,8 @@ void BVH8::pack_unaligned_node(int idx,
 	float8 data[BVH_UNALIGNED_ONODE_SIZE];
 	memset(data, 0, sizeof(data));
 
-	data[0].a = __uint_as_float(visibility | PATH_RAY_NODE_UNALIGNED);
+	data[0].a = __uint_as_float((visibility & ~PATH_RAY_NODE_COMPRESSED) |
+	                            PATH_RAY_NODE_UNALIGNED);
 	data[0].b = time_from;
 	data[0].c = time_to;
 
@@ -261,10 +311,10 @@ void BVH8::pack_nodes(const BVHNode *root)
 		const size_t num_unaligned_nodes =
 		        root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_ONODE_COUNT);
 		node_size = (num_unaligned_nodes * BVH_UNALIGNED_ONODE_SIZE) +
-		        (num_inner_nodes - num_unaligned_nodes) * BVH_ONODE_SIZE;
+		        (num_inner_nodes - num_unaligned_nodes) * aligned_node_size();
 	}
 	else {
-		node_size = num_inner_nodes * BVH_ONODE_SIZE;
+		node_size = num_inner_nodes * aligned_node_size();
 	}
 	/* Resize arrays. */
 	pack.nodes.clear();
@@ -289,7 +339,7 @@ void BVH8::pack_nodes(const BVHNode *root)
 		stack.push_back(BVHStackEntry(root, nextNodeIdx));
 		nextNodeIdx += node_is_unaligned(root, bvh8)
 		                   ? BVH_UNALIGNED_ONODE_SIZE
-		                   : BVH_ONODE_SIZE;
+		                   : aligned_node_size();
 	}
 
 	while(stack.size()) {
@@ -361,7 +411,7 @@ void BVH8::pack_nodes(const BVHNode *root)
 					idx = nextNodeIdx;
 					nextNodeIdx += node_is_unaligned(nodes[i], bvh8)
 						? BVH_UNALIGNED_ONODE_SIZE
-						: BVH_ONODE_SIZE;
+						: aligned_node_size();
 				}
 				stack.push_back(BVHStackEntry(nodes[i], idx));
 			}
@@ -374,10 +424,13 @@ void BVH8::pack_nodes(const BVHNode *root)
 	pack.root_index = (root->is_leaf()) ? -1 : 0;
 }
 
-void BVH8::refit_nodes()
+int BVH8::aligned_node_size() const
 {
-	assert(!params.top_level);
+	return (params.use_compressed_nodes)? BVH_COMPRESSED_ONODE_SIZE: BVH_ONODE_SIZE;
+}
 
+void BVH8::refit_nodes()
+{
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -388,8 +441,12 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 	if(leaf) {
 		int4 *data = &pack.leaf_nodes[idx];
 		int4 c = data[0];
+		/* Object leaves of the top level BVH store the inverted index of
+		 * their only primitive. */
+		const int prim_start = (c.x < 0)? ~c.x: c.x;
+		const int prim_end = (c.x < 0)? ~c.x + 1: c.y;
 		/* Refit leaf node. */
-		for(int prim = c.x; prim < c.y; prim++) {
+		for(int prim = prim_start; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
 			Object *ob = objects[tob];
@@ -465,6 +522,7 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 	else {
 		float8 *data = (float8*)&pack.nodes[idx];
 		bool is_unaligned = (__float_as_uint(data[0].a) & PATH_RAY_NODE_UNALIGNED) != 0;
+		bool is_compressed = (__float_as_uint(data[0].a) & PATH_RAY_NODE_COMPRESSED) != 0;
 		/* Refit inner node, set bbox from children. */
 		BoundBox child_bbox[8] = { BoundBox::empty, BoundBox::empty,
 		                           BoundBox::empty, BoundBox::empty,
@@ -475,7 +533,7 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		int num_nodes = 0;
 
 		for(int i = 0; i < 8; ++i) {
-			child[i] = __float_as_int(data[(is_unaligned) ? 13: 7][i]);
+			child[i] = __float_as_int(data[(is_unaligned) ? 13: (is_compressed) ? 3: 7][i]);
 
 			if(child[i] != 0) {
 				refit_node((child[i] < 0)? -child[i]-1: child[i], (child[i] < 0),
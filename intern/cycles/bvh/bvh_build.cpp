@@ -28,6 +28,7 @@
 #include "render/curves.h"
 
 #include "util/util_algorithm.h"
+#include "util/util_atomic.h"
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
@@ -467,6 +468,8 @@ BVHNode* BVHBuild::run()
 	}
 	spatial_free_index = 0;
 
+	stats = BVHBuildStats();
+
 	need_prim_time = params.num_motion_curve_steps > 0 ||
 	                 params.num_motion_triangle_steps > 0;
 
@@ -515,8 +518,14 @@ BVHNode* BVHBuild::run()
 			rootnode->update_time();
 		}
 		if(rootnode != NULL) {
+			stats.build_time = time_dt() - build_start_time;
+			stats.sah_cost = rootnode->computeSubtreeSAHCost(params);
+			stats.num_primitives = progress_original_total;
+			stats.add_subtree(rootnode);
+
 			VLOG(1) << "BVH build statistics:\n"
-			        << "  Build time: " << time_dt() - build_start_time << "\n"
+			        << "  Build time: " << stats.build_time << "\n"
+			        << "  SAH cost: " << stats.sah_cost << "\n"
 			        << "  Total number of nodes: "
 			        << string_human_readable_number(rootnode->getSubtreeSize(BVH_STAT_NODE_COUNT)) << "\n"
 			        << "  Number of inner nodes: "
@@ -525,6 +534,10 @@ BVHNode* BVHBuild::run()
 			        << string_human_readable_number(rootnode->getSubtreeSize(BVH_STAT_LEAF_COUNT)) << "\n"
 			        << "  Number of unaligned nodes: "
 			        << string_human_readable_number(rootnode->getSubtreeSize(BVH_STAT_UNALIGNED_COUNT))  << "\n"
+			        << "  Number of object/spatial/unaligned splits: "
+			        << stats.num_object_splits << "/"
+			        << stats.num_spatial_splits << "/"
+			        << stats.num_unaligned_splits << "\n"
 			        << "  Allocation slop factor: "
 			               << ((prim_type.capacity() != 0)
 			                       ? (float)prim_type.size() / prim_type.capacity()
@@ -682,9 +695,11 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	BVHObjectBinning left, right;
 	if(do_unalinged_split) {
 		unaligned_range.split(&references[0], left, right);
+		atomic_add_and_fetch_z(&stats.num_unaligned_splits, 1);
 	}
 	else {
 		range.split(&references[0], left, right);
+		atomic_add_and_fetch_z(&stats.num_object_splits, 1);
 	}
 
 	BoundBox bounds;
@@ -790,9 +805,13 @@ BVHNode* BVHBuild::build_node(const BVHRange& range,
 	BVHRange left, right;
 	if(do_unalinged_split) {
 		unaligned_split.split(this, left, right, range);
+		atomic_add_and_fetch_z(&stats.num_unaligned_splits, 1);
+	}
+	else if(split.split(this, left, right, range)) {
+		atomic_add_and_fetch_z(&stats.num_spatial_splits, 1);
 	}
 	else {
-		split.split(this, left, right, range);
+		atomic_add_and_fetch_z(&stats.num_object_splits, 1);
 	}
 
 	progress_total += left.size() + right.size() - range.size();
@@ -20,6 +20,7 @@
 
 #include <float.h>
 
+#include "bvh/bvh.h"
 #include "bvh/bvh_params.h"
 #include "bvh/bvh_unaligned.h"
 
@@ -56,6 +57,9 @@ public:
 
 	BVHNode *run();
 
+	/* Statistics of the last build. */
+	BVHBuildStats stats;
+
 protected:
 	friend class BVHMixedSplit;
 	friend class BVHObjectSplit;
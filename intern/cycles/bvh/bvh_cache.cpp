@@ -0,0 +1,417 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh/bvh_cache.h"
+#include "bvh/bvh_params.h"
+
+#include "render/attribute.h"
+#include "render/mesh.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_logging.h"
+#include "util/util_md5.h"
+#include "util/util_path.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Increase when the packed BVH layout changes, to invalidate files on disk. */
+#define BVH_CACHE_VERSION 1
+
+static const char BVH_CACHE_MAGIC[4] = {'C', 'B', 'V', 'H'};
+
+/* Hashing */
+
+static void hash_data(MD5Hash& md5, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	/* MD5Hash takes int sizes, append large arrays in chunks. */
+	while(size > 0) {
+		const size_t chunk = std::min(size, (size_t)(1 << 30));
+		md5.append(bytes, (int)chunk);
+		bytes += chunk;
+		size -= chunk;
+	}
+}
+
+template<typename T>
+static void hash_value(MD5Hash& md5, const T& value)
+{
+	hash_data(md5, &value, sizeof(T));
+}
+
+template<typename T>
+static void hash_array(MD5Hash& md5, const array<T>& data)
+{
+	hash_value(md5, data.size());
+	if(data.size()) {
+		hash_data(md5, &data[0], data.size()*sizeof(T));
+	}
+}
+
+/* Only hash the used components, the padding of float3 is not guaranteed to
+ * be initialized. */
+static void hash_float3(MD5Hash& md5, const float3 *data, size_t size)
+{
+	const size_t chunk_size = 1024;
+	float buffer[chunk_size*3];
+
+	hash_value(md5, size);
+	for(size_t start = 0; start < size; start += chunk_size) {
+		const size_t end = std::min(start + chunk_size, size);
+		float *b = buffer;
+		for(size_t i = start; i < end; i++) {
+			*(b++) = data[i].x;
+			*(b++) = data[i].y;
+			*(b++) = data[i].z;
+		}
+		hash_data(md5, buffer, (b - buffer)*sizeof(float));
+	}
+}
+
+static void hash_motion_attribute(MD5Hash& md5, const AttributeSet& attributes)
+{
+	const Attribute *attr = attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+	if(attr) {
+		hash_float3(md5,
+		            (const float3*)attr->data(),
+		            attr->buffer.size()/sizeof(float3));
+	}
+}
+
+/* Serialization */
+
+template<typename T>
+static void write_array(vector<uint8_t>& binary, const array<T>& data)
+{
+	const uint64_t size = data.size();
+	const size_t offset = binary.size();
+	const size_t data_size = sizeof(T)*size;
+
+	binary.resize(offset + sizeof(size) + data_size);
+	memcpy(&binary[offset], &size, sizeof(size));
+	if(size) {
+		memcpy(&binary[offset + sizeof(size)], &data[0], data_size);
+	}
+}
+
+template<typename T>
+static bool read_array(const vector<uint8_t>& binary, size_t *offset, array<T>& data)
+{
+	uint64_t size;
+	if(*offset + sizeof(size) > binary.size()) {
+		return false;
+	}
+	memcpy(&size, &binary[*offset], sizeof(size));
+	*offset += sizeof(size);
+
+	if(size > (binary.size() - *offset)/sizeof(T)) {
+		return false;
+	}
+
+	data.resize(size);
+	if(size) {
+		memcpy(&data[0], &binary[*offset], sizeof(T)*size);
+	}
+	*offset += sizeof(T)*size;
+
+	return true;
+}
+
+/* Cache */
+
+BVHCache& BVHCache::instance()
+{
+	static BVHCache cache;
+	return cache;
+}
+
+string BVHCache::key(const Mesh *mesh, const BVHParams& params)
+{
+	MD5Hash md5;
+	const int version = BVH_CACHE_VERSION;
+
+	hash_value(md5, version);
+
+	/* Build parameters. */
+	hash_value(md5, params.bvh_layout);
+	hash_value(md5, params.bvh_type);
+	hash_value(md5, params.use_spatial_split);
+	hash_value(md5, params.use_unaligned_nodes);
+	hash_value(md5, params.use_compressed_nodes);
+	hash_value(md5, params.num_motion_triangle_steps);
+	hash_value(md5, params.num_motion_curve_steps);
+	hash_value(md5, params.curve_flags);
+	hash_value(md5, params.curve_subdivisions);
+
+	/* Geometry. */
+	hash_float3(md5, mesh->verts.data(), mesh->verts.size());
+	hash_array(md5, mesh->triangles);
+	hash_float3(md5, mesh->curve_keys.data(), mesh->curve_keys.size());
+	hash_array(md5, mesh->curve_radius);
+	hash_array(md5, mesh->curve_first_key);
+
+	/* Motion. */
+	const bool use_motion_blur = mesh->use_motion_blur;
+	hash_value(md5, use_motion_blur);
+	if(use_motion_blur) {
+		hash_value(md5, mesh->motion_steps);
+		hash_motion_attribute(md5, mesh->attributes);
+		hash_motion_attribute(md5, mesh->curve_attributes);
+	}
+
+	return md5.get_hex();
+}
+
+/* Move all arrays from one pack to the other, without copying. */
+static void pack_move(PackedBVH *to, PackedBVH *from)
+{
+	to->nodes.steal_data(from->nodes);
+	to->leaf_nodes.steal_data(from->leaf_nodes);
+	to->object_node.steal_data(from->object_node);
+	to->prim_tri_index.steal_data(from->prim_tri_index);
+	to->prim_tri_verts.steal_data(from->prim_tri_verts);
+	to->prim_type.steal_data(from->prim_type);
+	to->prim_visibility.steal_data(from->prim_visibility);
+	to->prim_index.steal_data(from->prim_index);
+	to->prim_object.steal_data(from->prim_object);
+	to->prim_time.steal_data(from->prim_time);
+	to->root_index = from->root_index;
+}
+
+bool BVHCache::lookup(const string& key, const void *user, bool use_disk, BVH *bvh)
+{
+	{
+		thread_scoped_lock lock(mutex);
+		map<string, Entry>::iterator it = entries.find(key);
+
+		if(it != entries.end()) {
+			Entry& entry = it->second;
+			entry.used.insert(user);
+
+			if(entry.holder == NULL) {
+				pack_move(&bvh->pack, &entry.pack);
+				entry.holder = bvh;
+				holders[bvh] = key;
+			}
+			else {
+				/* Identical geometry in another mesh which is still alive,
+				 * both need their own pack. */
+				bvh->pack = entry.holder->pack;
+			}
+			return true;
+		}
+	}
+
+	PackedBVH pack;
+	if(use_disk && read_file(key, &pack)) {
+		thread_scoped_lock lock(mutex);
+		Entry& entry = entries[key];
+		entry.used.insert(user);
+		if(entry.holder == NULL) {
+			entry.holder = bvh;
+			holders[bvh] = key;
+		}
+		pack_move(&bvh->pack, &pack);
+		return true;
+	}
+
+	return false;
+}
+
+void BVHCache::insert(const string& key,
+                      const void *user,
+                      bool use_disk,
+                      uint64_t disk_limit,
+                      BVH *bvh)
+{
+	if(use_disk) {
+		write_file(key, bvh->pack, disk_limit);
+	}
+
+	thread_scoped_lock lock(mutex);
+	Entry& entry = entries[key];
+	entry.used.insert(user);
+	if(entry.holder == NULL) {
+		entry.pack = PackedBVH();
+		entry.holder = bvh;
+		holders[bvh] = key;
+	}
+}
+
+void BVHCache::release(BVH *bvh, bool keep)
+{
+	thread_scoped_lock lock(mutex);
+	map<const BVH*, string>::iterator holder_it = holders.find(bvh);
+
+	if(holder_it == holders.end()) {
+		return;
+	}
+
+	map<string, Entry>::iterator it = entries.find(holder_it->second);
+	holders.erase(holder_it);
+
+	if(it == entries.end()) {
+		return;
+	}
+
+	if(keep) {
+		pack_move(&it->second.pack, &bvh->pack);
+		it->second.holder = NULL;
+	}
+	else {
+		entries.erase(it);
+	}
+}
+
+void BVHCache::collect_garbage(const void *user)
+{
+	thread_scoped_lock lock(mutex);
+	size_t num_removed = 0;
+
+	for(map<string, Entry>::iterator it = entries.begin(); it != entries.end(); ) {
+		Entry& entry = it->second;
+
+		if(entry.used.erase(user)) {
+			entry.users.insert(user);
+		}
+		else {
+			entry.users.erase(user);
+		}
+
+		if(entry.users.empty() && entry.used.empty() && entry.holder == NULL) {
+			entries.erase(it++);
+			num_removed++;
+		}
+		else {
+			++it;
+		}
+	}
+
+	VLOG(1) << "BVH cache has " << entries.size() << " entries, removed "
+	        << num_removed << " unused entries.";
+}
+
+void BVHCache::remove_user(const void *user)
+{
+	thread_scoped_lock lock(mutex);
+
+	for(map<string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+		it->second.users.erase(user);
+		it->second.used.erase(user);
+	}
+}
+
+void BVHCache::clear()
+{
+	thread_scoped_lock lock(mutex);
+
+	/* Entries held by a BVH are kept, so they can be released. */
+	for(map<string, Entry>::iterator it = entries.begin(); it != entries.end(); ) {
+		if(it->second.holder == NULL) {
+			entries.erase(it++);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+bool BVHCache::read_file(const string& key, PackedBVH *pack)
+{
+	const string filepath = path_cache_get(path_join("bvh", key));
+	vector<uint8_t> binary;
+
+	if(!path_exists(filepath) || !path_read_binary(filepath, binary)) {
+		return false;
+	}
+
+	/* Modification time is used to evict least recently used files. */
+	path_touch(filepath);
+
+	int version;
+	size_t offset = sizeof(BVH_CACHE_MAGIC) + sizeof(version) + sizeof(pack->root_index);
+
+	if(binary.size() < offset ||
+	   memcmp(&binary[0], BVH_CACHE_MAGIC, sizeof(BVH_CACHE_MAGIC)) != 0)
+	{
+		return false;
+	}
+
+	memcpy(&version, &binary[sizeof(BVH_CACHE_MAGIC)], sizeof(version));
+	if(version != BVH_CACHE_VERSION) {
+		return false;
+	}
+
+	memcpy(&pack->root_index,
+	       &binary[sizeof(BVH_CACHE_MAGIC) + sizeof(version)],
+	       sizeof(pack->root_index));
+
+	if(!(read_array(binary, &offset, pack->nodes) &&
+	     read_array(binary, &offset, pack->leaf_nodes) &&
+	     read_array(binary, &offset, pack->object_node) &&
+	     read_array(binary, &offset, pack->prim_tri_index) &&
+	     read_array(binary, &offset, pack->prim_tri_verts) &&
+	     read_array(binary, &offset, pack->prim_type) &&
+	     read_array(binary, &offset, pack->prim_visibility) &&
+	     read_array(binary, &offset, pack->prim_index) &&
+	     read_array(binary, &offset, pack->prim_object) &&
+	     read_array(binary, &offset, pack->prim_time)))
+	{
+		VLOG(1) << "Invalid BVH cache file " << filepath << ".";
+		*pack = PackedBVH();
+		return false;
+	}
+
+	VLOG(2) << "Read BVH from cache file " << filepath << ".";
+
+	return true;
+}
+
+void BVHCache::write_file(const string& key, const PackedBVH& pack, uint64_t disk_limit)
+{
+	const string filepath = path_cache_get(path_join("bvh", key));
+	const int version = BVH_CACHE_VERSION;
+	vector<uint8_t> binary;
+
+	binary.resize(sizeof(BVH_CACHE_MAGIC) + sizeof(version) + sizeof(pack.root_index));
+	memcpy(&binary[0], BVH_CACHE_MAGIC, sizeof(BVH_CACHE_MAGIC));
+	memcpy(&binary[sizeof(BVH_CACHE_MAGIC)], &version, sizeof(version));
+	memcpy(&binary[sizeof(BVH_CACHE_MAGIC) + sizeof(version)],
+	       &pack.root_index,
+	       sizeof(pack.root_index));
+
+	write_array(binary, pack.nodes);
+	write_array(binary, pack.leaf_nodes);
+	write_array(binary, pack.object_node);
+	write_array(binary, pack.prim_tri_index);
+	write_array(binary, pack.prim_tri_verts);
+	write_array(binary, pack.prim_type);
+	write_array(binary, pack.prim_visibility);
+	write_array(binary, pack.prim_index);
+	write_array(binary, pack.prim_object);
+	write_array(binary, pack.prim_time);
+
+	path_create_directories(filepath);
+	if(!path_write_binary(filepath, binary)) {
+		VLOG(1) << "Failed to write BVH cache file " << filepath << ".";
+		return;
+	}
+
+	path_cache_trim(path_dirname(filepath), disk_limit);
+}
+
+CCL_NAMESPACE_END
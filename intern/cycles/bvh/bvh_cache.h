@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BVH_CACHE_H__
+#define __BVH_CACHE_H__
+
+#include "bvh/bvh.h"
+
+#include "util/util_map.h"
+#include "util/util_set.h"
+#include "util/util_string.h"
+#include "util/util_thread.h"
+
+CCL_NAMESPACE_BEGIN
+
+class BVH;
+class BVHParams;
+class Mesh;
+
+/* BVH Cache
+ *
+ * Keeps the BVHs of meshes built in previous scene updates, so they can be
+ * reused when a mesh with identical geometry is synced again, like static
+ * meshes in the frames of an animation render where the scene is recreated
+ * for every frame. Entries are identified by a hash of the geometry and the
+ * build parameters. They can also be stored in the user cache directory, to
+ * be reused in later sessions.
+ *
+ * The pack of an entry is held by at most one BVH at a time instead of being
+ * copied, and moved back into the cache when that BVH is freed. This way the
+ * data is only in memory once.
+ *
+ * The cache is shared by all sessions, each session is identified by an
+ * opaque user pointer. Entries are kept in memory as long as some session
+ * used them in its last scene update. Files on disk are evicted least
+ * recently used first to fit in a size limit. */
+
+class BVHCache {
+public:
+	static BVHCache& instance();
+
+	/* Key for the BVH of a mesh, built with the given parameters. */
+	static string key(const Mesh *mesh, const BVHParams& params);
+
+	/* Fill the pack of the BVH from the cache, returns false if there is
+	 * none. The BVH holds the cached pack until release(). */
+	bool lookup(const string& key, const void *user, bool use_disk, BVH *bvh);
+	/* Add the pack of a freshly built BVH, which keeps holding it. Files on
+	 * disk are trimmed to disk_limit bytes. */
+	void insert(const string& key,
+	            const void *user,
+	            bool use_disk,
+	            uint64_t disk_limit,
+	            BVH *bvh);
+	/* Must be called before a BVH is freed or its pack is modified. With keep
+	 * the pack is moved back into the cache, otherwise the entry is dropped. */
+	void release(BVH *bvh, bool keep);
+
+	/* Drop entries from memory which the user did not use since the last
+	 * call and which are not used by any other session. */
+	void collect_garbage(const void *user);
+	/* Forget the user when its session ends. Its entries stay in memory until
+	 * the next garbage collection, so the next session can still use them. */
+	void remove_user(const void *user);
+	void clear();
+
+protected:
+	struct Entry {
+		Entry() : holder(NULL) {}
+
+		/* Empty while a BVH holds the pack. */
+		PackedBVH pack;
+		BVH *holder;
+		/* Users which used the entry in their last scene update, and users
+		 * which used it since their last garbage collection. */
+		set<const void*> users;
+		set<const void*> used;
+	};
+
+	bool read_file(const string& key, PackedBVH *pack);
+	void write_file(const string& key, const PackedBVH& pack, uint64_t disk_limit);
+
+	thread_mutex mutex;
+	map<string, Entry> entries;
+	map<const BVH*, string> holders;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __BVH_CACHE_H__ */
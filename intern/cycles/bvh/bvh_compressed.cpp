@@ -0,0 +1,99 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh/bvh_compressed.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_math.h"
+
+#include <cmath>
+
+CCL_NAMESPACE_BEGIN
+
+/* Kernels reconstruct bounds with a multiply-add, which may or may not be
+ * fused depending on the instruction set. Bounds are checked against both. */
+static float dequantize_min(float origin, float scale, int q)
+{
+	return min(origin + (float)q*scale, fmaf((float)q, scale, origin));
+}
+
+static float dequantize_max(float origin, float scale, int q)
+{
+	return max(origin + (float)q*scale, fmaf((float)q, scale, origin));
+}
+
+BVHCompressedBounds::BVHCompressedBounds(const BoundBox *bounds, int num)
+{
+	assert(num <= 8);
+
+	BoundBox node_bounds = BoundBox::empty;
+	for(int i = 0; i < num; i++) {
+		node_bounds.grow(bounds[i]);
+	}
+
+	for(int axis = 0; axis < 3; axis++) {
+		const float lo = node_bounds.min[axis];
+		const float hi = node_bounds.max[axis];
+
+		/* Scale must be non-zero for unused children to get an inverted
+		 * box, and large enough for 255 steps to reach the upper bound. */
+		float s = (hi - lo) / 255.0f;
+		if(!(s > 0.0f)) {
+			s = max(fabsf(lo), 1.0f) * FLT_EPSILON;
+		}
+		while(dequantize_min(lo, s, 255) < hi) {
+			s = nextafterf(s, FLT_MAX);
+		}
+
+		origin[axis] = lo;
+		scale[axis] = s;
+
+		for(int i = 0; i < num; i++) {
+			const float bmin = bounds[i].min[axis];
+			const float bmax = bounds[i].max[axis];
+
+			int qmin = (int)clamp(floorf((bmin - lo) / s), 0.0f, 255.0f);
+			while(qmin > 0 && dequantize_max(lo, s, qmin) > bmin) {
+				qmin--;
+			}
+
+			int qmax = (int)clamp(ceilf((bmax - lo) / s), (float)qmin, 255.0f);
+			while(qmax < 255 && dequantize_min(lo, s, qmax) < bmax) {
+				qmax++;
+			}
+
+			lower[axis][i] = (uchar)qmin;
+			upper[axis][i] = (uchar)qmax;
+		}
+
+		for(int i = num; i < 8; i++) {
+			lower[axis][i] = 255;
+			upper[axis][i] = 0;
+		}
+	}
+}
+
+uint BVHCompressedBounds::pack(int axis, int side, int first_child) const
+{
+	const uchar *q = (side == 0)? lower[axis]: upper[axis];
+	uint word = 0;
+	for(int i = 0; i < 4; i++) {
+		word |= (uint)q[first_child + i] << (8*i);
+	}
+	return word;
+}
+
+CCL_NAMESPACE_END
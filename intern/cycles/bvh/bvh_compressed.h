@@ -0,0 +1,56 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BVH_COMPRESSED_H__
+#define __BVH_COMPRESSED_H__
+
+#include "util/util_types.h"
+
+CCL_NAMESPACE_BEGIN
+
+class BoundBox;
+
+/* Child bounds of a compressed BVH node.
+ *
+ * Bounds are quantized to 8 bits on a grid spanning the union of all child
+ * bounds. The kernel reconstructs them as origin + q * scale, which always
+ * contains the original bounds. Unused children get an inverted box, so they
+ * are never intersected.
+ *
+ * Compressed nodes store origin and scale in the first 6 words after the
+ * node header, followed by the quantized bounds in the order min x, max x,
+ * min y, max y, min z, max z. Each of those takes one word per 4 children,
+ * with the first child in the lowest byte.
+ */
+class BVHCompressedBounds {
+public:
+	BVHCompressedBounds(const BoundBox *bounds, int num);
+
+	float3 origin;
+	float3 scale;
+
+	/* Quantized bounds of 4 children, starting at first_child, packed into
+	 * a single word. Side is 0 for the lower and 1 for the upper bound. */
+	uint pack(int axis, int side, int first_child) const;
+
+protected:
+	uchar lower[3][8];
+	uchar upper[3][8];
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __BVH_COMPRESSED_H__ */
@@ -64,21 +64,32 @@ CCL_NAMESPACE_BEGIN
  */
 static void rtc_filter_func(const RTCFilterFunctionNArguments *args)
 {
-	/* Current implementation in Cycles assumes only single-ray intersection queries. */
-	assert(args->N == 1);
-
-	const RTCRay *ray = (RTCRay*)args->ray;
-	const RTCHit *hit = (RTCHit*)args->hit;
+	/* Regular rays are also traced as packets for camera rays, see
+	 * scene_intersect_stream(), so this must handle any N. */
 	CCLIntersectContext *ctx = ((IntersectContext*)args->context)->userRayExt;
 	KernelGlobals *kg = ctx->kg;
 
 	/* Check if there is backfacing hair to ignore. */
-	if(IS_HAIR(hit->geomID) && (kernel_data.curve.curveflags & CURVE_KN_INTERPOLATE)
-	   && !(kernel_data.curve.curveflags & CURVE_KN_BACKFACING)
-	   && !(kernel_data.curve.curveflags & CURVE_KN_RIBBONS)) {
-		if(dot(make_float3(ray->dir_x, ray->dir_y, ray->dir_z), make_float3(hit->Ng_x, hit->Ng_y, hit->Ng_z)) > 0.0f) {
-			*args->valid = 0;
-			return;
+	if(!((kernel_data.curve.curveflags & CURVE_KN_INTERPOLATE)
+	     && !(kernel_data.curve.curveflags & CURVE_KN_BACKFACING)
+	     && !(kernel_data.curve.curveflags & CURVE_KN_RIBBONS)))
+	{
+		return;
+	}
+
+	for(uint i = 0; i < args->N; i++) {
+		if(args->valid[i] == 0 || !IS_HAIR(RTCHitN_geomID(args->hit, args->N, i))) {
+			continue;
+		}
+
+		float3 dir = make_float3(RTCRayN_dir_x(args->ray, args->N, i),
+		                         RTCRayN_dir_y(args->ray, args->N, i),
+		                         RTCRayN_dir_z(args->ray, args->N, i));
+		float3 Ng = make_float3(RTCHitN_Ng_x(args->hit, args->N, i),
+		                        RTCHitN_Ng_y(args->hit, args->N, i),
+		                        RTCHitN_Ng_z(args->hit, args->N, i));
+		if(dot(dir, Ng) > 0.0f) {
+			args->valid[i] = 0;
 		}
 	}
 }
@@ -79,6 +79,11 @@ public:
 	 */
 	bool use_unaligned_nodes;
 
+	/* Store child bounds of aligned nodes quantized to 8 bits.
+	 * Only used for BVH4 and BVH8 layouts.
+	 */
+	bool use_compressed_nodes;
+
 	/* Split time range to this number of steps and create leaf node for each
 	 * of this time steps.
 	 *
@@ -125,6 +130,7 @@ public:
 		top_level = false;
 		bvh_layout = BVH_LAYOUT_BVH2;
 		use_unaligned_nodes = false;
+		use_compressed_nodes = false;
 
 		primitive_mask = PRIMITIVE_ALL;
 
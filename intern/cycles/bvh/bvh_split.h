@@ -245,15 +245,19 @@ public:
 		            builder->range_within_max_leaf_size(range, *references));
 	}
 
-	__forceinline void split(BVHBuild *builder,
+	/* Returns true if a spatial split was done. */
+	__forceinline bool split(BVHBuild *builder,
 	                         BVHRange& left,
 	                         BVHRange& right,
 	                         const BVHRange& range)
 	{
-		if(builder->params.use_spatial_split && minSAH == spatial.sah)
+		if(builder->params.use_spatial_split && minSAH == spatial.sah) {
 			spatial.split(builder, left, right, range);
-		if(!left.size() || !right.size())
-			object.split(left, right, range);
+			if(left.size() && right.size())
+				return true;
+		}
+		object.split(left, right, range);
+		return false;
 	}
 };
 
@@ -229,8 +229,15 @@ Device *Device::create(DeviceInfo& info, Stats &stats, Profiler &profiler, bool
 #endif
 #ifdef WITH_NETWORK
 		case DEVICE_NETWORK:
-			device = device_network_create(info, stats, profiler, "127.0.0.1");
+		{
+			/* Server address is stored in the device id, see device_network_info(). */
+			string address = "127.0.0.1";
+			if(string_startswith(info.id, "NETWORK_")) {
+				address = info.id.substr(strlen("NETWORK_"));
+			}
+			device = device_network_create(info, stats, profiler, address.c_str());
 			break;
+		}
 #endif
 #ifdef WITH_OPENCL
 		case DEVICE_OPENCL:
@@ -363,6 +370,8 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo>& subdevices, int th
 	info.has_volume_decoupled = true;
 	info.has_osl = true;
 	info.has_profiling = true;
+	info.has_texture_cache = true;
+	info.has_sparse_volumes = true;
 
 	foreach(const DeviceInfo &device, subdevices) {
 		/* Ensure CPU device does not slow down GPU. */
@@ -398,6 +407,8 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo>& subdevices, int th
 		info.has_volume_decoupled &= device.has_volume_decoupled;
 		info.has_osl &= device.has_osl;
 		info.has_profiling &= device.has_profiling;
+		info.has_texture_cache &= device.has_texture_cache;
+		info.has_sparse_volumes &= device.has_sparse_volumes;
 	}
 
 	return info;
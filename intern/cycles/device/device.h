@@ -61,6 +61,8 @@ public:
 	bool has_osl;                   /* Support Open Shading Language. */
 	bool use_split_kernel;          /* Use split or mega kernel. */
 	bool has_profiling;             /* Supports runtime collection of profiling info. */
+	bool has_texture_cache;         /* Supports on demand loading of image textures. */
+	bool has_sparse_volumes;        /* Supports sparse storage of 3D textures. */
 	int cpu_threads;
 	vector<DeviceInfo> multi_devices;
 
@@ -77,6 +79,8 @@ public:
 		has_osl = false;
 		use_split_kernel = false;
 		has_profiling = false;
+		has_texture_cache = false;
+		has_sparse_volumes = false;
 	}
 
 	bool operator==(const DeviceInfo &info) {
@@ -314,7 +318,7 @@ public:
 
 #ifdef WITH_NETWORK
 	/* networking */
-	void server_run();
+	void server_run(int port, size_t cache_size);
 #endif
 
 	/* multi device */
@@ -169,6 +169,16 @@ public:
 	device_vector<TextureInfo> texture_info;
 	bool need_texture_info;
 
+	/* Copies of data textures (BVH, geometry, shaders) in the memory of every
+	 * CPU group, so threads bound to a NUMA node do not have to read them
+	 * from the memory of another node. */
+	struct GroupTexture {
+		size_t data_size;
+		size_t memory_size;
+		vector<void*> data;
+	};
+	map<string, GroupTexture> group_textures;
+
 #ifdef WITH_OSL
 	OSLGlobals osl_globals;
 #endif
@@ -178,6 +188,11 @@ public:
 	DeviceRequestedFeatures requested_features;
 
 	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int)>        path_trace_row_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_stopping_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_filter_x_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_filter_y_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_adjust_samples_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, int, int, int, int, int)>   shader_kernel;
@@ -187,14 +202,14 @@ public:
 	KernelFunctions<void(*)(int, int, float*, float*, float*, float*, int*, int)>                               filter_detect_outliers_kernel;
 	KernelFunctions<void(*)(int, int, float*, float*, float*, float*, int*, int)>                               filter_combine_halves_kernel;
 
-	KernelFunctions<void(*)(int, int, float*, float*, float*, int*, int, int, float, float)>   filter_nlm_calc_difference_kernel;
+	KernelFunctions<void(*)(int, int, float*, float*, float*, int*, int, int, int, float, float)> filter_nlm_calc_difference_kernel;
 	KernelFunctions<void(*)(float*, float*, int*, int, int)>                                   filter_nlm_blur_kernel;
 	KernelFunctions<void(*)(float*, float*, int*, int, int)>                                   filter_nlm_calc_weight_kernel;
 	KernelFunctions<void(*)(int, int, float*, float*, float*, float*, float*, int*, int, int)> filter_nlm_update_output_kernel;
 	KernelFunctions<void(*)(float*, float*, int*, int)>                                        filter_nlm_normalize_kernel;
 
 	KernelFunctions<void(*)(float*, int, int, int, float*, int*, int*, int, int, float)>                         filter_construct_transform_kernel;
-	KernelFunctions<void(*)(int, int, float*, float*, float*, int*, float*, float3*, int*, int*, int, int, int)> filter_nlm_construct_gramian_kernel;
+	KernelFunctions<void(*)(int, int, float*, float*, float*, int*, float*, float3*, int*, int*, int, int, int, int)> filter_nlm_construct_gramian_kernel;
 	KernelFunctions<void(*)(int, int, int, float*, int*, float*, float3*, int*, int)>                            filter_finalize_kernel;
 
 	KernelFunctions<void(*)(KernelGlobals *, ccl_constant KernelData*, ccl_global void*, int, ccl_global char*,
@@ -215,6 +230,11 @@ public:
 	  texture_info(this, "__texture_info", MEM_TEXTURE),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(path_trace_row),
+	  REGISTER_KERNEL(adaptive_stopping),
+	  REGISTER_KERNEL(adaptive_filter_x),
+	  REGISTER_KERNEL(adaptive_filter_y),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
@@ -402,6 +422,7 @@ public:
 							mem.name,
 							mem.host_pointer,
 							mem.data_size);
+			tex_alloc_groups(mem);
 		}
 		else {
 			/* Image Texture. */
@@ -428,6 +449,8 @@ public:
 			info.width = mem.data_width;
 			info.height = mem.data_height;
 			info.depth = mem.data_depth;
+			info.cache = (uint64_t)mem.texture_cache_image;
+			info.grid_info = (uint64_t)mem.grid_info;
 
 			need_texture_info = true;
 		}
@@ -437,8 +460,64 @@ public:
 		stats.mem_alloc(mem.device_size);
 	}
 
+	void tex_alloc_groups(device_memory& mem)
+	{
+		const int num_groups = system_cpu_group_count();
+		if(num_groups < 2 || mem.data_size == 0) {
+			return;
+		}
+
+		GroupTexture group_tex;
+		group_tex.data_size = mem.data_size;
+		group_tex.memory_size = mem.memory_size();
+
+		for(int group = 0; group < num_groups; ++group) {
+			void *data = system_cpu_group_alloc(group_tex.memory_size, group);
+			if(data == NULL) {
+				break;
+			}
+			memcpy(data, mem.host_pointer, group_tex.memory_size);
+			group_tex.data.push_back(data);
+		}
+
+		if(group_tex.data.size() != num_groups) {
+			/* Groups are not backed by NUMA memory, or we ran out of it. */
+			foreach(void *data, group_tex.data) {
+				system_cpu_group_free(data, group_tex.memory_size);
+			}
+			return;
+		}
+
+		VLOG(1) << "Texture " << mem.name << " replicated to "
+		        << num_groups << " CPU groups.";
+
+		group_textures[mem.name] = group_tex;
+		stats.mem_alloc(group_tex.memory_size * num_groups);
+	}
+
+	void tex_free_groups(device_memory& mem)
+	{
+		if(mem.name == NULL) {
+			return;
+		}
+
+		map<string, GroupTexture>::iterator it = group_textures.find(mem.name);
+		if(it == group_textures.end()) {
+			return;
+		}
+
+		GroupTexture& group_tex = it->second;
+		foreach(void *data, group_tex.data) {
+			system_cpu_group_free(data, group_tex.memory_size);
+		}
+		stats.mem_free(group_tex.memory_size * group_tex.data.size());
+		group_textures.erase(it);
+	}
+
 	void tex_free(device_memory& mem)
 	{
+		tex_free_groups(mem);
+
 		if(mem.device_pointer) {
 			mem.device_pointer = 0;
 			stats.mem_free(mem.device_size);
@@ -508,7 +587,7 @@ public:
 			                                    (float*) variance_ptr,
 			                                    difference,
 			                                    local_rect,
-			                                    w, 0,
+			                                    w, 0, 0,
 			                                    a, k_2);
 
 			filter_nlm_blur_kernel()       (difference, blurDifference, local_rect, w, f);
@@ -566,38 +645,47 @@ public:
 		float *difference     = temporary_mem;
 		float *blurDifference = temporary_mem + task->buffer.pass_stride;
 
+		/* Neighboring frames are stored after the current one in the buffer,
+		 * their pixels are weighted against the current frame in the same way
+		 * as the spatial neighbors. */
 		int r = task->radius;
-		for(int i = 0; i < (2*r+1)*(2*r+1); i++) {
-			int dy = i / (2*r+1) - r;
-			int dx = i % (2*r+1) - r;
-
-			int local_rect[4] = {max(0, -dx), max(0, -dy),
-			                     task->reconstruction_state.source_w - max(0, dx),
-			                     task->reconstruction_state.source_h - max(0, dy)};
-			filter_nlm_calc_difference_kernel()(dx, dy,
-			                                    (float*) color_ptr,
-			                                    (float*) color_variance_ptr,
-			                                    difference,
-			                                    local_rect,
-			                                    task->buffer.stride,
-			                                    task->buffer.pass_stride,
-			                                    1.0f,
-			                                    task->nlm_k_2);
-			filter_nlm_blur_kernel()(difference, blurDifference, local_rect, task->buffer.stride, 4);
-			filter_nlm_calc_weight_kernel()(blurDifference, difference, local_rect, task->buffer.stride, 4);
-			filter_nlm_blur_kernel()(difference, blurDifference, local_rect, task->buffer.stride, 4);
-			filter_nlm_construct_gramian_kernel()(dx, dy,
-			                                      blurDifference,
-			                                      (float*)  task->buffer.mem.device_pointer,
-			                                      (float*)  task->storage.transform.device_pointer,
-			                                      (int*)    task->storage.rank.device_pointer,
-			                                      (float*)  task->storage.XtWX.device_pointer,
-			                                      (float3*) task->storage.XtWY.device_pointer,
-			                                      local_rect,
-			                                      &task->reconstruction_state.filter_window.x,
-			                                      task->buffer.stride,
-			                                      4,
-			                                      task->buffer.pass_stride);
+		for(int frame = 0; frame < task->buffer.frames; frame++) {
+			int frame_offset = frame * task->buffer.frame_stride;
+
+			for(int i = 0; i < (2*r+1)*(2*r+1); i++) {
+				int dy = i / (2*r+1) - r;
+				int dx = i % (2*r+1) - r;
+
+				int local_rect[4] = {max(0, -dx), max(0, -dy),
+				                     task->reconstruction_state.source_w - max(0, dx),
+				                     task->reconstruction_state.source_h - max(0, dy)};
+				filter_nlm_calc_difference_kernel()(dx, dy,
+				                                    (float*) color_ptr,
+				                                    (float*) color_variance_ptr,
+				                                    difference,
+				                                    local_rect,
+				                                    task->buffer.stride,
+				                                    task->buffer.pass_stride,
+				                                    frame_offset,
+				                                    1.0f,
+				                                    task->nlm_k_2);
+				filter_nlm_blur_kernel()(difference, blurDifference, local_rect, task->buffer.stride, 4);
+				filter_nlm_calc_weight_kernel()(blurDifference, difference, local_rect, task->buffer.stride, 4);
+				filter_nlm_blur_kernel()(difference, blurDifference, local_rect, task->buffer.stride, 4);
+				filter_nlm_construct_gramian_kernel()(dx, dy,
+				                                      blurDifference,
+				                                      (float*)  task->buffer.mem.device_pointer,
+				                                      (float*)  task->storage.transform.device_pointer,
+				                                      (int*)    task->storage.rank.device_pointer,
+				                                      (float*)  task->storage.XtWX.device_pointer,
+				                                      (float3*) task->storage.XtWY.device_pointer,
+				                                      local_rect,
+				                                      &task->reconstruction_state.filter_window.x,
+				                                      task->buffer.stride,
+				                                      4,
+				                                      task->buffer.pass_stride,
+				                                      frame_offset);
+			}
 		}
 		for(int y = 0; y < task->filter_area.w; y++) {
 			for(int x = 0; x < task->filter_area.z; x++) {
@@ -706,9 +794,54 @@ public:
 		return true;
 	}
 
+	bool adaptive_sampling_need_filter(KernelGlobals *kg, const RenderTile &tile, int sample)
+	{
+		const int num_samples = sample - tile.start_sample + 1;
+		return (num_samples >= kernel_data.integrator.adaptive_min_samples) &&
+		       (num_samples % kernel_data.integrator.adaptive_step == 0);
+	}
+
+	/* Run the convergence test on all pixels of the tile and dilate the regions
+	 * that still need samples. Returns false once the whole tile converged. */
+	bool adaptive_sampling_filter(KernelGlobals *kg, RenderTile &tile, int sample)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		const int num_samples = sample - tile.start_sample + 1;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				adaptive_stopping_kernel()(kg, render_buffer, num_samples, x, y, tile.offset, tile.stride);
+			}
+		}
+
+		bool any = false;
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			any |= adaptive_filter_x_kernel()(kg, render_buffer, y, tile.x, tile.w, tile.offset, tile.stride);
+		}
+		for(int x = tile.x; x < tile.x + tile.w; x++) {
+			any |= adaptive_filter_y_kernel()(kg, render_buffer, x, tile.y, tile.h, tile.offset, tile.stride);
+		}
+
+		return any;
+	}
+
+	/* Rescale pixels that stopped early to the sample count of the tile. */
+	void adaptive_sampling_post(KernelGlobals *kg, RenderTile &tile)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		const int num_samples = tile.sample - tile.start_sample;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				adaptive_adjust_samples_kernel()(kg, render_buffer, num_samples, x, y, tile.offset, tile.stride);
+			}
+		}
+	}
+
 	void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
 	{
 		const bool use_coverage = kernel_data.film.cryptomatte_passes & CRYPT_ACCURATE;
+		const bool use_adaptive_sampling = task.adaptive_sampling && kernel_data.film.pass_adaptive_aux_buffer;
 
 		scoped_timer timer(&tile.buffers->render_time);
 
@@ -731,10 +864,15 @@ public:
 			}
 
 			for(int y = tile.y; y < tile.y + tile.h; y++) {
+				if(!use_coverage) {
+					/* Whole rows allow the kernel to trace coherent rays together. */
+					path_trace_row_kernel()(kg, render_buffer,
+					                        sample, tile.x, y, tile.w, tile.offset, tile.stride);
+					continue;
+				}
+
 				for(int x = tile.x; x < tile.x + tile.w; x++) {
-					if(use_coverage) {
-						coverage.init_pixel(x, y);
-					}
+					coverage.init_pixel(x, y);
 					path_trace_kernel()(kg, render_buffer,
 					                    sample, x, y, tile.offset, tile.stride);
 				}
@@ -743,10 +881,22 @@ public:
 			tile.sample = sample + 1;
 
 			task.update_progress(&tile, tile.w*tile.h);
+
+			if(use_adaptive_sampling && adaptive_sampling_need_filter(kg, tile, sample)) {
+				if(!adaptive_sampling_filter(kg, tile, sample)) {
+					/* Account the skipped samples to the progress. */
+					task.update_progress(&tile, tile.w*tile.h*(end_sample - tile.sample));
+					tile.sample = end_sample;
+					break;
+				}
+			}
 		}
 		if(use_coverage) {
 			coverage.finalize();
 		}
+		if(use_adaptive_sampling) {
+			adaptive_sampling_post(kg, tile);
+		}
 	}
 
 	void denoise(DenoisingTask& denoising, RenderTile &tile)
@@ -799,6 +949,8 @@ public:
 		RenderTile tile;
 		DenoisingTask denoising(this, task);
 		denoising.profiler = &kg->profiler;
+		/* Temporal denoising is only supported by the CPU kernels. */
+		denoising.frames = task.denoising_frames;
 
 		while(task.acquire_tile(this, tile)) {
 			if(tile.task == RenderTile::PATH_TRACE) {
@@ -920,6 +1072,19 @@ protected:
 	{
 		KernelGlobals kg = kernel_globals;
 		kg.transparent_shadow_intersections = NULL;
+		/* Use copies of data textures local to the thread's CPU group. */
+		const int group = system_cpu_thread_group();
+		if(group != -1) {
+			map<string, GroupTexture>::iterator it;
+			for(it = group_textures.begin(); it != group_textures.end(); ++it) {
+				if(group < it->second.data.size()) {
+					kernel_tex_copy(&kg,
+					                it->first.c_str(),
+					                it->second.data[group],
+					                it->second.data_size);
+				}
+			}
+		}
 		const int decoupled_count = sizeof(kg.decoupled_volume_steps) /
 		                            sizeof(*kg.decoupled_volume_steps);
 		for(int i = 0; i < decoupled_count; ++i) {
@@ -1085,6 +1250,8 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	info.has_osl = true;
 	info.has_half_images = true;
 	info.has_profiling = true;
+	info.has_texture_cache = true;
+	info.has_sparse_volumes = true;
 
 	devices.insert(devices.begin(), info);
 }
@@ -1227,6 +1227,8 @@ public:
 		info.width = mem.data_width;
 		info.height = mem.data_height;
 		info.depth = mem.data_depth;
+		info.cache = 0;
+		info.grid_info = 0;
 		need_texture_info = true;
 	}
 
@@ -82,6 +82,19 @@ void DenoisingTask::set_render_buffer(RenderTile *rtiles)
 	tile_info_mem.copy_to_device();
 }
 
+void DenoisingTask::set_frame_buffer(RenderTile *rtiles, int frame)
+{
+	/* Frames share the layout of the current one, only the buffers differ. */
+	for(int i = 0; i < 9; i++) {
+		if(!rtiles[i].buffer) {
+			continue;
+		}
+		tile_info->buffers[i] = (frame == 0)? rtiles[i].buffer : frames[frame-1];
+	}
+
+	tile_info_mem.copy_to_device();
+}
+
 void DenoisingTask::setup_denoising_buffer()
 {
 	/* Expand filter_area by radius pixels and clamp the result to the extent of the neighboring tiles */
@@ -95,8 +108,10 @@ void DenoisingTask::setup_denoising_buffer()
 	buffer.h = rect.w - rect.y;
 	int alignment_floats = divide_up(device->mem_sub_ptr_alignment(), sizeof(float));
 	buffer.pass_stride = align_up(buffer.stride * buffer.h, alignment_floats);
+	buffer.frames = frames.size() + 1;
+	buffer.frame_stride = buffer.pass_stride * buffer.passes;
 	/* Pad the total size by four floats since the SIMD kernels might go a bit over the end. */
-	int mem_size = align_up(buffer.pass_stride * buffer.passes + 4, alignment_floats);
+	int mem_size = align_up(buffer.frame_stride * buffer.frames + 4, alignment_floats);
 	buffer.mem.alloc_to_device(mem_size, false);
 
 	/* CPUs process shifts sequentially while GPUs process them in parallel. */
@@ -114,16 +129,17 @@ void DenoisingTask::setup_denoising_buffer()
 	buffer.temporary_mem.alloc_to_device(num_layers * buffer.pass_stride);
 }
 
-void DenoisingTask::prefilter_shadowing()
+void DenoisingTask::prefilter_shadowing(int frame)
 {
 	device_ptr null_ptr = (device_ptr) 0;
+	int frame_offset = frame * buffer.frame_stride;
 
-	device_sub_ptr unfiltered_a   (buffer.mem, 0,                    buffer.pass_stride);
-	device_sub_ptr unfiltered_b   (buffer.mem, 1*buffer.pass_stride, buffer.pass_stride);
-	device_sub_ptr sample_var     (buffer.mem, 2*buffer.pass_stride, buffer.pass_stride);
-	device_sub_ptr sample_var_var (buffer.mem, 3*buffer.pass_stride, buffer.pass_stride);
-	device_sub_ptr buffer_var     (buffer.mem, 5*buffer.pass_stride, buffer.pass_stride);
-	device_sub_ptr filtered_var   (buffer.mem, 6*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr unfiltered_a   (buffer.mem, frame_offset,                        buffer.pass_stride);
+	device_sub_ptr unfiltered_b   (buffer.mem, frame_offset + 1*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr sample_var     (buffer.mem, frame_offset + 2*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr sample_var_var (buffer.mem, frame_offset + 3*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr buffer_var     (buffer.mem, frame_offset + 5*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr filtered_var   (buffer.mem, frame_offset + 6*buffer.pass_stride, buffer.pass_stride);
 
 	/* Get the A/B unfiltered passes, the combined sample variance, the estimated variance of the sample variance and the buffer variance. */
 	functions.divide_shadow(*unfiltered_a, *unfiltered_b, *sample_var, *sample_var_var, *buffer_var);
@@ -152,20 +168,22 @@ void DenoisingTask::prefilter_shadowing()
 	functions.non_local_means(filtered_b, filtered_a, residual_var, final_b);
 
 	/* Combine the two double-filtered halves to a final shadow feature. */
-	device_sub_ptr shadow_pass(buffer.mem, 4*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr shadow_pass(buffer.mem, frame_offset + 4*buffer.pass_stride, buffer.pass_stride);
 	functions.combine_halves(final_a, final_b, *shadow_pass, null_ptr, 0, rect);
 }
 
-void DenoisingTask::prefilter_features()
+void DenoisingTask::prefilter_features(int frame)
 {
-	device_sub_ptr unfiltered     (buffer.mem,  8*buffer.pass_stride, buffer.pass_stride);
-	device_sub_ptr variance       (buffer.mem,  9*buffer.pass_stride, buffer.pass_stride);
+	int frame_offset = frame * buffer.frame_stride;
+
+	device_sub_ptr unfiltered     (buffer.mem, frame_offset + 8*buffer.pass_stride, buffer.pass_stride);
+	device_sub_ptr variance       (buffer.mem, frame_offset + 9*buffer.pass_stride, buffer.pass_stride);
 
 	int mean_from[]     = { 0, 1, 2, 12, 6,  7, 8 };
 	int variance_from[] = { 3, 4, 5, 13, 9, 10, 11};
 	int pass_to[]       = { 1, 2, 3, 0,  5,  6,  7};
 	for(int pass = 0; pass < 7; pass++) {
-		device_sub_ptr feature_pass(buffer.mem, pass_to[pass]*buffer.pass_stride, buffer.pass_stride);
+		device_sub_ptr feature_pass(buffer.mem, frame_offset + pass_to[pass]*buffer.pass_stride, buffer.pass_stride);
 		/* Get the unfiltered pass and its variance from the RenderBuffers. */
 		functions.get_feature(mean_from[pass], variance_from[pass], *unfiltered, *variance);
 		/* Smooth the pass and store the result in the denoising buffers. */
@@ -174,8 +192,10 @@ void DenoisingTask::prefilter_features()
 	}
 }
 
-void DenoisingTask::prefilter_color()
+void DenoisingTask::prefilter_color(int frame)
 {
+	int frame_offset = frame * buffer.frame_stride;
+
 	int mean_from[]     = {20, 21, 22};
 	int variance_from[] = {23, 24, 25};
 	int mean_to[]       = { 8,  9, 10};
@@ -187,13 +207,13 @@ void DenoisingTask::prefilter_color()
 
 	for(int pass = 0; pass < num_color_passes; pass++) {
 		device_sub_ptr color_pass(temporary_color, pass*buffer.pass_stride, buffer.pass_stride);
-		device_sub_ptr color_var_pass(buffer.mem, variance_to[pass]*buffer.pass_stride, buffer.pass_stride);
+		device_sub_ptr color_var_pass(buffer.mem, frame_offset + variance_to[pass]*buffer.pass_stride, buffer.pass_stride);
 		functions.get_feature(mean_from[pass], variance_from[pass], *color_pass, *color_var_pass);
 	}
 
-	device_sub_ptr depth_pass    (buffer.mem,                                 0,   buffer.pass_stride);
-	device_sub_ptr color_var_pass(buffer.mem, variance_to[0]*buffer.pass_stride, 3*buffer.pass_stride);
-	device_sub_ptr output_pass   (buffer.mem,     mean_to[0]*buffer.pass_stride, 3*buffer.pass_stride);
+	device_sub_ptr depth_pass    (buffer.mem,                                  frame_offset,   buffer.pass_stride);
+	device_sub_ptr color_var_pass(buffer.mem, frame_offset + variance_to[0]*buffer.pass_stride, 3*buffer.pass_stride);
+	device_sub_ptr output_pass   (buffer.mem,     frame_offset + mean_to[0]*buffer.pass_stride, 3*buffer.pass_stride);
 	functions.detect_outliers(temporary_color.device_pointer, *color_var_pass, *depth_pass, *output_pass);
 }
 
@@ -236,10 +256,15 @@ void DenoisingTask::run_denoising(RenderTile *tile)
 
 	setup_denoising_buffer();
 
-	prefilter_shadowing();
-	prefilter_features();
-	prefilter_color();
+	for(int frame = 0; frame < buffer.frames; frame++) {
+		set_frame_buffer(rtiles, frame);
+
+		prefilter_shadowing(frame);
+		prefilter_features(frame);
+		prefilter_color(frame);
+	}
 
+	/* The feature space is built from the current frame only. */
 	construct_transform();
 	reconstruct();
 
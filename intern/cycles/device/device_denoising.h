@@ -53,6 +53,9 @@ public:
 	TileInfo *tile_info;
 	device_vector<int> tile_info_mem;
 
+	/* Render buffers of neighboring frames, see DeviceTask::denoising_frames. */
+	vector<device_ptr> frames;
+
 	ProfilingState *profiler;
 
 	int4 rect;
@@ -145,6 +148,9 @@ public:
 		int stride;
 		int h;
 		int width;
+		/* Prefiltered passes of each frame, the current frame comes first. */
+		int frames;
+		int frame_stride;
 		device_only_memory<float> mem;
 		device_only_memory<float> temporary_mem;
 
@@ -160,10 +166,11 @@ protected:
 	Device *device;
 
 	void set_render_buffer(RenderTile *rtiles);
+	void set_frame_buffer(RenderTile *rtiles, int frame);
 	void setup_denoising_buffer();
-	void prefilter_shadowing();
-	void prefilter_features();
-	void prefilter_color();
+	void prefilter_shadowing(int frame);
+	void prefilter_features(int frame);
+	void prefilter_color(int frame);
 	void construct_transform();
 	void reconstruct();
 };
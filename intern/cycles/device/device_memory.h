@@ -204,6 +204,11 @@ public:
 	const char *name;
 	InterpolationType interpolation;
 	ExtensionType extension;
+	/* Texture cache image, in which case the host data is only a placeholder. */
+	void *texture_cache_image;
+	/* Tile offsets of a 3D texture stored as sparse grid, in which case the
+	 * host data only holds the non-empty tiles. */
+	void *grid_info;
 
 	/* Pointers. */
 	Device *device;
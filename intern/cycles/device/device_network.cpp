@@ -60,11 +60,21 @@ public:
 	: Device(info, stats, profiler, true), socket(io_service)
 	{
 		error_func = NetworkError();
+
+		/* Address is host name with optional port, host:port. */
+		string host = address;
 		stringstream portstr;
-		portstr << SERVER_PORT;
+		size_t colon = host.rfind(':');
+		if(colon != string::npos) {
+			portstr << host.substr(colon + 1);
+			host = host.substr(0, colon);
+		}
+		else {
+			portstr << SERVER_PORT;
+		}
 
 		tcp::resolver resolver(io_service);
-		tcp::resolver::query query(address, portstr.str());
+		tcp::resolver::query query(host, portstr.str());
 		tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
 		tcp::resolver::iterator end;
 
@@ -112,11 +122,34 @@ public:
 	{
 		thread_scoped_lock lock(rpc_lock);
 
+		size_t data_size = mem.memory_size();
+
+		/* Large buffers are identified by content hash, the server skips the
+		 * upload if it still has the data from an earlier render. */
+		string hash;
+		if(data_size >= NETWORK_CACHE_MIN_SIZE) {
+			hash = network_data_hash(mem.host_pointer, data_size);
+		}
+
 		RPCSend snd(socket, &error_func, "mem_copy_to");
 
 		snd.add(mem);
+		snd.add(hash);
 		snd.write();
-		snd.write_buffer(mem.host_pointer, mem.memory_size());
+
+		if(!hash.empty()) {
+			RPCReceive rcv(socket, &error_func);
+			if(rcv.name == "mem_copy_to_cached") {
+				VLOG(2) << "Buffer " << mem.name << " found in server cache.";
+				return;
+			}
+			else if(rcv.name != "mem_copy_to_upload") {
+				error_func.network_error("Network receive error: unexpected reply to mem_copy_to: " + rcv.name);
+				return;
+			}
+		}
+
+		snd.write_buffer(mem.host_pointer, data_size);
 	}
 
 	void mem_copy_from(device_memory& mem, int y, int w, int h, int elem)
@@ -230,15 +263,29 @@ public:
 			RPCReceive rcv(socket, &error_func);
 
 			if(rcv.name == "acquire_tile") {
+				int num_tiles;
+				rcv.read(num_tiles);
 				lock.unlock();
 
-				/* todo: watch out for recursive calls! */
-				if(the_task.acquire_tile(this, tile)) { /* write return as bool */
+				/* Server may ask for multiple tiles to keep them in flight,
+				 * give it as many as are left. */
+				vector<RenderTile> tiles;
+				for(int i = 0; i < num_tiles; i++) {
+					/* todo: watch out for recursive calls! */
+					if(!the_task.acquire_tile(this, tile)) {
+						break;
+					}
 					the_tiles.push_back(tile);
+					tiles.push_back(tile);
+				}
 
+				if(!tiles.empty()) {
 					lock.lock();
 					RPCSend snd(socket, &error_func, "acquire_tile");
-					snd.add(tile);
+					snd.add((int)tiles.size());
+					foreach(RenderTile& acquired_tile, tiles) {
+						snd.add(acquired_tile);
+					}
 					snd.write();
 					lock.unlock();
 				}
@@ -300,19 +347,40 @@ Device *device_network_create(DeviceInfo& info, Stats &stats, Profiler &profiler
 
 void device_network_info(vector<DeviceInfo>& devices)
 {
-	DeviceInfo info;
+	/* Servers can be listed as host:port separated by spaces, there is
+	 * a device for each of them, which can be combined into a multi device
+	 * to distribute tiles over all of them. */
+	vector<string> servers;
+	const char *servers_env = getenv("CYCLES_NETWORK_SERVERS");
+	if(servers_env) {
+		string_split(servers, servers_env, " ,");
+	}
 
-	info.type = DEVICE_NETWORK;
-	info.description = "Network Device";
-	info.id = "NETWORK";
-	info.num = 0;
+	if(servers.empty()) {
+		servers.push_back("");
+	}
+
+	int num = 0;
+	foreach(const string& server, servers) {
+		DeviceInfo info;
+
+		info.type = DEVICE_NETWORK;
+		info.description = "Network Device";
+		info.id = "NETWORK";
+		info.num = num++;
+
+		if(!server.empty()) {
+			info.description += " " + server;
+			info.id += "_" + server;
+		}
 
-	/* todo: get this info from device */
-	info.advanced_shading = true;
-	info.has_volume_decoupled = false;
-	info.has_osl = false;
+		/* todo: get this info from device */
+		info.advanced_shading = true;
+		info.has_volume_decoupled = false;
+		info.has_osl = false;
 
-	devices.push_back(info);
+		devices.push_back(info);
+	}
 }
 
 class DeviceServer {
@@ -325,8 +393,8 @@ public:
 
 	bool have_error() { return error_func.have_error(); }
 
-	DeviceServer(Device *device_, tcp::socket& socket_)
-	: device(device_), socket(socket_), stop(false), blocked_waiting(false)
+	DeviceServer(Device *device_, tcp::socket& socket_, NetworkDataCache *cache_)
+	: device(device_), socket(socket_), cache(cache_), stop(false), blocked_waiting(false)
 	{
 		error_func = NetworkError();
 	}
@@ -451,10 +519,10 @@ protected:
 			pointer_mapping_insert(client_pointer, mem.device_pointer);
 		}
 		else if(rcv.name == "mem_copy_to") {
-			string name;
+			string name, hash;
 			network_device_memory mem(device);
 			rcv.read(mem, name);
-			lock.unlock();
+			rcv.read(hash);
 
 			size_t data_size = mem.memory_size();
 			device_ptr client_pointer = mem.device_pointer;
@@ -473,8 +541,24 @@ protected:
 				mem.host_pointer = (data_size)? (void*)&(data_v[0]): 0;
 			}
 
-			/* Copy data from network into memory buffer. */
-			rcv.read_buffer((uint8_t*)mem.host_pointer, data_size);
+			/* Use cached data if we have it, otherwise ask client to upload
+			 * it and copy data from network into memory buffer. */
+			bool cached = false;
+			if(!hash.empty()) {
+				cached = cache->find(hash, mem.host_pointer, data_size);
+
+				RPCSend snd(socket, &error_func, (cached)? "mem_copy_to_cached": "mem_copy_to_upload");
+				snd.write();
+			}
+			lock.unlock();
+
+			if(!cached) {
+				rcv.read_buffer((uint8_t*)mem.host_pointer, data_size);
+
+				if(!hash.empty() && !have_error()) {
+					cache->insert(hash, mem.host_pointer, data_size);
+				}
+			}
 
 			/* Copy the data from the memory buffer to the device buffer. */
 			device->mem_copy_to(mem);
@@ -609,6 +693,8 @@ protected:
 			task.update_tile_sample = function_bind(&DeviceServer::task_update_tile_sample, this, _1);
 			task.get_cancel = function_bind(&DeviceServer::task_get_cancel, this);
 
+			acquired_tiles.clear();
+
 			device->task_add(task);
 		}
 		else if(rcv.name == "task_wait") {
@@ -630,7 +716,12 @@ protected:
 		else if(rcv.name == "acquire_tile") {
 			AcquireEntry entry;
 			entry.name = rcv.name;
-			rcv.read(entry.tile);
+			int num_tiles;
+			rcv.read(num_tiles);
+			entry.tiles.resize(num_tiles);
+			foreach(RenderTile& tile, entry.tiles) {
+				rcv.read(tile);
+			}
 			acquire_queue.push_back(entry);
 			lock.unlock();
 		}
@@ -658,7 +749,15 @@ protected:
 
 		bool result = false;
 
+		/* Use tile which came along with an earlier request. */
+		if(!acquired_tiles.empty()) {
+			tile = acquired_tiles.front();
+			acquired_tiles.pop_front();
+			return true;
+		}
+
 		RPCSend snd(socket, &error_func, "acquire_tile");
+		snd.add(NETWORK_TILES_IN_FLIGHT);
 		snd.write();
 
 		do {
@@ -673,11 +772,16 @@ protected:
 				acquire_queue.pop_front();
 
 				if(entry.name == "acquire_tile") {
-					tile = entry.tile;
-
-					if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
-
-					result = true;
+					foreach(RenderTile& entry_tile, entry.tiles) {
+						if(entry_tile.buffer) entry_tile.buffer = ptr_map[entry_tile.buffer];
+						acquired_tiles.push_back(entry_tile);
+					}
+
+					if(!acquired_tiles.empty()) {
+						tile = acquired_tiles.front();
+						acquired_tiles.pop_front();
+						result = true;
+					}
 					break;
 				}
 				else if(entry.name == "acquire_tile_none") {
@@ -746,6 +850,7 @@ protected:
 	/* properties */
 	Device *device;
 	tcp::socket& socket;
+	NetworkDataCache *cache;
 
 	/* mapping of remote to local pointer */
 	PtrMap ptr_map;
@@ -754,12 +859,15 @@ protected:
 
 	struct AcquireEntry {
 		string name;
-		RenderTile tile;
+		vector<RenderTile> tiles;
 	};
 
 	thread_mutex acquire_mutex;
 	list<AcquireEntry> acquire_queue;
 
+	/* Tiles received from the client but not yet given to the device. */
+	list<RenderTile> acquired_tiles;
+
 	bool stop;
 	bool blocked_waiting;
 private:
@@ -769,16 +877,19 @@ private:
 
 };
 
-void Device::server_run()
+void Device::server_run(int port, size_t cache_size)
 {
 	try {
 		/* starts thread that responds to discovery requests */
 		ServerDiscovery discovery;
 
+		/* scene data is kept between connections */
+		NetworkDataCache cache(cache_size);
+
 		for(;;) {
 			/* accept connection */
 			boost::asio::io_service io_service;
-			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
 			tcp::socket socket(io_service);
 			acceptor.accept(socket);
@@ -786,7 +897,7 @@ void Device::server_run()
 			string remote_address = socket.remote_endpoint().address().to_string();
 			printf("Connected to remote client at: %s\n", remote_address.c_str());
 
-			DeviceServer server(this, socket);
+			DeviceServer server(this, socket, &cache);
 			server.listen();
 
 			printf("Disconnected.\n");
@@ -33,13 +33,17 @@
 #include <sstream>
 #include <deque>
 
+#include <zlib.h>
+
 #include "render/buffers.h"
 
 #include "util/util_foreach.h"
 #include "util/util_list.h"
 #include "util/util_map.h"
+#include "util/util_md5.h"
 #include "util/util_param.h"
 #include "util/util_string.h"
+#include "util/util_thread.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -56,6 +60,15 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Buffers are sent in separately compressed chunks of this size. */
+static const size_t NETWORK_CHUNK_SIZE = 1024*1024;
+/* Buffers from this size on are looked up in the server cache by content
+ * hash before uploading them. */
+static const size_t NETWORK_CACHE_MIN_SIZE = 64*1024;
+/* Number of tiles a server asks for at once, so its render threads don't
+ * have to wait for a network round trip after every tile. */
+static const int NETWORK_TILES_IN_FLIGHT = 2;
+
 #if 0
 typedef boost::archive::text_oarchive o_archive;
 typedef boost::archive::text_iarchive i_archive;
@@ -82,6 +95,85 @@ public:
 	vector<char> local_data;
 };
 
+/* Hash of buffer contents, used as key of the server cache. */
+static inline string network_data_hash(const void *data, size_t size)
+{
+	MD5Hash md5;
+	const uint8_t *bytes = (const uint8_t*)data;
+	for(size_t offset = 0; offset < size; offset += NETWORK_CHUNK_SIZE) {
+		size_t chunk_size = (size - offset < NETWORK_CHUNK_SIZE)? size - offset: NETWORK_CHUNK_SIZE;
+		md5.append(bytes + offset, (int)chunk_size);
+	}
+	return md5.get_hex();
+}
+
+/* Buffers uploaded to a server, by content hash. The cache outlives client
+ * connections, so rendering the same scene again only uploads buffers that
+ * changed. Least recently used buffers are removed above the size limit. */
+class NetworkDataCache {
+public:
+	explicit NetworkDataCache(size_t max_size_)
+	: size(0), max_size(max_size_)
+	{
+	}
+
+	/* Copy cached data into buffer, returns false if it's not in the cache. */
+	bool find(const string& hash, void *data, size_t data_size)
+	{
+		thread_scoped_lock lock(mutex);
+
+		map<string, list<Entry>::iterator>::iterator it = entries_map.find(hash);
+		if(it == entries_map.end() || it->second->data.size() != data_size) {
+			return false;
+		}
+
+		/* Move to the front of the list. */
+		entries.splice(entries.begin(), entries, it->second);
+		if(data_size) {
+			memcpy(data, &entries.front().data[0], data_size);
+		}
+		return true;
+	}
+
+	void insert(const string& hash, const void *data, size_t data_size)
+	{
+		thread_scoped_lock lock(mutex);
+
+		if(data_size > max_size || entries_map.find(hash) != entries_map.end()) {
+			return;
+		}
+
+		while(size + data_size > max_size) {
+			Entry& last = entries.back();
+			size -= last.data.size();
+			entries_map.erase(last.hash);
+			entries.pop_back();
+		}
+
+		entries.push_front(Entry());
+		Entry& entry = entries.front();
+		entry.hash = hash;
+		entry.data.resize(data_size);
+		if(data_size) {
+			memcpy(&entry.data[0], data, data_size);
+		}
+		entries_map[hash] = entries.begin();
+		size += data_size;
+	}
+
+protected:
+	struct Entry {
+		string hash;
+		vector<uint8_t> data;
+	};
+
+	list<Entry> entries;
+	map<string, list<Entry>::iterator> entries_map;
+	size_t size;
+	size_t max_size;
+	thread_mutex mutex;
+};
+
 /* Common netowrk error function / object for both DeviceNetwork and DeviceServer*/
 class NetworkError {
 public:
@@ -186,16 +278,45 @@ public:
 		sent = true;
 	}
 
+	/* Buffers are sent as a sequence of chunks, each preceded by its size
+	 * and compressed size. Chunks which don't compress are sent as is and
+	 * have compressed size zero. */
 	void write_buffer(void *buffer, size_t size)
 	{
 		boost::system::error_code error;
 
-		boost::asio::write(socket,
-			boost::asio::buffer(buffer, size),
-			boost::asio::transfer_all(), error);
+		const uint8_t *data = (const uint8_t*)buffer;
+		vector<uint8_t> compressed(compressBound(NETWORK_CHUNK_SIZE));
 
-		if(error.value())
-			error_func->network_error(error.message());
+		for(size_t offset = 0; offset < size; offset += NETWORK_CHUNK_SIZE) {
+			size_t chunk_size = (size - offset < NETWORK_CHUNK_SIZE)? size - offset: NETWORK_CHUNK_SIZE;
+			uLongf compressed_size = compressed.size();
+
+			uint32_t header[2] = {(uint32_t)chunk_size, 0};
+			const uint8_t *chunk_data = data + offset;
+
+			/* Fastest compression level, network is the bottleneck only for
+			 * data which compresses well anyway. */
+			if(compress2(&compressed[0], &compressed_size,
+			             chunk_data, chunk_size, 1) == Z_OK &&
+			   compressed_size < chunk_size)
+			{
+				header[1] = (uint32_t)compressed_size;
+				chunk_data = &compressed[0];
+			}
+
+			std::vector<boost::asio::const_buffer> buffers;
+			buffers.push_back(boost::asio::buffer(header, sizeof(header)));
+			buffers.push_back(boost::asio::buffer(chunk_data,
+			                                      (header[1])? header[1]: chunk_size));
+
+			boost::asio::write(socket, buffers, boost::asio::transfer_all(), error);
+
+			if(error.value()) {
+				error_func->network_error(error.message());
+				return;
+			}
+		}
 	}
 
 protected:
@@ -291,17 +412,49 @@ public:
 		*archive & data;
 	}
 
+	/* Read buffer sent with RPCSend::write_buffer(). */
 	void read_buffer(void *buffer, size_t size)
 	{
-		boost::system::error_code error;
-		size_t len = boost::asio::read(socket, boost::asio::buffer(buffer, size), error);
+		uint8_t *data = (uint8_t*)buffer;
+		vector<uint8_t> compressed;
 
-		if(error.value()) {
-			error_func->network_error(error.message());
-		}
+		for(size_t offset = 0; offset < size;) {
+			uint32_t header[2];
+			if(!read_raw(header, sizeof(header))) {
+				return;
+			}
+
+			size_t chunk_size = header[0];
+			size_t compressed_size = header[1];
+
+			if(chunk_size == 0 || chunk_size > size - offset) {
+				error_func->network_error("Network receive error: buffer size doesn't match expected size");
+				return;
+			}
+
+			if(compressed_size == 0) {
+				if(!read_raw(data + offset, chunk_size)) {
+					return;
+				}
+			}
+			else {
+				compressed.resize(compressed_size);
+				if(!read_raw(&compressed[0], compressed_size)) {
+					return;
+				}
+
+				uLongf uncompressed_size = chunk_size;
+				if(uncompress(data + offset, &uncompressed_size,
+				              &compressed[0], compressed_size) != Z_OK ||
+				   uncompressed_size != chunk_size)
+				{
+					error_func->network_error("Network receive error: can't decompress buffer");
+					return;
+				}
+			}
 
-		if(len != size)
-			cout << "Network receive error: buffer size doesn't match expected size\n";
+			offset += chunk_size;
+		}
 	}
 
 	void read(DeviceTask& task)
@@ -331,6 +484,24 @@ public:
 	string name;
 
 protected:
+	bool read_raw(void *buffer, size_t size)
+	{
+		boost::system::error_code error;
+		size_t len = boost::asio::read(socket, boost::asio::buffer(buffer, size), error);
+
+		if(error.value()) {
+			error_func->network_error(error.message());
+			return false;
+		}
+
+		if(len != size) {
+			error_func->network_error("Network receive error: buffer size doesn't match expected size");
+			return false;
+		}
+
+		return true;
+	}
+
 	tcp::socket& socket;
 	string archive_str;
 	istringstream *archive_stream;
@@ -22,6 +22,7 @@
 #include "util/util_function.h"
 #include "util/util_list.h"
 #include "util/util_task.h"
+#include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -75,9 +76,13 @@ public:
 	int pass_stride;
 	int pass_denoising_data;
 	int pass_denoising_clean;
+	/* Render buffers of neighboring frames for temporal denoising, with the
+	 * same layout as the buffers of the denoised tiles. */
+	vector<device_ptr> denoising_frames;
 
 	bool need_finish_queue;
 	bool integrator_branched;
+	bool adaptive_sampling;
 	int2 requested_tile_size;
 protected:
 	double last_update_time;
@@ -675,6 +675,8 @@ void OpenCLDeviceBase::flush_texture_buffers()
 		MemoryManager::BufferDescriptor desc = memory_manager.get_descriptor(slot.name);
 		info.data = desc.offset;
 		info.cl_buffer = desc.device_buffer;
+		info.cache = 0;
+		info.grid_info = 0;
 
 		if(string_startswith(slot.name, "__tex_image")) {
 			device_memory *mem = textures[slot.name];
@@ -241,6 +241,53 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif  /* __KERNEL_CPU__ */
 }
 
+#ifdef __EMBREE__
+/* Intersect a number of coherent rays at once, like camera rays of
+ * neighboring pixels. Embree traces these as packets, which is faster than
+ * tracing them one by one. Rays that miss get prim set to PRIM_NONE. */
+ccl_device_intersect void scene_intersect_stream(KernelGlobals *kg,
+                                                 const Ray *rays,
+                                                 const uint *visibility,
+                                                 Intersection *isects,
+                                                 int num_rays)
+{
+	PROFILING_INIT(kg, PROFILING_INTERSECT);
+
+	kernel_assert(num_rays <= SCENE_INTERSECT_STREAM_SIZE);
+
+	RTCRayHit ray_hits[SCENE_INTERSECT_STREAM_SIZE];
+	int ray_index[SCENE_INTERSECT_STREAM_SIZE];
+	int num_valid = 0;
+
+	for(int i = 0; i < num_rays; i++) {
+		isects[i].t = rays[i].t;
+		isects[i].prim = PRIM_NONE;
+		isects[i].object = OBJECT_NONE;
+
+		if(scene_intersect_valid(&rays[i])) {
+			kernel_embree_setup_rayhit(rays[i], ray_hits[num_valid], visibility[i]);
+			ray_index[num_valid++] = i;
+		}
+	}
+
+	if(num_valid == 0) {
+		return;
+	}
+
+	CCLIntersectContext ctx(kg, CCLIntersectContext::RAY_REGULAR);
+	IntersectContext rtc_ctx(&ctx);
+	rtc_ctx.context.flags = RTC_INTERSECT_CONTEXT_FLAG_COHERENT;
+	rtcIntersect1M(kernel_data.bvh.scene, &rtc_ctx.context, ray_hits, num_valid, sizeof(RTCRayHit));
+
+	for(int i = 0; i < num_valid; i++) {
+		const RTCRayHit& ray_hit = ray_hits[i];
+		if(ray_hit.hit.geomID != RTC_INVALID_GEOMETRY_ID && ray_hit.hit.primID != RTC_INVALID_GEOMETRY_ID) {
+			kernel_embree_convert_hit(kg, &ray_hit.ray, &ray_hit.hit, &isects[ray_index[i]]);
+		}
+	}
+}
+#endif  /* __EMBREE__ */
+
 #ifdef __BVH_LOCAL__
 /* Note: ray is passed by value to work around a possible CUDA compiler bug. */
 ccl_device_intersect bool scene_intersect_local(KernelGlobals *kg,
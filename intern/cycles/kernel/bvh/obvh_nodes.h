@@ -188,6 +188,48 @@ ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict s1,
 	}
 }
 
+#ifdef __KERNEL_AVX2__
+/* Compressed nodes bounds */
+
+ccl_device_inline avxf obvh_compressed_node_bound(const float *ccl_restrict words,
+                                                  const int k)
+{
+	const int axis = k >> 1;
+	const __m128i q = _mm_set_epi32(0,
+	                                0,
+	                                __float_as_int(words[6 + k*2 + 1]),
+	                                __float_as_int(words[6 + k*2 + 0]));
+	const avxf qf = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(q));
+	return madd(qf, avxf(words[3 + axis]), avxf(words[axis]));
+}
+
+/* Child bounds of an aligned node, in the order min x, max x, min y, max y,
+ * min z, max z. Compressed nodes are dequantized here.
+ */
+ccl_device_inline void obvh_aligned_node_bounds(KernelGlobals *ccl_restrict kg,
+                                                const int node_addr,
+                                                avxf bounds[6])
+{
+	const float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_COMPRESSED) {
+		const float4 data[5] = {kernel_tex_fetch(__bvh_nodes, node_addr+1),
+		                        kernel_tex_fetch(__bvh_nodes, node_addr+2),
+		                        kernel_tex_fetch(__bvh_nodes, node_addr+3),
+		                        kernel_tex_fetch(__bvh_nodes, node_addr+4),
+		                        kernel_tex_fetch(__bvh_nodes, node_addr+5)};
+		const float *words = (const float*)data;
+		for(int k = 0; k < 6; k++) {
+			bounds[k] = obvh_compressed_node_bound(words, k);
+		}
+	}
+	else {
+		for(int k = 0; k < 6; k++) {
+			bounds[k] = kernel_tex_fetch_avxf(__bvh_nodes, node_addr+2+k*2);
+		}
+	}
+}
+#endif  /* __KERNEL_AVX2__ */
+
 /* Axis-aligned nodes intersection */
 
 ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
@@ -208,14 +250,15 @@ ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg
                                                   const int node_addr,
                                                   avxf *ccl_restrict dist)
 {
-	const int offset = node_addr + 2;
 #ifdef __KERNEL_AVX2__
-	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x*2), idir.x, org_idir.x);
-	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y*2), idir.y, org_idir.y);
-	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z*2), idir.z, org_idir.z);
-	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x*2), idir.x, org_idir.x);
-	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y*2), idir.y, org_idir.y);
-	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z*2), idir.z, org_idir.z);
+	avxf bounds[6];
+	obvh_aligned_node_bounds(kg, node_addr, bounds);
+	const avxf tnear_x = msub(bounds[near_x], idir.x, org_idir.x);
+	const avxf tnear_y = msub(bounds[near_y], idir.y, org_idir.y);
+	const avxf tnear_z = msub(bounds[near_z], idir.z, org_idir.z);
+	const avxf tfar_x = msub(bounds[far_x], idir.x, org_idir.x);
+	const avxf tfar_y = msub(bounds[far_y], idir.y, org_idir.y);
+	const avxf tfar_z = msub(bounds[far_z], idir.z, org_idir.z);
 
 	const avxf tnear = max4(tnear_x, tnear_y, tnear_z, isect_near);
 	const avxf tfar = min4(tfar_x, tfar_y, tfar_z, isect_far);
@@ -248,14 +291,15 @@ ccl_device_inline int obvh_aligned_node_intersect_robust(
         const float difl,
         avxf *ccl_restrict dist)
 {
-	const int offset = node_addr + 2;
 #ifdef __KERNEL_AVX2__
-	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset + near_x * 2), idir.x, P_idir.x);
-	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset + far_x * 2), idir.x, P_idir.x);
-	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset + near_y * 2), idir.y, P_idir.y);
-	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset + far_y * 2), idir.y, P_idir.y);
-	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset + near_z * 2), idir.z, P_idir.z);
-	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset + far_z * 2), idir.z, P_idir.z);
+	avxf bounds[6];
+	obvh_aligned_node_bounds(kg, node_addr, bounds);
+	const avxf tnear_x = msub(bounds[near_x], idir.x, P_idir.x);
+	const avxf tfar_x = msub(bounds[far_x], idir.x, P_idir.x);
+	const avxf tnear_y = msub(bounds[near_y], idir.y, P_idir.y);
+	const avxf tfar_y = msub(bounds[far_y], idir.y, P_idir.y);
+	const avxf tnear_z = msub(bounds[near_z], idir.z, P_idir.z);
+	const avxf tfar_z = msub(bounds[far_z], idir.z, P_idir.z);
 
 	const float round_down = 1.0f - difl;
 	const float round_up = 1.0f + difl;
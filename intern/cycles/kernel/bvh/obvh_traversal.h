@@ -181,7 +181,10 @@ ccl_device bool BVH_FUNCTION_FULL_NAME(OBVH)(KernelGlobals *kg,
 					}
 					else
 #endif
-					{
+					if(__float_as_uint(inodes.x) & PATH_RAY_NODE_COMPRESSED) {
+						cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr+6);
+					}
+					else {
 						cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr+14);
 					}
 
@@ -83,6 +83,48 @@ ccl_device_inline void qbvh_stack_sort(QBVHStackItem *ccl_restrict s1,
 	if(s3->dist < s2->dist) { qbvh_item_swap(s3, s2); }
 }
 
+/* Compressed nodes bounds */
+
+ccl_device_inline ssef qbvh_compressed_node_bound(const float *ccl_restrict words,
+                                                  const int k)
+{
+	const int axis = k >> 1;
+	const uint q = __float_as_uint(words[6 + k]);
+#ifdef __KERNEL_SSE41__
+	const __m128i qi = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(q));
+#else
+	const __m128i qi = _mm_set_epi32(q >> 24,
+	                                 (q >> 16) & 0xff,
+	                                 (q >> 8) & 0xff,
+	                                 q & 0xff);
+#endif
+	return madd(ssef(qi), ssef(words[3 + axis]), ssef(words[axis]));
+}
+
+/* Child bounds of an aligned node, in the order min x, max x, min y, max y,
+ * min z, max z. Compressed nodes are dequantized here.
+ */
+ccl_device_inline void qbvh_aligned_node_bounds(KernelGlobals *ccl_restrict kg,
+                                                const int node_addr,
+                                                ssef bounds[6])
+{
+	const float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_COMPRESSED) {
+		const float4 data[3] = {kernel_tex_fetch(__bvh_nodes, node_addr+1),
+		                        kernel_tex_fetch(__bvh_nodes, node_addr+2),
+		                        kernel_tex_fetch(__bvh_nodes, node_addr+3)};
+		const float *words = (const float*)data;
+		for(int k = 0; k < 6; k++) {
+			bounds[k] = qbvh_compressed_node_bound(words, k);
+		}
+	}
+	else {
+		for(int k = 0; k < 6; k++) {
+			bounds[k] = kernel_tex_fetch_ssef(__bvh_nodes, node_addr+1+k);
+		}
+	}
+}
+
 /* Axis-aligned nodes intersection */
 
 //ccl_device_inline int qbvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
@@ -104,21 +146,22 @@ static int qbvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
                                                   const int node_addr,
                                                   ssef *ccl_restrict dist)
 {
-	const int offset = node_addr + 1;
+	ssef bounds[6];
+	qbvh_aligned_node_bounds(kg, node_addr, bounds);
 #ifdef __KERNEL_AVX2__
-	const ssef tnear_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x), idir.x, org_idir.x);
-	const ssef tnear_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y), idir.y, org_idir.y);
-	const ssef tnear_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z), idir.z, org_idir.z);
-	const ssef tfar_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x), idir.x, org_idir.x);
-	const ssef tfar_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y), idir.y, org_idir.y);
-	const ssef tfar_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z), idir.z, org_idir.z);
+	const ssef tnear_x = msub(bounds[near_x], idir.x, org_idir.x);
+	const ssef tnear_y = msub(bounds[near_y], idir.y, org_idir.y);
+	const ssef tnear_z = msub(bounds[near_z], idir.z, org_idir.z);
+	const ssef tfar_x = msub(bounds[far_x], idir.x, org_idir.x);
+	const ssef tfar_y = msub(bounds[far_y], idir.y, org_idir.y);
+	const ssef tfar_z = msub(bounds[far_z], idir.z, org_idir.z);
 #else
-	const ssef tnear_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x) - org.x) * idir.x;
-	const ssef tnear_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y) - org.y) * idir.y;
-	const ssef tnear_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z) - org.z) * idir.z;
-	const ssef tfar_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x) - org.x) * idir.x;
-	const ssef tfar_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y) - org.y) * idir.y;
-	const ssef tfar_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z) - org.z) * idir.z;
+	const ssef tnear_x = (bounds[near_x] - org.x) * idir.x;
+	const ssef tnear_y = (bounds[near_y] - org.y) * idir.y;
+	const ssef tnear_z = (bounds[near_z] - org.z) * idir.z;
+	const ssef tfar_x = (bounds[far_x] - org.x) * idir.x;
+	const ssef tfar_y = (bounds[far_y] - org.y) * idir.y;
+	const ssef tfar_z = (bounds[far_z] - org.z) * idir.z;
 #endif
 
 #ifdef __KERNEL_SSE41__
@@ -156,21 +199,22 @@ ccl_device_inline int qbvh_aligned_node_intersect_robust(
         const float difl,
         ssef *ccl_restrict dist)
 {
-	const int offset = node_addr + 1;
+	ssef bounds[6];
+	qbvh_aligned_node_bounds(kg, node_addr, bounds);
 #ifdef __KERNEL_AVX2__
-	const ssef tnear_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x), idir.x, P_idir.x);
-	const ssef tnear_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y), idir.y, P_idir.y);
-	const ssef tnear_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z), idir.z, P_idir.z);
-	const ssef tfar_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x), idir.x, P_idir.x);
-	const ssef tfar_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y), idir.y, P_idir.y);
-	const ssef tfar_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z), idir.z, P_idir.z);
+	const ssef tnear_x = msub(bounds[near_x], idir.x, P_idir.x);
+	const ssef tnear_y = msub(bounds[near_y], idir.y, P_idir.y);
+	const ssef tnear_z = msub(bounds[near_z], idir.z, P_idir.z);
+	const ssef tfar_x = msub(bounds[far_x], idir.x, P_idir.x);
+	const ssef tfar_y = msub(bounds[far_y], idir.y, P_idir.y);
+	const ssef tfar_z = msub(bounds[far_z], idir.z, P_idir.z);
 #else
-	const ssef tnear_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x) - P.x) * idir.x;
-	const ssef tnear_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y) - P.y) * idir.y;
-	const ssef tnear_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z) - P.z) * idir.z;
-	const ssef tfar_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x) - P.x) * idir.x;
-	const ssef tfar_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y) - P.y) * idir.y;
-	const ssef tfar_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z) - P.z) * idir.z;
+	const ssef tnear_x = (bounds[near_x] - P.x) * idir.x;
+	const ssef tnear_y = (bounds[near_y] - P.y) * idir.y;
+	const ssef tnear_z = (bounds[near_z] - P.z) * idir.z;
+	const ssef tfar_x = (bounds[far_x] - P.x) * idir.x;
+	const ssef tfar_y = (bounds[far_y] - P.y) * idir.y;
+	const ssef tfar_z = (bounds[far_z] - P.z) * idir.z;
 #endif
 
 	const float round_down = 1.0f - difl;
@@ -132,7 +132,10 @@ ccl_device uint BVH_FUNCTION_FULL_NAME(QBVH)(KernelGlobals *kg,
 					}
 					else
 #endif
-					{
+					if(__float_as_uint(inodes.x) & PATH_RAY_NODE_COMPRESSED) {
+						cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+4);
+					}
+					else {
 						cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
 					}
 
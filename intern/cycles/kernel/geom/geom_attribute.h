@@ -94,6 +94,36 @@ ccl_device_inline AttributeDescriptor find_attribute(KernelGlobals *kg, const Sh
 	return desc;
 }
 
+/* Float3 attribute value, decoded from compact storage if needed */
+
+ccl_device_inline float attribute_half_to_float(uint h)
+{
+	/* Encoded without denormals, infinity and NaN, see float_to_half(). */
+	uint f = (h & 0x8000) << 16;
+	if(h & 0x7c00) {
+		f |= ((h & 0x7fff) + 0x1c000) << 13;
+	}
+	return __uint_as_float(f);
+}
+
+ccl_device_inline float3 attribute_float3_fetch(KernelGlobals *kg, const AttributeDescriptor desc, int index)
+{
+	if(desc.flags & (ATTR_STORAGE_UNORM16|ATTR_STORAGE_HALF)) {
+		ushort4 v = kernel_tex_fetch(__attributes_ushort4, index);
+
+		if(desc.flags & ATTR_STORAGE_UNORM16) {
+			return make_float3((float)v.x, (float)v.y, (float)v.z) * (1.0f / 65535.0f);
+		}
+		else {
+			return make_float3(attribute_half_to_float(v.x),
+			                   attribute_half_to_float(v.y),
+			                   attribute_half_to_float(v.z));
+		}
+	}
+
+	return float4_to_float3(kernel_tex_fetch(__attributes_float3, index));
+}
+
 /* Transform matrix attribute on meshes */
 
 ccl_device Transform primitive_attribute_matrix(KernelGlobals *kg, const ShaderData *sd, const AttributeDescriptor desc)
@@ -74,15 +74,25 @@ ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3
 	P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
 }
 
+/* Smooth vertex normal, stored either as float4 or octahedral encoded */
+
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals *kg, uint vert)
+{
+	if(kernel_data.bvh.use_packed_normals) {
+		return packed_normal_decode(kernel_tex_fetch(__tri_vnormal_packed, vert));
+	}
+	return float4_to_float3(kernel_tex_fetch(__tri_vnormal, vert));
+}
+
 /* Interpolate smooth vertex normal from vertices */
 
 ccl_device_inline float3 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, int prim, float u, float v)
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-	float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-	float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+	float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+	float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+	float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
 	float3 N = safe_normalize((1.0f - u - v)*n2 + u*n0 + v*n1);
 
@@ -155,14 +165,14 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 		if(dx) *dx = make_float3(0.0f, 0.0f, 0.0f);
 		if(dy) *dy = make_float3(0.0f, 0.0f, 0.0f);
 
-		return float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + sd->prim));
+		return attribute_float3_fetch(kg, desc, desc.offset + sd->prim);
 	}
 	else if(desc.element == ATTR_ELEMENT_VERTEX || desc.element == ATTR_ELEMENT_VERTEX_MOTION) {
 		uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
 
-		float3 f0 = float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.x));
-		float3 f1 = float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.y));
-		float3 f2 = float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.z));
+		float3 f0 = attribute_float3_fetch(kg, desc, desc.offset + tri_vindex.x);
+		float3 f1 = attribute_float3_fetch(kg, desc, desc.offset + tri_vindex.y);
+		float3 f2 = attribute_float3_fetch(kg, desc, desc.offset + tri_vindex.z);
 
 #ifdef __RAY_DIFFERENTIALS__
 		if(dx) *dx = sd->du.dx*f0 + sd->dv.dx*f1 - (sd->du.dx + sd->dv.dx)*f2;
@@ -176,9 +186,9 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 		float3 f0, f1, f2;
 
 		if(desc.element == ATTR_ELEMENT_CORNER) {
-			f0 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 0));
-			f1 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 1));
-			f2 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 2));
+			f0 = attribute_float3_fetch(kg, desc, tri + 0);
+			f1 = attribute_float3_fetch(kg, desc, tri + 1);
+			f2 = attribute_float3_fetch(kg, desc, tri + 2);
 		}
 		else {
 			f0 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 0));
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_ADAPTIVE_SAMPLING_H__
+#define __KERNEL_ADAPTIVE_SAMPLING_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive sampling
+ *
+ * Besides the combined pass, every odd sample is also accumulated (at twice the
+ * weight) into the auxiliary buffer. The difference between the two gives a
+ * per pixel error estimate, see section 2.1 of "A hierarchical automatic
+ * stopping condition for Monte Carlo global illumination". Once it drops below
+ * the threshold, the fourth component of the auxiliary buffer is set to mark
+ * the pixel as converged and the path tracing kernel skips it from then on. */
+
+ccl_device_inline bool kernel_adaptive_pixel_converged(KernelGlobals *kg,
+                                                       ccl_global float *buffer)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer == 0) {
+		return false;
+	}
+	return buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f;
+}
+
+ccl_device_inline ccl_global float *kernel_adaptive_pixel_buffer(KernelGlobals *kg,
+                                                                 ccl_global float *buffer,
+                                                                 int x, int y,
+                                                                 int offset, int stride)
+{
+	int index = offset + x + y*stride;
+	return buffer + index*kernel_data.film.pass_stride;
+}
+
+/* Determine whether the pixel has converged, given the number of samples
+ * accumulated so far. */
+ccl_device void kernel_do_adaptive_stopping(KernelGlobals *kg,
+                                            ccl_global float *buffer,
+                                            int sample)
+{
+	ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+	float4 I = make_float4(buffer[0], buffer[1], buffer[2], buffer[3]);
+	float4 A = make_float4(aux[0], aux[1], aux[2], aux[3]);
+
+	/* A small epsilon is added to the divisor to prevent division by zero. */
+	float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	              (sample * 0.0001f + sqrtf(max(I.x + I.y + I.z, 0.0f)));
+	if(error < kernel_data.integrator.adaptive_threshold * (float)sample) {
+		aux[3] += 1.0f;
+	}
+}
+
+/* Mark the direct neighbors of pixels which are still rendering as not
+ * converged, so that regions next to noisy areas keep being refined too.
+ * Returns true if any pixel in the row still needs samples. */
+ccl_device bool kernel_do_adaptive_filter_x(KernelGlobals *kg,
+                                            ccl_global float *buffer,
+                                            int y,
+                                            int tile_x, int tile_w,
+                                            int offset, int stride)
+{
+	const int aux_offset = kernel_data.film.pass_adaptive_aux_buffer;
+	bool any = false;
+	bool prev = false;
+
+	for(int x = tile_x; x < tile_x + tile_w; x++) {
+		ccl_global float *aux = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride) + aux_offset;
+		if(aux[3] == 0.0f) {
+			any = true;
+			if(x > tile_x && !prev) {
+				ccl_global float *aux_prev = kernel_adaptive_pixel_buffer(kg, buffer, x - 1, y, offset, stride) + aux_offset;
+				aux_prev[3] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				aux[3] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+ccl_device bool kernel_do_adaptive_filter_y(KernelGlobals *kg,
+                                            ccl_global float *buffer,
+                                            int x,
+                                            int tile_y, int tile_h,
+                                            int offset, int stride)
+{
+	const int aux_offset = kernel_data.film.pass_adaptive_aux_buffer;
+	bool any = false;
+	bool prev = false;
+
+	for(int y = tile_y; y < tile_y + tile_h; y++) {
+		ccl_global float *aux = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride) + aux_offset;
+		if(aux[3] == 0.0f) {
+			any = true;
+			if(y > tile_y && !prev) {
+				ccl_global float *aux_prev = kernel_adaptive_pixel_buffer(kg, buffer, x, y - 1, offset, stride) + aux_offset;
+				aux_prev[3] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				aux[3] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+ccl_device_inline void kernel_adaptive_scale_pass(ccl_global float *buffer,
+                                                  int components,
+                                                  float scale)
+{
+	for(int i = 0; i < components; i++) {
+		buffer[i] *= scale;
+	}
+}
+
+/* Pixels that stopped early accumulated fewer samples than the rest of the
+ * tile. Scale them up so that the regular 1/N normalization of the film
+ * gives the correct average for every pixel. */
+ccl_device void kernel_adaptive_post_adjust(KernelGlobals *kg,
+                                            ccl_global float *buffer,
+                                            float sample_multiplier)
+{
+	kernel_adaptive_scale_pass(buffer, 4, sample_multiplier);
+
+#ifdef __PASSES__
+	int flag = kernel_data.film.pass_flag;
+	int light_flag = kernel_data.film.light_pass_flag;
+
+	if(flag & PASSMASK(NORMAL))
+		kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_normal, 3, sample_multiplier);
+	if(flag & PASSMASK(UV))
+		kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_uv, 3, sample_multiplier);
+	if(flag & PASSMASK(MOTION)) {
+		kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_motion, 4, sample_multiplier);
+		kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_motion_weight, 1, sample_multiplier);
+	}
+	if(flag & PASSMASK(RENDER_COST))
+		kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_render_cost, 3, sample_multiplier);
+
+	if(kernel_data.film.cryptomatte_passes) {
+		/* ID and weight pairs, only the weights scale. Every enabled type
+		 * stores depth RGBA layers of two pairs each. */
+		const int num_types = ((kernel_data.film.cryptomatte_passes & CRYPT_OBJECT) != 0) +
+		                      ((kernel_data.film.cryptomatte_passes & CRYPT_MATERIAL) != 0) +
+		                      ((kernel_data.film.cryptomatte_passes & CRYPT_ASSET) != 0);
+		const int num_slots = 2 * kernel_data.film.cryptomatte_depth * num_types;
+		ccl_global float *id_buffer = buffer + kernel_data.film.pass_cryptomatte;
+		for(int slot = 0; slot < num_slots; slot++) {
+			id_buffer[slot * 2 + 1] *= sample_multiplier;
+		}
+	}
+
+	if(kernel_data.film.use_light_pass) {
+		if(light_flag & PASSMASK(DIFFUSE_INDIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_diffuse_indirect, 3, sample_multiplier);
+		if(light_flag & PASSMASK(GLOSSY_INDIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_glossy_indirect, 3, sample_multiplier);
+		if(light_flag & PASSMASK(TRANSMISSION_INDIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_transmission_indirect, 3, sample_multiplier);
+		if(light_flag & PASSMASK(SUBSURFACE_INDIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_subsurface_indirect, 3, sample_multiplier);
+		if(light_flag & PASSMASK(VOLUME_INDIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_volume_indirect, 3, sample_multiplier);
+		if(light_flag & PASSMASK(DIFFUSE_DIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_diffuse_direct, 3, sample_multiplier);
+		if(light_flag & PASSMASK(GLOSSY_DIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_glossy_direct, 3, sample_multiplier);
+		if(light_flag & PASSMASK(TRANSMISSION_DIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_transmission_direct, 3, sample_multiplier);
+		if(light_flag & PASSMASK(SUBSURFACE_DIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_subsurface_direct, 3, sample_multiplier);
+		if(light_flag & PASSMASK(VOLUME_DIRECT))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_volume_direct, 3, sample_multiplier);
+
+		if(light_flag & PASSMASK(EMISSION))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_emission, 3, sample_multiplier);
+		if(light_flag & PASSMASK(BACKGROUND))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_background, 3, sample_multiplier);
+		if(light_flag & PASSMASK(AO))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_ao, 3, sample_multiplier);
+
+		if(light_flag & PASSMASK(DIFFUSE_COLOR))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_diffuse_color, 3, sample_multiplier);
+		if(light_flag & PASSMASK(GLOSSY_COLOR))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_glossy_color, 3, sample_multiplier);
+		if(light_flag & PASSMASK(TRANSMISSION_COLOR))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_transmission_color, 3, sample_multiplier);
+		if(light_flag & PASSMASK(SUBSURFACE_COLOR))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_subsurface_color, 3, sample_multiplier);
+		if(light_flag & PASSMASK(SHADOW))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_shadow, 4, sample_multiplier);
+		if(light_flag & PASSMASK(MIST))
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_mist, 1, sample_multiplier);
+	}
+#endif  /* __PASSES__ */
+
+#ifdef __DENOISING_FEATURES__
+	if(kernel_data.film.pass_denoising_data) {
+		/* Both the means and the E[x^2] terms scale linearly with the sample count. */
+		kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_denoising_data,
+		                           DENOISING_PASS_SIZE_BASE,
+		                           sample_multiplier);
+		if(kernel_data.film.pass_denoising_clean) {
+			kernel_adaptive_scale_pass(buffer + kernel_data.film.pass_denoising_clean,
+			                           DENOISING_PASS_SIZE_CLEAN,
+			                           sample_multiplier);
+		}
+	}
+#endif  /* __DENOISING_FEATURES__ */
+}
+
+CCL_NAMESPACE_END
+
+#endif  /* __KERNEL_ADAPTIVE_SAMPLING_H__ */
@@ -39,7 +39,10 @@
 #include "util/util_simd.h"
 #include "util/util_half.h"
 #include "util/util_types.h"
+#include "util/util_sparse_grid.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
+#include "util/util_time.h"
 
 #define ccl_addr_space
 
@@ -86,6 +86,10 @@ typedef struct KernelGlobals {
 	int2 global_id;
 
 	ProfilingState profiler;
+
+	/* Counters of the current sample for the render cost pass. */
+	uint render_cost_bounces;
+	uint render_cost_shader_evals;
 } KernelGlobals;
 
 #endif  /* __KERNEL_CPU__ */
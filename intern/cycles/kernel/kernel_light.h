@@ -503,6 +503,20 @@ ccl_device float lamp_light_pdf(KernelGlobals *kg, const float3 Ng, const float3
 	return t*t/cos_pi;
 }
 
+/* Probability of picking the lamp, for lamps sampled through the light tree
+ * it depends on the shading point. */
+ccl_device_inline float lamp_light_select_pdf(KernelGlobals *kg, int lamp, LightType type, float3 P)
+{
+#ifdef __LIGHT_TREE__
+	if(kernel_data.integrator.use_light_tree &&
+	   type != LIGHT_DISTANT && type != LIGHT_BACKGROUND)
+	{
+		return light_tree_lamp_pdf(kg, P, lamp);
+	}
+#endif
+	return kernel_data.integrator.pdf_lights;
+}
+
 ccl_device_inline bool lamp_light_sample(KernelGlobals *kg,
                                          int lamp,
                                          float randu, float randv,
@@ -620,7 +634,7 @@ ccl_device_inline bool lamp_light_sample(KernelGlobals *kg,
 		}
 	}
 
-	ls->pdf *= kernel_data.integrator.pdf_lights;
+	ls->pdf *= lamp_light_select_pdf(kg, lamp, type, P);
 
 	return (ls->pdf > 0.0f);
 }
@@ -764,7 +778,7 @@ ccl_device bool lamp_light_eval(KernelGlobals *kg, int lamp, float3 P, float3 D,
 		return false;
 	}
 
-	ls->pdf *= kernel_data.integrator.pdf_lights;
+	ls->pdf *= lamp_light_select_pdf(kg, lamp, type, P);
 
 	return true;
 }
@@ -802,9 +816,38 @@ ccl_device_inline bool triangle_world_space_vertices(KernelGlobals *kg, int obje
 	return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg, const float3 Ng, const float3 I, float t)
+/* Probability density over the area of the triangle of picking it as light,
+ * relative to the center frame vertices for triangles with motion. */
+ccl_device_inline float triangle_light_select_pdf(KernelGlobals *kg,
+                                                  int object,
+                                                  int prim,
+                                                  bool has_motion,
+                                                  const float3 V[3],
+                                                  float3 P)
+{
+#ifdef __LIGHT_TREE__
+	if(kernel_data.integrator.use_light_tree) {
+		float area;
+		if(has_motion) {
+			float3 V_center[3];
+			triangle_world_space_vertices(kg, object, prim, -1.0f, V_center);
+			area = triangle_area(V_center[0], V_center[1], V_center[2]);
+		}
+		else {
+			area = triangle_area(V[0], V[1], V[2]);
+		}
+
+		if(UNLIKELY(area == 0.0f)) {
+			return 0.0f;
+		}
+		return light_tree_triangle_pdf(kg, P, object, prim)/area;
+	}
+#endif
+	return kernel_data.integrator.pdf_triangles;
+}
+
+ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg, const float3 Ng, const float3 I, float t, float pdf)
 {
-	float pdf = kernel_data.integrator.pdf_triangles;
 	float cos_pi = fabsf(dot(Ng, I));
 
 	if(cos_pi == 0.0f)
@@ -829,10 +872,12 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 	const float3 N = cross(e0, e1);
 	const float distance_to_plane = fabsf(dot(N, sd->I * t))/dot(N, N);
 
+	/* sd contains the point on the light source
+	 * calculate Px, the point that we're shading */
+	const float3 Px = sd->P + sd->I * t;
+	const float pdf_triangles = triangle_light_select_pdf(kg, sd->object, sd->prim, has_motion, V, Px);
+
 	if(longest_edge_squared > distance_to_plane*distance_to_plane) {
-		/* sd contains the point on the light source
-		 * calculate Px, the point that we're shading */
-		const float3 Px = sd->P + sd->I * t;
 		const float3 v0_p = V[0] - Px;
 		const float3 v1_p = V[1] - Px;
 		const float3 v2_p = V[2] - Px;
@@ -860,12 +905,12 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 			else {
 				area = 0.5f * len(N);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = area * pdf_triangles;
 			return pdf / solid_angle;
 		}
 	}
 	else {
-		float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+		float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t, pdf_triangles);
 		if(has_motion) {
 			const float	area = 0.5f * len(N);
 			if(UNLIKELY(area == 0.0f)) {
@@ -914,6 +959,8 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 	ls->shader |= SHADER_USE_MIS;
 	ls->type = LIGHT_TRIANGLE;
 
+	const float pdf_triangles = triangle_light_select_pdf(kg, object, prim, has_motion, V, P);
+
 	float distance_to_plane = fabsf(dot(N0, V[0] - P)/dot(N0, N0));
 
 	if(longest_edge_squared > distance_to_plane*distance_to_plane) {
@@ -1001,7 +1048,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 				triangle_world_space_vertices(kg, object, prim, -1.0f, V);
 				area = triangle_area(V[0], V[1], V[2]);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = area * pdf_triangles;
 			ls->pdf = pdf / solid_angle;
 		}
 	}
@@ -1015,7 +1062,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 		ls->P = u * V[0] + v * V[1] + t * V[2];
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
+		ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t, pdf_triangles);
 		if(has_motion && area != 0.0f) {
 			/* scale the PDF.
 			 * area = the area the sample was taken from
@@ -1083,7 +1130,21 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, &randu);
+	int index;
+#ifdef __LIGHT_TREE__
+	if(kernel_data.integrator.use_light_tree) {
+		/* The selection probability depends on the shading point, it is
+		 * evaluated along with the sample on the emitter below. */
+		index = light_tree_sample(kg, P, &randu);
+		if(index == -1) {
+			return false;
+		}
+	}
+	else
+#endif
+	{
+		index = light_distribution_sample(kg, &randu);
+	}
 
 	/* fetch light data */
 	const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(__light_distribution, index);
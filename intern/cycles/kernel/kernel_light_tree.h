@@ -0,0 +1,194 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Hierarchy over the emitters, traversed from the root picking one of the two
+ * children with a probability proportional to their estimated contribution to
+ * the shading point. The estimate is based on the energy, distance and the
+ * orientation bounds of the emitters in the node, as described in
+ * "Importance Sampling of Many Lights with Adaptive Tree Splitting" by
+ * Alejandro Conty Estevez and Christopher Kulla.
+ *
+ * There are separate trees for mesh lights, lamps and distant lamps, the root
+ * to use is picked with fixed probabilities. Every leaf holds one emitter. */
+
+#ifdef __LIGHT_TREE__
+
+ccl_device float light_tree_node_importance(const ccl_global KernelLightTreeNode *knode,
+                                           float3 P)
+{
+	const float energy = knode->bbox_min.w;
+
+	if(knode->is_distant) {
+		return energy;
+	}
+
+	const float3 bbox_min = float4_to_float3(knode->bbox_min);
+	const float3 bbox_max = float4_to_float3(knode->bbox_max);
+	const float3 centroid = 0.5f*(bbox_min + bbox_max);
+	const float radius_squared = 0.25f*len_squared(bbox_max - bbox_min);
+
+	float distance;
+	const float3 D = normalize_len(P - centroid, &distance);
+	const float distance_squared = distance*distance;
+
+	/* Angle between the cone axis and the shading point, reduced by the
+	 * spread of the emitter normals and of the bounding sphere as seen from
+	 * the shading point, gives the smallest angle any emitter can have. */
+	const float theta_o = knode->bbox_max.w;
+	const float theta_e = knode->axis.w;
+	float theta_u = M_PI_F;
+	if(distance_squared > radius_squared) {
+		theta_u = safe_asinf(sqrtf(radius_squared/distance_squared));
+	}
+
+	const float theta = safe_acosf(dot(float4_to_float3(knode->axis), D));
+	const float theta_min = max(theta - theta_o - theta_u, 0.0f);
+
+	if(theta_min >= theta_e) {
+		return 0.0f;
+	}
+
+	/* Don't let the distance go below the size of the node, the emitters
+	 * are spread out over it. */
+	return energy*cosf(theta_min)/max(max(distance_squared, radius_squared), 1e-8f);
+}
+
+ccl_device_inline int light_tree_root_sample(KernelGlobals *kg, float *randu)
+{
+	const float triangle_pdf = kernel_data.integrator.light_tree_triangle_pdf;
+	const float lamp_pdf = kernel_data.integrator.light_tree_lamp_pdf;
+	float r = *randu;
+
+	if(r < triangle_pdf) {
+		*randu = r/triangle_pdf;
+		return kernel_data.integrator.light_tree_triangle_root;
+	}
+	r -= triangle_pdf;
+
+	if(r < lamp_pdf || kernel_data.integrator.light_tree_distant_pdf == 0.0f) {
+		*randu = min(r/lamp_pdf, 1.0f - FLT_EPSILON);
+		return kernel_data.integrator.light_tree_lamp_root;
+	}
+	r -= lamp_pdf;
+
+	const float distant_pdf = kernel_data.integrator.light_tree_distant_pdf;
+	*randu = min(r/distant_pdf, 1.0f - FLT_EPSILON);
+	return kernel_data.integrator.light_tree_distant_root;
+}
+
+ccl_device_inline float light_tree_root_pdf(KernelGlobals *kg, int root)
+{
+	if(root == kernel_data.integrator.light_tree_triangle_root)
+		return kernel_data.integrator.light_tree_triangle_pdf;
+	else if(root == kernel_data.integrator.light_tree_lamp_root)
+		return kernel_data.integrator.light_tree_lamp_pdf;
+	else
+		return kernel_data.integrator.light_tree_distant_pdf;
+}
+
+/* Pick an emitter, returning its index in the light distribution, or -1 if
+ * no emitter can contribute to the shading point. The random number is
+ * rescaled so it can be reused for sampling a point on the emitter. The
+ * probability of the pick is given by light_tree_pdf(). */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu)
+{
+	float r = *randu;
+	int index = light_tree_root_sample(kg, &r);
+	const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+
+	while(!knode->is_leaf) {
+		const int left = index + 1;
+		const int right = knode->child;
+		const ccl_global KernelLightTreeNode *kleft = &kernel_tex_fetch(__light_tree_nodes, left);
+		const ccl_global KernelLightTreeNode *kright = &kernel_tex_fetch(__light_tree_nodes, right);
+
+		const float importance_left = light_tree_node_importance(kleft, P);
+		const float importance_right = light_tree_node_importance(kright, P);
+		const float importance = importance_left + importance_right;
+
+		if(importance == 0.0f) {
+			return -1;
+		}
+
+		const float pdf_left = importance_left/importance;
+		if(r < pdf_left) {
+			r = r/pdf_left;
+			index = left;
+			knode = kleft;
+		}
+		else {
+			r = (r - pdf_left)/(1.0f - pdf_left);
+			index = right;
+			knode = kright;
+		}
+
+		r = min(r, 1.0f - FLT_EPSILON);
+	}
+
+	*randu = r;
+	return knode->child;
+}
+
+/* Probability of light_tree_sample() picking the emitter in the given leaf,
+ * computed by walking up to the root. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, float3 P, int leaf)
+{
+	float pdf = 1.0f;
+	int index = leaf;
+	const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+
+	while(knode->parent != -1) {
+		const int parent = knode->parent;
+		const ccl_global KernelLightTreeNode *kparent = &kernel_tex_fetch(__light_tree_nodes, parent);
+		const int sibling = (index == parent + 1)? kparent->child: parent + 1;
+		const ccl_global KernelLightTreeNode *ksibling = &kernel_tex_fetch(__light_tree_nodes, sibling);
+
+		const float importance = light_tree_node_importance(knode, P);
+		if(importance == 0.0f) {
+			return 0.0f;
+		}
+		pdf *= importance/(importance + light_tree_node_importance(ksibling, P));
+
+		index = parent;
+		knode = kparent;
+	}
+
+	return pdf*light_tree_root_pdf(kg, index);
+}
+
+ccl_device_inline float light_tree_lamp_pdf(KernelGlobals *kg, float3 P, int lamp)
+{
+	return light_tree_pdf(kg, P, kernel_tex_fetch(__light_tree_leaf_map, lamp));
+}
+
+/* Triangle leaves are stored per object, so instances of the same mesh map
+ * to their own leaves. The object entry holds the offset of its block
+ * relative to the mesh triangle offset. */
+ccl_device_inline float light_tree_triangle_pdf(KernelGlobals *kg, float3 P, int object, int prim)
+{
+	const uint offset = kernel_tex_fetch(__light_tree_leaf_map,
+	                                     kernel_data.integrator.num_all_lights + object);
+	const int leaf = kernel_tex_fetch(__light_tree_leaf_map, offset + (uint)prim);
+	return light_tree_pdf(kg, P, leaf);
+}
+
+#endif  /* __LIGHT_TREE__ */
+
+CCL_NAMESPACE_END
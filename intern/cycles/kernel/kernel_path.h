@@ -29,8 +29,10 @@
 
 #include "kernel/kernel_accumulate.h"
 #include "kernel/kernel_shader.h"
+#include "kernel/kernel_light_tree.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #if defined(__VOLUME__) || defined(__SUBSURFACE__)
 #  include "kernel/kernel_volume.h"
@@ -94,6 +96,9 @@ ccl_device_forceinline bool kernel_path_scene_intersect(
 	}
 	L->debug_data.num_ray_bounces++;
 #endif  /* __KERNEL_DEBUG__ */
+#ifdef __KERNEL_CPU__
+	kg->render_cost_bounces++;
+#endif
 
 	return hit;
 }
@@ -576,7 +581,8 @@ ccl_device_forceinline void kernel_path_integrate(
 	Ray *ray,
 	PathRadiance *L,
 	ccl_global float *buffer,
-	ShaderData *emission_sd)
+	ShaderData *emission_sd,
+	const Intersection *camera_isect)
 {
 	PROFILING_INIT(kg, PROFILING_PATH_INTEGRATE);
 
@@ -594,7 +600,20 @@ ccl_device_forceinline void kernel_path_integrate(
 	for(;;) {
 		/* Find intersection with objects in scene. */
 		Intersection isect;
-		bool hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		bool hit;
+
+		if(camera_isect) {
+			/* Camera ray was already traced together with other pixels. */
+			isect = *camera_isect;
+			hit = (isect.prim != PRIM_NONE);
+			camera_isect = NULL;
+#ifdef __KERNEL_DEBUG__
+			L->debug_data.num_ray_bounces++;
+#endif  /* __KERNEL_DEBUG__ */
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		}
 
 		/* Find intersection with lamps and compute emission for MIS. */
 		kernel_path_lamp_emission(kg, state, ray, throughput, &isect, &sd, L);
@@ -739,6 +758,11 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 
 	buffer += index*pass_stride;
 
+	/* Pixel already converged with adaptive sampling. */
+	if(kernel_adaptive_pixel_converged(kg, buffer)) {
+		return;
+	}
+
 	/* Initialize random numbers and sample ray. */
 	uint rng_hash;
 	Ray ray;
@@ -768,11 +792,120 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	                      &ray,
 	                      &L,
 	                      buffer,
-	                      emission_sd);
+	                      emission_sd,
+	                      NULL);
 
 	kernel_write_result(kg, buffer, sample, &L);
 }
 
+#ifdef __EMBREE__
+/* Object that a camera ray hit, used to sort pixels before shading. */
+ccl_device_inline int kernel_path_camera_isect_object(KernelGlobals *kg,
+                                                      const Intersection *isect)
+{
+	if(isect->prim == PRIM_NONE) {
+		return -1;
+	}
+	else if(isect->object != OBJECT_NONE) {
+		return isect->object;
+	}
+	return kernel_tex_fetch(__prim_object, isect->prim);
+}
+
+/* Path trace a span of up to SCENE_INTERSECT_STREAM_SIZE pixels in a row.
+ * Camera rays are intersected together so Embree can trace them as packets,
+ * and pixels are then shaded sorted by the object they hit so that the same
+ * shaders run back to back. */
+ccl_device void kernel_path_trace_stream(KernelGlobals *kg,
+	ccl_global float *buffer,
+	int sample, int x, int y, int num, int offset, int stride)
+{
+	PROFILING_INIT(kg, PROFILING_RAY_SETUP);
+
+	kernel_assert(num <= SCENE_INTERSECT_STREAM_SIZE);
+
+	Ray rays[SCENE_INTERSECT_STREAM_SIZE];
+	PathState states[SCENE_INTERSECT_STREAM_SIZE];
+	uint visibility[SCENE_INTERSECT_STREAM_SIZE];
+	Intersection isects[SCENE_INTERSECT_STREAM_SIZE];
+	int pixel_x[SCENE_INTERSECT_STREAM_SIZE];
+	int order[SCENE_INTERSECT_STREAM_SIZE];
+	int num_rays = 0;
+
+	ShaderDataTinyStorage emission_sd_storage;
+	ShaderData *emission_sd = AS_SHADER_DATA(&emission_sd_storage);
+
+	int pass_stride = kernel_data.film.pass_stride;
+
+	/* Initialize random numbers, sample rays and state. */
+	for(int i = 0; i < num; i++) {
+		ccl_global float *pixel_buffer = buffer + (offset + x + i + y*stride)*pass_stride;
+
+		/* Pixel already converged with adaptive sampling. */
+		if(kernel_adaptive_pixel_converged(kg, pixel_buffer)) {
+			continue;
+		}
+
+		uint rng_hash;
+		Ray *ray = &rays[num_rays];
+
+		kernel_path_trace_setup(kg, sample, x + i, y, &rng_hash, ray);
+
+		if(ray->t == 0.0f) {
+			continue;
+		}
+
+		path_state_init(kg, emission_sd, &states[num_rays], rng_hash, sample, ray);
+		visibility[num_rays] = path_state_ray_visibility(kg, &states[num_rays]);
+		pixel_x[num_rays] = x + i;
+		num_rays++;
+	}
+
+	if(num_rays == 0) {
+		return;
+	}
+
+	scene_intersect_stream(kg, rays, visibility, isects, num_rays);
+
+	/* Insertion sort by hit object, stable so that pixels of the same object
+	 * stay in order. */
+	int objects[SCENE_INTERSECT_STREAM_SIZE];
+
+	for(int i = 0; i < num_rays; i++) {
+		objects[i] = kernel_path_camera_isect_object(kg, &isects[i]);
+
+		int j = i;
+		while(j > 0 && objects[order[j-1]] > objects[i]) {
+			order[j] = order[j-1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	/* Integrate. */
+	for(int j = 0; j < num_rays; j++) {
+		int i = order[j];
+		ccl_global float *pixel_buffer = buffer + (offset + pixel_x[i] + y*stride)*pass_stride;
+
+		float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
+
+		PathRadiance L;
+		path_radiance_init(&L, kernel_data.film.use_light_pass);
+
+		kernel_path_integrate(kg,
+		                      &states[i],
+		                      throughput,
+		                      &rays[i],
+		                      &L,
+		                      pixel_buffer,
+		                      emission_sd,
+		                      &isects[i]);
+
+		kernel_write_result(kg, pixel_buffer, sample, &L);
+	}
+}
+#endif  /* __EMBREE__ */
+
 #endif  /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
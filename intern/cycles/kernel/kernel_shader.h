@@ -1015,6 +1015,9 @@ ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 	ccl_addr_space PathState *state, int path_flag)
 {
 	PROFILING_INIT(kg, PROFILING_SHADER_EVAL);
+#ifdef __KERNEL_CPU__
+	kg->render_cost_shader_evals++;
+#endif
 
 	/* If path is being terminated, we are tracing a shadow ray or evaluating
 	 * emission, then we don't need to store closures. The emission and shadow
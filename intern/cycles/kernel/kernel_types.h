@@ -63,6 +63,9 @@ CCL_NAMESPACE_BEGIN
 
 #define VOLUME_STACK_SIZE		32
 
+/* Number of camera rays traced together on the CPU with Embree. */
+#define SCENE_INTERSECT_STREAM_SIZE 32
+
 /* Split kernel constants */
 #define WORK_POOL_SIZE_GPU 64
 #define WORK_POOL_SIZE_CPU 1
@@ -103,6 +106,7 @@ CCL_NAMESPACE_BEGIN
 #  define __SHADOW_RECORD_ALL__
 #  define __VOLUME_DECOUPLED__
 #  define __VOLUME_RECORD_ALL__
+#  define __LIGHT_TREE__
 #endif  /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -350,34 +354,36 @@ enum PathRayFlag {
 
 	/* Special flag to tag unaligned BVH nodes. */
 	PATH_RAY_NODE_UNALIGNED = (1 << 13),
+	/* Special flag to tag BVH nodes with quantized child bounds. */
+	PATH_RAY_NODE_COMPRESSED = (1 << 14),
 
-	PATH_RAY_ALL_VISIBILITY = ((1 << 14)-1),
+	PATH_RAY_ALL_VISIBILITY = ((1 << 15)-1),
 
 	/* Don't apply multiple importance sampling weights to emission from
 	 * lamp or surface hits, because they were not direct light sampled. */
-	PATH_RAY_MIS_SKIP                    = (1 << 14),
+	PATH_RAY_MIS_SKIP                    = (1 << 15),
 	/* Diffuse bounce earlier in the path, skip SSS to improve performance
 	 * and avoid branching twice with disk sampling SSS. */
-	PATH_RAY_DIFFUSE_ANCESTOR            = (1 << 15),
+	PATH_RAY_DIFFUSE_ANCESTOR            = (1 << 16),
 	/* Single pass has been written. */
-	PATH_RAY_SINGLE_PASS_DONE            = (1 << 16),
+	PATH_RAY_SINGLE_PASS_DONE            = (1 << 17),
 	/* Ray is behind a shadow catcher .*/
-	PATH_RAY_SHADOW_CATCHER              = (1 << 17),
+	PATH_RAY_SHADOW_CATCHER              = (1 << 18),
 	/* Store shadow data for shadow catcher or denoising. */
-	PATH_RAY_STORE_SHADOW_INFO           = (1 << 18),
+	PATH_RAY_STORE_SHADOW_INFO           = (1 << 19),
 	/* Zero background alpha, for camera or transparent glass rays. */
-	PATH_RAY_TRANSPARENT_BACKGROUND      = (1 << 19),
+	PATH_RAY_TRANSPARENT_BACKGROUND      = (1 << 20),
 	/* Terminate ray immediately at next bounce. */
-	PATH_RAY_TERMINATE_IMMEDIATE         = (1 << 20),
+	PATH_RAY_TERMINATE_IMMEDIATE         = (1 << 21),
 	/* Ray is to be terminated, but continue with transparent bounces and
 	 * emission as long as we encounter them. This is required to make the
 	 * MIS between direct and indirect light rays match, as shadow rays go
 	 * through transparent surfaces to reach emisison too. */
-	PATH_RAY_TERMINATE_AFTER_TRANSPARENT = (1 << 21),
+	PATH_RAY_TERMINATE_AFTER_TRANSPARENT = (1 << 22),
 	/* Ray is to be terminated. */
 	PATH_RAY_TERMINATE                   = (PATH_RAY_TERMINATE_IMMEDIATE|PATH_RAY_TERMINATE_AFTER_TRANSPARENT),
 	/* Path and shader is being evaluated for direct lighting emission. */
-	PATH_RAY_EMISSION                    = (1 << 22)
+	PATH_RAY_EMISSION                    = (1 << 23)
 };
 
 /* Closure Label */
@@ -423,6 +429,9 @@ typedef enum PassType {
 #endif
 	PASS_RENDER_TIME,
 	PASS_CRYPTOMATTE,
+	PASS_ADAPTIVE_AUX_BUFFER,
+	PASS_SAMPLE_COUNT,
+	PASS_RENDER_COST,
 	PASS_CATEGORY_MAIN_END = 31,
 
 	PASS_MIST = 32,
@@ -828,6 +837,10 @@ typedef enum AttributeStandard {
 typedef enum AttributeFlag {
 	ATTR_FINAL_SIZE = (1 << 0),
 	ATTR_SUBDIVIDED = (1 << 1),
+	/* Float3 attribute stored in __attributes_ushort4 as 16 bit values in
+	 * the 0..1 range, or as half floats. */
+	ATTR_STORAGE_UNORM16 = (1 << 2),
+	ATTR_STORAGE_HALF = (1 << 3),
 } AttributeFlag;
 
 typedef struct AttributeDescriptor {
@@ -1292,6 +1305,11 @@ typedef struct KernelFilm {
 	int pass_denoising_clean;
 	int denoising_flags;
 
+	int pass_adaptive_aux_buffer;
+	int pass_sample_count;
+	int pass_render_cost;
+	int pad1;
+
 	/* XYZ to rendering color space transform. float4 instead of float3 to
 	 * ensure consistent padding/alignment across devices. */
 	float4 xyz_to_r;
@@ -1395,7 +1413,20 @@ typedef struct KernelIntegrator {
 
 	int max_closures;
 
-	int pad1, pad2, pad3;
+	/* adaptive sampling */
+	int adaptive_min_samples;
+	int adaptive_step;
+	float adaptive_threshold;
+
+	/* light tree */
+	int use_light_tree;
+	int light_tree_triangle_root;
+	int light_tree_lamp_root;
+	int light_tree_distant_root;
+	float light_tree_triangle_pdf;
+	float light_tree_lamp_pdf;
+	float light_tree_distant_pdf;
+	int light_tree_pad;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1418,6 +1449,9 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int bvh_layout;
 	int use_bvh_steps;
+	/* Smooth normals are octahedral encoded in __tri_vnormal_packed. */
+	int use_packed_normals;
+	int pad0;
 
 	/* Embree */
 #ifdef __EMBREE__
@@ -1428,6 +1462,7 @@ typedef struct KernelBVH {
 #else
 	int pad1, pad2;
 #endif
+	int pad3, pad4;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
@@ -1557,6 +1592,25 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+typedef struct KernelLightTreeNode {
+	/* Bounding box of the emitters below the node, with their total energy
+	 * in the w component of the minimum. */
+	float4 bbox_min;
+	/* Spread of the emitter normals around the axis in the w component. */
+	float4 bbox_max;
+	/* Orientation cone axis, with the emission spread in the w component. */
+	float4 axis;
+	/* Index of the right child for inner nodes, the left child directly
+	 * follows its parent. For leaves index into the light distribution. */
+	int child;
+	int parent;
+	int is_leaf;
+	/* Distant lights are infinitely far away, their importance does not
+	 * depend on the shading point. */
+	int is_distant;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
 	int index;
 	float age;
@@ -256,6 +256,20 @@ template<typename T> struct TextureInterpolator  {
 
 	/* ********  3D interpolation ******** */
 
+	static ccl_always_inline float4 read_3d(const TextureInfo& info,
+	                                        const T *data,
+	                                        int x, int y, int z)
+	{
+		/* Sparse grids only store non-empty tiles, empty tiles all point to
+		 * the same tile of zeros. */
+		if(info.grid_info) {
+			const int *tile_offsets = (const int*)info.grid_info;
+			const size_t tile = sparse_grid_tile_index(x, y, z, info.width, info.height);
+			return read(data[tile_offsets[tile] + sparse_grid_voxel_index(x, y, z)]);
+		}
+		return read(data[x + y*info.width + z*info.width*info.height]);
+	}
+
 	static ccl_always_inline float4 interp_3d_closest(const TextureInfo& info,
 	                                                  float x, float y, float z)
 	{
@@ -292,7 +306,7 @@ template<typename T> struct TextureInterpolator  {
 		}
 
 		const T *data = (const T*)info.data;
-		return read(data[ix + iy*width + iz*width*height]);
+		return read_3d(info, data, ix, iy, iz);
 	}
 
 	static ccl_always_inline float4 interp_3d_linear(const TextureInfo& info,
@@ -342,15 +356,15 @@ template<typename T> struct TextureInterpolator  {
 		const T *data = (const T*)info.data;
 		float4 r;
 
-		r  = (1.0f - tz)*(1.0f - ty)*(1.0f - tx)*read(data[ix + iy*width + iz*width*height]);
-		r += (1.0f - tz)*(1.0f - ty)*tx*read(data[nix + iy*width + iz*width*height]);
-		r += (1.0f - tz)*ty*(1.0f - tx)*read(data[ix + niy*width + iz*width*height]);
-		r += (1.0f - tz)*ty*tx*read(data[nix + niy*width + iz*width*height]);
+		r  = (1.0f - tz)*(1.0f - ty)*(1.0f - tx)*read_3d(info, data, ix, iy, iz);
+		r += (1.0f - tz)*(1.0f - ty)*tx*read_3d(info, data, nix, iy, iz);
+		r += (1.0f - tz)*ty*(1.0f - tx)*read_3d(info, data, ix, niy, iz);
+		r += (1.0f - tz)*ty*tx*read_3d(info, data, nix, niy, iz);
 
-		r += tz*(1.0f - ty)*(1.0f - tx)*read(data[ix + iy*width + niz*width*height]);
-		r += tz*(1.0f - ty)*tx*read(data[nix + iy*width + niz*width*height]);
-		r += tz*ty*(1.0f - tx)*read(data[ix + niy*width + niz*width*height]);
-		r += tz*ty*tx*read(data[nix + niy*width + niz*width*height]);
+		r += tz*(1.0f - ty)*(1.0f - tx)*read_3d(info, data, ix, iy, niz);
+		r += tz*(1.0f - ty)*tx*read_3d(info, data, nix, iy, niz);
+		r += tz*ty*(1.0f - tx)*read_3d(info, data, ix, niy, niz);
+		r += tz*ty*tx*read_3d(info, data, nix, niy, niz);
 
 		return r;
 	}
@@ -427,20 +441,14 @@ template<typename T> struct TextureInterpolator  {
 		}
 
 		const int xc[4] = {pix, ix, nix, nnix};
-		const int yc[4] = {width * piy,
-		                   width * iy,
-		                   width * niy,
-		                   width * nniy};
-		const int zc[4] = {width * height * piz,
-		                   width * height * iz,
-		                   width * height * niz,
-		                   width * height * nniz};
+		const int yc[4] = {piy, iy, niy, nniy};
+		const int zc[4] = {piz, iz, niz, nniz};
 		float u[4], v[4], w[4];
 
 		/* Some helper macro to keep code reasonable size,
 		 * let compiler to inline all the matrix multiplications.
 		 */
-#define DATA(x, y, z) (read(data[xc[x] + yc[y] + zc[z]]))
+#define DATA(x, y, z) (read_3d(info, data, xc[x], yc[y], zc[z]))
 #define COL_TERM(col, row) \
 		(v[col] * (u[0] * DATA(0, col, row) + \
 		           u[1] * DATA(1, col, row) + \
@@ -484,10 +492,33 @@ template<typename T> struct TextureInterpolator  {
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
 
+/* Images loaded on demand by the texture cache. The derivatives of the texture
+ * coordinates select the MIP level, only the tiles that are actually hit get
+ * loaded. Without derivatives lookups are done at the finest level. */
+ccl_device float4 kernel_tex_image_interp_cache(const TextureInfo& info,
+                                                float x, float y,
+                                                float2 dx, float2 dy)
+{
+	float r[4];
+	if(!texture_cache_lookup((const TextureCacheImage*)info.cache,
+	                         x, y,
+	                         dx.x, dx.y,
+	                         dy.x, dy.y,
+	                         r))
+	{
+		return make_float4(TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+	}
+	return make_float4(r[0], r[1], r[2], r[3]);
+}
+
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
 
+	if(info.cache) {
+		return kernel_tex_image_interp_cache(info, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
+	}
+
 	switch(kernel_tex_type(id)) {
 		case IMAGE_DATA_TYPE_HALF:
 			return TextureInterpolator<half>::interp(info, x, y);
@@ -511,6 +542,22 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
 	}
 }
 
+/* Lookup with screen space derivatives of the texture coordinates. Only images
+ * in the texture cache are filtered with them, the others are interpolated
+ * from the full resolution pixels as usual. */
+ccl_device float4 kernel_tex_image_interp_deriv(KernelGlobals *kg, int id,
+                                                float x, float y,
+                                                float2 dx, float2 dy)
+{
+	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
+
+	if(info.cache) {
+		return kernel_tex_image_interp_cache(info, x, y, dx, dy);
+	}
+
+	return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg, int id, float x, float y, float z, InterpolationType interp)
 {
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
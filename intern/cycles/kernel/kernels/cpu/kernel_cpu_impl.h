@@ -83,6 +83,13 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #ifdef KERNEL_STUB
 	STUB_ASSERT(KERNEL_ARCH, path_trace);
 #else
+	uint64_t start_cycles = 0;
+	if(kernel_data.film.pass_render_cost) {
+		kg->render_cost_bounces = 0;
+		kg->render_cost_shader_evals = 0;
+		start_cycles = time_cycles();
+	}
+
 #  ifdef __BRANCHED_PATH__
 	if(kernel_data.integrator.branched) {
 		kernel_branched_path_trace(kg,
@@ -97,6 +104,118 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 	{
 		kernel_path_trace(kg, buffer, sample, x, y, offset, stride);
 	}
+
+	if(kernel_data.film.pass_render_cost) {
+		/* Thousands of CPU cycles, bounces and shader evaluations of this
+		 * sample. Divided by the number of samples by the film. */
+		float kilo_cycles = (float)(time_cycles() - start_cycles) * 1e-3f;
+		ccl_global float *pixel_buffer = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride);
+		kernel_write_pass_float3(pixel_buffer + kernel_data.film.pass_render_cost,
+		                         make_float3(kilo_cycles,
+		                                     (float)kg->render_cost_bounces,
+		                                     (float)kg->render_cost_shader_evals));
+	}
+#endif  /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(path_trace_row)(KernelGlobals *kg,
+                                               float *buffer,
+                                               int sample,
+                                               int x, int y, int w,
+                                               int offset,
+                                               int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, path_trace_row);
+#else
+#  ifdef __EMBREE__
+	/* Trace camera rays of the row in packets. Branched path tracing and
+	 * the render cost pass still need one pixel at a time. */
+	if(kernel_data.bvh.scene &&
+	   !kernel_data.integrator.branched &&
+	   !kernel_data.film.pass_render_cost)
+	{
+		for(int i = 0; i < w; i += SCENE_INTERSECT_STREAM_SIZE) {
+			kernel_path_trace_stream(kg,
+			                         buffer,
+			                         sample,
+			                         x + i, y,
+			                         min(w - i, SCENE_INTERSECT_STREAM_SIZE),
+			                         offset,
+			                         stride);
+		}
+		return;
+	}
+#  endif
+	for(int i = 0; i < w; i++) {
+		KERNEL_FUNCTION_FULL_NAME(path_trace)(kg, buffer, sample, x + i, y, offset, stride);
+	}
+#endif  /* KERNEL_STUB */
+}
+
+/* Adaptive Sampling */
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+#else
+	kernel_do_adaptive_stopping(kg,
+	                            kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride),
+	                            sample);
+#endif  /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_x)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int y,
+                                                  int tile_x, int tile_w,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_x);
+	return false;
+#else
+	return kernel_do_adaptive_filter_x(kg, buffer, y, tile_x, tile_w, offset, stride);
+#endif  /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_y)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int x,
+                                                  int tile_y, int tile_h,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_y);
+	return false;
+#else
+	return kernel_do_adaptive_filter_y(kg, buffer, x, tile_y, tile_h, offset, stride);
+#endif  /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int num_samples,
+                                                        int x, int y,
+                                                        int offset,
+                                                        int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+#else
+	ccl_global float *pixel_buffer = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride);
+	float pixel_samples = pixel_buffer[kernel_data.film.pass_sample_count];
+	if(pixel_samples > 0.0f && pixel_samples < (float)num_samples) {
+		kernel_adaptive_post_adjust(kg, pixel_buffer, (float)num_samples / pixel_samples);
+	}
 #endif  /* KERNEL_STUB */
 }
 
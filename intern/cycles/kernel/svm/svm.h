@@ -14,8 +14,8 @@
  * limitations under the License.
  */
 
-#ifndef __SVM_H__
-#define __SVM_H__
+#ifndef __KERNEL_SVM_H__
+#define __KERNEL_SVM_H__
 
 /* Shader Virtual Machine
  *
@@ -277,7 +277,7 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ccl_a
 #  endif  /* NODES_FEATURE(NODE_FEATURE_BUMP) */
 #  ifdef __TEXTURES__
 			case NODE_TEX_IMAGE:
-				svm_node_tex_image(kg, sd, stack, node);
+				svm_node_tex_image(kg, sd, stack, node, &offset);
 				break;
 			case NODE_TEX_IMAGE_BOX:
 				svm_node_tex_image_box(kg, sd, stack, node);
@@ -343,6 +343,9 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ccl_a
 			case NODE_MATH:
 				svm_node_math(kg, sd, stack, node.y, node.z, node.w, &offset);
 				break;
+			case NODE_MATH_SEQ:
+				svm_node_math_seq(kg, sd, stack, node.y, node.z, node.w, &offset);
+				break;
 			case NODE_VECTOR_MATH:
 				svm_node_vector_math(kg, sd, stack, node.y, node.z, node.w, &offset);
 				break;
@@ -497,4 +500,4 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ccl_a
 
 CCL_NAMESPACE_END
 
-#endif  /* __SVM_H__ */
+#endif  /* __KERNEL_SVM_H__ */
@@ -16,9 +16,8 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture_post(KernelGlobals *kg, int id, float4 r, uint srgb, uint use_alpha)
 {
-	float4 r = kernel_tex_image_interp(kg, id, x, y);
 	const float alpha = r.w;
 
 	if(use_alpha && alpha != 1.0f && alpha != 0.0f) {
@@ -40,19 +39,41 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 	return r;
 }
 
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+{
+	float4 r = kernel_tex_image_interp(kg, id, x, y);
+	return svm_image_texture_post(kg, id, r, srgb, use_alpha);
+}
+
+/* Lookup with the screen space derivatives of the texture coordinates, used
+ * for MIP level selection by the texture cache on the CPU. */
+ccl_device float4 svm_image_texture_deriv(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint srgb, uint use_alpha)
+{
+#ifdef __KERNEL_CPU__
+	float4 r = kernel_tex_image_interp_deriv(kg, id, x, y, dx, dy);
+#else
+	float4 r = kernel_tex_image_interp(kg, id, x, y);
+#endif
+	return svm_image_texture_post(kg, id, r, srgb, use_alpha);
+}
+
 /* Remap coordnate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
 	return (co - make_float3(0.5f, 0.5f, 0.5f)) * 2.0f;
 }
 
-ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
+ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
 	uint id = node.y;
 	uint co_offset, out_offset, alpha_offset, srgb;
 
 	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
 
+	/* UV map the texture coordinate comes from unmodified, if known. */
+	uint4 node2 = read_node(kg, offset);
+	uint uv_attr = node2.x;
+
 	float3 co = stack_load_float3(stack, co_offset);
 	float2 tex_co;
 	uint use_alpha = stack_valid(alpha_offset);
@@ -67,7 +88,20 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
 	else {
 		tex_co = make_float2(co.x, co.y);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+
+	float2 dx = make_float2(0.0f, 0.0f);
+	float2 dy = make_float2(0.0f, 0.0f);
+	if(uv_attr != ATTR_STD_NOT_FOUND) {
+		const AttributeDescriptor desc = find_attribute(kg, sd, uv_attr);
+		if(desc.offset != ATTR_STD_NOT_FOUND) {
+			float3 uv_dx, uv_dy;
+			primitive_attribute_float3(kg, sd, desc, &uv_dx, &uv_dy);
+			dx = make_float2(uv_dx.x, uv_dx.y);
+			dy = make_float2(uv_dy.x, uv_dy.y);
+		}
+	}
+
+	float4 f = svm_image_texture_deriv(kg, id, tex_co.x, tex_co.y, dx, dy, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -18,18 +18,39 @@ CCL_NAMESPACE_BEGIN
 
 /* Nodes */
 
-ccl_device void svm_node_math(KernelGlobals *kg, ShaderData *sd, float *stack, uint itype, uint f1_offset, uint f2_offset, int *offset)
+ccl_device void svm_node_math(KernelGlobals *kg, ShaderData *sd, float *stack, uint type_clamp, uint f1_offset, uint f2_offset, int *offset)
 {
-	NodeMath type = (NodeMath)itype;
-	float f1 = stack_load_float(stack, f1_offset);
-	float f2 = stack_load_float(stack, f2_offset);
-	float f = svm_math(type, f1, f2);
+	uint type, use_clamp;
+	decode_node_uchar4(type_clamp, &type, &use_clamp, NULL, NULL);
 
 	uint4 node1 = read_node(kg, offset);
 
+	float f1 = stack_load_float_default(stack, f1_offset, node1.z);
+	float f2 = stack_load_float_default(stack, f2_offset, node1.w);
+	float f = svm_math((NodeMath)type, f1, f2);
+
+	if(use_clamp)
+		f = saturate(f);
+
 	stack_store_float(stack, node1.y, f);
 }
 
+/* Run of consecutive math nodes, the number of nodes is stored in the third
+ * byte of the first header. The nodes following the first one are regular
+ * math nodes which are executed here directly. */
+ccl_device void svm_node_math_seq(KernelGlobals *kg, ShaderData *sd, float *stack, uint type_clamp_count, uint f1_offset, uint f2_offset, int *offset)
+{
+	uint count;
+	decode_node_uchar4(type_clamp_count, NULL, NULL, &count, NULL);
+
+	svm_node_math(kg, sd, stack, type_clamp_count, f1_offset, f2_offset, offset);
+
+	for(uint i = 1; i < count; i++) {
+		uint4 node = read_node(kg, offset);
+		svm_node_math(kg, sd, stack, node.y, node.z, node.w, offset);
+	}
+}
+
 ccl_device void svm_node_vector_math(KernelGlobals *kg, ShaderData *sd, float *stack, uint itype, uint v1_offset, uint v2_offset, int *offset)
 {
 	NodeVectorMath type = (NodeVectorMath)itype;
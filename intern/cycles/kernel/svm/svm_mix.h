@@ -23,10 +23,16 @@ ccl_device void svm_node_mix(KernelGlobals *kg, ShaderData *sd, float *stack, ui
 	/* read extra data */
 	uint4 node1 = read_node(kg, offset);
 
-	float fac = stack_load_float(stack, fac_offset);
+	uint type, use_clamp;
+	decode_node_uchar4(node1.y, &type, &use_clamp, NULL, NULL);
+
+	float fac = stack_load_float_default(stack, fac_offset, node1.w);
 	float3 c1 = stack_load_float3(stack, c1_offset);
 	float3 c2 = stack_load_float3(stack, c2_offset);
-	float3 result = svm_mix((NodeMix)node1.y, fac, c1, c2);
+	float3 result = svm_mix((NodeMix)type, fac, c1, c2);
+
+	if(use_clamp)
+		result = svm_mix_clamp(result);
 
 	stack_store_float3(stack, node1.z, result);
 }
@@ -137,6 +137,7 @@ typedef enum ShaderNodeType {
 	NODE_VECTOR_DISPLACEMENT,
 	NODE_PRINCIPLED_VOLUME,
 	NODE_IES,
+	NODE_MATH_SEQ,
 } ShaderNodeType;
 
 typedef enum NodeAttributeType {
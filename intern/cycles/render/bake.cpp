@@ -20,6 +20,7 @@
 #include "render/shader.h"
 #include "render/integrator.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 
 CCL_NAMESPACE_BEGIN
@@ -136,96 +137,261 @@ void BakeManager::set_shader_limit(const size_t x, const size_t y)
 	m_shader_limit = (size_t)pow(2, ceil(log(m_shader_limit)/log(2)));
 }
 
+/* Contiguous range of pixels of one bake data, stored at buffer_offset in
+ * the job buffers. The kernel seeds the random numbers of every pixel with
+ * its index in the bake data, so each range is evaluated by its own device
+ * task with the offset between both indices. */
+struct BakeSegment {
+	size_t data_index;
+	size_t pixel_offset;
+	size_t buffer_offset;
+	size_t size;
+};
+
+/* Pixels of one shader evaluation job. Jobs are filled with ranges of as
+ * many objects as fit in the shader limit. Invalid pixels at the start and
+ * end of a range are trimmed, and ranges without valid pixels are skipped
+ * entirely. All objects of a job use the same number of AA samples. */
+struct BakeJob {
+	BakeJob(Device *device)
+	: input(device, "bake_input", MEM_READ_ONLY),
+	  output(device, "bake_output", MEM_READ_WRITE),
+	  size(0),
+	  num_samples(0)
+	{
+	}
+
+	device_vector<uint4> input;
+	device_vector<float4> output;
+	vector<BakeSegment> segments;
+	size_t size;
+	int num_samples;
+
+	void free()
+	{
+		input.free();
+		output.free();
+	}
+};
+
+/* Find the next range of at most limit pixels starting at the cursor, and
+ * advance the cursor past it. Returns false when no pixels are left. */
+static bool bake_job_next_range(BakeData *bake_data,
+                                size_t limit,
+                                size_t *cursor,
+                                size_t *offset,
+                                size_t *size)
+{
+	const size_t num_pixels = bake_data->size();
+
+	while(*cursor < num_pixels) {
+		size_t start = *cursor;
+		size_t end = min(start + limit, num_pixels);
+		*cursor = end;
+
+		while(start < end && !bake_data->is_valid(start))
+			start++;
+		while(end > start && !bake_data->is_valid(end - 1))
+			end--;
+
+		if(start < end) {
+			*offset = start;
+			*size = end - start;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void bake_job_pack(const vector<BakeData*>& bake_datas,
+                          const vector<int>& num_samples,
+                          size_t limit,
+                          size_t *data_cursor,
+                          size_t *pixel_cursor,
+                          BakeJob *job)
+{
+	job->segments.clear();
+	job->size = 0;
+	job->num_samples = 0;
+
+	while(*data_cursor < bake_datas.size() && job->size < limit) {
+		const size_t data_index = *data_cursor;
+
+		if(job->size > 0 && num_samples[data_index] != job->num_samples)
+			break;
+
+		size_t offset, size;
+		if(!bake_job_next_range(bake_datas[data_index], limit - job->size, pixel_cursor, &offset, &size)) {
+			(*data_cursor)++;
+			*pixel_cursor = 0;
+			continue;
+		}
+
+		job->num_samples = num_samples[data_index];
+
+		if(!job->segments.empty() &&
+		   job->segments.back().data_index == data_index &&
+		   job->segments.back().pixel_offset + job->segments.back().size == offset)
+		{
+			job->segments.back().size += size;
+		}
+		else {
+			BakeSegment segment = {data_index, offset, job->size, size};
+			job->segments.push_back(segment);
+		}
+
+		job->size += size;
+	}
+
+	if(job->size == 0)
+		return;
+
+	uint4 *input = job->input.alloc(job->size * 2);
+
+	foreach(const BakeSegment& segment, job->segments) {
+		BakeData *bake_data = bake_datas[segment.data_index];
+
+		for(size_t k = 0; k < segment.size; k++) {
+			const size_t j = segment.buffer_offset + k;
+			input[j * 2] = bake_data->data(segment.pixel_offset + k);
+			input[j * 2 + 1] = bake_data->differentials(segment.pixel_offset + k);
+		}
+	}
+}
+
+static void bake_job_read_result(BakeJob *job,
+                                 const vector<BakeData*>& bake_datas,
+                                 const vector<float*>& results)
+{
+	float4 *output = job->output.data();
+
+	foreach(const BakeSegment& segment, job->segments) {
+		BakeData *bake_data = bake_datas[segment.data_index];
+		float *result = results[segment.data_index];
+
+		for(size_t k = 0; k < segment.size; k++) {
+			size_t i = segment.pixel_offset + k;
+
+			if(!bake_data->is_valid(i))
+				continue;
+
+			float4 out = output[segment.buffer_offset + k];
+			for(size_t j = 0; j < 4; j++) {
+				result[i * 4 + j] = out[j];
+			}
+		}
+	}
+}
+
 bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress, ShaderEvalType shader_type, const int pass_filter, BakeData *bake_data, float result[])
 {
-	size_t num_pixels = bake_data->size();
+	vector<BakeData*> bake_datas(1, bake_data);
+	vector<float*> results(1, result);
 
-	int num_samples = aa_samples(scene, bake_data, shader_type);
+	return bake(device, dscene, scene, progress, shader_type, pass_filter, bake_datas, results);
+}
+
+bool BakeManager::bake(Device *device,
+                       DeviceScene *dscene,
+                       Scene *scene,
+                       Progress& progress,
+                       ShaderEvalType shader_type,
+                       const int pass_filter,
+                       const vector<BakeData*>& bake_datas,
+                       const vector<float*>& results)
+{
+	assert(bake_datas.size() == results.size());
 
 	/* calculate the total pixel samples for the progress bar */
+	vector<int> num_samples(bake_datas.size());
 	total_pixel_samples = 0;
-	for(size_t shader_offset = 0; shader_offset < num_pixels; shader_offset += m_shader_limit) {
-		size_t shader_size = (size_t)fminf(num_pixels - shader_offset, m_shader_limit);
-		total_pixel_samples += shader_size * num_samples;
+
+	for(size_t i = 0; i < bake_datas.size(); i++) {
+		num_samples[i] = aa_samples(scene, bake_datas[i], shader_type);
+
+		size_t cursor = 0, range_offset, range_size;
+		while(bake_job_next_range(bake_datas[i], m_shader_limit, &cursor, &range_offset, &range_size)) {
+			total_pixel_samples += range_size * num_samples[i];
+		}
 	}
 	progress.reset_sample();
 	progress.set_total_pixel_samples(total_pixel_samples);
 
-	/* needs to be up to date for baking specific AA samples */
-	dscene->data.integrator.aa_samples = num_samples;
-	device->const_copy_to("__data", &dscene->data, sizeof(dscene->data));
-
-	for(size_t shader_offset = 0; shader_offset < num_pixels; shader_offset += m_shader_limit) {
-		size_t shader_size = (size_t)fminf(num_pixels - shader_offset, m_shader_limit);
-
-		/* setup input for device task */
-		device_vector<uint4> d_input(device, "bake_input", MEM_READ_ONLY);
-		uint4 *d_input_data = d_input.alloc(shader_size * 2);
-		size_t d_input_size = 0;
+	/* report failure when there are no valid pixels to bake */
+	if(total_pixel_samples == 0) {
+		m_is_baking = false;
+		return false;
+	}
 
-		for(size_t i = shader_offset; i < (shader_offset + shader_size); i++) {
-			d_input_data[d_input_size++] = bake_data->data(i);
-			d_input_data[d_input_size++] = bake_data->differentials(i);
+	/* Two jobs in flight: while the device evaluates one, the next one is
+	 * packed and the results of the previous one are written out. */
+	BakeJob job_a(device), job_b(device);
+	BakeJob *job = &job_a;
+	BakeJob *next_job = &job_b;
+
+	size_t data_cursor = 0, pixel_cursor = 0;
+	bake_job_pack(bake_datas, num_samples, m_shader_limit, &data_cursor, &pixel_cursor, job);
+
+	bool cancel = false;
+
+	while(job->size > 0) {
+		/* needs to be up to date for baking specific AA samples */
+		dscene->data.integrator.aa_samples = job->num_samples;
+		device->const_copy_to("__data", &dscene->data, sizeof(dscene->data));
+
+		/* run device tasks, one per range of pixels */
+		job->output.alloc(job->size);
+		job->output.zero_to_device();
+		job->input.copy_to_device();
+
+		foreach(const BakeSegment& segment, job->segments) {
+			DeviceTask task(DeviceTask::SHADER);
+			task.shader_input = job->input.device_pointer;
+			task.shader_output = job->output.device_pointer;
+			task.shader_eval_type = shader_type;
+			task.shader_filter = pass_filter;
+			task.shader_x = segment.buffer_offset;
+			task.offset = (int)segment.pixel_offset - (int)segment.buffer_offset;
+			task.shader_w = segment.size;
+			task.num_samples = job->num_samples;
+			task.get_cancel = function_bind(&Progress::get_cancel, &progress);
+			task.update_progress_sample = function_bind(&Progress::add_samples_update, &progress, _1, _2);
+
+			device->task_add(task);
 		}
 
-		if(d_input_size == 0) {
-			m_is_baking = false;
-			return false;
+		/* write results of the previous job while this one runs */
+		if(next_job->size > 0) {
+			bake_job_read_result(next_job, bake_datas, results);
+			next_job->size = 0;
 		}
 
-		/* run device task */
-		device_vector<float4> d_output(device, "bake_output", MEM_READ_WRITE);
-		d_output.alloc(shader_size);
-		d_output.zero_to_device();
-		d_input.copy_to_device();
-
-		DeviceTask task(DeviceTask::SHADER);
-		task.shader_input = d_input.device_pointer;
-		task.shader_output = d_output.device_pointer;
-		task.shader_eval_type = shader_type;
-		task.shader_filter = pass_filter;
-		task.shader_x = 0;
-		task.offset = shader_offset;
-		task.shader_w = d_output.size();
-		task.num_samples = num_samples;
-		task.get_cancel = function_bind(&Progress::get_cancel, &progress);
-		task.update_progress_sample = function_bind(&Progress::add_samples_update, &progress, _1, _2);
-
-		device->task_add(task);
+		bake_job_pack(bake_datas, num_samples, m_shader_limit, &data_cursor, &pixel_cursor, next_job);
+
 		device->task_wait();
 
 		if(progress.get_cancel()) {
-			d_input.free();
-			d_output.free();
-			m_is_baking = false;
-			return false;
+			cancel = true;
+			break;
 		}
 
-		d_output.copy_from_device(0, 1, d_output.size());
-		d_input.free();
-
-		/* read result */
-		int k = 0;
+		job->output.copy_from_device(0, 1, job->size);
+		job->input.free();
 
-		float4 *offset = d_output.data();
-
-		size_t depth = 4;
-		for(size_t i=shader_offset; i < (shader_offset + shader_size); i++) {
-			size_t index = i * depth;
-			float4 out = offset[k++];
-
-			if(bake_data->is_valid(i)) {
-				for(size_t j=0; j < 4; j++) {
-					result[index + j] = out[j];
-				}
-			}
-		}
+		swap(job, next_job);
+	}
 
-		d_output.free();
+	/* write results of the last job */
+	if(!cancel && next_job->size > 0) {
+		bake_job_read_result(next_job, bake_datas, results);
 	}
 
+	job_a.free();
+	job_b.free();
+
 	m_is_baking = false;
-	return true;
+	return !cancel;
 }
 
 void BakeManager::device_update(Device * /*device*/,
@@ -65,6 +65,18 @@ public:
 
 	bool bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress, ShaderEvalType shader_type, const int pass_filter, BakeData *bake_data, float result[]);
 
+	/* Bake many objects at once, with the pixels of all objects packed into
+	 * the same shader evaluation jobs. Each result array receives 4 floats
+	 * per pixel of the matching bake data. */
+	bool bake(Device *device,
+	          DeviceScene *dscene,
+	          Scene *scene,
+	          Progress& progress,
+	          ShaderEvalType shader_type,
+	          const int pass_filter,
+	          const vector<BakeData*>& bake_datas,
+	          const vector<float*>& results);
+
 	void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
 
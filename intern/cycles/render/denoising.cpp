@@ -0,0 +1,567 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/denoising.h"
+
+#include "render/buffers.h"
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_foreach.h"
+#include "util/util_image.h"
+#include "util/util_logging.h"
+#include "util/util_map.h"
+#include "util/util_task.h"
+#include "util/util_thread.h"
+#include "util/util_unique_ptr.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Layout of the render buffers that are reconstructed from the images:
+ * the combined pass, followed by the denoising data and optionally the
+ * clean pass, like the buffers of a regular render. */
+#define DENOISE_DATA_OFFSET 4
+#define DENOISE_CLEAN_OFFSET (DENOISE_DATA_OFFSET + DENOISING_PASS_SIZE_BASE)
+
+/* Passes of the denoising data as written by Blender, see
+ * RenderBuffers::get_denoising_pass_rect() for how they are stored. */
+static const struct {
+	const char *name;
+	const char *channels;
+	int offset;
+	/* For variance passes, offset of the pass it is the variance of. */
+	int mean_offset;
+} denoising_passes[] = {
+	{"Denoising Normal",          "XYZ", DENOISING_PASS_NORMAL,     -1},
+	{"Denoising Normal Variance", "XYZ", DENOISING_PASS_NORMAL_VAR, DENOISING_PASS_NORMAL},
+	{"Denoising Albedo",          "RGB", DENOISING_PASS_ALBEDO,     -1},
+	{"Denoising Albedo Variance", "RGB", DENOISING_PASS_ALBEDO_VAR, DENOISING_PASS_ALBEDO},
+	{"Denoising Depth",           "Z",   DENOISING_PASS_DEPTH,      -1},
+	{"Denoising Depth Variance",  "Z",   DENOISING_PASS_DEPTH_VAR,  DENOISING_PASS_DEPTH},
+	{"Denoising Shadow A",        "XYV", DENOISING_PASS_SHADOW_A,   -1},
+	{"Denoising Shadow B",        "XYV", DENOISING_PASS_SHADOW_B,   -1},
+	{"Noisy Image",               "RGB", DENOISING_PASS_COLOR,      -1},
+	{"Denoising Image Variance",  "RGB", DENOISING_PASS_COLOR_VAR,  DENOISING_PASS_COLOR},
+	{"Denoising Clean",           "RGB", DENOISING_PASS_CLEAN,      -1},
+};
+
+/* Render layer of an image, with the image channel of every channel of the
+ * denoising data, or -1 if the image does not contain it. */
+struct DenoiseImageLayer {
+	string name;
+	int input_channels[DENOISING_PASS_SIZE_BASE + DENOISING_PASS_SIZE_CLEAN];
+	/* Channels of the combined pass, which receives the result. */
+	int output_channels[3];
+	int samples;
+	bool has_clean;
+
+	DenoiseImageLayer()
+	{
+		for(int i = 0; i < DENOISING_PASS_SIZE_BASE + DENOISING_PASS_SIZE_CLEAN; i++) {
+			input_channels[i] = -1;
+		}
+		for(int i = 0; i < 3; i++) {
+			output_channels[i] = -1;
+		}
+		samples = 0;
+		has_clean = false;
+	}
+
+	bool is_complete() const
+	{
+		for(int i = 0; i < DENOISING_PASS_SIZE_BASE; i++) {
+			if(input_channels[i] == -1) {
+				return false;
+			}
+		}
+		for(int i = 0; i < 3; i++) {
+			if(output_channels[i] == -1) {
+				return false;
+			}
+		}
+		return samples > 0;
+	}
+};
+
+class DenoiseImage {
+public:
+	int width, height, num_channels;
+	ImageSpec spec;
+	vector<float> pixels;
+	/* Layers which contain all passes needed for denoising. */
+	vector<DenoiseImageLayer> layers;
+
+	bool load(const string& filepath, int default_samples, string& error);
+	bool save(const string& filepath, string& error);
+
+	const DenoiseImageLayer *find_layer(const string& name) const;
+
+	/* Convert between the image and the layout of render buffers. */
+	void read_buffer(const DenoiseImageLayer& layer, float *buffer, int pass_stride) const;
+	void write_buffer(const DenoiseImageLayer& layer, const float *buffer, int pass_stride);
+
+protected:
+	void parse_channels(int default_samples);
+};
+
+/* Split a multilayer EXR channel name of the form "layer.pass.channel".
+ * Layer names may contain dots themselves, so the pass is found by name. */
+static bool split_channel_name(const string& channel_name,
+                               string& layer,
+                               string& pass,
+                               string& channel)
+{
+	size_t channel_start = channel_name.rfind('.');
+	if(channel_start == string::npos) {
+		return false;
+	}
+	channel = channel_name.substr(channel_start + 1);
+	string layer_pass = channel_name.substr(0, channel_start);
+
+	for(int i = -1; i < (int)(sizeof(denoising_passes)/sizeof(*denoising_passes)); i++) {
+		string pass_name = (i == -1)? "Combined": denoising_passes[i].name;
+		if(string_endswith(layer_pass, ("." + pass_name).c_str())) {
+			layer = layer_pass.substr(0, layer_pass.size() - pass_name.size() - 1);
+			pass = pass_name;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void DenoiseImage::parse_channels(int default_samples)
+{
+	map<string, DenoiseImageLayer> image_layers;
+
+	for(int i = 0; i < spec.nchannels; i++) {
+		string layer_name, pass, channel;
+		if(!split_channel_name(spec.channelnames[i], layer_name, pass, channel) ||
+		   channel.size() != 1)
+		{
+			continue;
+		}
+
+		DenoiseImageLayer& layer = image_layers[layer_name];
+		layer.name = layer_name;
+
+		if(pass == "Combined") {
+			const char *rgb = strchr("RGB", channel[0]);
+			if(rgb) {
+				layer.output_channels[rgb - "RGB"] = i;
+			}
+			continue;
+		}
+
+		for(int j = 0; j < (int)(sizeof(denoising_passes)/sizeof(*denoising_passes)); j++) {
+			if(pass == denoising_passes[j].name) {
+				const char *c = strchr(denoising_passes[j].channels, channel[0]);
+				if(c) {
+					layer.input_channels[denoising_passes[j].offset + (c - denoising_passes[j].channels)] = i;
+				}
+			}
+		}
+	}
+
+	for(map<string, DenoiseImageLayer>::iterator it = image_layers.begin(); it != image_layers.end(); it++) {
+		DenoiseImageLayer& layer = it->second;
+
+		/* Blender stores the sample count in the render metadata. */
+		string samples = spec.get_string_attribute("cycles." + layer.name + ".samples");
+		layer.samples = samples.empty()? default_samples: atoi(samples.c_str());
+
+		layer.has_clean = true;
+		for(int i = 0; i < DENOISING_PASS_SIZE_CLEAN; i++) {
+			if(layer.input_channels[DENOISING_PASS_CLEAN + i] == -1) {
+				layer.has_clean = false;
+			}
+		}
+
+		if(layer.is_complete()) {
+			layers.push_back(layer);
+		}
+		else {
+			VLOG(1) << "Skipping layer " << layer.name << ", it does not contain all denoising data.";
+		}
+	}
+}
+
+bool DenoiseImage::load(const string& filepath, int default_samples, string& error)
+{
+	unique_ptr<ImageInput> in(ImageInput::create(filepath));
+	if(!in || !in->open(filepath, spec)) {
+		error = "Couldn't open " + filepath;
+		return false;
+	}
+
+	width = spec.width;
+	height = spec.height;
+	num_channels = spec.nchannels;
+
+	pixels.resize((size_t)width*height*num_channels);
+	if(!in->read_image(TypeDesc::FLOAT, &pixels[0])) {
+		error = "Failed to read " + filepath;
+		return false;
+	}
+	in->close();
+
+	parse_channels(default_samples);
+	if(layers.empty()) {
+		error = filepath + " has no render layers with denoising data";
+		return false;
+	}
+
+	return true;
+}
+
+bool DenoiseImage::save(const string& filepath, string& error)
+{
+	unique_ptr<ImageOutput> out(ImageOutput::create(filepath));
+	if(!out || !out->open(filepath, spec)) {
+		error = "Couldn't create " + filepath;
+		return false;
+	}
+
+	bool ok = out->write_image(TypeDesc::FLOAT, &pixels[0]);
+	out->close();
+
+	if(!ok) {
+		error = "Failed to write " + filepath;
+	}
+	return ok;
+}
+
+const DenoiseImageLayer *DenoiseImage::find_layer(const string& name) const
+{
+	foreach(const DenoiseImageLayer& layer, layers) {
+		if(layer.name == name) {
+			return &layer;
+		}
+	}
+	return NULL;
+}
+
+void DenoiseImage::read_buffer(const DenoiseImageLayer& layer, float *buffer, int pass_stride) const
+{
+	const float samples = layer.samples;
+	const int num_data = DENOISING_PASS_SIZE_BASE + (layer.has_clean? DENOISING_PASS_SIZE_CLEAN: 0);
+
+	for(size_t i = 0; i < (size_t)width*height; i++) {
+		const float *in = &pixels[i*num_channels];
+		float *out = buffer + i*pass_stride;
+
+		/* The combined pass is written by the denoiser. */
+		out[0] = out[1] = out[2] = out[3] = 0.0f;
+
+		for(int j = 0; j < (int)(sizeof(denoising_passes)/sizeof(*denoising_passes)); j++) {
+			int offset = denoising_passes[j].offset;
+			if(offset >= num_data) {
+				continue;
+			}
+
+			for(int c = 0; denoising_passes[j].channels[c]; c++) {
+				float value = in[layer.input_channels[offset + c]];
+				if(denoising_passes[j].mean_offset != -1) {
+					/* Undo the conversion of the sum of squares to the variance. */
+					float mean = in[layer.input_channels[denoising_passes[j].mean_offset + c]];
+					value += mean*mean;
+				}
+				/* Images store averages, the render buffers sums over all samples. */
+				out[DENOISE_DATA_OFFSET + offset + c] = value * samples;
+			}
+		}
+	}
+}
+
+void DenoiseImage::write_buffer(const DenoiseImageLayer& layer, const float *buffer, int pass_stride)
+{
+	const float invsample = 1.0f / layer.samples;
+
+	for(size_t i = 0; i < (size_t)width*height; i++) {
+		const float *in = buffer + i*pass_stride;
+		float *out = &pixels[i*num_channels];
+
+		for(int c = 0; c < 3; c++) {
+			out[layer.output_channels[c]] = in[c] * invsample;
+		}
+	}
+}
+
+/* Denoising of one layer of a frame. The render buffers cover the whole
+ * image, which is handed out in tiles to the device threads. */
+class DenoiseTask {
+public:
+	DenoiseTask(Denoiser *denoiser, int width, int height, int samples)
+	: denoiser(denoiser), width(width), height(height), samples(samples),
+	  buffer(0), next_tile(0)
+	{
+		tile_size = denoiser->tile_size;
+		tiles_x = divide_up(width, tile_size);
+		tiles_y = divide_up(height, tile_size);
+	}
+
+	void run(device_ptr center_buffer, const vector<device_ptr>& frames, int pass_stride, bool has_clean)
+	{
+		buffer = center_buffer;
+
+		DeviceTask task(DeviceTask::RENDER);
+		task.acquire_tile = function_bind(&DenoiseTask::acquire_tile, this, _1, _2);
+		task.release_tile = function_bind(&DenoiseTask::release_tile, this, _1);
+		task.map_neighbor_tiles = function_bind(&DenoiseTask::map_neighbor_tiles, this, _1, _2);
+		task.unmap_neighbor_tiles = function_bind(&DenoiseTask::unmap_neighbor_tiles, this, _1, _2);
+		task.need_finish_queue = false;
+		task.integrator_branched = false;
+		task.requested_tile_size = make_int2(tile_size, tile_size);
+
+		task.denoising_radius = denoiser->radius;
+		task.denoising_strength = denoiser->strength;
+		task.denoising_feature_strength = denoiser->feature_strength;
+		task.denoising_relative_pca = denoiser->relative_pca;
+		task.pass_stride = pass_stride;
+		task.pass_denoising_data = DENOISE_DATA_OFFSET;
+		task.pass_denoising_clean = has_clean? DENOISE_CLEAN_OFFSET: 0;
+		task.denoising_frames = frames;
+
+		denoiser->device->task_add(task);
+		denoiser->device->task_wait();
+	}
+
+protected:
+	Denoiser *denoiser;
+	int width, height, samples;
+	int tile_size, tiles_x, tiles_y;
+	device_ptr buffer;
+
+	thread_mutex tile_mutex;
+	int next_tile;
+
+	void fill_tile(RenderTile& rtile, int px, int py)
+	{
+		if(px >= 0 && py >= 0 && px < width && py < height) {
+			rtile.buffer = buffer;
+			rtile.x = px;
+			rtile.y = py;
+			rtile.w = min(tile_size, width - px);
+			rtile.h = min(tile_size, height - py);
+		}
+		else {
+			rtile.buffer = (device_ptr)NULL;
+			rtile.x = clamp(px, 0, width);
+			rtile.y = clamp(py, 0, height);
+			rtile.w = rtile.h = 0;
+		}
+		rtile.offset = 0;
+		rtile.stride = width;
+		rtile.buffers = NULL;
+	}
+
+	bool acquire_tile(Device * /*tile_device*/, RenderTile& rtile)
+	{
+		thread_scoped_lock tile_lock(tile_mutex);
+
+		if(next_tile == tiles_x*tiles_y) {
+			return false;
+		}
+
+		int tile_index = next_tile++;
+		tile_lock.unlock();
+
+		fill_tile(rtile, (tile_index % tiles_x) * tile_size, (tile_index / tiles_x) * tile_size);
+		rtile.task = RenderTile::DENOISE;
+		rtile.tile_index = tile_index;
+		rtile.start_sample = 0;
+		rtile.num_samples = samples;
+		rtile.sample = samples;
+		rtile.resolution = 1;
+
+		return true;
+	}
+
+	void release_tile(RenderTile& /*rtile*/)
+	{
+	}
+
+	void map_neighbor_tiles(RenderTile *tiles, Device *tile_device)
+	{
+		for(int dy = -1, i = 0; dy <= 1; dy++) {
+			for(int dx = -1; dx <= 1; dx++, i++) {
+				if(i != 4) {
+					fill_tile(tiles[i], tiles[4].x + dx*tile_size, tiles[4].y + dy*tile_size);
+				}
+			}
+		}
+
+		denoiser->device->map_neighbor_tiles(tile_device, tiles);
+
+		/* The denoised result is written back to the original tile. */
+		tiles[9] = tiles[4];
+	}
+
+	void unmap_neighbor_tiles(RenderTile *tiles, Device *tile_device)
+	{
+		denoiser->device->unmap_neighbor_tiles(tile_device, tiles);
+	}
+};
+
+Denoiser::Denoiser(DeviceInfo& device_info)
+: frame_radius(2),
+  samples(0),
+  tile_size(64),
+  radius(8),
+  strength(0.5f),
+  feature_strength(0.5f),
+  relative_pca(false)
+{
+	TaskScheduler::init();
+
+	device = Device::create(device_info, stats, profiler, true);
+
+	DeviceRequestedFeatures req;
+	req.use_denoising = true;
+	device->load_kernels(req);
+}
+
+Denoiser::~Denoiser()
+{
+	delete device;
+	TaskScheduler::exit();
+}
+
+bool Denoiser::run()
+{
+	assert(input.size() == output.size());
+
+	if(device->info.type != DEVICE_CPU) {
+		error = "Temporal denoising is only supported on the CPU";
+		return false;
+	}
+
+	int num_frames = input.size();
+
+	/* Images of the frames within frame_radius of the current one. */
+	map<int, DenoiseImage*> images;
+
+	for(int frame = 0; frame < num_frames; frame++) {
+		int frame_start = max(frame - frame_radius, 0);
+		int frame_end = min(frame + frame_radius, num_frames - 1);
+
+		/* Release the frames that are out of range, and load the new ones. */
+		for(map<int, DenoiseImage*>::iterator it = images.begin(); it != images.end();) {
+			if(it->first < frame_start) {
+				delete it->second;
+				images.erase(it++);
+			}
+			else {
+				it++;
+			}
+		}
+
+		for(int i = frame_start; i <= frame_end; i++) {
+			if(images.count(i)) {
+				continue;
+			}
+
+			DenoiseImage *image = new DenoiseImage();
+			if(!image->load(input[i], samples, error)) {
+				delete image;
+				if(i == frame) {
+					break;
+				}
+				/* Neighbors are optional, the frame is denoised without them. */
+				VLOG(1) << error;
+				error = "";
+				image = NULL;
+			}
+			images[i] = image;
+		}
+
+		DenoiseImage *image = images.count(frame)? images[frame]: NULL;
+		if(!image) {
+			break;
+		}
+
+		VLOG(1) << "Denoising " << input[frame];
+
+		foreach(const DenoiseImageLayer& layer, image->layers) {
+			int pass_stride = DENOISE_DATA_OFFSET + DENOISING_PASS_SIZE_BASE;
+			if(layer.has_clean) {
+				pass_stride += DENOISING_PASS_SIZE_CLEAN;
+			}
+
+			device_vector<float> buffer(device, "denoising render buffer", MEM_READ_WRITE);
+			image->read_buffer(layer, buffer.alloc(image->width*pass_stride, image->height), pass_stride);
+			buffer.copy_to_device();
+
+			/* Neighboring frames need to match the current frame to be usable. */
+			vector<device_vector<float>*> frame_buffers;
+			vector<device_ptr> frames;
+			for(int i = frame_start; i <= frame_end; i++) {
+				DenoiseImage *neighbor = images[i];
+				if(i == frame || !neighbor ||
+				   neighbor->width != image->width || neighbor->height != image->height)
+				{
+					continue;
+				}
+
+				const DenoiseImageLayer *neighbor_layer = neighbor->find_layer(layer.name);
+				if(!neighbor_layer || neighbor_layer->has_clean != layer.has_clean) {
+					continue;
+				}
+
+				/* The passes are turned into sums over all samples, and the
+				 * denoiser divides every frame by the sample count of the
+				 * current one. Frames rendered with a different number of
+				 * samples would be scaled wrong and also have a different noise
+				 * level, so they are not used. */
+				if(neighbor_layer->samples != layer.samples) {
+					VLOG(1) << "Not using " << input[i] << " for layer " << layer.name
+					        << ", it has " << neighbor_layer->samples << " samples instead of "
+					        << layer.samples;
+					continue;
+				}
+
+				device_vector<float> *frame_buffer = new device_vector<float>(device, "denoising frame buffer", MEM_READ_ONLY);
+				neighbor->read_buffer(*neighbor_layer, frame_buffer->alloc(image->width*pass_stride, image->height), pass_stride);
+				frame_buffer->copy_to_device();
+
+				frame_buffers.push_back(frame_buffer);
+				frames.push_back(frame_buffer->device_pointer);
+			}
+
+			DenoiseTask task(this, image->width, image->height, layer.samples);
+			task.run(buffer.device_pointer, frames, pass_stride, layer.has_clean);
+
+			buffer.copy_from_device(0, image->width*pass_stride, image->height);
+			image->write_buffer(layer, buffer.data(), pass_stride);
+
+			foreach(device_vector<float> *frame_buffer, frame_buffers) {
+				delete frame_buffer;
+			}
+		}
+
+		if(!image->save(output[frame], error)) {
+			break;
+		}
+	}
+
+	for(map<int, DenoiseImage*>::iterator it = images.begin(); it != images.end(); it++) {
+		delete it->second;
+	}
+
+	return error.empty();
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DENOISING_H__
+#define __DENOISING_H__
+
+#include "device/device.h"
+
+#include "util/util_profiling.h"
+#include "util/util_string.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Denoiser for frames that were rendered with the denoising data passes
+ * stored in multilayer EXR files. Frames are given in sequence, and their
+ * neighbors within frame_radius are used to denoise them temporally. */
+
+class Denoiser {
+public:
+	explicit Denoiser(DeviceInfo& device_info);
+	~Denoiser();
+
+	bool run();
+
+	/* Error message after running, in case of failure. */
+	string error;
+
+	/* Sequential list of frame filepaths to denoise, and where to write the results. */
+	vector<string> input;
+	vector<string> output;
+
+	/* Number of frames before and after the denoised one to use as well. */
+	int frame_radius;
+	/* Sample count of the frames, for images without render metadata. */
+	int samples;
+	int tile_size;
+
+	/* Equivalent to the settings in the regular denoiser. */
+	int radius;
+	float strength;
+	float feature_strength;
+	bool relative_pca;
+
+protected:
+	friend class DenoiseTask;
+
+	Stats stats;
+	Profiler profiler;
+	Device *device;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __DENOISING_H__ */
@@ -164,6 +164,18 @@ void Pass::add(PassType type, vector<Pass>& passes, const char *name)
 		case PASS_CRYPTOMATTE:
 			pass.components = 4;
 			break;
+		case PASS_ADAPTIVE_AUX_BUFFER:
+			pass.components = 4;
+			break;
+		case PASS_SAMPLE_COUNT:
+			pass.components = 1;
+			pass.exposure = false;
+			pass.filter = false;
+			break;
+		case PASS_RENDER_COST:
+			pass.components = 4;
+			pass.exposure = false;
+			break;
 		default:
 			assert(false);
 			break;
@@ -323,6 +335,10 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 	kfilm->pass_stride = 0;
 	kfilm->use_light_pass = use_light_visibility || use_sample_clamp;
 
+	kfilm->pass_adaptive_aux_buffer = 0;
+	kfilm->pass_sample_count = 0;
+	kfilm->pass_render_cost = 0;
+
 	bool have_cryptomatte = false;
 
 	for(size_t i = 0; i < passes.size(); i++) {
@@ -449,6 +465,15 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 				kfilm->pass_cryptomatte = have_cryptomatte ? min(kfilm->pass_cryptomatte, kfilm->pass_stride) : kfilm->pass_stride;
 				have_cryptomatte = true;
 				break;
+			case PASS_ADAPTIVE_AUX_BUFFER:
+				kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+				break;
+			case PASS_SAMPLE_COUNT:
+				kfilm->pass_sample_count = kfilm->pass_stride;
+				break;
+			case PASS_RENDER_COST:
+				kfilm->pass_render_cost = kfilm->pass_stride;
+				break;
 			default:
 				assert(false);
 				break;
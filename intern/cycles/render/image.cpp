@@ -19,11 +19,15 @@
 #include "render/scene.h"
 #include "render/stats.h"
 
+#include "util/util_atomic.h"
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
+#include "util/util_sparse_grid.h"
+#include "util/util_task.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 #include "util/util_unique_ptr.h"
 
 #ifdef WITH_OSL
@@ -34,20 +38,6 @@ CCL_NAMESPACE_BEGIN
 
 namespace {
 
-/* Some helpers to silence warning in templated function. */
-bool isfinite(uchar /*value*/)
-{
-	return true;
-}
-bool isfinite(half /*value*/)
-{
-	return true;
-}
-bool isfinite(uint16_t  /*value*/)
-{
-	return true;
-}
-
 /* The lower three bits of a device texture slot number indicate its type.
  * These functions convert the slot ids from ImageManager "images" ones
  * to device ones and vice verse.
@@ -88,11 +78,14 @@ ImageManager::ImageManager(const DeviceInfo& info)
 {
 	need_update = true;
 	osl_texture_system = NULL;
+	texture_cache = NULL;
 	animation_frame = 0;
 
 	/* Set image limits */
 	max_num_images = TEX_NUM_MAX;
 	has_half_images = info.has_half_images;
+	has_texture_cache = info.has_texture_cache;
+	has_sparse_volumes = info.has_sparse_volumes;
 
 	for(size_t type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		tex_num_images[type] = 0;
@@ -105,6 +98,8 @@ ImageManager::~ImageManager()
 		for(size_t slot = 0; slot < images[type].size(); slot++)
 			assert(!images[type][slot]);
 	}
+
+	delete texture_cache;
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -297,7 +292,7 @@ int ImageManager::add_image(const string& filename,
                             bool use_alpha,
                             ImageMetaData& metadata)
 {
-	Image *img;
+	ImageManager::Image *img;
 	size_t slot;
 
 	get_image_metadata(filename, builtin_data, metadata);
@@ -453,6 +448,263 @@ void ImageManager::tag_reload_image(const string& filename,
 	}
 }
 
+static ImageInput *image_input_open(const string& filename, bool use_alpha)
+{
+	ImageInput *in = ImageInput::create(filename);
+
+	if(!in)
+		return NULL;
+
+	ImageSpec spec = ImageSpec();
+	ImageSpec config = ImageSpec();
+
+	if(use_alpha == false)
+		config.attribute("oiio:UnassociatedAlpha", 1);
+
+	if(!in->open(filename, spec, config)) {
+		delete in;
+		return NULL;
+	}
+
+	return in;
+}
+
+/* Images with at least this many pixels are decoded in bands of scanlines,
+ * converting every band while the next ones are being decoded. */
+#define IMAGE_LOAD_BAND_MIN_PIXELS (2048*2048)
+#define IMAGE_LOAD_BAND_HEIGHT 256
+/* Number of decoded bands per thread waiting for conversion, for formats
+ * which are decoded serially. */
+#define IMAGE_LOAD_BANDS_PER_THREAD 2
+
+/* Reads pixels from a file or builtin image and converts them to the texture
+ * layout in a single pass: expand to RGBA, convert CMYK, discard unused
+ * alpha and clear non-finite values. */
+template<TypeDesc::BASETYPE FileFormat, typename StorageType>
+class ImageFileLoader {
+public:
+	ImageFileLoader(ImageManager::Image *img, int components, bool is_rgba, StorageType *pixels)
+	: img(img),
+	  width(img->metadata.width),
+	  height(img->metadata.height),
+	  depth(img->metadata.depth),
+	  components(components),
+	  is_rgba(is_rgba),
+	  cmyk(false),
+	  pixels(pixels),
+	  y_offset(0),
+	  failed(0)
+	{
+	}
+
+	/* Returns false if any part of the image failed to decode. */
+	bool load(ImageInput *in)
+	{
+		cmyk = strcmp(in->format_name(), "jpeg") == 0 && components == 4;
+		y_offset = in->spec().y;
+
+		const size_t num_pixels = ((size_t)width) * height;
+
+		if(depth > 1 || num_pixels < IMAGE_LOAD_BAND_MIN_PIXELS) {
+			/* Volumes and small images are read in one go. */
+			load_direct(in);
+		}
+		else {
+			/* Formats with an offset table for scanlines or tiles can be
+			 * decoded in parallel, with a separate file handle per band.
+			 * For others, decoding is serial and only the conversion of
+			 * decoded bands runs in parallel. */
+			const bool random_access = strcmp(in->format_name(), "openexr") == 0 ||
+			                           strcmp(in->format_name(), "tiff") == 0;
+			const int max_bands_in_flight = max(TaskScheduler::num_threads(), 1) *
+			                                IMAGE_LOAD_BANDS_PER_THREAD;
+			int num_bands_in_flight = 0;
+			TaskPool pool;
+
+			for(int y = 0; y < height && !failed; y += IMAGE_LOAD_BAND_HEIGHT) {
+				int y_end = min(y + IMAGE_LOAD_BAND_HEIGHT, height);
+
+				if(random_access) {
+					pool.push(function_bind(&ImageFileLoader::load_band_file, this, y, y_end));
+					continue;
+				}
+
+				/* Bound the memory used by decoded bands when decoding is
+				 * faster than conversion. Waiting on the pool instead of
+				 * blocking keeps this safe when running from a task. */
+				if(num_bands_in_flight == max_bands_in_flight) {
+					pool.wait_work();
+					num_bands_in_flight = 0;
+				}
+
+				vector<StorageType> *band = read_band(in, y, y_end);
+				if(band == NULL) {
+					break;
+				}
+				pool.push(function_bind(&ImageFileLoader::convert_band, this, band, y, y_end));
+				num_bands_in_flight++;
+			}
+
+			pool.wait_work();
+		}
+
+		return !failed;
+	}
+
+	/* Builtin images are written directly to the texture memory, and
+	 * converted in place. */
+	void convert_in_place()
+	{
+		convert(pixels, pixels, ((size_t)width) * height * depth);
+	}
+
+protected:
+	ImageManager::Image *img;
+	int width, height, depth;
+	int components;
+	bool is_rgba;
+	bool cmyk;
+	StorageType *pixels;
+	int y_offset;
+	/* Set atomically by band tasks, checked to stop queuing more work. */
+	uint32_t failed;
+
+	void set_failed(ImageInput *in)
+	{
+		VLOG(1) << "Failed to read image " << img->filename << ": " << in->geterror();
+		atomic_fetch_and_or_uint32(&failed, 1);
+	}
+
+	/* Read the whole image straight into the texture memory and convert in
+	 * place, flipping scanlines so images are stored bottom to top. */
+	void load_direct(ImageInput *in)
+	{
+		const size_t num_pixels = ((size_t)width) * height * depth;
+		vector<StorageType> tmppixels;
+		StorageType *readpixels = pixels;
+		if(components > 4) {
+			tmppixels.resize(num_pixels*components);
+			readpixels = &tmppixels[0];
+		}
+
+		bool ok;
+		if(depth > 1) {
+			ok = in->read_image(FileFormat, (uchar*)readpixels);
+		}
+		else {
+			size_t scanlinesize = ((size_t)width)*components*sizeof(StorageType);
+			ok = in->read_image(FileFormat,
+			                    (uchar*)readpixels + (height-1)*scanlinesize,
+			                    AutoStride,
+			                    -scanlinesize,
+			                    AutoStride);
+		}
+
+		if(!ok) {
+			set_failed(in);
+			return;
+		}
+
+		convert(readpixels, pixels, num_pixels);
+	}
+
+	/* Returns NULL if decoding failed. */
+	vector<StorageType> *read_band(ImageInput *in, int y_start, int y_end)
+	{
+		vector<StorageType> *band = new vector<StorageType>(((size_t)width) * (y_end - y_start) * components);
+		if(!in->read_scanlines(y_offset + y_start, y_offset + y_end, 0, FileFormat, &(*band)[0])) {
+			set_failed(in);
+			delete band;
+			return NULL;
+		}
+		return band;
+	}
+
+	void convert_band(vector<StorageType> *band, int y_start, int y_end)
+	{
+		/* Images are stored bottom to top. */
+		const size_t out_components = is_rgba? 4: 1;
+		for(int y = y_start; y < y_end; y++) {
+			convert(&(*band)[((size_t)width) * (y - y_start) * components],
+			        pixels + ((size_t)width) * (height - 1 - y) * out_components,
+			        width);
+		}
+		delete band;
+	}
+
+	void load_band_file(int y_start, int y_end)
+	{
+		if(failed) {
+			return;
+		}
+
+		unique_ptr<ImageInput> in(image_input_open(img->filename, img->use_alpha));
+		if(!in) {
+			VLOG(1) << "Failed to open image " << img->filename << " for reading band.";
+			atomic_fetch_and_or_uint32(&failed, 1);
+			return;
+		}
+
+		vector<StorageType> *band = read_band(in.get(), y_start, y_end);
+		if(band != NULL) {
+			convert_band(band, y_start, y_end);
+		}
+		in->close();
+	}
+
+	/* RGBA pixels are converted from last to first and single channel ones
+	 * from first to last, so that the conversion can be done in place. */
+	void convert(const StorageType *in, StorageType *out, size_t num_pixels)
+	{
+		const StorageType one = util_image_cast_from_float<StorageType>(1.0f);
+		const StorageType zero = util_image_cast_from_float<StorageType>(0.0f);
+
+		if(!is_rgba) {
+			for(size_t i = 0; i < num_pixels; i++) {
+				StorageType value = in[i*components];
+				out[i] = util_image_is_finite(value)? value: zero;
+			}
+			return;
+		}
+
+		for(size_t i = num_pixels; i-- > 0;) {
+			const StorageType *pixel = in + i*components;
+			StorageType r, g, b, a;
+
+			if(components == 1) {
+				/* grayscale */
+				r = g = b = pixel[0];
+				a = one;
+			}
+			else if(components == 2) {
+				/* grayscale + alpha */
+				r = g = b = pixel[0];
+				a = pixel[1];
+			}
+			else if(components == 3) {
+				/* RGB */
+				r = pixel[0];
+				g = pixel[1];
+				b = pixel[2];
+				a = one;
+			}
+			else {
+				r = pixel[0];
+				g = pixel[1];
+				b = pixel[2];
+				a = pixel[3];
+			}
+
+			util_image_convert_rgba(&r, &g, &b, &a, cmyk, img->use_alpha);
+
+			out[i*4+0] = r;
+			out[i*4+1] = g;
+			out[i*4+2] = b;
+			out[i*4+3] = a;
+		}
+	}
+};
+
 bool ImageManager::file_load_image_generic(Image *img,
                                            unique_ptr<ImageInput> *in)
 {
@@ -466,20 +718,10 @@ bool ImageManager::file_load_image_generic(Image *img,
 		}
 
 		/* load image from file through OIIO */
-		*in = unique_ptr<ImageInput>(ImageInput::create(img->filename));
+		*in = unique_ptr<ImageInput>(image_input_open(img->filename, img->use_alpha));
 
 		if(!*in)
 			return false;
-
-		ImageSpec spec = ImageSpec();
-		ImageSpec config = ImageSpec();
-
-		if(img->use_alpha == false)
-			config.attribute("oiio:UnassociatedAlpha", 1);
-
-		if(!(*in)->open(img->filename, spec, config)) {
-			return false;
-		}
 	}
 	else {
 		/* load image using builtin images callbacks */
@@ -537,40 +779,23 @@ bool ImageManager::file_load_image(Image *img,
 		/* Could be that we've run out of memory. */
 		return false;
 	}
-	bool cmyk = false;
-	const size_t num_pixels = ((size_t)width) * height * depth;
+	/* Check if we actually have a float4 slot, in case components == 1,
+	 * but device doesn't support single channel textures.
+	 */
+	bool is_rgba = (type == IMAGE_DATA_TYPE_FLOAT4 ||
+	                type == IMAGE_DATA_TYPE_HALF4 ||
+	                type == IMAGE_DATA_TYPE_BYTE4 ||
+	                type == IMAGE_DATA_TYPE_USHORT4);
+	ImageFileLoader<FileFormat, StorageType> loader(img, components, is_rgba, pixels);
 	if(in) {
-		StorageType *readpixels = pixels;
-		vector<StorageType> tmppixels;
-		if(components > 4) {
-			tmppixels.resize(((size_t)width)*height*components);
-			readpixels = &tmppixels[0];
-		}
-		if(depth <= 1) {
-			size_t scanlinesize = ((size_t)width)*components*sizeof(StorageType);
-			in->read_image(FileFormat,
-			               (uchar*)readpixels + (height-1)*scanlinesize,
-			               AutoStride,
-			               -scanlinesize,
-			               AutoStride);
-		}
-		else {
-			in->read_image(FileFormat, (uchar*)readpixels);
-		}
-		if(components > 4) {
-			size_t dimensions = ((size_t)width)*height;
-			for(size_t i = dimensions-1, pixel = 0; pixel < dimensions; pixel++, i--) {
-				pixels[i*4+3] = tmppixels[i*components+3];
-				pixels[i*4+2] = tmppixels[i*components+2];
-				pixels[i*4+1] = tmppixels[i*components+1];
-				pixels[i*4+0] = tmppixels[i*components+0];
-			}
-			tmppixels.clear();
-		}
-		cmyk = strcmp(in->format_name(), "jpeg") == 0 && components == 4;
+		const bool loaded = loader.load(in.get());
 		in->close();
+		if(!loaded) {
+			return false;
+		}
 	}
 	else {
+		const size_t num_pixels = ((size_t)width) * height * depth;
 		if(FileFormat == TypeDesc::FLOAT) {
 			builtin_image_float_pixels_cb(img->filename,
 			                              img->builtin_data,
@@ -588,92 +813,7 @@ bool ImageManager::file_load_image(Image *img,
 		else {
 			/* TODO(dingto): Support half for ImBuf. */
 		}
-	}
-	/* Check if we actually have a float4 slot, in case components == 1,
-	 * but device doesn't support single channel textures.
-	 */
-	bool is_rgba = (type == IMAGE_DATA_TYPE_FLOAT4 ||
-	                type == IMAGE_DATA_TYPE_HALF4 ||
-	                type == IMAGE_DATA_TYPE_BYTE4 ||
-					type == IMAGE_DATA_TYPE_USHORT4);
-	if(is_rgba) {
-		const StorageType one = util_image_cast_from_float<StorageType>(1.0f);
-
-		if(cmyk) {
-			/* CMYK */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				float c = util_image_cast_to_float(pixels[i*4+0]);
-				float m = util_image_cast_to_float(pixels[i*4+1]);
-				float y = util_image_cast_to_float(pixels[i*4+2]);
-				float k = util_image_cast_to_float(pixels[i*4+3]);
-				pixels[i*4+0] = util_image_cast_from_float<StorageType>((1.0f - c) * (1.0f - k));
-				pixels[i*4+1] = util_image_cast_from_float<StorageType>((1.0f - m) * (1.0f - k));
-				pixels[i*4+2] = util_image_cast_from_float<StorageType>((1.0f - y) * (1.0f - k));
-				pixels[i*4+3] = one;
-			}
-		}
-		else if(components == 2) {
-			/* grayscale + alpha */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = pixels[i*2+1];
-				pixels[i*4+2] = pixels[i*2+0];
-				pixels[i*4+1] = pixels[i*2+0];
-				pixels[i*4+0] = pixels[i*2+0];
-			}
-		}
-		else if(components == 3) {
-			/* RGB */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = one;
-				pixels[i*4+2] = pixels[i*3+2];
-				pixels[i*4+1] = pixels[i*3+1];
-				pixels[i*4+0] = pixels[i*3+0];
-			}
-		}
-		else if(components == 1) {
-			/* grayscale */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = one;
-				pixels[i*4+2] = pixels[i];
-				pixels[i*4+1] = pixels[i];
-				pixels[i*4+0] = pixels[i];
-			}
-		}
-		if(img->use_alpha == false) {
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = one;
-			}
-		}
-	}
-	/* Make sure we don't have buggy values. */
-	if(FileFormat == TypeDesc::FLOAT) {
-		/* For RGBA buffers we put all channels to 0 if either of them is not
-		 * finite. This way we avoid possible artifacts caused by fully changed
-		 * hue.
-		 */
-		if(is_rgba) {
-			for(size_t i = 0; i < num_pixels; i += 4) {
-				StorageType *pixel = &pixels[i*4];
-				if(!isfinite(pixel[0]) ||
-				   !isfinite(pixel[1]) ||
-				   !isfinite(pixel[2]) ||
-				   !isfinite(pixel[3]))
-				{
-					pixel[0] = 0;
-					pixel[1] = 0;
-					pixel[2] = 0;
-					pixel[3] = 0;
-				}
-			}
-		}
-		else {
-			for(size_t i = 0; i < num_pixels; ++i) {
-				StorageType *pixel = &pixels[i];
-				if(!isfinite(pixel[0])) {
-					pixel[0] = 0;
-				}
-			}
-		}
+		loader.convert_in_place();
 	}
 	/* Scale image down if needed. */
 	if(pixels_storage.size() > 0) {
@@ -708,6 +848,107 @@ bool ImageManager::file_load_image(Image *img,
 	return true;
 }
 
+bool ImageManager::texture_cache_load_image(Device *device,
+                                            Scene *scene,
+                                            Image *img)
+{
+	/* Only image files can be read on demand, builtin images are generated
+	 * or packed and go through the regular path. Scaled down textures are
+	 * also loaded fully, the cache does not know about the texture limit. */
+	if(!scene->params.use_texture_cache || !has_texture_cache ||
+	   img->builtin_data || img->metadata.depth > 1 ||
+	   scene->params.texture_limit > 0)
+	{
+		return false;
+	}
+
+	TextureCacheImage *cache_image;
+
+	{
+		thread_scoped_lock device_lock(device_mutex);
+
+		if(!texture_cache) {
+			texture_cache = new TextureCache(scene->params.texture_cache_size);
+		}
+
+		/* Pick up changes to the file on reload. */
+		texture_cache->invalidate(img->filename);
+		cache_image = texture_cache->get_image(img->filename,
+		                                       img->interpolation,
+		                                       img->extension,
+		                                       img->use_alpha);
+	}
+
+	if(!cache_image) {
+		return false;
+	}
+
+	/* The device only gets a single pixel, lookups go through the cache. */
+	device_vector<float4> *tex_img
+		= new device_vector<float4>(device, img->mem_name.c_str(), MEM_TEXTURE);
+
+	thread_scoped_lock device_lock(device_mutex);
+	float *pixels = (float*)tex_img->alloc(1, 1);
+
+	pixels[0] = TEX_IMAGE_MISSING_R;
+	pixels[1] = TEX_IMAGE_MISSING_G;
+	pixels[2] = TEX_IMAGE_MISSING_B;
+	pixels[3] = TEX_IMAGE_MISSING_A;
+
+	img->mem = tex_img;
+	img->mem->interpolation = img->interpolation;
+	img->mem->extension = img->extension;
+	img->mem->texture_cache_image = cache_image;
+
+	tex_img->copy_to_device();
+
+	return true;
+}
+
+template<typename DeviceType>
+void ImageManager::create_sparse_image(Image *img,
+                                       device_vector<DeviceType>& tex_img)
+{
+	img->grid_offsets.clear();
+
+	const size_t width = tex_img.data_width;
+	const size_t height = tex_img.data_height;
+	const size_t depth = tex_img.data_depth;
+
+	if(!has_sparse_volumes || depth <= 1) {
+		return;
+	}
+
+	vector<DeviceType> sparse_voxels;
+	vector<int> grid_offsets;
+
+	if(!create_sparse_grid(tex_img.data(),
+	                       width, height, depth,
+	                       &sparse_voxels,
+	                       &grid_offsets))
+	{
+		return;
+	}
+
+	VLOG(1) << "Sparse grid for " << img->mem_name << ", "
+	        << string_human_readable_size(tex_img.memory_size()) << " dense, "
+	        << string_human_readable_size(sparse_voxels.size()*sizeof(DeviceType) +
+	                                      grid_offsets.size()*sizeof(int))
+	        << " sparse.";
+
+	thread_scoped_lock device_lock(device_mutex);
+	DeviceType *voxels = tex_img.alloc(sparse_voxels.size());
+	memcpy(voxels, &sparse_voxels[0], sparse_voxels.size()*sizeof(DeviceType));
+
+	/* Lookups still use the dense resolution. */
+	tex_img.data_width = width;
+	tex_img.data_height = height;
+	tex_img.data_depth = depth;
+
+	img->grid_offsets.swap(grid_offsets);
+	tex_img.grid_info = &img->grid_offsets[0];
+}
+
 void ImageManager::device_load_image(Device *device,
                                      Scene *scene,
                                      ImageDataType type,
@@ -739,6 +980,12 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = NULL;
 	}
 
+	/* Load on demand if possible. */
+	if(texture_cache_load_image(device, scene, img)) {
+		img->need_load = false;
+		return;
+	}
+
 	/* Create new texture. */
 	if(type == IMAGE_DATA_TYPE_FLOAT4) {
 		device_vector<float4> *tex_img
@@ -758,6 +1005,9 @@ void ImageManager::device_load_image(Device *device,
 			pixels[2] = TEX_IMAGE_MISSING_B;
 			pixels[3] = TEX_IMAGE_MISSING_A;
 		}
+		else {
+			create_sparse_image(img, *tex_img);
+		}
 
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
@@ -781,6 +1031,9 @@ void ImageManager::device_load_image(Device *device,
 
 			pixels[0] = TEX_IMAGE_MISSING_R;
 		}
+		else {
+			create_sparse_image(img, *tex_img);
+		}
 
 		img->mem = tex_img;
 		img->mem->interpolation = img->interpolation;
@@ -946,6 +1199,10 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 #endif
 		}
 
+		if(img->mem && img->mem->texture_cache_image) {
+			texture_cache->invalidate(img->filename);
+		}
+
 		if(img->mem) {
 			thread_scoped_lock device_lock(device_mutex);
 			delete img->mem;
@@ -32,6 +32,7 @@ class Device;
 class Progress;
 class RenderStats;
 class Scene;
+class TextureCache;
 
 class ImageMetaData {
 public:
@@ -127,6 +128,8 @@ public:
 
 		string mem_name;
 		device_memory *mem;
+		/* Tile offsets of 3D images stored as sparse grid. */
+		vector<int> grid_offsets;
 
 		int users;
 	};
@@ -135,12 +138,15 @@ private:
 	int tex_num_images[IMAGE_DATA_NUM_TYPES];
 	int max_num_images;
 	bool has_half_images;
+	bool has_texture_cache;
+	bool has_sparse_volumes;
 
 	thread_mutex device_mutex;
 	int animation_frame;
 
 	vector<Image*> images[IMAGE_DATA_NUM_TYPES];
 	void *osl_texture_system;
+	TextureCache *texture_cache;
 
 	bool file_load_image_generic(Image *img, unique_ptr<ImageInput> *in);
 
@@ -152,6 +158,14 @@ private:
 	                     int texture_limit,
 	                     device_vector<DeviceType>& tex_img);
 
+	bool texture_cache_load_image(Device *device,
+	                              Scene *scene,
+	                              Image *img);
+
+	template<typename DeviceType>
+	void create_sparse_image(Image *img,
+	                         device_vector<DeviceType>& tex_img);
+
 	void device_load_image(Device *device,
 	                       Scene *scene,
 	                       ImageDataType type,
@@ -67,6 +67,10 @@ NODE_DEFINE(Integrator)
 	SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 	SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+	SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.0f);
 
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
@@ -168,6 +172,21 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 	kintegrator->sampling_pattern = sampling_pattern;
 	kintegrator->aa_samples = aa_samples;
 
+	/* Adaptive sampling, zero values pick a default based on the sample count. */
+	if(adaptive_threshold > 0.0f) {
+		kintegrator->adaptive_threshold = adaptive_threshold;
+	}
+	else {
+		kintegrator->adaptive_threshold = max(0.001f, 1.0f / (float)max(aa_samples, 1));
+	}
+	if(adaptive_min_samples > 0) {
+		kintegrator->adaptive_min_samples = adaptive_min_samples;
+	}
+	else {
+		kintegrator->adaptive_min_samples = max(4, (int)sqrtf((float)aa_samples));
+	}
+	kintegrator->adaptive_step = 4;
+
 	if(light_sampling_threshold > 0.0f) {
 		kintegrator->light_inv_rr_threshold = 1.0f / light_sampling_threshold;
 	}
@@ -232,6 +251,8 @@ void Integrator::tag_update(Scene *scene)
 			break;
 		}
 	}
+	/* Light sampling settings affect the light distribution. */
+	scene->light_manager->tag_update(scene);
 	need_update = true;
 }
 
@@ -68,6 +68,10 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
+	bool use_light_tree;
+
+	int adaptive_min_samples;
+	float adaptive_threshold;
 
 	enum Method {
 		BRANCHED_PATH = 0,
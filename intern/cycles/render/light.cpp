@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -246,10 +247,25 @@ bool LightManager::object_usable_as_light(Object *object) {
 	return false;
 }
 
-void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Scene *scene, Progress& progress)
+void LightManager::device_update_distribution(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Lights", "Computing distribution");
 
+	/* The light tree is not used when sampling all lights, that relies on
+	 * the uniform probabilities of the distribution. */
+	Integrator *integrator = scene->integrator;
+	const bool sample_all_lights = integrator->method == Integrator::BRANCHED_PATH &&
+	                               (integrator->sample_all_lights_direct ||
+	                                integrator->sample_all_lights_indirect);
+	const bool use_light_tree = integrator->use_light_tree &&
+	                            device->info.type == DEVICE_CPU &&
+	                            !sample_all_lights;
+
+	vector<LightTreePrimitive> tree_triangles;
+	vector<LightTreePrimitive> tree_lamps;
+	vector<LightTreePrimitive> tree_distant_lamps;
+	vector<uint> tree_leaf_map;
+
 	/* count */
 	size_t num_lights = 0;
 	size_t num_portals = 0;
@@ -295,6 +311,14 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* Leaf map starts with the lamps followed by one entry per object, which
+	 * points to the block of leaves of the object's triangles. Instances of
+	 * the same mesh get separate blocks, since their triangles are separate
+	 * primitives in the tree. */
+	if(use_light_tree) {
+		tree_leaf_map.resize(num_lights + scene->objects.size(), 0);
+	}
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -330,6 +354,9 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 			use_light_visibility = true;
 		}
 
+		const size_t tree_block_offset = tree_leaf_map.size();
+		bool use_tree_block = false;
+
 		size_t mesh_num_triangles = mesh->num_triangles();
 		for(size_t i = 0; i < mesh_num_triangles; i++) {
 			int shader_index = mesh->shader[i];
@@ -359,9 +386,35 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 				}
 
 				totarea += triangle_area(p1, p2, p3);
+
+				if(use_light_tree) {
+					/* Emission is two sided, only the position matters. */
+					LightTreePrimitive prim;
+					prim.bounds = BoundBox::empty;
+					prim.bounds.grow(p1);
+					prim.bounds.grow(p2);
+					prim.bounds.grow(p3);
+					prim.orientation = LightTreeOrientation(safe_normalize(cross(p2 - p1, p3 - p1)),
+					                                        M_PI_F,
+					                                        M_PI_2_F);
+					prim.energy = triangle_area(p1, p2, p3);
+					prim.distribution_index = offset - 1;
+					prim.map_index = tree_block_offset + i;
+					tree_triangles.push_back(prim);
+					use_tree_block = true;
+				}
 			}
 		}
 
+		if(use_tree_block) {
+			/* The kernel indexes the block with the global triangle index,
+			 * so store the offset relative to the first mesh triangle. This
+			 * wraps around for small offsets, which is fine for unsigned
+			 * arithmetic. */
+			tree_leaf_map[num_lights + j] = (uint)(tree_block_offset - mesh->tri_offset);
+			tree_leaf_map.resize(tree_block_offset + mesh_num_triangles, 0);
+		}
+
 		j++;
 	}
 
@@ -389,6 +442,49 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 			background_mis = light->use_mis;
 		}
 
+		if(use_light_tree) {
+			/* Light strength is defined by the shader, so all lamps get the
+			 * same energy like in the distribution. */
+			LightTreePrimitive prim;
+			prim.bounds = BoundBox::empty;
+			prim.energy = 1.0f;
+			prim.distribution_index = offset;
+			prim.map_index = light_index;
+
+			if(light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND) {
+				prim.bounds.grow(make_float3(0.0f, 0.0f, 0.0f));
+				tree_distant_lamps.push_back(prim);
+			}
+			else {
+				if(light->type == LIGHT_AREA) {
+					float3 axisu = light->axisu*(light->sizeu*light->size);
+					float3 axisv = light->axisv*(light->sizev*light->size);
+					float3 corner = light->co - 0.5f*(axisu + axisv);
+					prim.bounds.grow(corner);
+					prim.bounds.grow(corner + axisu);
+					prim.bounds.grow(corner + axisv);
+					prim.bounds.grow(corner + axisu + axisv);
+					prim.orientation = LightTreeOrientation(safe_normalize(light->dir),
+					                                        0.0f,
+					                                        M_PI_2_F);
+				}
+				else {
+					prim.bounds.grow(light->co, light->size);
+					if(light->type == LIGHT_SPOT) {
+						prim.orientation = LightTreeOrientation(safe_normalize(light->dir),
+						                                        0.0f,
+						                                        min(light->spot_angle*0.5f, M_PI_F));
+					}
+					else {
+						prim.orientation = LightTreeOrientation(make_float3(0.0f, 0.0f, 1.0f),
+						                                        M_PI_F,
+						                                        M_PI_2_F);
+					}
+				}
+				tree_lamps.push_back(prim);
+			}
+		}
+
 		light_index++;
 		offset++;
 	}
@@ -450,6 +546,18 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		/* CDF */
 		dscene->light_distribution.copy_to_device();
 
+		/* Light tree */
+		if(use_light_tree) {
+			device_update_light_tree(dscene,
+			                         tree_triangles,
+			                         tree_lamps,
+			                         tree_distant_lamps,
+			                         tree_leaf_map);
+		}
+		else {
+			device_free_light_tree(dscene);
+		}
+
 		/* Portals */
 		if(num_portals > 0) {
 			kintegrator->portal_offset = light_index;
@@ -475,7 +583,93 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		kintegrator->portal_pdf = 0.0f;
 
 		kfilm->pass_shadow_scale = 1.0f;
+
+		device_free_light_tree(dscene);
+	}
+}
+
+void LightManager::device_update_light_tree(DeviceScene *dscene,
+                                            vector<LightTreePrimitive>& triangles,
+                                            vector<LightTreePrimitive>& lamps,
+                                            vector<LightTreePrimitive>& distant_lamps,
+                                            vector<uint>& leaf_map)
+{
+	KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+	vector<KernelLightTreeNode> nodes;
+	nodes.reserve(2*(triangles.size() + lamps.size() + distant_lamps.size()));
+
+	LightTreeBuilder builder(nodes, leaf_map);
+	const int triangle_root = builder.build(triangles, false);
+	const int lamp_root = builder.build(lamps, false);
+	const int distant_root = builder.build(distant_lamps, true);
+
+	if(nodes.empty()) {
+		device_free_light_tree(dscene);
+		return;
+	}
+
+	/* Same split between triangles and lamps as the distribution, lamps are
+	 * split between the local and distant tree by their count. */
+	const size_t num_lamps = lamps.size() + distant_lamps.size();
+	float triangle_pdf = (triangle_root != -1)? 1.0f: 0.0f;
+	float lamp_group_pdf = 0.0f;
+
+	if(num_lamps > 0) {
+		lamp_group_pdf = 1.0f;
+		if(triangle_root != -1) {
+			triangle_pdf = 0.5f;
+			lamp_group_pdf = 0.5f;
+		}
+	}
+
+	kintegrator->use_light_tree = 1;
+	kintegrator->light_tree_triangle_root = triangle_root;
+	kintegrator->light_tree_lamp_root = lamp_root;
+	kintegrator->light_tree_distant_root = distant_root;
+	kintegrator->light_tree_triangle_pdf = triangle_pdf;
+	kintegrator->light_tree_lamp_pdf = (num_lamps > 0)?
+	        lamp_group_pdf*lamps.size()/num_lamps: 0.0f;
+	kintegrator->light_tree_distant_pdf = (num_lamps > 0)?
+	        lamp_group_pdf*distant_lamps.size()/num_lamps: 0.0f;
+
+	/* Distant lamps and the background are picked uniformly inside their
+	 * tree, so their probability is constant and the regular code paths for
+	 * them keep working. */
+	if(distant_lamps.size() > 0) {
+		kintegrator->pdf_lights = kintegrator->light_tree_distant_pdf/distant_lamps.size();
+	}
+
+	KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(nodes.size());
+	memcpy(knodes, &nodes[0], sizeof(KernelLightTreeNode)*nodes.size());
+	dscene->light_tree_nodes.copy_to_device();
+
+	if(leaf_map.size() > 0) {
+		uint *kleaf_map = dscene->light_tree_leaf_map.alloc(leaf_map.size());
+		memcpy(kleaf_map, &leaf_map[0], sizeof(uint)*leaf_map.size());
+		dscene->light_tree_leaf_map.copy_to_device();
 	}
+
+	VLOG(1) << "Light tree with " << nodes.size() << " nodes, "
+	        << triangles.size() << " triangles, "
+	        << lamps.size() << " lamps and "
+	        << distant_lamps.size() << " distant lamps.";
+}
+
+void LightManager::device_free_light_tree(DeviceScene *dscene)
+{
+	KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+	dscene->light_tree_nodes.free();
+	dscene->light_tree_leaf_map.free();
+
+	kintegrator->use_light_tree = 0;
+	kintegrator->light_tree_triangle_root = -1;
+	kintegrator->light_tree_lamp_root = -1;
+	kintegrator->light_tree_distant_root = -1;
+	kintegrator->light_tree_triangle_pdf = 0.0f;
+	kintegrator->light_tree_lamp_pdf = 0.0f;
+	kintegrator->light_tree_distant_pdf = 0.0f;
 }
 
 static void background_cdf(int start,
@@ -900,6 +1094,8 @@ void LightManager::device_free(Device *, DeviceScene *dscene)
 {
 	dscene->light_distribution.free();
 	dscene->lights.free();
+	dscene->light_tree_nodes.free();
+	dscene->light_tree_leaf_map.free();
 	dscene->light_background_marginal_cdf.free();
 	dscene->light_background_conditional_cdf.free();
 	dscene->ies_lights.free();
@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceScene;
+struct LightTreePrimitive;
 class Object;
 class Progress;
 class Scene;
@@ -122,6 +123,12 @@ protected:
 	                              DeviceScene *dscene,
 	                              Scene *scene,
 	                              Progress& progress);
+	void device_update_light_tree(DeviceScene *dscene,
+	                              vector<LightTreePrimitive>& triangles,
+	                              vector<LightTreePrimitive>& lamps,
+	                              vector<LightTreePrimitive>& distant_lamps,
+	                              vector<uint>& leaf_map);
+	void device_free_light_tree(DeviceScene *dscene);
 	void device_update_ies(DeviceScene *dscene);
 
 	/* Check whether light manager can use the object as a light-emissive. */
@@ -0,0 +1,294 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Number of buckets per axis to evaluate split candidates. */
+#define LIGHT_TREE_NUM_BUCKETS 12
+/* Beyond this depth nodes are split in the middle, to bound the depth. */
+#define LIGHT_TREE_MAX_SAOH_DEPTH 48
+
+/* Orientation */
+
+void LightTreeOrientation::grow(const LightTreeOrientation& other)
+{
+	LightTreeOrientation a = *this;
+	LightTreeOrientation b = other;
+
+	if(b.theta_o > a.theta_o) {
+		swap(a, b);
+	}
+
+	const float theta_d = safe_acosf(dot(a.axis, b.axis));
+	const float theta_e_new = max(a.theta_e, b.theta_e);
+
+	/* Cone of a already contains cone of b. */
+	if(min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+		*this = LightTreeOrientation(a.axis, a.theta_o, theta_e_new);
+		return;
+	}
+
+	const float theta_o_new = 0.5f*(a.theta_o + theta_d + b.theta_o);
+	if(theta_o_new >= M_PI_F) {
+		*this = LightTreeOrientation(a.axis, M_PI_F, theta_e_new);
+		return;
+	}
+
+	/* Rotate the axis of a towards the axis of b. */
+	const float theta_r = theta_o_new - a.theta_o;
+	float3 ortho = b.axis - a.axis*dot(a.axis, b.axis);
+	if(len_squared(ortho) < 1e-12f) {
+		*this = LightTreeOrientation(a.axis, theta_o_new, theta_e_new);
+		return;
+	}
+	ortho = normalize(ortho);
+
+	const float3 axis_new = normalize(a.axis*cosf(theta_r) + ortho*sinf(theta_r));
+	*this = LightTreeOrientation(axis_new, theta_o_new, theta_e_new);
+}
+
+float LightTreeOrientation::measure() const
+{
+	const float theta_w = min(theta_o + theta_e, M_PI_F);
+	const float sin_o = sinf(theta_o);
+	const float cos_o = cosf(theta_o);
+
+	return M_2PI_F*(1.0f - cos_o) +
+	       M_PI_2_F*(2.0f*theta_w*sin_o - cosf(theta_o - 2.0f*theta_w) -
+	                 2.0f*theta_o*sin_o + cos_o);
+}
+
+/* Builder */
+
+namespace {
+
+struct LightTreeBucket {
+	BoundBox bounds;
+	LightTreeOrientation orientation;
+	float energy;
+	int count;
+
+	LightTreeBucket()
+	: bounds(BoundBox::empty), energy(0.0f), count(0) {}
+
+	void grow(const BoundBox& other_bounds,
+	          const LightTreeOrientation& other_orientation,
+	          float other_energy,
+	          int other_count)
+	{
+		if(count == 0) {
+			orientation = other_orientation;
+		}
+		else {
+			orientation.grow(other_orientation);
+		}
+		bounds.grow(other_bounds);
+		energy += other_energy;
+		count += other_count;
+	}
+
+	void grow(const LightTreeBucket& other)
+	{
+		if(other.count > 0) {
+			grow(other.bounds, other.orientation, other.energy, other.count);
+		}
+	}
+
+	float cost() const
+	{
+		return energy*orientation.measure()*bounds.safe_area();
+	}
+};
+
+struct LightTreeCentroidCompare {
+	int dim;
+
+	explicit LightTreeCentroidCompare(int dim) : dim(dim) {}
+
+	bool operator()(const LightTreePrimitive& a, const LightTreePrimitive& b) const
+	{
+		return a.bounds.center()[dim] < b.bounds.center()[dim];
+	}
+};
+
+}  /* namespace */
+
+LightTreeBuilder::LightTreeBuilder(vector<KernelLightTreeNode>& nodes,
+                                   vector<uint>& leaf_map)
+: nodes(nodes),
+  leaf_map(leaf_map),
+  primitives(NULL),
+  is_distant(false)
+{
+}
+
+int LightTreeBuilder::build(vector<LightTreePrimitive>& primitives,
+                            bool is_distant)
+{
+	if(primitives.empty()) {
+		return -1;
+	}
+
+	this->primitives = &primitives;
+	this->is_distant = is_distant;
+
+	return recursive_build(-1, 0, primitives.size(), 0);
+}
+
+int LightTreeBuilder::recursive_build(int parent, int start, int end, int depth)
+{
+	vector<LightTreePrimitive>& prims = *primitives;
+
+	LightTreeBucket node_bounds;
+	for(int i = start; i < end; i++) {
+		node_bounds.grow(prims[i].bounds, prims[i].orientation, prims[i].energy, 1);
+	}
+
+	const int index = nodes.size();
+	nodes.push_back(KernelLightTreeNode());
+
+	KernelLightTreeNode& knode = nodes[index];
+	const BoundBox& bounds = node_bounds.bounds;
+	const LightTreeOrientation& orientation = node_bounds.orientation;
+
+	knode.bbox_min = make_float4(bounds.min.x, bounds.min.y, bounds.min.z, node_bounds.energy);
+	knode.bbox_max = make_float4(bounds.max.x, bounds.max.y, bounds.max.z, orientation.theta_o);
+	knode.axis = make_float4(orientation.axis.x, orientation.axis.y, orientation.axis.z, orientation.theta_e);
+	knode.parent = parent;
+	knode.is_distant = is_distant;
+
+	if(end - start == 1) {
+		knode.child = prims[start].distribution_index;
+		knode.is_leaf = 1;
+		leaf_map[prims[start].map_index] = index;
+		return index;
+	}
+
+	const int mid = split(start, end, depth);
+
+	/* Note that the node reference is invalidated by the recursion. */
+	recursive_build(index, start, mid, depth + 1);
+	const int right = recursive_build(index, mid, end, depth + 1);
+
+	nodes[index].child = right;
+	nodes[index].is_leaf = 0;
+
+	return index;
+}
+
+int LightTreeBuilder::split(int start, int end, int depth)
+{
+	vector<LightTreePrimitive>& prims = *primitives;
+	const int middle = start + (end - start)/2;
+
+	BoundBox centroid_bounds = BoundBox::empty;
+	for(int i = start; i < end; i++) {
+		centroid_bounds.grow(prims[i].bounds.center());
+	}
+
+	const float3 extent = centroid_bounds.size();
+	const float max_extent = max(extent.x, max(extent.y, extent.z));
+
+	if(max_extent == 0.0f) {
+		/* All at the same spot, any split is as good as another. */
+		return middle;
+	}
+
+	int best_dim = -1;
+	int best_bucket = 0;
+
+	if(!is_distant && depth < LIGHT_TREE_MAX_SAOH_DEPTH) {
+		float best_cost = FLT_MAX;
+
+		for(int dim = 0; dim < 3; dim++) {
+			if(extent[dim] == 0.0f) {
+				continue;
+			}
+
+			const float inv_extent = 1.0f/extent[dim];
+			LightTreeBucket buckets[LIGHT_TREE_NUM_BUCKETS];
+
+			for(int i = start; i < end; i++) {
+				const float offset = (prims[i].bounds.center()[dim] - centroid_bounds.min[dim])*inv_extent;
+				const int b = min((int)(offset*LIGHT_TREE_NUM_BUCKETS), LIGHT_TREE_NUM_BUCKETS - 1);
+				buckets[b].grow(prims[i].bounds, prims[i].orientation, prims[i].energy, 1);
+			}
+
+			/* Regularize against thin nodes along the split axis. */
+			const float regularization = max_extent*inv_extent;
+
+			for(int split_bucket = 1; split_bucket < LIGHT_TREE_NUM_BUCKETS; split_bucket++) {
+				LightTreeBucket left, right;
+				for(int b = 0; b < split_bucket; b++) {
+					left.grow(buckets[b]);
+				}
+				for(int b = split_bucket; b < LIGHT_TREE_NUM_BUCKETS; b++) {
+					right.grow(buckets[b]);
+				}
+
+				if(left.count == 0 || right.count == 0) {
+					continue;
+				}
+
+				const float cost = (left.cost() + right.cost())*regularization;
+				if(cost < best_cost) {
+					best_cost = cost;
+					best_dim = dim;
+					best_bucket = split_bucket;
+				}
+			}
+		}
+	}
+
+	if(best_dim != -1) {
+		const int dim = best_dim;
+		const float inv_extent = 1.0f/extent[dim];
+		const float min_dim = centroid_bounds.min[dim];
+
+		int mid = start;
+		for(int i = start; i < end; i++) {
+			const float offset = (prims[i].bounds.center()[dim] - min_dim)*inv_extent;
+			const int b = min((int)(offset*LIGHT_TREE_NUM_BUCKETS), LIGHT_TREE_NUM_BUCKETS - 1);
+			if(b < best_bucket) {
+				swap(prims[i], prims[mid]);
+				mid++;
+			}
+		}
+
+		if(mid != start && mid != end) {
+			return mid;
+		}
+	}
+
+	/* Fall back to splitting in the middle along the largest axis. */
+	int dim = 0;
+	if(extent.y > extent[dim]) dim = 1;
+	if(extent.z > extent[dim]) dim = 2;
+
+	std::nth_element(prims.begin() + start,
+	                 prims.begin() + middle,
+	                 prims.begin() + end,
+	                 LightTreeCentroidCompare(dim));
+
+	return middle;
+}
+
+CCL_NAMESPACE_END
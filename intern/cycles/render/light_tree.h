@@ -0,0 +1,86 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds of the directions in which emitters emit light: the normals are
+ * within theta_o of the axis, and light leaves within theta_e of them. */
+struct LightTreeOrientation {
+	float3 axis;
+	float theta_o;
+	float theta_e;
+
+	LightTreeOrientation()
+	: axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f), theta_e(0.0f) {}
+
+	LightTreeOrientation(const float3& axis, float theta_o, float theta_e)
+	: axis(axis), theta_o(theta_o), theta_e(theta_e) {}
+
+	void grow(const LightTreeOrientation& other);
+	/* Measure of the bounded directions, used for the split cost. */
+	float measure() const;
+};
+
+/* Emitter as seen by the tree builder. */
+struct LightTreePrimitive {
+	BoundBox bounds;
+	LightTreeOrientation orientation;
+	float energy;
+	/* Index in the light distribution, stored in the leaf. */
+	int distribution_index;
+	/* Index in the map from lamps and triangles to leaf nodes. */
+	int map_index;
+};
+
+/* Light Tree Builder
+ *
+ * Builds a binary tree over the emitters, splitting nodes to minimize a cost
+ * based on energy, surface area and orientation bounds of the children
+ * ("surface area orientation heuristic"). Nodes are laid out depth first,
+ * with the left child following its parent. */
+
+class LightTreeBuilder {
+public:
+	LightTreeBuilder(vector<KernelLightTreeNode>& nodes,
+	                 vector<uint>& leaf_map);
+
+	/* Appends the tree to the nodes and returns the index of its root, or -1
+	 * if there are no primitives. Distant emitters are infinitely far away
+	 * and only use their energy for importance. */
+	int build(vector<LightTreePrimitive>& primitives, bool is_distant);
+
+protected:
+	int recursive_build(int parent, int start, int end, int depth);
+	int split(int start, int end, int depth);
+
+	vector<KernelLightTreeNode>& nodes;
+	vector<uint>& leaf_map;
+	vector<LightTreePrimitive> *primitives;
+	bool is_distant;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __LIGHT_TREE_H__ */
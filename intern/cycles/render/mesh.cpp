@@ -16,6 +16,7 @@
 
 #include "bvh/bvh.h"
 #include "bvh/bvh_build.h"
+#include "bvh/bvh_cache.h"
 
 #include "render/camera.h"
 #include "render/curves.h"
@@ -35,6 +36,7 @@
 #include "subd/subd_patch_table.h"
 
 #include "util/util_foreach.h"
+#include "util/util_half.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
@@ -459,15 +461,17 @@ Mesh::Mesh()
 
 	subdivision_type = SUBDIVISION_NONE;
 	subd_params = NULL;
+	dicing_cache = NULL;
 
 	patch_table = NULL;
 }
 
 Mesh::~Mesh()
 {
-	delete bvh;
+	free_bvh();
 	delete patch_table;
 	delete subd_params;
+	delete dicing_cache;
 }
 
 void Mesh::resize_mesh(int numverts, int numtris)
@@ -928,6 +932,30 @@ void Mesh::pack_normals(float4 *vnormal)
 	}
 }
 
+void Mesh::pack_normals(uint *vnormal)
+{
+	Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
+	if(attr_vN == NULL) {
+		/* Happens on objects with just hair. */
+		return;
+	}
+
+	bool do_transform = transform_applied;
+	Transform ntfm = transform_normal;
+
+	float3 *vN = attr_vN->data_float3();
+	size_t verts_size = verts.size();
+
+	for(size_t i = 0; i < verts_size; i++) {
+		float3 vNi = vN[i];
+
+		if(do_transform)
+			vNi = safe_normalize(transform_direction(&ntfm, vNi));
+
+		vnormal[i] = packed_normal_encode(vNi);
+	}
+}
+
 void Mesh::pack_verts(const vector<uint>& tri_prim_index,
                       uint4 *tri_vindex,
                       uint *tri_patch,
@@ -1035,9 +1063,17 @@ void Mesh::pack_patches(uint *patch_data, uint vert_offset, uint face_offset, ui
 	}
 }
 
+void Mesh::free_bvh()
+{
+	if(bvh) {
+		BVHCache::instance().release(bvh, true);
+		delete bvh;
+		bvh = NULL;
+	}
+}
+
 void Mesh::compute_bvh(Device *device,
-                       DeviceScene *dscene,
-                       SceneParams *params,
+                       Scene *scene,
                        Progress *progress,
                        int n,
                        int total)
@@ -1045,6 +1081,9 @@ void Mesh::compute_bvh(Device *device,
 	if(progress->get_cancel())
 		return;
 
+	DeviceScene *dscene = &scene->dscene;
+	SceneParams *params = &scene->params;
+
 	compute_bounds();
 
 	if(need_build_bvh()) {
@@ -1062,6 +1101,9 @@ void Mesh::compute_bvh(Device *device,
 
 		if(bvh && !need_update_rebuild) {
 			progress->set_status(msg, "Refitting BVH");
+			/* Refit changes the pack in place, it no longer matches the
+			 * geometry it was cached for. */
+			BVHCache::instance().release(bvh, false);
 			bvh->objects = objects;
 			bvh->refit(*progress);
 		}
@@ -1075,15 +1117,45 @@ void Mesh::compute_bvh(Device *device,
 			        device->get_bvh_layout_mask());
 			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 			                              params->use_bvh_unaligned_nodes;
+			bparams.use_compressed_nodes = params->use_bvh_compressed_nodes;
 			bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
 			bparams.num_motion_curve_steps = params->num_bvh_time_steps;
 			bparams.bvh_type = params->bvh_type;
 			bparams.curve_flags = dscene->data.curve.curveflags;
 			bparams.curve_subdivisions = dscene->data.curve.subdivisions;
 
-			delete bvh;
+			free_bvh();
 			bvh = BVH::create(bparams, objects);
-			MEM_GUARDED_CALL(progress, bvh->build, *progress);
+
+			/* Reuse BVH built for identical geometry before. Embree keeps its
+			 * own data structures which can't be copied. */
+			const bool use_bvh_cache = params->use_bvh_cache &&
+			                           bparams.bvh_layout != BVH_LAYOUT_EMBREE;
+			string bvh_cache_key;
+
+			if(use_bvh_cache) {
+				bvh_cache_key = BVHCache::key(this, bparams);
+			}
+
+			if(use_bvh_cache &&
+			   BVHCache::instance().lookup(bvh_cache_key,
+			                               scene,
+			                               params->use_bvh_disk_cache,
+			                               bvh))
+			{
+				progress->set_status(msg, "Using cached BVH");
+			}
+			else {
+				MEM_GUARDED_CALL(progress, bvh->build, *progress);
+
+				if(use_bvh_cache && !progress->get_cancel()) {
+					BVHCache::instance().insert(bvh_cache_key,
+					                            scene,
+					                            params->use_bvh_disk_cache,
+					                            ((uint64_t)params->bvh_disk_cache_size) << 20,
+					                            bvh);
+				}
+			}
 		}
 	}
 
@@ -1174,10 +1246,12 @@ MeshManager::MeshManager()
 {
 	need_update = true;
 	need_flags_update = true;
+	scene_bvh = NULL;
 }
 
 MeshManager::~MeshManager()
 {
+	delete scene_bvh;
 }
 
 void MeshManager::update_osl_attributes(Device *device, Scene *scene, vector<AttributeRequestSet>& mesh_attributes)
@@ -1400,12 +1474,60 @@ void MeshManager::update_svm_attributes(Device *, DeviceScene *dscene, Scene *sc
 	dscene->attributes_map.copy_to_device();
 }
 
+/* Float3 attributes of triangles are stored with 16 bits per component when
+ * that is precise enough: values in the 0..1 range like most UVs, generated
+ * coordinates and colors as normalized integers, and unit vectors as half
+ * floats. Returns the ATTR_STORAGE_* flag, or 0 for full float storage. */
+static uint attribute_float3_storage(Mesh *mesh,
+                                     Attribute *mattr,
+                                     AttributePrimitive prim)
+{
+	if(prim != ATTR_PRIM_TRIANGLE ||
+	   mesh->subdivision_type != Mesh::SUBDIVISION_NONE ||
+	   mattr->type == TypeDesc::TypeFloat ||
+	   mattr->type == TypeDesc::TypeMatrix)
+	{
+		return 0;
+	}
+
+	if(!(mattr->element == ATTR_ELEMENT_VERTEX ||
+	     mattr->element == ATTR_ELEMENT_CORNER ||
+	     mattr->element == ATTR_ELEMENT_FACE))
+	{
+		return 0;
+	}
+
+	if(mattr->std == ATTR_STD_UV_TANGENT ||
+	   mattr->std == ATTR_STD_VERTEX_NORMAL ||
+	   mattr->std == ATTR_STD_FACE_NORMAL)
+	{
+		return ATTR_STORAGE_HALF;
+	}
+
+	size_t size = mattr->element_size(mesh, prim);
+	const float4 *data = mattr->data_float4();
+
+	for(size_t k = 0; k < size; k++) {
+		const float4& f = data[k];
+		/* Negated comparisons so NaN also fails. */
+		if(!(f.x >= 0.0f && f.x <= 1.0f &&
+		     f.y >= 0.0f && f.y <= 1.0f &&
+		     f.z >= 0.0f && f.z <= 1.0f))
+		{
+			return 0;
+		}
+	}
+
+	return ATTR_STORAGE_UNORM16;
+}
+
 static void update_attribute_element_size(Mesh *mesh,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
                                           size_t *attr_float_size,
                                           size_t *attr_float3_size,
-                                          size_t *attr_uchar4_size)
+                                          size_t *attr_uchar4_size,
+                                          size_t *attr_ushort4_size)
 {
 	if(mattr) {
 		size_t size = mattr->element_size(mesh, prim);
@@ -1416,6 +1538,9 @@ static void update_attribute_element_size(Mesh *mesh,
 		else if(mattr->element == ATTR_ELEMENT_CORNER_BYTE) {
 			*attr_uchar4_size += size;
 		}
+		else if(attribute_float3_storage(mesh, mattr, prim)) {
+			*attr_ushort4_size += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			*attr_float_size += size;
 		}
@@ -1435,6 +1560,8 @@ static void update_attribute_element_offset(Mesh *mesh,
                                             size_t& attr_float3_offset,
                                             device_vector<uchar4>& attr_uchar4,
                                             size_t& attr_uchar4_offset,
+                                            device_vector<ushort4>& attr_ushort4,
+                                            size_t& attr_ushort4_offset,
                                             Attribute *mattr,
                                             AttributePrimitive prim,
                                             TypeDesc& type,
@@ -1448,6 +1575,7 @@ static void update_attribute_element_offset(Mesh *mesh,
 
 		/* store attribute data in arrays */
 		size_t size = mattr->element_size(mesh, prim);
+		uint storage = attribute_float3_storage(mesh, mattr, prim);
 
 		AttributeElement& element = desc.element;
 		int& offset = desc.offset;
@@ -1467,6 +1595,30 @@ static void update_attribute_element_offset(Mesh *mesh,
 			}
 			attr_uchar4_offset += size;
 		}
+		else if(storage) {
+			float4 *data = mattr->data_float4();
+			offset = attr_ushort4_offset;
+			desc.flags |= storage;
+
+			assert(attr_ushort4.size() >= offset + size);
+			if(storage == ATTR_STORAGE_UNORM16) {
+				for(size_t k = 0; k < size; k++) {
+					attr_ushort4[offset+k].x = (uint16_t)(data[k].x * 65535.0f + 0.5f);
+					attr_ushort4[offset+k].y = (uint16_t)(data[k].y * 65535.0f + 0.5f);
+					attr_ushort4[offset+k].z = (uint16_t)(data[k].z * 65535.0f + 0.5f);
+					attr_ushort4[offset+k].w = 0;
+				}
+			}
+			else {
+				for(size_t k = 0; k < size; k++) {
+					attr_ushort4[offset+k].x = float_to_half(data[k].x);
+					attr_ushort4[offset+k].y = float_to_half(data[k].y);
+					attr_ushort4[offset+k].z = float_to_half(data[k].z);
+					attr_ushort4[offset+k].w = 0;
+				}
+			}
+			attr_ushort4_offset += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			float *data = mattr->data_float();
 			offset = attr_float_offset;
@@ -1534,6 +1686,56 @@ static void update_attribute_element_offset(Mesh *mesh,
 	}
 }
 
+static void update_mesh_attributes(Mesh *mesh,
+                                   AttributeRequestSet *attributes,
+                                   DeviceScene *dscene,
+                                   size_t attr_float_offset,
+                                   size_t attr_float3_offset,
+                                   size_t attr_uchar4_offset,
+                                   size_t attr_ushort4_offset,
+                                   Progress *progress)
+{
+	if(progress->get_cancel()) return;
+
+	/* todo: we now store std and name attributes from requests even if
+	 * they actually refer to the same mesh attributes, optimize */
+	foreach(AttributeRequest& req, attributes->requests) {
+		Attribute *triangle_mattr = mesh->attributes.find(req);
+		Attribute *curve_mattr = mesh->curve_attributes.find(req);
+		Attribute *subd_mattr = mesh->subd_attributes.find(req);
+
+		update_attribute_element_offset(mesh,
+		                                dscene->attributes_float, attr_float_offset,
+		                                dscene->attributes_float3, attr_float3_offset,
+		                                dscene->attributes_uchar4, attr_uchar4_offset,
+		                                dscene->attributes_ushort4, attr_ushort4_offset,
+		                                triangle_mattr,
+		                                ATTR_PRIM_TRIANGLE,
+		                                req.triangle_type,
+		                                req.triangle_desc);
+
+		update_attribute_element_offset(mesh,
+		                                dscene->attributes_float, attr_float_offset,
+		                                dscene->attributes_float3, attr_float3_offset,
+		                                dscene->attributes_uchar4, attr_uchar4_offset,
+		                                dscene->attributes_ushort4, attr_ushort4_offset,
+		                                curve_mattr,
+		                                ATTR_PRIM_CURVE,
+		                                req.curve_type,
+		                                req.curve_desc);
+
+		update_attribute_element_offset(mesh,
+		                                dscene->attributes_float, attr_float_offset,
+		                                dscene->attributes_float3, attr_float3_offset,
+		                                dscene->attributes_uchar4, attr_uchar4_offset,
+		                                dscene->attributes_ushort4, attr_ushort4_offset,
+		                                subd_mattr,
+		                                ATTR_PRIM_SUBD,
+		                                req.subd_type,
+		                                req.subd_desc);
+	}
+}
+
 void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Mesh", "Computing attributes");
@@ -1563,9 +1765,24 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	size_t attr_float_size = 0;
 	size_t attr_float3_size = 0;
 	size_t attr_uchar4_size = 0;
+	size_t attr_ushort4_size = 0;
+
+	/* Start of each mesh's attributes in the arrays, so that meshes can be
+	 * filled in parallel. */
+	vector<size_t> mesh_attr_float_offset(scene->meshes.size());
+	vector<size_t> mesh_attr_float3_offset(scene->meshes.size());
+	vector<size_t> mesh_attr_uchar4_offset(scene->meshes.size());
+	vector<size_t> mesh_attr_ushort4_offset(scene->meshes.size());
+
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
 		Mesh *mesh = scene->meshes[i];
 		AttributeRequestSet& attributes = mesh_attributes[i];
+
+		mesh_attr_float_offset[i] = attr_float_size;
+		mesh_attr_float3_offset[i] = attr_float3_size;
+		mesh_attr_uchar4_offset[i] = attr_uchar4_size;
+		mesh_attr_ushort4_offset[i] = attr_ushort4_size;
+
 		foreach(AttributeRequest& req, attributes.requests) {
 			Attribute *triangle_mattr = mesh->attributes.find(req);
 			Attribute *curve_mattr = mesh->curve_attributes.find(req);
@@ -1576,72 +1793,48 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			                              ATTR_PRIM_TRIANGLE,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_ushort4_size);
 			update_attribute_element_size(mesh,
 			                              curve_mattr,
 			                              ATTR_PRIM_CURVE,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_ushort4_size);
 			update_attribute_element_size(mesh,
 			                              subd_mattr,
 			                              ATTR_PRIM_SUBD,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_ushort4_size);
 		}
 	}
 
 	dscene->attributes_float.alloc(attr_float_size);
 	dscene->attributes_float3.alloc(attr_float3_size);
 	dscene->attributes_uchar4.alloc(attr_uchar4_size);
-
-	size_t attr_float_offset = 0;
-	size_t attr_float3_offset = 0;
-	size_t attr_uchar4_offset = 0;
+	dscene->attributes_ushort4.alloc(attr_ushort4_size);
 
 	/* Fill in attributes. */
-	for(size_t i = 0; i < scene->meshes.size(); i++) {
-		Mesh *mesh = scene->meshes[i];
-		AttributeRequestSet& attributes = mesh_attributes[i];
+	TaskPool pool;
 
-		/* todo: we now store std and name attributes from requests even if
-		 * they actually refer to the same mesh attributes, optimize */
-		foreach(AttributeRequest& req, attributes.requests) {
-			Attribute *triangle_mattr = mesh->attributes.find(req);
-			Attribute *curve_mattr = mesh->curve_attributes.find(req);
-			Attribute *subd_mattr = mesh->subd_attributes.find(req);
+	for(size_t i = 0; i < scene->meshes.size(); i++) {
+		pool.push(function_bind(&update_mesh_attributes,
+		                        scene->meshes[i],
+		                        &mesh_attributes[i],
+		                        dscene,
+		                        mesh_attr_float_offset[i],
+		                        mesh_attr_float3_offset[i],
+		                        mesh_attr_uchar4_offset[i],
+		                        mesh_attr_ushort4_offset[i],
+		                        &progress));
+	}
 
-			update_attribute_element_offset(mesh,
-			                                dscene->attributes_float, attr_float_offset,
-			                                dscene->attributes_float3, attr_float3_offset,
-			                                dscene->attributes_uchar4, attr_uchar4_offset,
-			                                triangle_mattr,
-			                                ATTR_PRIM_TRIANGLE,
-			                                req.triangle_type,
-			                                req.triangle_desc);
-
-			update_attribute_element_offset(mesh,
-			                                dscene->attributes_float, attr_float_offset,
-			                                dscene->attributes_float3, attr_float3_offset,
-			                                dscene->attributes_uchar4, attr_uchar4_offset,
-			                                curve_mattr,
-			                                ATTR_PRIM_CURVE,
-			                                req.curve_type,
-			                                req.curve_desc);
-
-			update_attribute_element_offset(mesh,
-			                                dscene->attributes_float, attr_float_offset,
-			                                dscene->attributes_float3, attr_float3_offset,
-			                                dscene->attributes_uchar4, attr_uchar4_offset,
-			                                subd_mattr,
-			                                ATTR_PRIM_SUBD,
-			                                req.subd_type,
-			                                req.subd_desc);
+	pool.wait_work();
 
-			if(progress.get_cancel()) return;
-		}
-	}
+	if(progress.get_cancel()) return;
 
 	/* create attribute lookup maps */
 	if(scene->shader_manager->use_osl())
@@ -1663,6 +1856,9 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	if(dscene->attributes_uchar4.size()) {
 		dscene->attributes_uchar4.copy_to_device();
 	}
+	if(dscene->attributes_ushort4.size()) {
+		dscene->attributes_ushort4.copy_to_device();
+	}
 
 	if(progress.get_cancel()) return;
 
@@ -1715,6 +1911,82 @@ void MeshManager::mesh_calc_offset(Scene *scene)
 	}
 }
 
+static void pack_mesh_triangles(Scene *scene,
+                                Mesh *mesh,
+                                DeviceScene *dscene,
+                                const vector<uint> *tri_prim_index,
+                                Progress *progress)
+{
+	if(progress->get_cancel()) return;
+
+	uint *tri_shader = dscene->tri_shader.data();
+	uint4 *tri_vindex = dscene->tri_vindex.data();
+	uint *tri_patch = dscene->tri_patch.data();
+	float2 *tri_patch_uv = dscene->tri_patch_uv.data();
+
+	mesh->pack_shaders(scene,
+	                   &tri_shader[mesh->tri_offset]);
+	if(scene->params.use_packed_normals) {
+		uint *vnormal = dscene->tri_vnormal_packed.data();
+		mesh->pack_normals(&vnormal[mesh->vert_offset]);
+	}
+	else {
+		float4 *vnormal = dscene->tri_vnormal.data();
+		mesh->pack_normals(&vnormal[mesh->vert_offset]);
+	}
+	mesh->pack_verts(*tri_prim_index,
+	                 &tri_vindex[mesh->tri_offset],
+	                 &tri_patch[mesh->tri_offset],
+	                 &tri_patch_uv[mesh->vert_offset],
+	                 mesh->vert_offset,
+	                 mesh->tri_offset);
+}
+
+static void pack_mesh_curves(Scene *scene,
+                             Mesh *mesh,
+                             DeviceScene *dscene,
+                             Progress *progress)
+{
+	if(progress->get_cancel()) return;
+
+	float4 *curve_keys = dscene->curve_keys.data();
+	float4 *curves = dscene->curves.data();
+
+	mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
+}
+
+static void pack_mesh_patches(Mesh *mesh,
+                              DeviceScene *dscene,
+                              Progress *progress)
+{
+	if(progress->get_cancel()) return;
+
+	uint *patch_data = dscene->patches.data();
+
+	mesh->pack_patches(&patch_data[mesh->patch_offset], mesh->vert_offset, mesh->face_offset, mesh->corner_offset);
+
+	if(mesh->patch_table) {
+		mesh->patch_table->copy_adjusting_offsets(&patch_data[mesh->patch_table_offset], mesh->patch_table_offset);
+	}
+}
+
+static void pack_mesh_displacement_verts(Mesh *mesh,
+                                         DeviceScene *dscene,
+                                         Progress *progress)
+{
+	if(progress->get_cancel()) return;
+
+	float4 *prim_tri_verts = dscene->prim_tri_verts.data();
+
+	for(size_t i = 0; i < mesh->num_triangles(); ++i) {
+		Mesh::Triangle t = mesh->get_triangle(i);
+		size_t offset = 3 * (i + mesh->tri_offset);
+		prim_tri_verts[offset + 0] = float3_to_float4(mesh->verts[t.v[0]]);
+		prim_tri_verts[offset + 1] = float3_to_float4(mesh->verts[t.v[1]]);
+		prim_tri_verts[offset + 2] = float3_to_float4(mesh->verts[t.v[2]]);
+	}
+}
+
 void MeshManager::device_update_mesh(Device *,
                                      DeviceScene *dscene,
                                      Scene *scene,
@@ -1771,35 +2043,50 @@ void MeshManager::device_update_mesh(Device *,
 		}
 	}
 
+	/* Set before displacement, which already reads normals. */
+	dscene->data.bvh.use_packed_normals = scene->params.use_packed_normals;
+
 	/* Fill in all the arrays. */
 	if(tri_size != 0) {
 		/* normals */
 		progress.set_status("Updating Mesh", "Computing normals");
 
-		uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-		float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
-		uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
-		uint *tri_patch = dscene->tri_patch.alloc(tri_size);
-		float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
+		dscene->tri_shader.alloc(tri_size);
+		if(scene->params.use_packed_normals) {
+			dscene->tri_vnormal_packed.alloc(vert_size);
+		}
+		else {
+			dscene->tri_vnormal.alloc(vert_size);
+		}
+		dscene->tri_vindex.alloc(tri_size);
+		dscene->tri_patch.alloc(tri_size);
+		dscene->tri_patch_uv.alloc(vert_size);
 
+		/* Meshes write to disjoint ranges of the arrays, given by the offsets
+		 * from mesh_calc_offset(), so they can be packed in parallel. */
+		TaskPool pool;
 		foreach(Mesh *mesh, scene->meshes) {
-			mesh->pack_shaders(scene,
-			                   &tri_shader[mesh->tri_offset]);
-			mesh->pack_normals(&vnormal[mesh->vert_offset]);
-			mesh->pack_verts(tri_prim_index,
-			                 &tri_vindex[mesh->tri_offset],
-			                 &tri_patch[mesh->tri_offset],
-			                 &tri_patch_uv[mesh->vert_offset],
-			                 mesh->vert_offset,
-			                 mesh->tri_offset);
-			if(progress.get_cancel()) return;
+			pool.push(function_bind(&pack_mesh_triangles,
+			                        scene,
+			                        mesh,
+			                        dscene,
+			                        &tri_prim_index,
+			                        &progress));
 		}
+		pool.wait_work();
+
+		if(progress.get_cancel()) return;
 
 		/* vertex coordinates */
 		progress.set_status("Updating Mesh", "Copying Mesh to device");
 
 		dscene->tri_shader.copy_to_device();
-		dscene->tri_vnormal.copy_to_device();
+		if(scene->params.use_packed_normals) {
+			dscene->tri_vnormal_packed.copy_to_device();
+		}
+		else {
+			dscene->tri_vnormal.copy_to_device();
+		}
 		dscene->tri_vindex.copy_to_device();
 		dscene->tri_patch.copy_to_device();
 		dscene->tri_patch_uv.copy_to_device();
@@ -1808,13 +2095,20 @@ void MeshManager::device_update_mesh(Device *,
 	if(curve_size != 0) {
 		progress.set_status("Updating Mesh", "Copying Strands to device");
 
-		float4 *curve_keys = dscene->curve_keys.alloc(curve_key_size);
-		float4 *curves = dscene->curves.alloc(curve_size);
+		dscene->curve_keys.alloc(curve_key_size);
+		dscene->curves.alloc(curve_size);
 
+		TaskPool pool;
 		foreach(Mesh *mesh, scene->meshes) {
-			mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
-			if(progress.get_cancel()) return;
+			pool.push(function_bind(&pack_mesh_curves,
+			                        scene,
+			                        mesh,
+			                        dscene,
+			                        &progress));
 		}
+		pool.wait_work();
+
+		if(progress.get_cancel()) return;
 
 		dscene->curve_keys.copy_to_device();
 		dscene->curves.copy_to_device();
@@ -1823,37 +2117,97 @@ void MeshManager::device_update_mesh(Device *,
 	if(patch_size != 0) {
 		progress.set_status("Updating Mesh", "Copying Patches to device");
 
-		uint *patch_data = dscene->patches.alloc(patch_size);
+		dscene->patches.alloc(patch_size);
 
+		TaskPool pool;
 		foreach(Mesh *mesh, scene->meshes) {
-			mesh->pack_patches(&patch_data[mesh->patch_offset], mesh->vert_offset, mesh->face_offset, mesh->corner_offset);
-
-			if(mesh->patch_table) {
-				mesh->patch_table->copy_adjusting_offsets(&patch_data[mesh->patch_table_offset], mesh->patch_table_offset);
-			}
-
-			if(progress.get_cancel()) return;
+			pool.push(function_bind(&pack_mesh_patches,
+			                        mesh,
+			                        dscene,
+			                        &progress));
 		}
+		pool.wait_work();
+
+		if(progress.get_cancel()) return;
 
 		dscene->patches.copy_to_device();
 	}
 
 	if(for_displacement) {
-		float4 *prim_tri_verts = dscene->prim_tri_verts.alloc(tri_size * 3);
+		dscene->prim_tri_verts.alloc(tri_size * 3);
+
+		TaskPool pool;
 		foreach(Mesh *mesh, scene->meshes) {
-			for(size_t i = 0; i < mesh->num_triangles(); ++i) {
-				Mesh::Triangle t = mesh->get_triangle(i);
-				size_t offset = 3 * (i + mesh->tri_offset);
-				prim_tri_verts[offset + 0] = float3_to_float4(mesh->verts[t.v[0]]);
-				prim_tri_verts[offset + 1] = float3_to_float4(mesh->verts[t.v[1]]);
-				prim_tri_verts[offset + 2] = float3_to_float4(mesh->verts[t.v[2]]);
-			}
+			pool.push(function_bind(&pack_mesh_displacement_verts,
+			                        mesh,
+			                        dscene,
+			                        &progress));
 		}
+		pool.wait_work();
+
+		if(progress.get_cancel()) return;
+
 		dscene->prim_tri_verts.copy_to_device();
 	}
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+/* Everything the structure of the scene BVH depends on. When it matches
+ * the key of the previous BVH, primitive and object indices are the same and
+ * the BVH can be refitted to the new bounds. */
+static void scene_bvh_compute_key(const Scene *scene,
+                                  const BVHParams& bparams,
+                                  vector<size_t> *key)
+{
+	key->clear();
+	key->push_back(bparams.bvh_layout);
+	key->push_back(bparams.use_spatial_split);
+	key->push_back(bparams.use_unaligned_nodes);
+	key->push_back(bparams.use_compressed_nodes);
+	key->push_back(bparams.num_motion_triangle_steps);
+	key->push_back(bparams.num_motion_curve_steps);
+	key->push_back(bparams.bvh_type);
+	key->push_back(bparams.curve_flags);
+	key->push_back(bparams.curve_subdivisions);
+
+	foreach(Object *object, scene->objects) {
+		const Mesh *mesh = object->mesh;
+
+		key->push_back((size_t)object);
+		key->push_back((size_t)mesh);
+		key->push_back(object->visibility_for_tracing());
+		key->push_back(object->motion.size());
+		key->push_back(mesh->need_build_bvh());
+		key->push_back(mesh->num_triangles());
+		key->push_back(mesh->num_curves());
+		key->push_back(mesh->curve_keys.size());
+		key->push_back(mesh->tri_offset);
+		key->push_back(mesh->curve_offset);
+		key->push_back(mesh->use_motion_blur);
+		key->push_back(mesh->motion_steps);
+	}
+}
+
+/* Copy packed BVH data to the device. When the BVH is kept for refitting the
+ * host data is copied, otherwise it is handed over to the device vector. */
+template<typename T>
+static void scene_bvh_copy_to_device(device_vector<T>& dvec, array<T>& data, bool keep)
+{
+	if(!data.size()) {
+		return;
+	}
+
+	if(keep) {
+		T *dvec_data = dvec.alloc(data.size());
+		memcpy(dvec_data, data.data(), sizeof(T) * data.size());
+	}
+	else {
+		dvec.steal_data(data);
+	}
+
+	dvec.copy_to_device();
+}
+
+void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, bool can_refit, Progress& progress)
 {
 	/* bvh build */
 	progress.set_status("Updating Scene BVH", "Building");
@@ -1866,6 +2220,7 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 	                              scene->params.use_bvh_unaligned_nodes;
+	bparams.use_compressed_nodes = scene->params.use_bvh_compressed_nodes;
 	bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
 	bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
 	bparams.bvh_type = scene->params.bvh_type;
@@ -1883,8 +2238,35 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	}
 #endif
 
-	BVH *bvh = BVH::create(bparams, scene->objects);
-	bvh->build(progress, &device->stats);
+	/* Keep the scene BVH for refitting in later updates. This doubles the
+	 * host memory used by it, so only when the BVH cache is enabled. Embree
+	 * keeps its own data structures which are not refitted here. */
+	const bool keep_bvh = scene->params.use_bvh_cache &&
+	                      bparams.bvh_layout != BVH_LAYOUT_EMBREE;
+	vector<size_t> bvh_key;
+	if(keep_bvh) {
+		scene_bvh_compute_key(scene, bparams, &bvh_key);
+	}
+
+	BVH *bvh;
+
+	if(keep_bvh && can_refit && scene_bvh && bvh_key == scene_bvh_key) {
+		progress.set_status("Updating Scene BVH", "Refitting");
+
+		bvh = scene_bvh;
+		scene_bvh = NULL;
+
+		bvh->objects = scene->objects;
+		bvh->refit(progress);
+	}
+	else {
+		delete scene_bvh;
+		scene_bvh = NULL;
+
+		bvh = BVH::create(bparams, scene->objects);
+		bvh->build(progress, &device->stats);
+	}
+	bvh_stats = bvh->build_stats;
 
 	if(progress.get_cancel()) {
 #ifdef WITH_EMBREE
@@ -1903,46 +2285,16 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	PackedBVH& pack = bvh->pack;
 
-	if(pack.nodes.size()) {
-		dscene->bvh_nodes.steal_data(pack.nodes);
-		dscene->bvh_nodes.copy_to_device();
-	}
-	if(pack.leaf_nodes.size()) {
-		dscene->bvh_leaf_nodes.steal_data(pack.leaf_nodes);
-		dscene->bvh_leaf_nodes.copy_to_device();
-	}
-	if(pack.object_node.size()) {
-		dscene->object_node.steal_data(pack.object_node);
-		dscene->object_node.copy_to_device();
-	}
-	if(pack.prim_tri_index.size()) {
-		dscene->prim_tri_index.steal_data(pack.prim_tri_index);
-		dscene->prim_tri_index.copy_to_device();
-	}
-	if(pack.prim_tri_verts.size()) {
-		dscene->prim_tri_verts.steal_data(pack.prim_tri_verts);
-		dscene->prim_tri_verts.copy_to_device();
-	}
-	if(pack.prim_type.size()) {
-		dscene->prim_type.steal_data(pack.prim_type);
-		dscene->prim_type.copy_to_device();
-	}
-	if(pack.prim_visibility.size()) {
-		dscene->prim_visibility.steal_data(pack.prim_visibility);
-		dscene->prim_visibility.copy_to_device();
-	}
-	if(pack.prim_index.size()) {
-		dscene->prim_index.steal_data(pack.prim_index);
-		dscene->prim_index.copy_to_device();
-	}
-	if(pack.prim_object.size()) {
-		dscene->prim_object.steal_data(pack.prim_object);
-		dscene->prim_object.copy_to_device();
-	}
-	if(pack.prim_time.size()) {
-		dscene->prim_time.steal_data(pack.prim_time);
-		dscene->prim_time.copy_to_device();
-	}
+	scene_bvh_copy_to_device(dscene->bvh_nodes, pack.nodes, keep_bvh);
+	scene_bvh_copy_to_device(dscene->bvh_leaf_nodes, pack.leaf_nodes, keep_bvh);
+	scene_bvh_copy_to_device(dscene->object_node, pack.object_node, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_tri_index, pack.prim_tri_index, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_tri_verts, pack.prim_tri_verts, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_type, pack.prim_type, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_visibility, pack.prim_visibility, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_index, pack.prim_index, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_object, pack.prim_object, keep_bvh);
+	scene_bvh_copy_to_device(dscene->prim_time, pack.prim_time, keep_bvh);
 
 	dscene->data.bvh.root = pack.root_index;
 	dscene->data.bvh.bvh_layout = bparams.bvh_layout;
@@ -1958,7 +2310,13 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	}
 #endif
 
-	delete bvh;
+	if(keep_bvh) {
+		scene_bvh = bvh;
+		scene_bvh_key.swap(bvh_key);
+	}
+	else {
+		delete bvh;
+	}
 }
 
 void MeshManager::device_update_preprocess(Device *device,
@@ -2209,6 +2567,17 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(progress.get_cancel()) return;
 	}
 
+	/* The scene BVH can only be refitted when no mesh changed topology, and
+	 * no instance BVH that is merged into it changed. */
+	bool can_refit_scene_bvh = true;
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update &&
+		   (mesh->need_update_rebuild || mesh->need_build_bvh()))
+		{
+			can_refit_scene_bvh = false;
+		}
+	}
+
 	TaskPool pool;
 
 	size_t i = 0;
@@ -2217,8 +2586,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 			pool.push(function_bind(&Mesh::compute_bvh,
 			                        mesh,
 			                        device,
-			                        dscene,
-			                        &scene->params,
+			                        scene,
 			                        &progress,
 			                        i,
 			                        num_bvh));
@@ -2233,6 +2601,10 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	VLOG(2) << "Objects BVH build pool statistics:\n"
 	        << summary.full_report();
 
+	if(scene->params.use_bvh_cache && !progress.get_cancel()) {
+		BVHCache::instance().collect_garbage(scene);
+	}
+
 	foreach(Shader *shader, scene->shaders) {
 		shader->need_update_mesh = false;
 	}
@@ -2248,7 +2620,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	device_update_bvh(device, dscene, scene, can_refit_scene_bvh, progress);
 	if(progress.get_cancel()) return;
 
 	device_update_mesh(device, dscene, scene, false, progress);
@@ -2281,6 +2653,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->prim_time.free();
 	dscene->tri_shader.free();
 	dscene->tri_vnormal.free();
+	dscene->tri_vnormal_packed.free();
 	dscene->tri_vindex.free();
 	dscene->tri_patch.free();
 	dscene->tri_patch_uv.free();
@@ -2291,6 +2664,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->attributes_float.free();
 	dscene->attributes_float3.free();
 	dscene->attributes_uchar4.free();
+	dscene->attributes_ushort4.free();
 
 #ifdef WITH_OSL
 	OSLGlobals *og = (OSLGlobals*)device->osl_memory();
@@ -2318,6 +2692,15 @@ void MeshManager::collect_statistics(const Scene *scene, RenderStats *stats)
 		        NamedSizeEntry(string(mesh->name.c_str()),
 		                       mesh->get_total_size_in_bytes()));
 	}
+
+	/* Meshes only have their own BVH when instanced. */
+	stats->bvh.add_entry(NamedBVHStats("Scene", bvh_stats));
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->bvh) {
+			stats->bvh.add_entry(NamedBVHStats(string(mesh->name.c_str()),
+			                                   mesh->bvh->build_stats));
+		}
+	}
 }
 
 bool Mesh::need_attribute(Scene *scene, AttributeStandard std)
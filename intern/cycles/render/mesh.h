@@ -17,6 +17,8 @@
 #ifndef __MESH_H__
 #define __MESH_H__
 
+#include "bvh/bvh.h"
+
 #include "graph/node.h"
 
 #include "render/attribute.h"
@@ -44,6 +46,7 @@ class Scene;
 class SceneParams;
 class AttributeRequest;
 struct SubdParams;
+struct DicingCache;
 class DiagSplit;
 struct PackedPatchTable;
 
@@ -220,6 +223,7 @@ public:
 	array<SubdEdgeCrease> subd_creases;
 
 	SubdParams *subd_params;
+	DicingCache *dicing_cache;
 
 	vector<Shader*> used_shaders;
 	AttributeSet attributes;
@@ -283,6 +287,7 @@ public:
 
 	void pack_shaders(Scene *scene, uint *shader);
 	void pack_normals(float4 *vnormal);
+	void pack_normals(uint *vnormal);
 	void pack_verts(const vector<uint>& tri_prim_index,
 	                uint4 *tri_vindex,
 	                uint *tri_patch,
@@ -293,11 +298,12 @@ public:
 	void pack_patches(uint *patch_data, uint vert_offset, uint face_offset, uint corner_offset);
 
 	void compute_bvh(Device *device,
-	                 DeviceScene *dscene,
-	                 SceneParams *params,
+	                 Scene *scene,
 	                 Progress *progress,
 	                 int n,
 	                 int total);
+	/* Free the BVH, giving its pack back to the BVH cache. */
+	void free_bvh();
 
 	bool need_attribute(Scene *scene, AttributeStandard std);
 	bool need_attribute(Scene *scene, ustring name);
@@ -335,6 +341,9 @@ public:
 	bool need_update;
 	bool need_flags_update;
 
+	/* Statistics of the last scene BVH build. */
+	BVHBuildStats bvh_stats;
+
 	MeshManager();
 	~MeshManager();
 
@@ -356,6 +365,12 @@ public:
 	void collect_statistics(const Scene *scene, RenderStats *stats);
 
 protected:
+	/* Scene BVH of the last update, kept when the BVH cache is enabled so it
+	 * can be refitted when only object transforms or vertex positions
+	 * changed. The key describes the structure it was built for. */
+	BVH *scene_bvh;
+	vector<size_t> scene_bvh_key;
+
 	/* Calculate verts/triangles/curves offsets in global arrays. */
 	void mesh_calc_offset(Scene *scene);
 
@@ -378,6 +393,7 @@ protected:
 	void device_update_bvh(Device *device,
 	                       DeviceScene *dscene,
 	                       Scene *scene,
+	                       bool can_refit,
 	                       Progress& progress);
 
 	void device_update_displacement_images(Device *device,
@@ -24,9 +24,12 @@
 
 #include "util/util_foreach.h"
 #include "util/util_algorithm.h"
+#include "util/util_task.h"
 
 CCL_NAMESPACE_BEGIN
 
+class OsdData;
+
 #ifdef WITH_OPENSUBDIV
 
 CCL_NAMESPACE_END
@@ -339,6 +342,240 @@ struct OsdPatch : Patch {
 
 #endif
 
+/* Split all patches of a face, and dice them unless the face was already
+ * diced from the same split. Patches must stay alive until diced. */
+
+static void tessellate_face(Mesh *mesh,
+                            OsdData *osd_data,
+                            DiagSplit *split,
+                            const float3 *vN,
+                            int f,
+                            DicedFace *diced)
+{
+	Mesh::SubdFace& face = mesh->subd_faces[f];
+	const array<float3>& verts = mesh->verts;
+	const array<int>& subd_face_corners = mesh->subd_face_corners;
+
+	if(face.is_quad()) {
+		/* quad */
+		QuadDice::SubPatch subpatch;
+
+		LinearQuadPatch quad_patch;
+#ifdef WITH_OPENSUBDIV
+		OsdPatch osd_patch(osd_data);
+
+		if(mesh->subdivision_type == Mesh::SUBDIVISION_CATMULL_CLARK) {
+			osd_patch.patch_index = face.ptex_offset;
+
+			subpatch.patch = &osd_patch;
+		}
+		else
+#endif
+		{
+			float3 *hull = quad_patch.hull;
+			float3 *normals = quad_patch.normals;
+
+			quad_patch.patch_index = face.ptex_offset;
+
+			for(int i = 0; i < 4; i++) {
+				hull[i] = verts[subd_face_corners[face.start_corner+i]];
+			}
+
+			if(face.smooth) {
+				for(int i = 0; i < 4; i++) {
+					normals[i] = vN[subd_face_corners[face.start_corner+i]];
+				}
+			}
+			else {
+				float3 N = face.normal(mesh);
+				for(int i = 0; i < 4; i++) {
+					normals[i] = N;
+				}
+			}
+
+			swap(hull[2], hull[3]);
+			swap(normals[2], normals[3]);
+
+			subpatch.patch = &quad_patch;
+		}
+
+		subpatch.patch->shader = face.shader;
+
+		/* Quad faces need to be split at least once to line up with split ngons, we do this
+		 * here in this manner because if we do it later edge factors may end up slightly off.
+		 */
+		subpatch.P00 = make_float2(0.0f, 0.0f);
+		subpatch.P10 = make_float2(0.5f, 0.0f);
+		subpatch.P01 = make_float2(0.0f, 0.5f);
+		subpatch.P11 = make_float2(0.5f, 0.5f);
+		split->split_quad(subpatch.patch, &subpatch);
+
+		subpatch.P00 = make_float2(0.5f, 0.0f);
+		subpatch.P10 = make_float2(1.0f, 0.0f);
+		subpatch.P01 = make_float2(0.5f, 0.5f);
+		subpatch.P11 = make_float2(1.0f, 0.5f);
+		split->split_quad(subpatch.patch, &subpatch);
+
+		subpatch.P00 = make_float2(0.0f, 0.5f);
+		subpatch.P10 = make_float2(0.5f, 0.5f);
+		subpatch.P01 = make_float2(0.0f, 1.0f);
+		subpatch.P11 = make_float2(0.5f, 1.0f);
+		split->split_quad(subpatch.patch, &subpatch);
+
+		subpatch.P00 = make_float2(0.5f, 0.5f);
+		subpatch.P10 = make_float2(1.0f, 0.5f);
+		subpatch.P01 = make_float2(0.5f, 1.0f);
+		subpatch.P11 = make_float2(1.0f, 1.0f);
+		split->split_quad(subpatch.patch, &subpatch);
+
+		if(!split->split_matches(*diced)) {
+			split->dice(diced);
+		}
+		split->clear();
+		return;
+	}
+
+	/* ngon */
+#ifdef WITH_OPENSUBDIV
+	if(mesh->subdivision_type == Mesh::SUBDIVISION_CATMULL_CLARK) {
+		vector<OsdPatch> patches(face.num_corners, OsdPatch(osd_data));
+
+		for(int corner = 0; corner < face.num_corners; corner++) {
+			OsdPatch& patch = patches[corner];
+
+			patch.shader = face.shader;
+			patch.patch_index = face.ptex_offset + corner;
+
+			split->split_quad(&patch);
+		}
+
+		if(!split->split_matches(*diced)) {
+			split->dice(diced);
+		}
+		split->clear();
+		return;
+	}
+#else
+	(void)osd_data;
+#endif
+
+	float3 center_vert = make_float3(0.0f, 0.0f, 0.0f);
+	float3 center_normal = make_float3(0.0f, 0.0f, 0.0f);
+
+	float inv_num_corners = 1.0f/float(face.num_corners);
+	for(int corner = 0; corner < face.num_corners; corner++) {
+		center_vert += verts[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
+		center_normal += vN[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
+	}
+
+	vector<LinearQuadPatch> patches(face.num_corners);
+
+	for(int corner = 0; corner < face.num_corners; corner++) {
+		LinearQuadPatch& patch = patches[corner];
+		float3 *hull = patch.hull;
+		float3 *normals = patch.normals;
+
+		patch.patch_index = face.ptex_offset + corner;
+
+		patch.shader = face.shader;
+
+		hull[0] = verts[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
+		hull[1] = verts[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
+		hull[2] = verts[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
+		hull[3] = center_vert;
+
+		hull[1] = (hull[1] + hull[0]) * 0.5;
+		hull[2] = (hull[2] + hull[0]) * 0.5;
+
+		if(face.smooth) {
+			normals[0] = vN[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
+			normals[1] = vN[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
+			normals[2] = vN[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
+			normals[3] = center_normal;
+
+			normals[1] = (normals[1] + normals[0]) * 0.5;
+			normals[2] = (normals[2] + normals[0]) * 0.5;
+		}
+		else {
+			float3 N = face.normal(mesh);
+			for(int i = 0; i < 4; i++) {
+				normals[i] = N;
+			}
+		}
+
+		split->split_quad(&patch);
+	}
+
+	if(!split->split_matches(*diced)) {
+		split->dice(diced);
+	}
+	split->clear();
+}
+
+static void tessellate_faces(Mesh *mesh,
+                             OsdData *osd_data,
+                             const SubdParams *params,
+                             const float3 *vN,
+                             int start,
+                             int end,
+                             DicedFace *diced_faces)
+{
+	DiagSplit split(*params);
+
+	for(int f = start; f < end; f++) {
+		tessellate_face(mesh, osd_data, &split, vN, f, &diced_faces[f]);
+	}
+}
+
+/* Update cached copy of the control mesh, clearing the diced faces when it
+ * changed since they can't be reused then. */
+static void dicing_cache_update(DicingCache *cache, Mesh *mesh)
+{
+	size_t num_faces = mesh->subd_faces.size();
+
+	array<int> faces(num_faces*4);
+	for(size_t f = 0; f < num_faces; f++) {
+		const Mesh::SubdFace& face = mesh->subd_faces[f];
+
+		faces[f*4 + 0] = face.start_corner;
+		faces[f*4 + 1] = face.num_corners;
+		faces[f*4 + 2] = face.ptex_offset;
+		faces[f*4 + 3] = face.smooth;
+	}
+
+	size_t num_creases = mesh->subd_creases.size();
+
+	array<int> crease_verts(num_creases*2);
+	array<float> creases(num_creases);
+	for(size_t i = 0; i < num_creases; i++) {
+		const Mesh::SubdEdgeCrease& crease = mesh->subd_creases[i];
+
+		crease_verts[i*2 + 0] = crease.v[0];
+		crease_verts[i*2 + 1] = crease.v[1];
+		creases[i] = crease.crease;
+	}
+
+	if(cache->subdivision_type == mesh->subdivision_type &&
+	   cache->verts == mesh->verts &&
+	   cache->face_corners == mesh->subd_face_corners &&
+	   cache->faces == faces &&
+	   cache->crease_verts == crease_verts &&
+	   cache->creases == creases)
+	{
+		return;
+	}
+
+	cache->subdivision_type = mesh->subdivision_type;
+	cache->verts = mesh->verts;
+	cache->face_corners = mesh->subd_face_corners;
+	cache->faces.steal_data(faces);
+	cache->crease_verts.steal_data(crease_verts);
+	cache->creases.steal_data(creases);
+
+	cache->diced_faces.clear();
+	cache->diced_faces.resize(num_faces);
+}
+
 void Mesh::tessellate(DiagSplit *split)
 {
 #ifdef WITH_OPENSUBDIV
@@ -369,146 +606,118 @@ void Mesh::tessellate(DiagSplit *split)
 	Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
 	float3* vN = attr_vN->data_float3();
 
-	for(int f = 0; f < num_faces; f++) {
-		SubdFace& face = subd_faces[f];
+	/* Faces diced in a previous tessellation are reused when their control
+	 * mesh and split did not change. */
+	const SubdParams& params = split->params;
+	vector<DicedFace> local_diced_faces;
+	DicedFace *diced_faces;
 
-		if(face.is_quad()) {
-			/* quad */
-			QuadDice::SubPatch subpatch;
+	if(params.use_dicing_cache) {
+		if(!dicing_cache) {
+			dicing_cache = new DicingCache();
+			dicing_cache->subdivision_type = SUBDIVISION_NONE;
+		}
 
-			LinearQuadPatch quad_patch;
-#ifdef WITH_OPENSUBDIV
-			OsdPatch osd_patch(&osd_data);
+		dicing_cache_update(dicing_cache, this);
+		diced_faces = dicing_cache->diced_faces.data();
+	}
+	else {
+		delete dicing_cache;
+		dicing_cache = NULL;
 
-			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-				osd_patch.patch_index = face.ptex_offset;
+		local_diced_faces.resize(num_faces);
+		diced_faces = local_diced_faces.data();
+	}
 
-				subpatch.patch = &osd_patch;
-			}
-			else
+	/* Split and dice faces in parallel. Faces are diced independently with
+	 * vertices local to the face, so they can be appended in order after. */
+	OsdData *osd_data_ptr = NULL;
+#ifdef WITH_OPENSUBDIV
+	osd_data_ptr = &osd_data;
 #endif
-			{
-				float3 *hull = quad_patch.hull;
-				float3 *normals = quad_patch.normals;
 
-				quad_patch.patch_index = face.ptex_offset;
+	TaskPool pool;
+	const int faces_per_task = 64;
 
-				for(int i = 0; i < 4; i++) {
-					hull[i] = verts[subd_face_corners[face.start_corner+i]];
-				}
+	for(int start = 0; start < num_faces; start += faces_per_task) {
+		int end = min(start + faces_per_task, num_faces);
 
-				if(face.smooth) {
-					for(int i = 0; i < 4; i++) {
-						normals[i] = vN[subd_face_corners[face.start_corner+i]];
-					}
-				}
-				else {
-					float3 N = face.normal(this);
-					for(int i = 0; i < 4; i++) {
-						normals[i] = N;
-					}
-				}
+		pool.push(function_bind(&tessellate_faces,
+		                        this,
+		                        osd_data_ptr,
+		                        &params,
+		                        vN,
+		                        start,
+		                        end,
+		                        diced_faces));
+	}
 
-				swap(hull[2], hull[3]);
-				swap(normals[2], normals[3]);
+	pool.wait_work();
 
-				subpatch.patch = &quad_patch;
-			}
+	/* Append diced faces to the mesh. */
+	size_t num_diced_verts = 0;
+	size_t num_diced_tris = 0;
 
-			subpatch.patch->shader = face.shader;
-
-			/* Quad faces need to be split at least once to line up with split ngons, we do this
-			 * here in this manner because if we do it later edge factors may end up slightly off.
-			 */
-			subpatch.P00 = make_float2(0.0f, 0.0f);
-			subpatch.P10 = make_float2(0.5f, 0.0f);
-			subpatch.P01 = make_float2(0.0f, 0.5f);
-			subpatch.P11 = make_float2(0.5f, 0.5f);
-			split->split_quad(subpatch.patch, &subpatch);
-
-			subpatch.P00 = make_float2(0.5f, 0.0f);
-			subpatch.P10 = make_float2(1.0f, 0.0f);
-			subpatch.P01 = make_float2(0.5f, 0.5f);
-			subpatch.P11 = make_float2(1.0f, 0.5f);
-			split->split_quad(subpatch.patch, &subpatch);
-
-			subpatch.P00 = make_float2(0.0f, 0.5f);
-			subpatch.P10 = make_float2(0.5f, 0.5f);
-			subpatch.P01 = make_float2(0.0f, 1.0f);
-			subpatch.P11 = make_float2(0.5f, 1.0f);
-			split->split_quad(subpatch.patch, &subpatch);
-
-			subpatch.P00 = make_float2(0.5f, 0.5f);
-			subpatch.P10 = make_float2(1.0f, 0.5f);
-			subpatch.P01 = make_float2(0.5f, 1.0f);
-			subpatch.P11 = make_float2(1.0f, 1.0f);
-			split->split_quad(subpatch.patch, &subpatch);
-		}
-		else {
-			/* ngon */
-#ifdef WITH_OPENSUBDIV
-			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-				OsdPatch patch(&osd_data);
-
-				patch.shader = face.shader;
+	for(int f = 0; f < num_faces; f++) {
+		num_diced_verts += diced_faces[f].P.size();
+		num_diced_tris += diced_faces[f].patch.size();
+	}
 
-				for(int corner = 0; corner < face.num_corners; corner++) {
-					patch.patch_index = face.ptex_offset + corner;
+	Attribute *attr_mesh_vN = attributes.add(ATTR_STD_VERTEX_NORMAL);
+	Attribute *attr_ptex_uv = NULL;
+	Attribute *attr_ptex_face_id = NULL;
 
-					split->split_quad(&patch);
-				}
-			}
-			else
-#endif
-			{
-				float3 center_vert = make_float3(0.0f, 0.0f, 0.0f);
-				float3 center_normal = make_float3(0.0f, 0.0f, 0.0f);
-
-				float inv_num_corners = 1.0f/float(face.num_corners);
-				for(int corner = 0; corner < face.num_corners; corner++) {
-					center_vert += verts[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
-					center_normal += vN[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
-				}
+	if(params.ptex) {
+		attr_ptex_uv = attributes.add(ATTR_STD_PTEX_UV);
+		attr_ptex_face_id = attributes.add(ATTR_STD_PTEX_FACE_ID);
+	}
 
-				for(int corner = 0; corner < face.num_corners; corner++) {
-					LinearQuadPatch patch;
-					float3 *hull = patch.hull;
-					float3 *normals = patch.normals;
+	size_t vert_offset = verts.size();
+	size_t tri_offset = num_triangles();
 
-					patch.patch_index = face.ptex_offset + corner;
+	resize_mesh(vert_offset + num_diced_verts, tri_offset + num_diced_tris);
 
-					patch.shader = face.shader;
+	float3 *mesh_N = attr_mesh_vN->data_float3();
+	float3 *ptex_uv = (attr_ptex_uv)? attr_ptex_uv->data_float3(): NULL;
+	float *ptex_face_id = (attr_ptex_face_id)? attr_ptex_face_id->data_float(): NULL;
 
-					hull[0] = verts[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
-					hull[1] = verts[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
-					hull[2] = verts[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
-					hull[3] = center_vert;
+	for(int f = 0; f < num_faces; f++) {
+		DicedFace& diced = diced_faces[f];
+		int face_shader = subd_faces[f].shader;
 
-					hull[1] = (hull[1] + hull[0]) * 0.5;
-					hull[2] = (hull[2] + hull[0]) * 0.5;
+		for(size_t i = 0; i < diced.P.size(); i++) {
+			verts[vert_offset + i] = diced.P[i];
+			mesh_N[vert_offset + i] = diced.N[i];
+			vert_patch_uv[vert_offset + i] = diced.uv[i];
 
-					if(face.smooth) {
-						normals[0] = vN[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
-						normals[1] = vN[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
-						normals[2] = vN[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
-						normals[3] = center_normal;
+			if(ptex_uv) {
+				ptex_uv[vert_offset + i] = make_float3(diced.uv[i].x, diced.uv[i].y, 0.0f);
+			}
+		}
 
-						normals[1] = (normals[1] + normals[0]) * 0.5;
-						normals[2] = (normals[2] + normals[0]) * 0.5;
-					}
-					else {
-						float3 N = face.normal(this);
-						for(int i = 0; i < 4; i++) {
-							normals[i] = N;
-						}
-					}
+		for(size_t i = 0; i < diced.patch.size(); i++) {
+			triangles[(tri_offset + i)*3 + 0] = vert_offset + diced.triangles[i*3 + 0];
+			triangles[(tri_offset + i)*3 + 1] = vert_offset + diced.triangles[i*3 + 1];
+			triangles[(tri_offset + i)*3 + 2] = vert_offset + diced.triangles[i*3 + 2];
+			shader[tri_offset + i] = face_shader;
+			smooth[tri_offset + i] = true;
+			triangle_patch[tri_offset + i] = diced.patch[i];
 
-					split->split_quad(&patch);
-				}
+			if(ptex_face_id) {
+				ptex_face_id[tri_offset + i] = diced.ptex_face_id[i];
 			}
 		}
+
+		vert_offset += diced.P.size();
+		tri_offset += diced.patch.size();
+
+		if(!params.use_dicing_cache) {
+			diced.clear();
+		}
 	}
 
+	num_subd_verts += num_diced_verts;
+
 	/* interpolate center points for attributes */
 	foreach(Attribute& attr, subd_attributes.attributes) {
 #ifdef WITH_OPENSUBDIV
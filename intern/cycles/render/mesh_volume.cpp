@@ -21,6 +21,7 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_sparse_grid.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -357,6 +358,8 @@ void VolumeMeshBuilder::convert_quads_to_tris(const vector<QuadData> &quads,
 struct VoxelAttributeGrid {
 	float *data;
 	int channels;
+	/* Tile offsets if the grid is stored sparse. */
+	const int *tile_offsets;
 };
 
 void MeshManager::create_volume_mesh(Scene *scene,
@@ -394,6 +397,7 @@ void MeshManager::create_volume_mesh(Scene *scene,
 		VoxelAttributeGrid voxel_grid;
 		voxel_grid.data = static_cast<float*>(image_memory->host_pointer);
 		voxel_grid.channels = image_memory->data_elements;
+		voxel_grid.tile_offsets = static_cast<const int*>(image_memory->grid_info);
 		voxel_grids.push_back(voxel_grid);
 	}
 
@@ -457,9 +461,20 @@ void MeshManager::create_volume_mesh(Scene *scene,
 				for(size_t i = 0; i < voxel_grids.size(); ++i) {
 					const VoxelAttributeGrid &voxel_grid = voxel_grids[i];
 					const int channels = voxel_grid.channels;
+					size_t index = voxel_index;
+
+					if(voxel_grid.tile_offsets) {
+						const int offset = voxel_grid.tile_offsets[
+						        sparse_grid_tile_index(x, y, z, resolution.x, resolution.y)];
+						/* Skip empty tiles, they are all zero. */
+						if(offset == 0 && isovalue > 0.0f) {
+							continue;
+						}
+						index = offset + sparse_grid_voxel_index(x, y, z);
+					}
 
 					for(int c = 0; c < channels; c++) {
-						if(voxel_grid.data[voxel_index * channels + c] >= isovalue) {
+						if(voxel_grid.data[index * channels + c] >= isovalue) {
 							builder.add_node_with_padding(x, y, z);
 							break;
 						}
@@ -292,6 +292,42 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 	ShaderNode::attributes(shader, attributes);
 }
 
+/* Attribute of the UV map that the texture coordinates come from unmodified,
+ * so the kernel can look up their derivatives for filtering. */
+static uint image_texture_uv_attribute(SVMCompiler& compiler, ShaderInput *vector_in)
+{
+	ShaderOutput *link = vector_in->link;
+
+	/* Conversions between point and vector keep the value. */
+	while(link &&
+	      link->parent->special_type == SHADER_SPECIAL_TYPE_AUTOCONVERT &&
+	      SocketType::is_float3(link->type()))
+	{
+		link = link->parent->inputs[0]->link;
+	}
+
+	if(!link) {
+		return ATTR_STD_NOT_FOUND;
+	}
+
+	ShaderNode *node = link->parent;
+	if(node->type == UVMapNode::node_type) {
+		UVMapNode *uv_map = (UVMapNode*)node;
+		if(!uv_map->from_dupli) {
+			return (uv_map->attribute != "")? compiler.attribute(uv_map->attribute):
+			                                  compiler.attribute(ATTR_STD_UV);
+		}
+	}
+	else if(node->type == TextureCoordinateNode::node_type) {
+		TextureCoordinateNode *texco = (TextureCoordinateNode*)node;
+		if(!texco->from_dupli && link == texco->output("UV")) {
+			return compiler.attribute(ATTR_STD_UV);
+		}
+	}
+
+	return ATTR_STD_NOT_FOUND;
+}
+
 void ImageTextureNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *vector_in = input("Vector");
@@ -326,6 +362,11 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 					compiler.stack_assign_if_linked(alpha_out),
 					srgb),
 				projection);
+
+			const bool use_uv_derivatives = (projection == NODE_IMAGE_PROJ_FLAT &&
+			                                 tex_mapping.skip());
+			compiler.add_node(use_uv_derivatives? image_texture_uv_attribute(compiler, vector_in):
+			                                      ATTR_STD_NOT_FOUND);
 		}
 		else {
 			compiler.add_node(NODE_TEX_IMAGE_BOX,
@@ -4342,16 +4383,16 @@ void MixNode::compile(SVMCompiler& compiler)
 	ShaderInput *color2_in = input("Color2");
 	ShaderOutput *color_out = output("Color");
 
+	/* Unlinked factor is stored in the node, and clamping is done by the
+	 * same node. */
 	compiler.add_node(NODE_MIX,
-		compiler.stack_assign(fac_in),
+		compiler.stack_assign_if_linked(fac_in),
 		compiler.stack_assign(color1_in),
 		compiler.stack_assign(color2_in));
-	compiler.add_node(NODE_MIX, type, compiler.stack_assign(color_out));
-
-	if(use_clamp) {
-		compiler.add_node(NODE_MIX, 0, compiler.stack_assign(color_out));
-		compiler.add_node(NODE_MIX, NODE_MIX_CLAMP, compiler.stack_assign(color_out));
-	}
+	compiler.add_node(NODE_MIX,
+		compiler.encode_uchar4(type, use_clamp),
+		compiler.stack_assign(color_out),
+		__float_as_int(fac));
 }
 
 void MixNode::compile(OSLCompiler& compiler)
@@ -5272,13 +5313,14 @@ void MathNode::compile(SVMCompiler& compiler)
 	ShaderInput *value2_in = input("Value2");
 	ShaderOutput *value_out = output("Value");
 
-	compiler.add_node(NODE_MATH, type, compiler.stack_assign(value1_in), compiler.stack_assign(value2_in));
-	compiler.add_node(NODE_MATH, compiler.stack_assign(value_out));
-
-	if(use_clamp) {
-		compiler.add_node(NODE_MATH, NODE_MATH_CLAMP, compiler.stack_assign(value_out));
-		compiler.add_node(NODE_MATH, compiler.stack_assign(value_out));
-	}
+	/* Unlinked values are stored in the node instead of being loaded on the
+	 * stack by separate nodes, and clamping is done by the same node. */
+	compiler.add_math_node(compiler.encode_uchar4(type, use_clamp),
+		compiler.stack_assign_if_linked(value1_in),
+		compiler.stack_assign_if_linked(value2_in),
+		compiler.stack_assign(value_out),
+		value1,
+		value2);
 }
 
 void MathNode::compile(OSLCompiler& compiler)
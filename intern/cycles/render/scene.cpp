@@ -16,6 +16,8 @@
 
 #include <stdlib.h>
 
+#include "bvh/bvh_cache.h"
+
 #include "render/background.h"
 #include "render/bake.h"
 #include "render/camera.h"
@@ -53,6 +55,7 @@ DeviceScene::DeviceScene(Device *device)
   prim_time(device, "__prim_time", MEM_TEXTURE),
   tri_shader(device, "__tri_shader", MEM_TEXTURE),
   tri_vnormal(device, "__tri_vnormal", MEM_TEXTURE),
+  tri_vnormal_packed(device, "__tri_vnormal_packed", MEM_TEXTURE),
   tri_vindex(device, "__tri_vindex", MEM_TEXTURE),
   tri_patch(device, "__tri_patch", MEM_TEXTURE),
   tri_patch_uv(device, "__tri_patch_uv", MEM_TEXTURE),
@@ -68,10 +71,13 @@ DeviceScene::DeviceScene(Device *device)
   attributes_float(device, "__attributes_float", MEM_TEXTURE),
   attributes_float3(device, "__attributes_float3", MEM_TEXTURE),
   attributes_uchar4(device, "__attributes_uchar4", MEM_TEXTURE),
+  attributes_ushort4(device, "__attributes_ushort4", MEM_TEXTURE),
   light_distribution(device, "__light_distribution", MEM_TEXTURE),
   lights(device, "__lights", MEM_TEXTURE),
   light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
   light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_TEXTURE),
+  light_tree_nodes(device, "__light_tree_nodes", MEM_TEXTURE),
+  light_tree_leaf_map(device, "__light_tree_leaf_map", MEM_TEXTURE),
   particles(device, "__particles", MEM_TEXTURE),
   svm_nodes(device, "__svm_nodes", MEM_TEXTURE),
   shaders(device, "__shaders", MEM_TEXTURE),
@@ -111,6 +117,7 @@ Scene::Scene(const SceneParams& params_, Device *device)
 Scene::~Scene()
 {
 	free_memory(true);
+	BVHCache::instance().remove_user(this);
 }
 
 void Scene::free_memory(bool final)
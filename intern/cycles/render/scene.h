@@ -77,6 +77,7 @@ public:
 	/* mesh */
 	device_vector<uint> tri_shader;
 	device_vector<float4> tri_vnormal;
+	device_vector<uint> tri_vnormal_packed;
 	device_vector<uint4> tri_vindex;
 	device_vector<uint> tri_patch;
 	device_vector<float2> tri_patch_uv;
@@ -100,12 +101,15 @@ public:
 	device_vector<float> attributes_float;
 	device_vector<float4> attributes_float3;
 	device_vector<uchar4> attributes_uchar4;
+	device_vector<ushort4> attributes_ushort4;
 
 	/* lights */
 	device_vector<KernelLightDistribution> light_distribution;
 	device_vector<KernelLight> lights;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<KernelLightTreeNode> light_tree_nodes;
+	device_vector<uint> light_tree_leaf_map;
 
 	/* particles */
 	device_vector<KernelParticle> particles;
@@ -165,9 +169,22 @@ public:
 	BVHType bvh_type;
 	bool use_bvh_spatial_split;
 	bool use_bvh_unaligned_nodes;
+	/* Store BVH4 and BVH8 node bounds quantized to 8 bits, and smooth
+	 * normals octahedral encoded, to reduce memory usage. */
+	bool use_bvh_compressed_nodes;
+	bool use_packed_normals;
 	int num_bvh_time_steps;
 	bool persistent_data;
+	/* Reuse BVHs of meshes with unchanged geometry between scene updates,
+	 * optionally also between sessions through files in the cache directory. */
+	bool use_bvh_cache;
+	bool use_bvh_disk_cache;
+	/* Size limit of the BVH cache files on disk, in megabytes. */
+	int bvh_disk_cache_size;
 	int texture_limit;
+	/* Load image textures on demand, with the cache size in megabytes. */
+	bool use_texture_cache;
+	int texture_cache_size;
 
 	SceneParams()
 	{
@@ -176,9 +193,16 @@ public:
 		bvh_type = BVH_DYNAMIC;
 		use_bvh_spatial_split = false;
 		use_bvh_unaligned_nodes = true;
+		use_bvh_compressed_nodes = false;
+		use_packed_normals = false;
 		num_bvh_time_steps = 0;
 		persistent_data = false;
+		use_bvh_cache = false;
+		use_bvh_disk_cache = false;
+		bvh_disk_cache_size = 4096;
 		texture_limit = 0;
+		use_texture_cache = false;
+		texture_cache_size = 4096;
 	}
 
 	bool modified(const SceneParams& params)
@@ -187,9 +211,16 @@ public:
 		&& bvh_type == params.bvh_type
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
+		&& use_bvh_compressed_nodes == params.use_bvh_compressed_nodes
+		&& use_packed_normals == params.use_packed_normals
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& use_bvh_cache == params.use_bvh_cache
+		&& use_bvh_disk_cache == params.use_bvh_disk_cache
+		&& bvh_disk_cache_size == params.bvh_disk_cache_size
+		&& texture_limit == params.texture_limit
+		&& use_texture_cache == params.use_texture_cache
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
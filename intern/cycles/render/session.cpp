@@ -33,6 +33,7 @@
 #include "util/util_logging.h"
 #include "util/util_math.h"
 #include "util/util_opengl.h"
+#include "util/util_system.h"
 #include "util/util_task.h"
 #include "util/util_time.h"
 
@@ -365,7 +366,7 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	Tile *tile;
 	int device_num = device->device_number(tile_device);
 
-	if(!tile_manager.next_tile(tile, device_num))
+	if(!tile_manager.next_tile(tile, device_num, system_cpu_thread_group()))
 		return false;
 
 	/* fill render tile */
@@ -861,6 +862,7 @@ bool Session::update_scene()
 	BakeManager *bake_manager = scene->bake_manager;
 
 	if(integrator->sampling_pattern == SAMPLING_PATTERN_CMJ ||
+	   params.adaptive_sampling ||
 	   bake_manager->get_baking())
 	{
 		int aa_samples = tile_manager.num_samples;
@@ -968,6 +970,8 @@ void Session::render()
 	task.update_progress_sample = function_bind(&Progress::add_samples, &this->progress, _1, _2);
 	task.need_finish_queue = params.progressive_refine;
 	task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
+	/* Adaptive sampling needs all samples of a tile to be rendered in one go. */
+	task.adaptive_sampling = params.adaptive_sampling && !params.progressive;
 	task.requested_tile_size = params.tile_size;
 	task.passes_size = tile_manager.params.get_passes_size();
 
@@ -58,6 +58,8 @@ public:
 
 	bool use_profiling;
 
+	bool adaptive_sampling;
+
 	bool display_buffer_linear;
 
 	bool use_denoising;
@@ -94,6 +96,8 @@ public:
 
 		use_profiling = false;
 
+		adaptive_sampling = false;
+
 		use_denoising = false;
 		denoising_passes = false;
 		denoising_radius = 8;
@@ -124,6 +128,7 @@ public:
 		&& pixel_size == params.pixel_size
 		&& threads == params.threads
 		&& use_profiling == params.use_profiling
+		&& adaptive_sampling == params.adaptive_sampling
 		&& display_buffer_linear == params.display_buffer_linear
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
@@ -208,6 +208,81 @@ string MeshStats::full_report(int indent_level)
 	return result;
 }
 
+/* BVH statistics. */
+
+NamedBVHStats::NamedBVHStats(const string& name, const BVHBuildStats& stats)
+ : name(name), stats(stats)
+{}
+
+string NamedBVHStats::full_report(int indent_level)
+{
+	const string indent(indent_level * kIndentNumSpaces, ' ');
+	const string double_indent = indent + string(kIndentNumSpaces, ' ');
+	string result = indent + name + ":\n";
+	result += string_printf("%sBuild time: %.3fs\n", double_indent.c_str(), stats.build_time);
+	result += string_printf("%sSAH cost: %.3f\n", double_indent.c_str(), stats.sah_cost);
+	result += string_printf("%sNodes: %s inner, %s leaf, %s unaligned\n",
+	                        double_indent.c_str(),
+	                        string_human_readable_number(stats.num_inner_nodes).c_str(),
+	                        string_human_readable_number(stats.num_leaf_nodes).c_str(),
+	                        string_human_readable_number(stats.num_unaligned_nodes).c_str());
+	result += string_printf("%sPrimitives: %s (%s references)\n",
+	                        double_indent.c_str(),
+	                        string_human_readable_number(stats.num_primitives).c_str(),
+	                        string_human_readable_number(stats.num_references).c_str());
+	result += string_printf("%sSplits: %s object, %s spatial, %s unaligned\n",
+	                        double_indent.c_str(),
+	                        string_human_readable_number(stats.num_object_splits).c_str(),
+	                        string_human_readable_number(stats.num_spatial_splits).c_str(),
+	                        string_human_readable_number(stats.num_unaligned_splits).c_str());
+	result += string_printf("%sPacked nodes memory: %s\n",
+	                        double_indent.c_str(),
+	                        string_human_readable_size(stats.packed_size).c_str());
+
+	result += double_indent + "Depth   Nodes      Leaves     BVH2 memory\n";
+	for(size_t depth = 0; depth < stats.depth_nodes.size(); depth++) {
+		result += string_printf("%s%-7d %-10s %-10s %s\n",
+		                        double_indent.c_str(),
+		                        (int)depth,
+		                        string_human_readable_number(stats.depth_nodes[depth]).c_str(),
+		                        string_human_readable_number(stats.depth_leaves[depth]).c_str(),
+		                        string_human_readable_size(stats.depth_size[depth]).c_str());
+	}
+
+	result += double_indent + "Leaf primitives   Leaves\n";
+	for(size_t num_primitives = 0; num_primitives < stats.leaf_primitives.size(); num_primitives++) {
+		if(stats.leaf_primitives[num_primitives] == 0) {
+			continue;
+		}
+		result += string_printf("%s%-17d %s\n",
+		                        double_indent.c_str(),
+		                        (int)num_primitives,
+		                        string_human_readable_number(stats.leaf_primitives[num_primitives]).c_str());
+	}
+
+	return result;
+}
+
+BVHStats::BVHStats() {
+}
+
+void BVHStats::add_entry(const NamedBVHStats& entry)
+{
+	if(entry.stats.num_inner_nodes + entry.stats.num_leaf_nodes == 0) {
+		return;
+	}
+	entries.push_back(entry);
+}
+
+string BVHStats::full_report(int indent_level)
+{
+	string result = "";
+	foreach(NamedBVHStats& entry, entries) {
+		result += entry.full_report(indent_level);
+	}
+	return result;
+}
+
 /* Image statistics. */
 
 ImageStats::ImageStats() {
@@ -296,6 +371,7 @@ string RenderStats::full_report()
 {
 	string result = "";
 	result += "Mesh statistics:\n" + mesh.full_report(1);
+	result += "BVH statistics:\n" + bvh.full_report(1);
 	result += "Image statistics:\n" + image.full_report(1);
 	if(has_profiling) {
 		result += "Kernel statistics:\n" + kernel.full_report(1);
@@ -19,6 +19,8 @@
 
 #include "render/scene.h"
 
+#include "bvh/bvh.h"
+
 #include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_vector.h"
@@ -135,6 +137,33 @@ public:
 	NamedSizeStats textures;
 };
 
+/* Build statistics of a BVH, see BVHBuildStats. */
+class NamedBVHStats {
+public:
+	NamedBVHStats(const string& name, const BVHBuildStats& stats);
+
+	/* Generate full human-readable report. */
+	string full_report(int indent_level = 0);
+
+	string name;
+	BVHBuildStats stats;
+};
+
+/* Statistics about the scene BVH and the BVHs of instanced meshes. */
+class BVHStats {
+public:
+	BVHStats();
+
+	/* Add entry to the statistics, BVHs that were not built by Cycles itself
+	 * (Embree) have no statistics and are skipped. */
+	void add_entry(const NamedBVHStats& entry);
+
+	/* Generate full human-readable report. */
+	string full_report(int indent_level = 0);
+
+	vector<NamedBVHStats> entries;
+};
+
 /* Render process statistics. */
 class RenderStats {
 public:
@@ -149,6 +178,7 @@ public:
 	bool has_profiling;
 
 	MeshStats mesh;
+	BVHStats bvh;
 	ImageStats image;
 	NamedNestedSampleStats kernel;
 	NamedSampleCountStats shaders;
@@ -168,6 +168,8 @@ SVMCompiler::SVMCompiler(ShaderManager *shader_manager_,
 	background = false;
 	mix_weight_offset = SVM_STACK_INVALID;
 	compile_failed = false;
+	math_seq_start = -1;
+	math_seq_end = -1;
 }
 
 int SVMCompiler::stack_size(SocketType::Type type)
@@ -393,6 +395,49 @@ void SVMCompiler::add_node(const float4& f)
 		__float_as_int(f.w)));
 }
 
+void SVMCompiler::add_math_node(uint type_clamp,
+                                int f1_offset,
+                                int f2_offset,
+                                int out_offset,
+                                float value1,
+                                float value2)
+{
+	int index = current_svm_nodes.size();
+
+	/* When this node directly follows another math node, turn the header of
+	 * the first node of the run into NODE_MATH_SEQ and count this node in its
+	 * third byte, so the kernel runs the whole run without going through the
+	 * interpreter loop for every node. The other headers stay NODE_MATH, and
+	 * the code size does not change, so jumps into the middle of the run keep
+	 * working and execute the remaining nodes one by one. */
+	if(math_seq_start != -1 && math_seq_end == index) {
+		int4& head = current_svm_nodes[math_seq_start];
+		uint count = (((uint)head.y >> 16) & 0xFF) + 1;
+
+		if(count <= 255) {
+			head.x = NODE_MATH_SEQ;
+			head.y = ((uint)head.y & 0xFF00FFFF) | (count << 16);
+		}
+		else {
+			math_seq_start = index;
+		}
+	}
+	else {
+		math_seq_start = index;
+	}
+
+	add_node(NODE_MATH,
+	         (math_seq_start == index)? type_clamp | (1 << 16): type_clamp,
+	         f1_offset,
+	         f2_offset);
+	add_node(NODE_MATH,
+	         out_offset,
+	         __float_as_int(value1),
+	         __float_as_int(value2));
+
+	math_seq_end = current_svm_nodes.size();
+}
+
 uint SVMCompiler::attribute(ustring name)
 {
 	return shader_manager->get_attribute_id(name);
@@ -728,6 +773,8 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
 	/* clear all compiler state */
 	memset((void *)&active_stack, 0, sizeof(active_stack));
 	current_svm_nodes.clear();
+	math_seq_start = -1;
+	math_seq_end = -1;
 
 	foreach(ShaderNode *node_iter, graph->nodes) {
 		foreach(ShaderInput *input, node_iter->inputs)
@@ -31,6 +31,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class ImageManager;
+class LightManager;
 class Scene;
 class ShaderGraph;
 class ShaderInput;
@@ -118,6 +119,12 @@ public:
 	void add_node(int a = 0, int b = 0, int c = 0, int d = 0);
 	void add_node(ShaderNodeType type, const float3& f);
 	void add_node(const float4& f);
+	void add_math_node(uint type_clamp,
+	                   int f1_offset,
+	                   int f2_offset,
+	                   int out_offset,
+	                   float value1,
+	                   float value2);
 	uint attribute(ustring name);
 	uint attribute(AttributeStandard std);
 	uint attribute_standard(ustring name);
@@ -218,6 +225,12 @@ protected:
 	int max_stack_use;
 	uint mix_weight_offset;
 	bool compile_failed;
+
+	/* Index of the first node of the current run of math nodes, and of the
+	 * node following its last one. Consecutive math nodes are executed as
+	 * one NODE_MATH_SEQ instruction. */
+	int math_seq_start;
+	int math_seq_end;
 };
 
 CCL_NAMESPACE_END
@@ -18,6 +18,7 @@
 
 #include "util/util_algorithm.h"
 #include "util/util_foreach.h"
+#include "util/util_system.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -99,6 +100,7 @@ TileManager::TileManager(bool progressive_, int num_samples_, int2 tile_size_, i
 	pixel_size = pixel_size_;
 	num_samples = num_samples_;
 	num_devices = num_devices_;
+	num_groups = system_cpu_group_count();
 	preserve_tile_device = preserve_tile_device_;
 	background = background_;
 	schedule_denoising = false;
@@ -462,7 +464,7 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
 	}
 }
 
-bool TileManager::next_tile(Tile* &tile, int device)
+bool TileManager::next_tile(Tile* &tile, int device, int group)
 {
 	int logical_device = preserve_tile_device? device: 0;
 
@@ -479,8 +481,17 @@ bool TileManager::next_tile(Tile* &tile, int device)
 	if(state.render_tiles[logical_device].empty())
 		return false;
 
-	int idx = state.render_tiles[logical_device].front();
-	state.render_tiles[logical_device].pop_front();
+	list<int>& render_tiles = state.render_tiles[logical_device];
+	list<int>::iterator it = render_tiles.begin();
+	if(group > 0 && group < num_groups) {
+		/* Every group starts at its own fraction of the tile order, so threads
+		 * of one NUMA node work on neighboring tiles which share geometry and
+		 * textures in the node's caches. */
+		std::advance(it, (render_tiles.size() * group) / num_groups);
+	}
+
+	int idx = *it;
+	render_tiles.erase(it);
 	tile = &state.tiles[idx];
 	return true;
 }
@@ -95,7 +95,7 @@ public:
 	void reset(BufferParams& params, int num_samples);
 	void set_samples(int num_samples);
 	bool next();
-	bool next_tile(Tile* &tile, int device = 0);
+	bool next_tile(Tile* &tile, int device = 0, int group = -1);
 	bool finish_tile(int index, bool& delete_tile);
 	bool done();
 
@@ -125,6 +125,10 @@ protected:
 	int pixel_size;
 	int num_devices;
 
+	/* Number of CPU groups (NUMA nodes), render threads bound to different
+	 * groups take tiles from different parts of the tile order. */
+	int num_groups;
+
 	/* in some cases it is important that the same tile will be returned for the same
 	 * device it was originally generated for (i.e. viewport rendering when buffer is
 	 * allocating once for tile and then always used by it)
@@ -24,39 +24,28 @@ CCL_NAMESPACE_BEGIN
 
 /* EdgeDice Base */
 
-EdgeDice::EdgeDice(const SubdParams& params_)
-: params(params_)
+EdgeDice::EdgeDice(const SubdParams& params_, DicedFace *diced_)
+: params(params_), diced(diced_)
 {
-	mesh_P = NULL;
-	mesh_N = NULL;
 	vert_offset = 0;
-
-	params.mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
-
-	if(params.ptex) {
-		params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-	}
 }
 
 void EdgeDice::reserve(int num_verts)
 {
-	Mesh *mesh = params.mesh;
+	vert_offset = diced->P.size();
 
-	vert_offset = mesh->verts.size();
-	tri_offset = mesh->num_triangles();
+	size_t size = vert_offset + num_verts;
 
-	/* todo: optimize so we can reserve in advance, this is like push_back_slow() */
-	if(vert_offset + num_verts > mesh->verts.capacity()) {
-		mesh->reserve_mesh(size_t((vert_offset + num_verts) * 1.2), mesh->num_triangles());
+	if(size > diced->P.capacity()) {
+		size_t capacity = (size_t)(size * 1.2);
+		diced->P.reserve(capacity);
+		diced->N.reserve(capacity);
+		diced->uv.reserve(capacity);
 	}
 
-	mesh->resize_mesh(vert_offset + num_verts, tri_offset);
-
-	Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
-
-	mesh_P = mesh->verts.data();
-	mesh_N = attr_vN->data_float3();
+	diced->P.resize(size);
+	diced->N.resize(size);
+	diced->uv.resize(size);
 }
 
 int EdgeDice::add_vert(Patch *patch, float2 uv)
@@ -65,45 +54,25 @@ int EdgeDice::add_vert(Patch *patch, float2 uv)
 
 	patch->eval(&P, NULL, NULL, &N, uv.x, uv.y);
 
-	assert(vert_offset < params.mesh->verts.size());
+	assert(vert_offset < diced->P.size());
 
-	mesh_P[vert_offset] = P;
-	mesh_N[vert_offset] = N;
-	params.mesh->vert_patch_uv[vert_offset] = make_float2(uv.x, uv.y);
-
-	if(params.ptex) {
-		Attribute *attr_ptex_uv = params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.resize();
-
-		float3 *ptex_uv = attr_ptex_uv->data_float3();
-		ptex_uv[vert_offset] = make_float3(uv.x, uv.y, 0.0f);
-	}
-
-	params.mesh->num_subd_verts++;
+	diced->P[vert_offset] = P;
+	diced->N[vert_offset] = N;
+	diced->uv[vert_offset] = uv;
 
 	return vert_offset++;
 }
 
 void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
 {
-	Mesh *mesh = params.mesh;
-
-	/* todo: optimize so we can reserve in advance, this is like push_back_slow() */
-	if(mesh->triangles.size() == mesh->triangles.capacity())
-		mesh->reserve_mesh(mesh->verts.size(), size_t(max(mesh->num_triangles() + 1, 1) * 1.2));
-
-	mesh->add_triangle(v0, v1, v2, patch->shader, true);
-	params.mesh->triangle_patch[params.mesh->num_triangles()-1] = patch->patch_index;
+	diced->triangles.push_back_slow(v0);
+	diced->triangles.push_back_slow(v1);
+	diced->triangles.push_back_slow(v2);
+	diced->patch.push_back_slow(patch->patch_index);
 
 	if(params.ptex) {
-		Attribute *attr_ptex_face_id = params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-		params.mesh->attributes.resize();
-
-		float *ptex_face_id = attr_ptex_face_id->data_float();
-		ptex_face_id[tri_offset] = (float)patch->ptex_face_id();
+		diced->ptex_face_id.push_back_slow((float)patch->ptex_face_id());
 	}
-
-	tri_offset++;
 }
 
 void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& inner)
@@ -129,8 +98,8 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 		}
 		else {
 			/* length of diagonals */
-			float len1 = len_squared(mesh_P[inner[i]] - mesh_P[outer[j+1]]);
-			float len2 = len_squared(mesh_P[outer[j]] - mesh_P[inner[i+1]]);
+			float len1 = len_squared(diced->P[inner[i]] - diced->P[outer[j+1]]);
+			float len2 = len_squared(diced->P[outer[j]] - diced->P[inner[i+1]]);
 
 			/* use smallest diagonal */
 			if(len1 < len2)
@@ -145,8 +114,8 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 
 /* QuadDice */
 
-QuadDice::QuadDice(const SubdParams& params_)
-: EdgeDice(params_)
+QuadDice::QuadDice(const SubdParams& params_, DicedFace *diced_)
+: EdgeDice(params_, diced_)
 {
 }
 
@@ -319,7 +288,7 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	Mv = max((int)ceil(S*Mv), 2); // XXX handle 0 & 1?
 
 	/* reserve space for new verts */
-	int offset = params.mesh->verts.size();
+	int offset = diced->P.size();
 	reserve(ef, Mu, Mv);
 
 	/* corners and inner grid */
@@ -344,7 +313,7 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	add_side_v(sub, outer, inner, Mu, Mv, ef.tv1, 1, offset);
 	stitch_triangles(sub.patch, outer, inner);
 
-	assert(vert_offset == params.mesh->verts.size());
+	assert(vert_offset == diced->P.size());
 }
 
 CCL_NAMESPACE_END
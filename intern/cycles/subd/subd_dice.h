@@ -22,6 +22,7 @@
  * DiagSplit. For more algorithm details, see the DiagSplit paper or the
  * ARB_tessellation_shader OpenGL extension, Section 2.X.2. */
 
+#include "util/util_array.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
 
@@ -41,6 +42,7 @@ struct SubdParams {
 	int max_level;
 	Camera *camera;
 	Transform objecttoworld;
+	bool use_dicing_cache;
 
 	SubdParams(Mesh *mesh_, bool ptex_ = false)
 	{
@@ -52,21 +54,67 @@ struct SubdParams {
 		dicing_rate = 1.0f;
 		max_level = 12;
 		camera = NULL;
+		use_dicing_cache = false;
 	}
 
 };
 
+/* Diced Face
+ *
+ * Geometry diced from all subpatches of one face, with vertex indices local
+ * to the face. The edge factors and coordinates of the subpatches are kept
+ * along with it, so the face can be reused as long as it splits the same. */
+
+struct DicedFace {
+	/* Split result: 4 edge factors and 4 corner coordinates per subpatch. */
+	array<int> edge_factors;
+	array<float2> corners;
+
+	array<float3> P;
+	array<float3> N;
+	array<float2> uv;
+	array<int> triangles;
+	array<int> patch;
+	array<float> ptex_face_id;
+
+	void clear()
+	{
+		edge_factors.clear();
+		corners.clear();
+		P.clear();
+		N.clear();
+		uv.clear();
+		triangles.clear();
+		patch.clear();
+		ptex_face_id.clear();
+	}
+};
+
+/* Dicing Cache
+ *
+ * Diced faces of a mesh along with the control mesh they were diced from,
+ * kept between tessellations when SubdParams.use_dicing_cache is set. */
+
+struct DicingCache {
+	int subdivision_type;
+	array<float3> verts;
+	array<int> face_corners;
+	array<int> faces;
+	array<int> crease_verts;
+	array<float> creases;
+
+	vector<DicedFace> diced_faces;
+};
+
 /* EdgeDice Base */
 
 class EdgeDice {
 public:
 	SubdParams params;
-	float3 *mesh_P;
-	float3 *mesh_N;
+	DicedFace *diced;
 	size_t vert_offset;
-	size_t tri_offset;
 
-	explicit EdgeDice(const SubdParams& params);
+	EdgeDice(const SubdParams& params, DicedFace *diced);
 
 	void reserve(int num_verts);
 
@@ -107,7 +155,7 @@ public:
 		int tv1;
 	};
 
-	explicit QuadDice(const SubdParams& params);
+	QuadDice(const SubdParams& params, DicedFace *diced);
 
 	void reserve(EdgeFactors& ef, int Mu, int Mv);
 	float3 eval_projected(SubPatch& sub, float u, float v);
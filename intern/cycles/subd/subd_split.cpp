@@ -35,10 +35,34 @@ DiagSplit::DiagSplit(const SubdParams& params_)
 
 void DiagSplit::dispatch(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef)
 {
+	ef.tu0 = max(ef.tu0, 1);
+	ef.tu1 = max(ef.tu1, 1);
+	ef.tv0 = max(ef.tv0, 1);
+	ef.tv1 = max(ef.tv1, 1);
+
 	subpatches_quad.push_back(sub);
 	edgefactors_quad.push_back(ef);
 }
 
+/* Round edge factor up to 3 significant bits, so that small changes in
+ * projected edge length don't change the tessellation and cached dicing
+ * can be reused. Rounding is a function of the edge factor only, so edges
+ * shared between patches still get the same factor. */
+static int quantize_edge_factor(int t)
+{
+	if(t <= 8) {
+		return t;
+	}
+
+	int shift = 0;
+	while((t >> shift) >= 8) {
+		shift++;
+	}
+
+	int step = 1 << shift;
+	return (t + step - 1) & ~(step - 1);
+}
+
 float3 DiagSplit::to_world(Patch *patch, float2 uv)
 {
 	float3 P;
@@ -87,6 +111,9 @@ int DiagSplit::T(Patch *patch, float2 Pstart, float2 Pend)
 	if(tmax - tmin > params.split_threshold)
 		return DSPLIT_NON_UNIFORM;
 
+	if(params.use_dicing_cache)
+		return quantize_edge_factor(tmax);
+
 	return tmax;
 }
 
@@ -238,21 +265,74 @@ void DiagSplit::split_quad(Patch *patch, QuadDice::SubPatch *subpatch)
 	limit_edge_factors(sub_split, ef_split, 1 << params.max_level);
 
 	split(sub_split, ef_split);
+}
 
-	QuadDice dice(params);
+bool DiagSplit::split_matches(const DicedFace& diced)
+{
+	size_t num_subpatches = subpatches_quad.size();
 
-	for(size_t i = 0; i < subpatches_quad.size(); i++) {
+	if(diced.edge_factors.size() != num_subpatches*4 ||
+	   diced.corners.size() != num_subpatches*4)
+	{
+		return false;
+	}
+
+	for(size_t i = 0; i < num_subpatches; i++) {
+		const QuadDice::SubPatch& sub = subpatches_quad[i];
+		const QuadDice::EdgeFactors& ef = edgefactors_quad[i];
+		const int *diced_ef = &diced.edge_factors[i*4];
+		const float2 *diced_P = &diced.corners[i*4];
+
+		if(ef.tu0 != diced_ef[0] || ef.tu1 != diced_ef[1] ||
+		   ef.tv0 != diced_ef[2] || ef.tv1 != diced_ef[3])
+		{
+			return false;
+		}
+
+		if(sub.P00 != diced_P[0] || sub.P10 != diced_P[1] ||
+		   sub.P01 != diced_P[2] || sub.P11 != diced_P[3])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void DiagSplit::dice(DicedFace *diced)
+{
+	size_t num_subpatches = subpatches_quad.size();
+
+	diced->clear();
+	diced->edge_factors.resize(num_subpatches*4);
+	diced->corners.resize(num_subpatches*4);
+
+	QuadDice dice(params, diced);
+
+	for(size_t i = 0; i < num_subpatches; i++) {
 		QuadDice::SubPatch& sub = subpatches_quad[i];
 		QuadDice::EdgeFactors& ef = edgefactors_quad[i];
 
-		ef.tu0 = max(ef.tu0, 1);
-		ef.tu1 = max(ef.tu1, 1);
-		ef.tv0 = max(ef.tv0, 1);
-		ef.tv1 = max(ef.tv1, 1);
+		int *diced_ef = &diced->edge_factors[i*4];
+		diced_ef[0] = ef.tu0;
+		diced_ef[1] = ef.tu1;
+		diced_ef[2] = ef.tv0;
+		diced_ef[3] = ef.tv1;
+
+		float2 *diced_P = &diced->corners[i*4];
+		diced_P[0] = sub.P00;
+		diced_P[1] = sub.P10;
+		diced_P[2] = sub.P01;
+		diced_P[3] = sub.P11;
 
 		dice.dice(sub, ef);
 	}
 
+	clear();
+}
+
+void DiagSplit::clear()
+{
 	subpatches_quad.clear();
 	edgefactors_quad.clear();
 }
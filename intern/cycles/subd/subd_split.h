@@ -51,7 +51,15 @@ public:
 	void dispatch(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef);
 	void split(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef, int depth=0);
 
+	/* Split patch into subpatches, which are collected until dice(). */
 	void split_quad(Patch *patch, QuadDice::SubPatch *subpatch=NULL);
+
+	/* Test if diced was created from the same subpatches as split now. */
+	bool split_matches(const DicedFace& diced);
+
+	/* Dice collected subpatches into diced, and clear them. */
+	void dice(DicedFace *diced);
+	void clear();
 };
 
 CCL_NAMESPACE_END
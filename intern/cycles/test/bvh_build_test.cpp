@@ -0,0 +1,197 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh.h"
+#include "bvh/bvh_build.h"
+#include "bvh/bvh_node.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_hash.h"
+#include "util/util_progress.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int NUM_SOUP_TRIANGLES = 2000;
+
+float3 soup_random_float3(uint *seed)
+{
+	const float x = hash_int_01((*seed)++);
+	const float y = hash_int_01((*seed)++);
+	const float z = hash_int_01((*seed)++);
+	return make_float3(x, y, z);
+}
+
+/* Fixed soup of long and thin triangles in random directions. The triangles
+ * overlap a lot, which is the case spatial splits are meant for.
+ */
+void build_triangle_soup(Mesh *mesh, int num_triangles)
+{
+	mesh->reserve_mesh(num_triangles * 3, num_triangles);
+
+	uint seed = 0;
+	for(int i = 0; i < num_triangles; i++) {
+		const float3 p = soup_random_float3(&seed) * 10.0f;
+		const float3 dir = normalize(soup_random_float3(&seed) - make_float3(0.5f, 0.5f, 0.5f));
+		const float3 side = soup_random_float3(&seed) * 0.1f;
+
+		mesh->add_vertex(p);
+		mesh->add_vertex(p + dir * 5.0f);
+		mesh->add_vertex(p + side);
+		mesh->add_triangle(i * 3, i * 3 + 1, i * 3 + 2, 0, false);
+	}
+}
+
+/* Builds the binary tree like BVH::build() does, without packing it. */
+class SoupBuild {
+public:
+	explicit SoupBuild(bool use_spatial_split)
+	{
+		build_triangle_soup(&mesh, NUM_SOUP_TRIANGLES);
+		object.mesh = &mesh;
+		objects.push_back(&object);
+
+		params.use_spatial_split = use_spatial_split;
+
+		BVHBuild bvh_build(objects,
+		                   prim_type,
+		                   prim_index,
+		                   prim_object,
+		                   prim_time,
+		                   params,
+		                   progress);
+		root = bvh_build.run();
+		stats = bvh_build.stats;
+	}
+
+	~SoupBuild()
+	{
+		if(root) {
+			root->deleteSubtree();
+		}
+	}
+
+	Mesh mesh;
+	Object object;
+	vector<Object*> objects;
+	BVHParams params;
+	Progress progress;
+	array<int> prim_type;
+	array<int> prim_index;
+	array<int> prim_object;
+	array<float2> prim_time;
+
+	BVHNode *root;
+	BVHBuildStats stats;
+};
+
+/* Counters that follow from the tree alone, for any settings. */
+void check_stats_match_tree(const SoupBuild& build)
+{
+	const BVHBuildStats& stats = build.stats;
+	const BVHNode *root = build.root;
+
+	ASSERT_NE(root, (BVHNode*)NULL);
+
+	EXPECT_EQ(stats.num_primitives, (size_t)NUM_SOUP_TRIANGLES);
+	EXPECT_EQ(stats.num_inner_nodes, (size_t)root->getSubtreeSize(BVH_STAT_INNER_COUNT));
+	EXPECT_EQ(stats.num_leaf_nodes, (size_t)root->getSubtreeSize(BVH_STAT_LEAF_COUNT));
+	EXPECT_EQ(stats.num_references, (size_t)root->getSubtreeSize(BVH_STAT_TRIANGLE_COUNT));
+	EXPECT_EQ(stats.num_leaf_nodes, stats.num_inner_nodes + 1);
+
+	/* One split per inner node, a soup of triangles has no leaves with mixed
+	 * primitive types that would add inner nodes without a split. */
+	EXPECT_EQ(stats.num_object_splits + stats.num_spatial_splits + stats.num_unaligned_splits,
+	          stats.num_inner_nodes);
+	EXPECT_EQ(stats.num_unaligned_splits, 0);
+	EXPECT_EQ(stats.num_unaligned_nodes, 0);
+
+	EXPECT_FLOAT_EQ(stats.sah_cost, root->computeSubtreeSAHCost(build.params));
+
+	size_t num_depth_nodes = 0, num_depth_leaves = 0;
+	for(size_t depth = 0; depth < stats.depth_nodes.size(); depth++) {
+		num_depth_nodes += stats.depth_nodes[depth];
+		num_depth_leaves += stats.depth_leaves[depth];
+	}
+	EXPECT_EQ(num_depth_nodes, stats.num_inner_nodes + stats.num_leaf_nodes);
+	EXPECT_EQ(num_depth_leaves, stats.num_leaf_nodes);
+	EXPECT_EQ(stats.depth_nodes[0], 1);
+
+	size_t num_histogram_leaves = 0, num_histogram_references = 0;
+	for(size_t i = 0; i < stats.leaf_primitives.size(); i++) {
+		num_histogram_leaves += stats.leaf_primitives[i];
+		num_histogram_references += stats.leaf_primitives[i] * i;
+	}
+	EXPECT_EQ(num_histogram_leaves, stats.num_leaf_nodes);
+	EXPECT_EQ(num_histogram_references, stats.num_references);
+}
+
+void print_stats(const char *name, const BVHBuildStats& stats)
+{
+	printf("%s: %.2f ms, SAH cost %.2f, %d inner nodes, "
+	       "%d object splits, %d spatial splits, %d references\n",
+	       name,
+	       stats.build_time * 1000.0,
+	       (double)stats.sah_cost,
+	       (int)stats.num_inner_nodes,
+	       (int)stats.num_object_splits,
+	       (int)stats.num_spatial_splits,
+	       (int)stats.num_references);
+}
+
+}  // namespace
+
+TEST(bvh_build, stats_object_splits)
+{
+	SoupBuild build(false);
+	check_stats_match_tree(build);
+
+	/* Without spatial splits every triangle is referenced once. */
+	EXPECT_EQ(build.stats.num_spatial_splits, 0);
+	EXPECT_EQ(build.stats.num_references, build.stats.num_primitives);
+	EXPECT_GT(build.stats.num_object_splits, 0);
+}
+
+TEST(bvh_build, stats_spatial_splits)
+{
+	SoupBuild build(true);
+	check_stats_match_tree(build);
+
+	/* Spatial splits duplicate the references of the split triangles. */
+	EXPECT_GT(build.stats.num_spatial_splits, 0);
+	EXPECT_GT(build.stats.num_references, build.stats.num_primitives);
+}
+
+/* Prints the build time and quality of both settings for the same soup,
+ * spatial splits are expected to give the cheaper tree. */
+TEST(bvh_build, stats_benchmark)
+{
+	SoupBuild object_build(false);
+	SoupBuild spatial_build(true);
+
+	print_stats("Object splits", object_build.stats);
+	print_stats("Spatial splits", spatial_build.stats);
+
+	EXPECT_LT(spatial_build.stats.sah_cost, object_build.stats.sah_cost);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh.h"
+#include "bvh/bvh2.h"
+#include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_progress.h"
+#include "util/util_transform.h"
+#include "util/util_task.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const uint NODE_TYPE_FLAGS = PATH_RAY_NODE_UNALIGNED | PATH_RAY_NODE_COMPRESSED;
+
+/* Regular grid of triangles, big enough to get several levels of inner
+ * nodes in every layout.
+ */
+void build_grid_mesh(Mesh *mesh, int resolution)
+{
+	const int num_verts = (resolution + 1) * (resolution + 1);
+	const int num_tris = resolution * resolution * 2;
+
+	mesh->reserve_mesh(num_verts, num_tris);
+
+	for(int y = 0; y <= resolution; y++) {
+		for(int x = 0; x <= resolution; x++) {
+			mesh->add_vertex(make_float3((float)x, (float)y, (float)((x * y) % 3)));
+		}
+	}
+
+	for(int y = 0; y < resolution; y++) {
+		for(int x = 0; x < resolution; x++) {
+			const int v0 = y * (resolution + 1) + x;
+			const int v1 = v0 + 1;
+			const int v2 = v0 + resolution + 1;
+			const int v3 = v2 + 1;
+			mesh->add_triangle(v0, v1, v3, 0, false);
+			mesh->add_triangle(v0, v3, v2, 0, false);
+		}
+	}
+}
+
+/* Type flags of the inner node at the given offset. */
+uint node_type_flags(const PackedBVH& pack, int idx)
+{
+	return (uint)pack.nodes[idx].x & NODE_TYPE_FLAGS;
+}
+
+/* Offset of the int4 holding the children of an inner node, in units of
+ * int4. Wide layouts store 4 or 8 children per row.
+ */
+int node_children_offset(BVHLayout layout, uint flags)
+{
+	const bool is_unaligned = (flags & PATH_RAY_NODE_UNALIGNED) != 0;
+	const bool is_compressed = (flags & PATH_RAY_NODE_COMPRESSED) != 0;
+	switch(layout) {
+		case BVH_LAYOUT_BVH4:
+			return (is_unaligned)? 13: (is_compressed)? 4: 7;
+		case BVH_LAYOUT_BVH8:
+			/* One float8 row is two int4. */
+			return 2 * ((is_unaligned)? 13: (is_compressed)? 3: 7);
+		default:
+			return 0;
+	}
+}
+
+/* Walk the inner nodes from the root and record their type flags. */
+void collect_node_flags(const PackedBVH& pack,
+                        BVHLayout layout,
+                        int idx,
+                        vector<uint> *flags)
+{
+	const uint node_flags = node_type_flags(pack, idx);
+	flags->push_back(node_flags);
+
+	int children[8];
+	int num_children;
+	if(layout == BVH_LAYOUT_BVH2) {
+		children[0] = pack.nodes[idx].z;
+		children[1] = pack.nodes[idx].w;
+		num_children = 2;
+	}
+	else {
+		const int offset = idx + node_children_offset(layout, node_flags);
+		num_children = (layout == BVH_LAYOUT_BVH8)? 8: 4;
+		for(int i = 0; i < num_children; i++) {
+			children[i] = pack.nodes[offset + i / 4][i % 4];
+		}
+	}
+
+	/* Negative indices are leaves and 0 is an empty slot, the root is never
+	 * referenced as a child.
+	 */
+	for(int i = 0; i < num_children; i++) {
+		if(children[i] > 0) {
+			collect_node_flags(pack, layout, children[i], flags);
+		}
+	}
+}
+
+void test_pack_refit(BVHLayout layout, bool use_compressed_nodes)
+{
+	Mesh mesh;
+	build_grid_mesh(&mesh, 32);
+
+	/* Same setup as Mesh::compute_bvh(): default object with all visibility
+	 * bits set, including the bits reused as node type flags.
+	 */
+	Object object;
+	object.mesh = &mesh;
+	ASSERT_NE(object.visibility & PATH_RAY_NODE_COMPRESSED, 0);
+
+	vector<Object*> objects;
+	objects.push_back(&object);
+
+	BVHParams params;
+	params.bvh_layout = layout;
+	params.use_compressed_nodes = use_compressed_nodes;
+
+	BVH *bvh = BVH::create(params, objects);
+	Progress progress;
+	bvh->build(progress);
+
+	ASSERT_EQ(bvh->pack.root_index, 0);
+
+	vector<uint> built_flags;
+	collect_node_flags(bvh->pack, layout, 0, &built_flags);
+	ASSERT_GT(built_flags.size(), 1);
+
+	const bool expect_compressed = use_compressed_nodes && layout != BVH_LAYOUT_BVH2;
+	for(size_t i = 0; i < built_flags.size(); i++) {
+		EXPECT_EQ((built_flags[i] & PATH_RAY_NODE_COMPRESSED) != 0, expect_compressed);
+		EXPECT_EQ(built_flags[i] & PATH_RAY_NODE_UNALIGNED, 0);
+	}
+
+	bvh->refit(progress);
+
+	vector<uint> refit_flags;
+	collect_node_flags(bvh->pack, layout, 0, &refit_flags);
+	EXPECT_EQ(refit_flags, built_flags);
+
+	delete bvh;
+}
+
+/* Bounds of a subtree of a top level BVH2 from the current geometry. Counts
+ * the children whose bounds stored in the node don't contain them.
+ */
+BoundBox check_subtree_bounds(const BVH *bvh, int idx, bool leaf, int *num_errors)
+{
+	const PackedBVH& pack = bvh->pack;
+	BoundBox bounds = BoundBox::empty;
+
+	if(leaf) {
+		const int4 data = pack.leaf_nodes[idx];
+		if(data.x < 0) {
+			/* Object instance. */
+			bounds.grow(bvh->objects[pack.prim_object[~data.x]]->bounds);
+		}
+		else {
+			for(int prim = data.x; prim < data.y; prim++) {
+				const Mesh *mesh = bvh->objects[pack.prim_object[prim]]->mesh;
+				Mesh::Triangle t = mesh->get_triangle(pack.prim_index[prim] - mesh->tri_offset);
+				t.bounds_grow(&mesh->verts[0], bounds);
+			}
+		}
+		return bounds;
+	}
+
+	const int4 *data = &pack.nodes[idx];
+	const int children[2] = {data[0].z, data[0].w};
+
+	for(int i = 0; i < 2; i++) {
+		const int c = children[i];
+		const BoundBox child_bounds = check_subtree_bounds(bvh, (c < 0)? -c-1: c, c < 0, num_errors);
+		const float3 node_min = make_float3(__int_as_float(data[1][i]),
+		                                    __int_as_float(data[2][i]),
+		                                    __int_as_float(data[3][i]));
+		const float3 node_max = make_float3(__int_as_float(data[1][i + 2]),
+		                                    __int_as_float(data[2][i + 2]),
+		                                    __int_as_float(data[3][i + 2]));
+		if(min3(child_bounds.min - node_min) < 0.0f ||
+		   max3(child_bounds.max - node_max) > 0.0f)
+		{
+			(*num_errors)++;
+		}
+		bounds.grow(child_bounds);
+	}
+
+	return bounds;
+}
+
+}  // namespace
+
+TEST(bvh_pack, bvh2_top_level_refit)
+{
+	TaskScheduler::init(0);
+
+	/* Mesh with transform applied, its triangles are in the top level BVH. */
+	Mesh applied_mesh;
+	build_grid_mesh(&applied_mesh, 16);
+	applied_mesh.transform_applied = true;
+	applied_mesh.tri_offset = 0;
+
+	/* Instanced mesh with its own BVH. */
+	Mesh instanced_mesh;
+	build_grid_mesh(&instanced_mesh, 16);
+	instanced_mesh.tri_offset = applied_mesh.num_triangles();
+	instanced_mesh.compute_bounds();
+
+	BVHParams params;
+	params.bvh_layout = BVH_LAYOUT_BVH2;
+
+	Object instance_object;
+	instance_object.mesh = &instanced_mesh;
+	vector<Object*> instance_objects;
+	instance_objects.push_back(&instance_object);
+
+	Progress progress;
+	instanced_mesh.bvh = BVH::create(params, instance_objects);
+	instanced_mesh.bvh->build(progress);
+
+	Object applied_object;
+	applied_object.mesh = &applied_mesh;
+	applied_mesh.compute_bounds();
+	applied_object.compute_bounds(false);
+
+	Object instanced_object;
+	instanced_object.mesh = &instanced_mesh;
+	instanced_object.tfm = transform_translate(make_float3(40.0f, 0.0f, 0.0f));
+	instanced_object.compute_bounds(false);
+
+	vector<Object*> objects;
+	objects.push_back(&applied_object);
+	objects.push_back(&instanced_object);
+
+	params.top_level = true;
+	BVH *bvh = BVH::create(params, objects);
+	bvh->build(progress);
+	ASSERT_EQ(bvh->pack.root_index, 0);
+
+	int num_errors = 0;
+	check_subtree_bounds(bvh, 0, false, &num_errors);
+	EXPECT_EQ(num_errors, 0);
+
+	/* Move both objects, the old node bounds no longer contain them. */
+	for(size_t i = 0; i < applied_mesh.verts.size(); i++) {
+		applied_mesh.verts[i] += make_float3(0.0f, 0.0f, 5.0f);
+	}
+	instanced_object.tfm = transform_translate(make_float3(-40.0f, 3.0f, 0.0f));
+	instanced_object.compute_bounds(false);
+
+	num_errors = 0;
+	check_subtree_bounds(bvh, 0, false, &num_errors);
+	EXPECT_GT(num_errors, 0);
+
+	bvh->refit(progress);
+
+	num_errors = 0;
+	check_subtree_bounds(bvh, 0, false, &num_errors);
+	EXPECT_EQ(num_errors, 0);
+
+	/* Triangle vertices of the top level primitives are updated, the merged
+	 * instance primitives are left in object space. */
+	const PackedBVH& pack = bvh->pack;
+	ASSERT_EQ(bvh->num_top_level_prims, (size_t)applied_mesh.num_triangles() + 1);
+	for(size_t i = 0; i < pack.prim_index.size(); i++) {
+		if(pack.prim_index[i] == -1) {
+			continue;
+		}
+		const Mesh *mesh = (i < bvh->num_top_level_prims)? &applied_mesh: &instanced_mesh;
+		Mesh::Triangle t = mesh->get_triangle(pack.prim_index[i] - mesh->tri_offset);
+		const float4 *tri_verts = &pack.prim_tri_verts[pack.prim_tri_index[i]];
+		for(int j = 0; j < 3; j++) {
+			EXPECT_EQ(float4_to_float3(tri_verts[j]), mesh->verts[t.v[j]]);
+		}
+	}
+
+	delete bvh;
+
+	TaskScheduler::exit();
+}
+
+TEST(bvh_pack, bvh2_refit)
+{
+	TaskScheduler::init(0);
+	test_pack_refit(BVH_LAYOUT_BVH2, false);
+	TaskScheduler::exit();
+}
+
+TEST(bvh_pack, bvh4_refit)
+{
+	TaskScheduler::init(0);
+	test_pack_refit(BVH_LAYOUT_BVH4, false);
+	TaskScheduler::exit();
+}
+
+TEST(bvh_pack, bvh4_compressed_refit)
+{
+	TaskScheduler::init(0);
+	test_pack_refit(BVH_LAYOUT_BVH4, true);
+	TaskScheduler::exit();
+}
+
+TEST(bvh_pack, bvh8_refit)
+{
+	TaskScheduler::init(0);
+	test_pack_refit(BVH_LAYOUT_BVH8, false);
+	TaskScheduler::exit();
+}
+
+TEST(bvh_pack, bvh8_compressed_refit)
+{
+	TaskScheduler::init(0);
+	test_pack_refit(BVH_LAYOUT_BVH8, true);
+	TaskScheduler::exit();
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/kernel_math.h"
+#include "kernel/kernel_types.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+#include "kernel/kernel_color.h"
+#include "kernel/kernels/cpu/kernel_cpu_image.h"
+#include "kernel/kernel_path.h"
+
+#include "render/svm.h"
+
+#include "util/util_time.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Gives access to the generated nodes. */
+class TestSVMCompiler : public SVMCompiler {
+public:
+	TestSVMCompiler()
+	: SVMCompiler(NULL, NULL, NULL)
+	{
+	}
+
+	array<int4>& nodes()
+	{
+		return current_svm_nodes;
+	}
+};
+
+const NodeMath math_types[] = {NODE_MATH_MULTIPLY,
+                               NODE_MATH_ADD,
+                               NODE_MATH_SUBTRACT,
+                               NODE_MATH_MAXIMUM};
+
+/* Displacement shader with a chain of math nodes, every one but each fourth
+ * using the result of the previous node. The last three results are stored
+ * as the displacement vector, so the result of the chain ends up in
+ * ShaderData.P.
+ */
+void compile_math_chain(TestSVMCompiler *compiler, int num_math)
+{
+	compiler->add_node(NODE_SHADER_JUMP, 1, 1, 1);
+
+	for(int i = 0; i < num_math; i++) {
+		const int f1_offset = (i % 4 == 0)? SVM_STACK_INVALID: (i - 1) % 3;
+		compiler->add_math_node(compiler->encode_uchar4(math_types[i % 4], i % 3 == 0),
+		                        f1_offset,
+		                        SVM_STACK_INVALID,
+		                        i % 3,
+		                        0.5f + i,
+		                        0.25f);
+	}
+
+	compiler->add_node(NODE_SET_DISPLACEMENT, 0);
+	compiler->add_node(NODE_END, 0, 0, 0);
+}
+
+/* Same nodes with every header a regular math node again. */
+void unfuse_math_nodes(array<int4>& nodes)
+{
+	for(size_t i = 0; i < nodes.size(); i++) {
+		if(nodes[i].x == NODE_MATH_SEQ) {
+			nodes[i].x = NODE_MATH;
+		}
+	}
+}
+
+class SVMEvaluator {
+public:
+	explicit SVMEvaluator(array<int4>& nodes)
+	{
+		memset((void*)&kg, 0, sizeof(kg));
+		kg.__svm_nodes.data = (uint4*)nodes.data();
+		kg.__svm_nodes.width = nodes.size();
+		memset((void*)&state, 0, sizeof(state));
+	}
+
+	float3 eval(int offset = 0)
+	{
+		ShaderData sd;
+		memset((void*)&sd, 0, sizeof(sd));
+		sd.shader = offset;
+		svm_eval_nodes(&kg, &sd, &state, SHADER_TYPE_DISPLACEMENT, 0);
+		return sd.P;
+	}
+
+	/* Average time of one evaluation in nanoseconds. */
+	double time_eval(int num_evals)
+	{
+		const double time_start = time_dt();
+		float3 sum = make_float3(0.0f, 0.0f, 0.0f);
+		for(int i = 0; i < num_evals; i++) {
+			sum += eval();
+		}
+		const double time = time_dt() - time_start;
+		EXPECT_TRUE(isfinite3_safe(sum));
+		return time * 1e9 / num_evals;
+	}
+
+private:
+	KernelGlobals kg;
+	PathState state;
+};
+
+}  // namespace
+
+TEST(render_svm, math_seq_encoding)
+{
+	TestSVMCompiler compiler;
+	compile_math_chain(&compiler, 4);
+	compiler.add_math_node(compiler.encode_uchar4(NODE_MATH_ADD), 0, 1, 2, 0.0f, 0.0f);
+
+	const array<int4>& nodes = compiler.nodes();
+	ASSERT_EQ(nodes.size(), (size_t)(1 + 4 * 2 + 2 + 2));
+
+	/* The first node of the run counts all of them, the others are left as
+	 * regular math nodes. */
+	EXPECT_EQ(nodes[1].x, NODE_MATH_SEQ);
+	EXPECT_EQ(((uint)nodes[1].y >> 16) & 0xFF, 4u);
+	for(int i = 1; i < 4; i++) {
+		EXPECT_EQ(nodes[1 + i * 2].x, NODE_MATH);
+	}
+
+	/* A math node after another node starts a new run. */
+	EXPECT_EQ(nodes[11].x, NODE_MATH);
+	EXPECT_EQ(((uint)nodes[11].y >> 16) & 0xFF, 1u);
+}
+
+TEST(render_svm, math_seq_eval)
+{
+	/* All three displacement components are written from three nodes on. */
+	for(int num_math = 3; num_math <= 16; num_math++) {
+		TestSVMCompiler compiler;
+		compile_math_chain(&compiler, num_math);
+
+		array<int4> fused_nodes = compiler.nodes();
+		array<int4> nodes = fused_nodes;
+		unfuse_math_nodes(nodes);
+
+		SVMEvaluator fused(fused_nodes), unfused(nodes);
+		EXPECT_EQ(fused.eval(), unfused.eval());
+	}
+}
+
+TEST(render_svm, math_seq_jump_into_run)
+{
+	TestSVMCompiler compiler;
+	compile_math_chain(&compiler, 8);
+
+	array<int4> fused_nodes = compiler.nodes();
+	array<int4> nodes = fused_nodes;
+	unfuse_math_nodes(nodes);
+
+	/* Entering the run at a later node executes the remaining nodes one by
+	 * one, like a jump over a conditionally skipped part of a shader. The
+	 * fifth node does not read the result of the skipped ones. */
+	fused_nodes[0].w = 1 + 4 * 2;
+	nodes[0].w = 1 + 4 * 2;
+
+	SVMEvaluator fused(fused_nodes), unfused(nodes);
+	EXPECT_EQ(fused.eval(), unfused.eval());
+}
+
+/* Not a correctness test, prints the interpreter time per math node with
+ * and without fusion. */
+TEST(render_svm, math_seq_benchmark)
+{
+	const int num_evals = 200000;
+
+	for(int num_math = 4; num_math <= 16; num_math *= 2) {
+		TestSVMCompiler compiler;
+		compile_math_chain(&compiler, num_math);
+
+		array<int4> fused_nodes = compiler.nodes();
+		array<int4> nodes = fused_nodes;
+		unfuse_math_nodes(nodes);
+
+		SVMEvaluator fused(fused_nodes), unfused(nodes);
+
+		double time_fused = 1e10, time_unfused = 1e10;
+		for(int i = 0; i < 5; i++) {
+			time_unfused = min(time_unfused, unfused.time_eval(num_evals));
+			time_fused = min(time_fused, fused.time_eval(num_evals));
+		}
+
+		printf("%2d math nodes: %.2f ns/node separate, %.2f ns/node fused, %.2fx\n",
+		       num_math,
+		       time_unfused / num_math,
+		       time_fused / num_math,
+		       time_unfused / time_fused);
+	}
+}
+
+CCL_NAMESPACE_END
@@ -21,6 +21,8 @@
 
 #include <OpenImageIO/imageio.h>
 
+#include "util/util_half.h"
+#include "util/util_math.h"
 #include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -100,6 +102,49 @@ inline half util_image_cast_from_float(float value)
 	return float_to_half(value);
 }
 
+/* Only float pixels can have non-finite values. */
+template<typename T>
+inline bool util_image_is_finite(T /*value*/)
+{
+	return true;
+}
+template<>
+inline bool util_image_is_finite(float value)
+{
+	return isfinite(value);
+}
+
+/* Convert a pixel read from an image file to texture RGBA: CMYK to RGB, alpha
+ * to one when it is not used, and all channels to zero if any of them is not
+ * finite. Clearing all channels avoids artifacts from a fully changed hue. */
+template<typename T>
+inline void util_image_convert_rgba(T *r, T *g, T *b, T *a, bool cmyk, bool use_alpha)
+{
+	const T one = util_image_cast_from_float<T>(1.0f);
+	const T zero = util_image_cast_from_float<T>(0.0f);
+
+	if(cmyk) {
+		float c = util_image_cast_to_float(*r);
+		float m = util_image_cast_to_float(*g);
+		float y = util_image_cast_to_float(*b);
+		float k = util_image_cast_to_float(*a);
+		*r = util_image_cast_from_float<T>((1.0f - c) * (1.0f - k));
+		*g = util_image_cast_from_float<T>((1.0f - m) * (1.0f - k));
+		*b = util_image_cast_from_float<T>((1.0f - y) * (1.0f - k));
+		*a = one;
+	}
+
+	if(!use_alpha) {
+		*a = one;
+	}
+
+	if(!util_image_is_finite(*r) || !util_image_is_finite(*g) ||
+	   !util_image_is_finite(*b) || !util_image_is_finite(*a))
+	{
+		*r = *g = *b = *a = zero;
+	}
+}
+
 CCL_NAMESPACE_END
 
 #endif  /* __UTIL_IMAGE_H__ */
@@ -637,6 +637,34 @@ ccl_device_inline float2 map_to_sphere(const float3 co)
 	return make_float2(u, v);
 }
 
+/* Octahedral normal encoding, with two 16 bit components packed into a uint. */
+ccl_device_inline uint packed_normal_encode(const float3 N)
+{
+	const float l1 = fabsf(N.x) + fabsf(N.y) + fabsf(N.z);
+	float x = (l1 > 0.0f)? N.x / l1: 0.0f;
+	float y = (l1 > 0.0f)? N.y / l1: 0.0f;
+	if(N.z < 0.0f) {
+		const float fx = x, fy = y;
+		x = (1.0f - fabsf(fy)) * ((fx >= 0.0f)? 1.0f: -1.0f);
+		y = (1.0f - fabsf(fx)) * ((fy >= 0.0f)? 1.0f: -1.0f);
+	}
+	const int qx = float_to_int(floorf(clamp(x, -1.0f, 1.0f) * 32767.0f + 0.5f));
+	const int qy = float_to_int(floorf(clamp(y, -1.0f, 1.0f) * 32767.0f + 0.5f));
+	return ((uint)qx & 0xffff) | ((uint)qy << 16);
+}
+
+ccl_device_inline float3 packed_normal_decode(const uint packed)
+{
+	/* Sign extend the 16 bit components. */
+	const float x = (float)(((int)(packed << 16)) >> 16) * (1.0f/32767.0f);
+	const float y = (float)(((int)packed) >> 16) * (1.0f/32767.0f);
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+	const float t = max(-z, 0.0f);
+	return normalize(make_float3(x + ((x >= 0.0f)? -t: t),
+	                             y + ((y >= 0.0f)? -t: t),
+	                             z));
+}
+
 CCL_NAMESPACE_END
 
 #endif  /* __UTIL_MATH_H__ */
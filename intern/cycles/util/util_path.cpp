@@ -24,7 +24,9 @@
 
 OIIO_NAMESPACE_USING
 
+#include <algorithm>
 #include <stdio.h>
+#include <time.h>
 
 #include <sys/stat.h>
 
@@ -768,6 +770,15 @@ bool path_remove(const string& path)
 	return remove(path.c_str()) == 0;
 }
 
+bool path_touch(const string& path)
+{
+	if(!path_exists(path)) {
+		return false;
+	}
+	Filesystem::last_write_time(path, time(NULL));
+	return true;
+}
+
 struct SourceReplaceState {
 	typedef map<string, string> ProcessedMapping;
 	/* Base director for all relative include headers. */
@@ -986,4 +997,50 @@ void path_cache_clear_except(const string& name, const set<string>& except)
 
 }
 
+void path_cache_trim(const string& dir, uint64_t max_size)
+{
+	if(!path_exists(dir)) {
+		return;
+	}
+
+	struct CacheFile {
+		uint64_t time;
+		uint64_t size;
+		string path;
+
+		bool operator<(const CacheFile& other) const
+		{
+			return time < other.time;
+		}
+	};
+
+	vector<CacheFile> files;
+	uint64_t total_size = 0;
+
+	directory_iterator it(dir), it_end;
+	for(; it != it_end; ++it) {
+		CacheFile file;
+		file.path = it->path();
+		if(path_is_directory(file.path)) {
+			continue;
+		}
+		file.time = path_modified_time(file.path);
+		file.size = path_file_size(file.path);
+		total_size += file.size;
+		files.push_back(file);
+	}
+
+	if(total_size <= max_size) {
+		return;
+	}
+
+	std::sort(files.begin(), files.end());
+
+	for(size_t i = 0; i < files.size() && total_size > max_size; i++) {
+		if(path_remove(files[i].path)) {
+			total_size -= files[i].size;
+		}
+	}
+}
+
 CCL_NAMESPACE_END
@@ -64,6 +64,8 @@ bool path_read_text(const string& path, string& text);
 
 /* File manipulation. */
 bool path_remove(const string& path);
+/* Set the modification time of the file to the current time. */
+bool path_touch(const string& path);
 
 /* source code utility */
 string path_source_replace_includes(const string& source,
@@ -72,6 +74,9 @@ string path_source_replace_includes(const string& source,
 
 /* cache utility */
 void path_cache_clear_except(const string& name, const set<string>& except);
+/* Remove the least recently modified files in the directory until the total
+ * size of the remaining files is at most max_size bytes. */
+void path_cache_trim(const string& dir, uint64_t max_size);
 
 CCL_NAMESPACE_END
 
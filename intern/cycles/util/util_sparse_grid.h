@@ -0,0 +1,168 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_SPARSE_GRID_H__
+#define __UTIL_SPARSE_GRID_H__
+
+#include "util/util_texture.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+#include <climits>
+
+CCL_NAMESPACE_BEGIN
+
+/* Sparse Grid
+ *
+ * Storage for 3D textures that are mostly empty, like smoke domains. The
+ * volume is split into tiles of TEX_SPARSE_TILE_SIZE^3 voxels and only tiles
+ * containing non-zero voxels are stored, one after another. A table with one
+ * entry per tile gives the index of the first voxel of the tile in the sparse
+ * data. The first stored tile is all zeros and shared by all empty tiles, so
+ * lookups need no special case for them. */
+
+ccl_device_inline int sparse_grid_num_tiles(int size)
+{
+	return (size + TEX_SPARSE_TILE_SIZE - 1) >> TEX_SPARSE_TILE_SHIFT;
+}
+
+ccl_device_inline size_t sparse_grid_tile_index(int x, int y, int z,
+                                                int width, int height)
+{
+	const int tiles_x = sparse_grid_num_tiles(width);
+	const int tiles_y = sparse_grid_num_tiles(height);
+	return (x >> TEX_SPARSE_TILE_SHIFT) +
+	       ((size_t)(y >> TEX_SPARSE_TILE_SHIFT) +
+	        (size_t)(z >> TEX_SPARSE_TILE_SHIFT)*tiles_y)*tiles_x;
+}
+
+ccl_device_inline int sparse_grid_voxel_index(int x, int y, int z)
+{
+	return (x & TEX_SPARSE_TILE_MASK) +
+	       ((y & TEX_SPARSE_TILE_MASK) << TEX_SPARSE_TILE_SHIFT) +
+	       ((z & TEX_SPARSE_TILE_MASK) << (2*TEX_SPARSE_TILE_SHIFT));
+}
+
+static inline bool sparse_grid_is_zero(float value)
+{
+	return value == 0.0f;
+}
+
+static inline bool sparse_grid_is_zero(const float4& value)
+{
+	return value.x == 0.0f && value.y == 0.0f &&
+	       value.z == 0.0f && value.w == 0.0f;
+}
+
+static inline void sparse_grid_set_zero(float *value)
+{
+	*value = 0.0f;
+}
+
+static inline void sparse_grid_set_zero(float4 *value)
+{
+	*value = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+/* Convert dense voxels to sparse storage. Returns false if that would not
+ * save a significant amount of memory, in which case the dense voxels should
+ * be used as is. Empty tiles are those where all voxels are exactly zero, so
+ * lookups give the same result as with the dense grid. */
+template<typename T>
+bool create_sparse_grid(const T *voxels,
+                        int width, int height, int depth,
+                        vector<T> *sparse_voxels,
+                        vector<int> *tile_offsets)
+{
+	const int tile_size = TEX_SPARSE_TILE_SIZE;
+	const int tile_voxels = tile_size*tile_size*tile_size;
+	const int tiles_x = sparse_grid_num_tiles(width);
+	const int tiles_y = sparse_grid_num_tiles(height);
+	const int tiles_z = sparse_grid_num_tiles(depth);
+	const size_t num_tiles = (size_t)tiles_x*tiles_y*tiles_z;
+	const size_t num_voxels = (size_t)width*height*depth;
+
+	/* Find non-empty tiles, starting with the shared zero tile. */
+	vector<int> offsets(num_tiles, 0);
+	size_t num_sparse_voxels = tile_voxels;
+
+	for(int tz = 0; tz < tiles_z; tz++) {
+		for(int ty = 0; ty < tiles_y; ty++) {
+			for(int tx = 0; tx < tiles_x; tx++) {
+				const int x0 = tx*tile_size, x1 = min(x0 + tile_size, width);
+				const int y0 = ty*tile_size, y1 = min(y0 + tile_size, height);
+				const int z0 = tz*tile_size, z1 = min(z0 + tile_size, depth);
+				bool is_empty = true;
+
+				for(int z = z0; z < z1 && is_empty; z++) {
+					for(int y = y0; y < y1 && is_empty; y++) {
+						const T *row = voxels + ((size_t)z*height + y)*width;
+						for(int x = x0; x < x1; x++) {
+							if(!sparse_grid_is_zero(row[x])) {
+								is_empty = false;
+								break;
+							}
+						}
+					}
+				}
+
+				if(!is_empty) {
+					if(num_sparse_voxels > (size_t)(INT_MAX - tile_voxels)) {
+						return false;
+					}
+					offsets[tx + ((size_t)ty + (size_t)tz*tiles_y)*tiles_x] = (int)num_sparse_voxels;
+					num_sparse_voxels += tile_voxels;
+				}
+			}
+		}
+	}
+
+	/* Keep dense storage unless at least a quarter of the memory is saved. */
+	const size_t sparse_size = num_sparse_voxels*sizeof(T) + num_tiles*sizeof(int);
+	const size_t dense_size = num_voxels*sizeof(T);
+	if(sparse_size > dense_size - dense_size/4) {
+		return false;
+	}
+
+	/* Copy voxels of non-empty tiles, padding tiles on the upper borders of
+	 * the volume with zeros. */
+	sparse_voxels->resize(num_sparse_voxels);
+	T *sparse = &(*sparse_voxels)[0];
+
+	for(size_t i = 0; i < num_sparse_voxels; i++) {
+		sparse_grid_set_zero(&sparse[i]);
+	}
+
+	for(int z = 0; z < depth; z++) {
+		for(int y = 0; y < height; y++) {
+			const T *row = voxels + ((size_t)z*height + y)*width;
+			for(int x = 0; x < width; x++) {
+				const int offset = offsets[sparse_grid_tile_index(x, y, z, width, height)];
+				if(offset != 0) {
+					sparse[offset + sparse_grid_voxel_index(x, y, z)] = row[x];
+				}
+			}
+		}
+	}
+
+	tile_offsets->swap(offsets);
+
+	return true;
+}
+
+CCL_NAMESPACE_END
+
+#endif  /* __UTIL_SPARSE_GRID_H__ */
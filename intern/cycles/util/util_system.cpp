@@ -19,6 +19,7 @@
 #include "util/util_logging.h"
 #include "util/util_types.h"
 #include "util/util_string.h"
+#include "util/util_thread.h"
 
 #ifdef _WIN32
 #  if(!defined(FREE_WINDOWS))
@@ -32,13 +33,68 @@
 #  include <unistd.h>
 #endif
 
+#if defined(__linux__)
+#  include "numaapi.h"
+#endif
+
 CCL_NAMESPACE_BEGIN
 
+#if defined(__linux__)
+/* On Linux CPU groups are mapped to NUMA nodes, which are queried with
+ * numaapi. It loads libnuma dynamically, so when it is missing or the
+ * kernel has no NUMA support we fall back to a single group. */
+static thread_mutex system_cpu_numa_mutex;
+static int system_cpu_numa_num_nodes = -1;
+
+/* Number of NUMA nodes which has processors, only those can be used as
+ * CPU groups. Queried on first use, which might happen from multiple
+ * threads at once. */
+static int system_cpu_numa_node_count()
+{
+	thread_scoped_lock lock(system_cpu_numa_mutex);
+	if(system_cpu_numa_num_nodes != -1) {
+		return system_cpu_numa_num_nodes;
+	}
+	int count = 0;
+	if(numaAPI_Initialize() == NUMAAPI_SUCCESS) {
+		const int num_nodes = numaAPI_GetNumNodes();
+		for(int node = 0; node < num_nodes; ++node) {
+			if(numaAPI_GetNumNodeProcessors(node) > 0) {
+				++count;
+			}
+		}
+	}
+	system_cpu_numa_num_nodes = count;
+	return count;
+}
+
+/* Convert CPU group index to NUMA node index, skipping nodes without
+ * processors. */
+static int system_cpu_numa_group_node(int group)
+{
+	const int num_nodes = numaAPI_GetNumNodes();
+	for(int node = 0; node < num_nodes; ++node) {
+		if(numaAPI_GetNumNodeProcessors(node) > 0) {
+			if(group-- == 0) {
+				return node;
+			}
+		}
+	}
+	return -1;
+}
+#endif
+
+/* Group the calling thread was bound to with system_cpu_run_thread_on_group(). */
+static thread_local int system_cpu_current_group = -1;
+
 int system_cpu_group_count()
 {
 #ifdef _WIN32
 	util_windows_init_numa_groups();
 	return GetActiveProcessorGroupCount();
+#elif defined(__linux__)
+	const int num_nodes = system_cpu_numa_node_count();
+	return (num_nodes > 1) ? num_nodes : 1;
 #else
 	/* TODO(sergey): Need to adopt for other platforms. */
 	return 1;
@@ -51,6 +107,12 @@ int system_cpu_group_thread_count(int group)
 #ifdef _WIN32
 	util_windows_init_numa_groups();
 	return GetActiveProcessorCount(group);
+#elif defined(__linux__)
+	if(system_cpu_numa_node_count() > 1) {
+		return numaAPI_GetNumNodeProcessors(system_cpu_numa_group_node(group));
+	}
+	(void) group;
+	return sysconf(_SC_NPROCESSORS_ONLN);
 #elif defined(__APPLE__)
 	(void) group;
 	int count;
@@ -104,6 +166,67 @@ unsigned short system_cpu_process_groups(unsigned short max_groups,
 #endif
 }
 
+bool system_cpu_run_thread_on_group(int group)
+{
+#ifdef _WIN32
+	HANDLE thread_handle = GetCurrentThread();
+	GROUP_AFFINITY group_affinity = { 0 };
+	int num_threads = system_cpu_group_thread_count(group);
+	group_affinity.Group = group;
+	group_affinity.Mask = (num_threads == 64)
+	                              ? -1
+	                              :  (1ull << num_threads) - 1;
+	if(SetThreadGroupAffinity(thread_handle, &group_affinity, NULL) == 0) {
+		return false;
+	}
+	system_cpu_current_group = group;
+	return true;
+#elif defined(__linux__)
+	if(system_cpu_numa_node_count() < 2) {
+		return true;
+	}
+	const int node = system_cpu_numa_group_node(group);
+	if(node == -1 || !numaAPI_RunThreadOnNode(node)) {
+		return false;
+	}
+	system_cpu_current_group = group;
+	return true;
+#else
+	(void) group;
+	return true;
+#endif
+}
+
+int system_cpu_thread_group()
+{
+	return system_cpu_current_group;
+}
+
+void *system_cpu_group_alloc(size_t size, int group)
+{
+#if defined(__linux__)
+	if(system_cpu_numa_node_count() > 1) {
+		const int node = system_cpu_numa_group_node(group);
+		if(node != -1) {
+			return numaAPI_AllocateOnNode(size, node);
+		}
+	}
+#endif
+	(void) size;
+	(void) group;
+	return NULL;
+}
+
+void system_cpu_group_free(void *mem, size_t size)
+{
+#if defined(__linux__)
+	numaAPI_Free(mem, size);
+#else
+	(void) mem;
+	(void) size;
+#endif
+}
+
 #if !defined(_WIN32) || defined(FREE_WINDOWS)
 static void __cpuid(int data[4], int selector)
 {
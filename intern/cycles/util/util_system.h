@@ -34,6 +34,19 @@ int system_cpu_thread_count();
 unsigned short system_cpu_process_groups(unsigned short max_groups,
                                          unsigned short *grpups);
 
+/* Force current thread to only run on processors of the given group.
+ * On Linux groups are NUMA nodes and memory allocations of the thread are
+ * made local to the node as well. */
+bool system_cpu_run_thread_on_group(int group);
+
+/* Group the current thread was bound to, or -1 if it was not bound. */
+int system_cpu_thread_group();
+
+/* Allocate memory which physically resides on the memory of the given group.
+ * Returns NULL when groups are not backed by NUMA memory nodes. */
+void *system_cpu_group_alloc(size_t size, int group);
+void system_cpu_group_free(void *mem, size_t size);
+
 string system_cpu_brand_string();
 int system_cpu_bits();
 bool system_cpu_support_sse2();
@@ -28,6 +28,11 @@ CCL_NAMESPACE_BEGIN
 #define TEX_IMAGE_MISSING_B 1
 #define TEX_IMAGE_MISSING_A 1
 
+/* Tile size of sparse 3D textures, see util_sparse_grid.h. */
+#define TEX_SPARSE_TILE_SHIFT 3
+#define TEX_SPARSE_TILE_SIZE (1 << TEX_SPARSE_TILE_SHIFT)
+#define TEX_SPARSE_TILE_MASK (TEX_SPARSE_TILE_SIZE - 1)
+
 /* Texture type. */
 #define kernel_tex_type(tex) (tex & IMAGE_DATA_TYPE_MASK)
 
@@ -85,6 +90,10 @@ typedef struct TextureInfo {
 	uint interpolation, extension;
 	/* Dimensions. */
 	uint width, height, depth;
+	/* Texture cache image on the CPU, for images loaded on demand. */
+	uint64_t cache;
+	/* Tile offsets of sparse 3D textures on the CPU, 0 for dense storage. */
+	uint64_t grid_info;
 } TextureInfo;
 
 CCL_NAMESPACE_END
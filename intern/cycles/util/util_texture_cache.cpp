@@ -0,0 +1,209 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+
+#include "util/util_foreach.h"
+#include "util/util_image.h"
+#include "util/util_logging.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+OIIO_NAMESPACE_USING
+
+struct TextureCacheImage {
+	TextureSystem *texture_system;
+	TextureSystem::TextureHandle *handle;
+	TextureOpt options;
+	string filename;
+	InterpolationType interpolation;
+	ExtensionType extension;
+	bool use_alpha;
+	bool cmyk;
+};
+
+static TextureOpt::Wrap texture_cache_wrap(ExtensionType extension)
+{
+	switch(extension) {
+		case EXTENSION_EXTEND:
+			return TextureOpt::WrapClamp;
+		case EXTENSION_CLIP:
+			return TextureOpt::WrapBlack;
+		case EXTENSION_REPEAT:
+		default:
+			return TextureOpt::WrapPeriodic;
+	}
+}
+
+static TextureOpt::InterpMode texture_cache_interp(InterpolationType interpolation)
+{
+	switch(interpolation) {
+		case INTERPOLATION_CLOSEST:
+			return TextureOpt::InterpClosest;
+		case INTERPOLATION_LINEAR:
+			return TextureOpt::InterpBilinear;
+		case INTERPOLATION_CUBIC:
+			return TextureOpt::InterpBicubic;
+		case INTERPOLATION_SMART:
+		default:
+			return TextureOpt::InterpSmartBicubic;
+	}
+}
+
+TextureCache::TextureCache(int max_memory_mb)
+{
+	TextureSystem *ts = TextureSystem::create(false);
+
+	/* Build MIP-maps and tiles in memory for files that don't have them,
+	 * so every file benefits from partial loading. */
+	ts->attribute("automip", 1);
+	ts->attribute("autotile", 64);
+	ts->attribute("gray_to_rgb", 1);
+	ts->attribute("max_memory_MB", (float)max_memory_mb);
+
+	texture_system = ts;
+
+	VLOG(1) << "Created texture cache with " << max_memory_mb << " MB limit.";
+}
+
+TextureCache::~TextureCache()
+{
+	TextureSystem *ts = (TextureSystem*)texture_system;
+
+	VLOG(2) << "Texture cache statistics:\n" << ts->getstats(2, true);
+
+	foreach(TextureCacheImage *image, images) {
+		delete image;
+	}
+	images.clear();
+
+	ts->invalidate_all(true);
+	TextureSystem::destroy(ts);
+}
+
+TextureCacheImage *TextureCache::get_image(const string& filename,
+                                           InterpolationType interpolation,
+                                           ExtensionType extension,
+                                           bool use_alpha)
+{
+	thread_scoped_lock lock(images_mutex);
+
+	/* Images are shared between slots with identical sampling settings. */
+	foreach(TextureCacheImage *image, images) {
+		if(image->filename == filename &&
+		   image->interpolation == interpolation &&
+		   image->extension == extension &&
+		   image->use_alpha == use_alpha)
+		{
+			return image;
+		}
+	}
+
+	TextureSystem *ts = (TextureSystem*)texture_system;
+	TextureSystem::TextureHandle *handle = ts->get_texture_handle(ustring(filename));
+
+	if(!handle || !ts->good(handle)) {
+		VLOG(1) << "Texture cache can't read '" << filename << "': "
+		        << ts->geterror();
+		return NULL;
+	}
+
+	TextureCacheImage *image = new TextureCacheImage();
+	image->texture_system = ts;
+	image->handle = handle;
+	image->filename = filename;
+	image->interpolation = interpolation;
+	image->extension = extension;
+	image->use_alpha = use_alpha;
+
+	/* Same detection of CMYK files as for regular image loading. */
+	ustring fileformat;
+	int channels = 0;
+	ts->get_texture_info(ustring(filename), 0, ustring("fileformat"), TypeDesc::STRING, &fileformat);
+	ts->get_texture_info(ustring(filename), 0, ustring("channels"), TypeDesc::INT, &channels);
+	image->cmyk = (fileformat == "jpeg" && channels == 4);
+
+	image->options.swrap = texture_cache_wrap(extension);
+	image->options.twrap = image->options.swrap;
+	image->options.interpmode = texture_cache_interp(interpolation);
+	/* Closest interpolation is expected to give exact pixels, don't blur
+	 * them together from a coarser level. */
+	if(interpolation == INTERPOLATION_CLOSEST) {
+		image->options.mipmode = TextureOpt::MipModeNoMIP;
+	}
+	/* Missing alpha channel is opaque. */
+	image->options.fill = 1.0f;
+
+	images.push_back(image);
+
+	return image;
+}
+
+void TextureCache::invalidate(const string& filename)
+{
+	((TextureSystem*)texture_system)->invalidate(ustring(filename));
+}
+
+string TextureCache::stats() const
+{
+	return ((TextureSystem*)texture_system)->getstats(1, true);
+}
+
+bool texture_cache_lookup(const TextureCacheImage *image,
+                          float s, float t,
+                          float dsdx, float dtdx,
+                          float dsdy, float dtdy,
+                          float result[4])
+{
+	TextureSystem *ts = image->texture_system;
+	/* Per thread info is kept in thread local storage by the texture system,
+	 * which avoids contention on the shared tile cache. */
+	TextureSystem::Perthread *thread_info = ts->get_perthread_info();
+	TextureOpt options = image->options;
+
+	/* OpenImageIO has the origin at the top left, Cycles at the bottom left. */
+	if(!ts->texture(image->handle, thread_info, options,
+	                s, 1.0f - t,
+	                dsdx, -dtdx,
+	                dsdy, -dtdy,
+	                4, result))
+	{
+		return false;
+	}
+
+	/* The texture system returns associated alpha, match the unassociated
+	 * alpha of the regular image loading when alpha is not used. */
+	if(!image->use_alpha && !image->cmyk) {
+		const float alpha = result[3];
+		if(alpha != 0.0f && alpha != 1.0f) {
+			const float inv_alpha = 1.0f / alpha;
+			result[0] *= inv_alpha;
+			result[1] *= inv_alpha;
+			result[2] *= inv_alpha;
+		}
+	}
+
+	/* Filtering happens before this conversion, unlike for fully loaded
+	 * images, so non-finite pixels also clear their filtered neighbours. */
+	util_image_convert_rgba(&result[0], &result[1], &result[2], &result[3],
+	                        image->cmyk, image->use_alpha);
+
+	return true;
+}
+
+CCL_NAMESPACE_END
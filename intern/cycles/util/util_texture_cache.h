@@ -0,0 +1,74 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util/util_string.h"
+#include "util/util_texture.h"
+#include "util/util_thread.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * On demand loading of image textures for the CPU device, through the
+ * OpenImageIO texture system. Instead of decoding the full image into memory
+ * before rendering, tiles of the required MIP level are read at lookup time
+ * and kept in a cache of bounded size that is shared between all threads.
+ * Files which are not tiled and MIP-mapped already are converted in memory
+ * on first access. */
+
+struct TextureCacheImage;
+
+class TextureCache {
+public:
+	explicit TextureCache(int max_memory_mb);
+	~TextureCache();
+
+	/* Get a handle to pass to the kernel for the given file, or NULL if the
+	 * file can not be read by the texture system. Handles stay valid for the
+	 * lifetime of the cache. */
+	TextureCacheImage *get_image(const string& filename,
+	                             InterpolationType interpolation,
+	                             ExtensionType extension,
+	                             bool use_alpha);
+
+	/* Drop cached tiles of the file, so changes on disk are picked up. */
+	void invalidate(const string& filename);
+
+	/* Human readable cache statistics, for logging. */
+	string stats() const;
+
+protected:
+	void *texture_system;
+	thread_mutex images_mutex;
+	vector<TextureCacheImage*> images;
+};
+
+/* Filtered lookup of an image, with texture coordinates in Cycles convention
+ * (origin at the bottom left) and their screen space derivatives, which
+ * select the MIP level. Returns false if the lookup failed. */
+bool texture_cache_lookup(const TextureCacheImage *image,
+                          float s, float t,
+                          float dsdx, float dtdx,
+                          float dsdy, float dtdy,
+                          float result[4]);
+
+CCL_NAMESPACE_END
+
+#endif  /* __UTIL_TEXTURE_CACHE_H__ */
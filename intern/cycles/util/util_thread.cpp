@@ -40,18 +40,9 @@ void *thread::run(void *arg)
 {
 	thread *self = (thread*)(arg);
 	if(self->group_ != -1) {
-#ifdef _WIN32
-		HANDLE thread_handle = GetCurrentThread();
-		GROUP_AFFINITY group_affinity = { 0 };
-		int num_threads = system_cpu_group_thread_count(self->group_);
-		group_affinity.Group = self->group_;
-		group_affinity.Mask = (num_threads == 64)
-		                              ? -1
-		                              :  (1ull << num_threads) - 1;
-		if(SetThreadGroupAffinity(thread_handle, &group_affinity, NULL) == 0) {
+		if(!system_cpu_run_thread_on_group(self->group_)) {
 			fprintf(stderr, "Error setting thread affinity.\n");
 		}
-#endif
 	}
 	self->run_cb_();
 	return NULL;
@@ -60,6 +60,8 @@ extern "C" {
 #include "BKE_modifier.h"
 #include "BKE_particle.h"
 #include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
 }
 
 using Alembic::Abc::TimeSamplingPtr;
@@ -168,6 +170,127 @@ static bool export_object(const ExportSettings * const settings, Object *ob,
 
 /* ************************************************************************** */
 
+/* Transform and visibility of objects evaluated in advance for the frames
+ * where only transforms are written. Such frames then don't need a scene
+ * update, and all of them are evaluated in parallel. */
+class AbcTransformCache {
+	std::vector<Object *> m_objects;
+	std::map<double, size_t> m_frame_index;
+
+	std::vector<float> m_matrices;
+	std::vector<char> m_restrictflags;
+
+	/* State of the objects before the cached frames were applied. */
+	std::vector<float> m_orig_matrices;
+	std::vector<char> m_orig_restrictflags;
+
+	bool m_applied;
+
+public:
+	AbcTransformCache()
+	    : m_applied(false)
+	{}
+
+	bool build(Scene *scene, const std::set<Object *> &objects,
+	           const std::vector<double> &frames);
+
+	/* Set cached transforms of the frame on the objects, returns false if the
+	 * frame is not cached and the scene has to be updated instead. */
+	bool apply(double frame);
+
+	void restore();
+
+private:
+	static void storeEvaluated(void *userdata, int frame_index, int object_index, Object *ob_eval);
+};
+
+bool AbcTransformCache::build(Scene *scene, const std::set<Object *> &objects,
+                              const std::vector<double> &frames)
+{
+	if (objects.empty()) {
+		return false;
+	}
+
+	std::set<Object *>::const_iterator it;
+	for (it = objects.begin(); it != objects.end(); ++it) {
+		if (!DEG_object_supports_multiframe_eval(*it)) {
+			return false;
+		}
+	}
+
+	m_objects.assign(objects.begin(), objects.end());
+
+	const size_t num_objects = m_objects.size();
+	const size_t num_frames = frames.size();
+
+	std::vector<float> ctimes(num_frames);
+	for (size_t i = 0; i < num_frames; ++i) {
+		/* Same as BKE_scene_frame_get() after setting the frame. */
+		ctimes[i] = static_cast<float>(frames[i]) * scene->r.framelen;
+		m_frame_index[frames[i]] = i;
+	}
+
+	m_matrices.resize(num_frames * num_objects * 16);
+	m_restrictflags.resize(num_frames * num_objects);
+
+	DEG_evaluate_objects_multiframe(&m_objects[0], num_objects,
+	                                &ctimes[0], num_frames,
+	                                storeEvaluated, this);
+
+	m_orig_matrices.resize(num_objects * 16);
+	m_orig_restrictflags.resize(num_objects);
+
+	for (size_t i = 0; i < num_objects; ++i) {
+		memcpy(&m_orig_matrices[i * 16], m_objects[i]->obmat, sizeof(float) * 16);
+		m_orig_restrictflags[i] = m_objects[i]->restrictflag;
+	}
+
+	return true;
+}
+
+void AbcTransformCache::storeEvaluated(void *userdata, int frame_index, int object_index, Object *ob_eval)
+{
+	AbcTransformCache *cache = static_cast<AbcTransformCache *>(userdata);
+	const size_t index = frame_index * cache->m_objects.size() + object_index;
+
+	memcpy(&cache->m_matrices[index * 16], ob_eval->obmat, sizeof(float) * 16);
+	cache->m_restrictflags[index] = ob_eval->restrictflag;
+}
+
+bool AbcTransformCache::apply(double frame)
+{
+	std::map<double, size_t>::const_iterator it = m_frame_index.find(frame);
+
+	if (it == m_frame_index.end()) {
+		return false;
+	}
+
+	const size_t num_objects = m_objects.size();
+	const size_t offset = it->second * num_objects;
+
+	for (size_t i = 0; i < num_objects; ++i) {
+		memcpy(m_objects[i]->obmat, &m_matrices[(offset + i) * 16], sizeof(float) * 16);
+		m_objects[i]->restrictflag = m_restrictflags[offset + i];
+	}
+
+	m_applied = true;
+	return true;
+}
+
+void AbcTransformCache::restore()
+{
+	if (!m_applied) {
+		return;
+	}
+
+	for (size_t i = 0, e = m_objects.size(); i != e; ++i) {
+		memcpy(m_objects[i]->obmat, &m_orig_matrices[i * 16], sizeof(float) * 16);
+		m_objects[i]->restrictflag = m_orig_restrictflags[i];
+	}
+}
+
+/* ************************************************************************** */
+
 AbcExporter::AbcExporter(Main *bmain, Scene *scene, const char *filename, ExportSettings &settings)
     : m_bmain(bmain)
     , m_settings(settings)
@@ -307,7 +430,28 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 
 	/* Merge all frames needed. */
 	std::set<double> frames(xform_frames);
-	frames.insert(shape_frames.begin(), shape_frames.end());
+	if (!m_shapes.empty()) {
+		frames.insert(shape_frames.begin(), shape_frames.end());
+	}
+
+	/* Frames which only need transforms don't have to update the whole scene,
+	 * evaluate them all at once when possible. These are the extra transform
+	 * samples, or every frame when there are no shape writers. Frames which
+	 * write shapes always update the scene, as shapes need evaluated data. */
+	std::vector<double> xform_only_frames;
+	for (std::set<double>::const_iterator it = xform_frames.begin(); it != xform_frames.end(); ++it) {
+		if (m_shapes.empty() || shape_frames.count(*it) == 0) {
+			xform_only_frames.push_back(*it);
+		}
+	}
+
+	AbcTransformCache transform_cache;
+
+	if (!xform_only_frames.empty()) {
+		std::set<Object *> xform_objects;
+		getTransformObjects(xform_objects);
+		transform_cache.build(m_scene, xform_objects, xform_only_frames);
+	}
 
 	/* Export all frames. */
 
@@ -327,8 +471,10 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 
 		const double frame = *begin;
 
-		/* 'frame' is offset by start frame, so need to cancel the offset. */
-		setCurrentFrame(bmain, frame);
+		if (!transform_cache.apply(frame)) {
+			/* 'frame' is offset by start frame, so need to cancel the offset. */
+			setCurrentFrame(bmain, frame);
+		}
 
 		if (shape_frames.count(frame) != 0) {
 			for (int i = 0, e = m_shapes.size(); i != e; ++i) {
@@ -355,6 +501,28 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 
 		archive_bounds_prop.set(bounds);
 	}
+
+	transform_cache.restore();
+}
+
+void AbcExporter::getTransformObjects(std::set<Object *> &objects)
+{
+	/* Objects which matrices are read when writing transforms. */
+	m_xforms_type::iterator xit, xe;
+	for (xit = m_xforms.begin(), xe = m_xforms.end(); xit != xe; ++xit) {
+		AbcTransformWriter *xform = xit->second;
+		Object *ob = xform->object();
+
+		objects.insert(ob);
+
+		if (ob->parent) {
+			objects.insert(ob->parent);
+		}
+
+		if (xform->m_proxy_from) {
+			objects.insert(xform->m_proxy_from);
+		}
+	}
 }
 
 void AbcExporter::createTransformWritersHierarchy(EvaluationContext *eval_ctx)
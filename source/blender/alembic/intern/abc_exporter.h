@@ -122,6 +122,7 @@ private:
 	void createParticleSystemsWriters(Object *ob, AbcTransformWriter *xform);
 
 	AbcTransformWriter *getXForm(const std::string &name);
+	void getTransformObjects(std::set<Object *> &objects);
 
 	void setCurrentFrame(Main *bmain, double t);
 };
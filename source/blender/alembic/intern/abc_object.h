@@ -66,6 +66,8 @@ public:
 
 	void addChild(AbcObjectWriter *child);
 
+	Object *object() const { return m_object; }
+
 	virtual Imath::Box3d bounds();
 
 	void write();
@@ -1763,6 +1763,18 @@ void DAG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* only relations of given ID changed */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	if (DEG_depsgraph_use_legacy()) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		/* New dependency graph. */
+		DEG_id_relations_tag_update(bmain, id);
+	}
+}
+
 /* rebuild dependency graph only for a given scene */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *sce)
 {
@@ -3666,6 +3678,12 @@ void DAG_relations_tag_update(Main *bmain)
 	DEG_relations_tag_update(bmain);
 }
 
+/* Tag relations of given ID for update. */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	DEG_id_relations_tag_update(bmain, id);
+}
+
 /* Rebuild dependency graph only for a given scene. */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *scene)
 {
@@ -58,6 +58,19 @@
 
 #define PBVH_THREADED_LIMIT 4
 
+/* Minimum size of a subtree, in leaves worth of primitives, to be built as a
+ * separate task. */
+#define PBVH_BUILD_TASK_LIMIT 8
+
+/* Print the time of full PBVH builds. */
+// #define DEBUG_TIME
+/* Compare every build against a single threaded reference build. */
+// #define USE_VERIFY
+
+#ifdef DEBUG_TIME
+#  include "PIL_time_utildefines.h"
+#endif
+
 typedef struct PBVHStack {
 	PBVHNode *node;
 	bool revisiting;
@@ -242,15 +255,15 @@ void pbvh_grow_nodes(PBVH *bvh, int totnode)
  * a negative value for additional vertices */
 static int map_insert_vert(PBVH *bvh, GHash *map,
                            unsigned int *face_verts,
-                           unsigned int *uniq_verts, int vertex)
+                           unsigned int *uniq_verts, int vertex,
+                           const int leaf_index)
 {
 	void *key, **value_p;
 
 	key = POINTER_FROM_INT(vertex);
 	if (!BLI_ghash_ensure_p(map, key, &value_p)) {
 		int value_i;
-		if (BLI_BITMAP_TEST(bvh->vert_bitmap, vertex) == 0) {
-			BLI_BITMAP_ENABLE(bvh->vert_bitmap, vertex);
+		if (bvh->vert_leaf_owner[vertex] == leaf_index) {
 			value_i = *uniq_verts;
 			(*uniq_verts)++;
 		}
@@ -267,7 +280,7 @@ static int map_insert_vert(PBVH *bvh, GHash *map,
 }
 
 /* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
+static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node, const int leaf_index)
 {
 	bool has_visible = false;
 
@@ -287,7 +300,8 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 		for (int j = 0; j < 3; ++j) {
 			face_vert_indices[i][j] =
 			        map_insert_vert(bvh, map, &node->face_verts,
-			                        &node->uniq_verts, bvh->mloop[lt->tri[j]].v);
+			                        &node->uniq_verts, bvh->mloop[lt->tri[j]].v,
+			                        leaf_index);
 		}
 
 		if (!paint_is_face_hidden(lt, bvh->verts, bvh->mloop)) {
@@ -330,14 +344,13 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 	BLI_ghash_free(map, NULL, NULL);
 }
 
-static void update_vb(PBVH *bvh, PBVHNode *node, BBC *prim_bbc,
+static void update_vb(PBVH *bvh, BB *vb, BBC *prim_bbc,
                       int offset, int count)
 {
-	BB_reset(&node->vb);
+	BB_reset(vb);
 	for (int i = offset + count - 1; i >= offset; --i) {
-		BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[bvh->prim_indices[i]]));
+		BB_expand_with_bb(vb, (BB *)(&prim_bbc[bvh->prim_indices[i]]));
 	}
-	node->orig_vb = node->vb;
 }
 
 /* Returns the number of visible quads in the nodes' grids. */
@@ -379,24 +392,6 @@ static void build_grid_leaf_node(PBVH *bvh, PBVHNode *node)
 }
 
 
-static void build_leaf(PBVH *bvh, int node_index, BBC *prim_bbc,
-                       int offset, int count)
-{
-	bvh->nodes[node_index].flag |= PBVH_Leaf;
-
-	bvh->nodes[node_index].prim_indices = bvh->prim_indices + offset;
-	bvh->nodes[node_index].totprim = count;
-
-	/* Still need vb for searches */
-	update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
-
-	if (bvh->looptri)
-		build_mesh_leaf_node(bvh, bvh->nodes + node_index);
-	else {
-		build_grid_leaf_node(bvh, bvh->nodes + node_index);
-	}
-}
-
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
 static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
@@ -430,6 +425,30 @@ static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
 }
 
 
+/* Node of the tree while it is being built. Subtrees are built in parallel,
+ * so nodes are only copied into bvh->nodes once the whole tree is known. */
+typedef struct PBVHBuildNode {
+	struct PBVHBuildNode *children;
+	BB vb;
+	int offset, count;
+	bool is_leaf;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildData {
+	PBVH *bvh;
+	BBC *prim_bbc;
+	int totleaf;
+} PBVHBuildData;
+
+static void pbvh_build_node(PBVHBuildData *data, TaskPool *pool, int thread_id,
+                            PBVHBuildNode *node, const BB *vb, const BB *cb);
+
+static void pbvh_build_node_task_cb(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	PBVHBuildData *data = BLI_task_pool_userdata(pool);
+	pbvh_build_node(data, pool, thread_id, taskdata, NULL, NULL);
+}
+
 /* Recursively build a node in the tree
  *
  * vb is the voxel box around all of the primitives contained in
@@ -438,38 +457,45 @@ static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
  * cb is the bounding box around all the centroids of the primitives
  * contained in this node
  *
- * offset and start indicate a range in the array of primitive indices
+ * Both are calculated when not given. Large enough children are pushed
+ * to the pool, when there is one.
  */
 
-static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc,
-                      int offset, int count)
+static void pbvh_build_node(PBVHBuildData *data, TaskPool *pool, int thread_id,
+                            PBVHBuildNode *node, const BB *vb, const BB *cb)
 {
+	PBVH *bvh = data->bvh;
+	BBC *prim_bbc = data->prim_bbc;
+	const int offset = node->offset;
+	const int count = node->count;
 	int end;
 	BB cb_backing;
 
+	/* Still need vb for searches */
+	if (vb) {
+		node->vb = *vb;
+	}
+	else {
+		update_vb(bvh, &node->vb, prim_bbc, offset, count);
+	}
+
 	/* Decide whether this is a leaf or not */
 	const bool below_leaf_limit = count <= bvh->leaf_limit;
 	if (below_leaf_limit) {
 		if (!leaf_needs_material_split(bvh, offset, count)) {
-			build_leaf(bvh, node_index, prim_bbc, offset, count);
+			node->is_leaf = true;
+			atomic_add_and_fetch_int32(&data->totleaf, 1);
 			return;
 		}
 	}
 
-	/* Add two child nodes */
-	bvh->nodes[node_index].children_offset = bvh->totnode;
-	pbvh_grow_nodes(bvh, bvh->totnode + 2);
-
-	/* Update parent node bounding box */
-	update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
-
 	if (!below_leaf_limit) {
 		/* Find axis with widest range of primitive centroids */
 		if (!cb) {
-			cb = &cb_backing;
-			BB_reset(cb);
+			BB_reset(&cb_backing);
 			for (int i = offset + count - 1; i >= offset; --i)
-				BB_expand(cb, prim_bbc[bvh->prim_indices[i]].bcentroid);
+				BB_expand(&cb_backing, prim_bbc[bvh->prim_indices[i]].bcentroid);
+			cb = &cb_backing;
 		}
 		const int axis = BB_widest_axis(cb);
 
@@ -486,13 +512,263 @@ static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc,
 	}
 
 	/* Build children */
-	build_sub(bvh, bvh->nodes[node_index].children_offset, NULL,
-	          prim_bbc, offset, end - offset);
-	build_sub(bvh, bvh->nodes[node_index].children_offset + 1, NULL,
-	          prim_bbc, end, offset + count - end);
+	node->children = MEM_callocN(sizeof(PBVHBuildNode) * 2, "PBVHBuildNode children");
+	node->children[0].offset = offset;
+	node->children[0].count = end - offset;
+	node->children[1].offset = end;
+	node->children[1].count = offset + count - end;
+
+	for (int i = 0; i < 2; ++i) {
+		PBVHBuildNode *child = &node->children[i];
+		if (pool && child->count > bvh->leaf_limit * PBVH_BUILD_TASK_LIMIT) {
+			BLI_task_pool_push_from_thread(pool, pbvh_build_node_task_cb, child, false,
+			                               TASK_PRIORITY_HIGH, thread_id);
+		}
+		else {
+			pbvh_build_node(data, pool, thread_id, child, NULL, NULL);
+		}
+	}
+}
+
+/* Copy the built tree into bvh->nodes. Nodes are allocated in the same
+ * order as a recursive single threaded build does, children of a node are
+ * next to each other, followed by the subtree of the first child. Leaves are
+ * stored in depth-first order. */
+static void pbvh_build_flatten(PBVH *bvh, PBVHBuildNode *build_node, int node_index,
+                               int *leaf_indices, int *r_totleaf)
+{
+	PBVHNode *node = &bvh->nodes[node_index];
+
+	node->vb = build_node->vb;
+	node->orig_vb = build_node->vb;
+
+	if (build_node->is_leaf) {
+		node->flag |= PBVH_Leaf;
+		node->prim_indices = bvh->prim_indices + build_node->offset;
+		node->totprim = build_node->count;
+		leaf_indices[(*r_totleaf)++] = node_index;
+		return;
+	}
+
+	/* Add two child nodes, this invalidates the node pointer */
+	const int children_offset = bvh->totnode;
+	node->children_offset = children_offset;
+	pbvh_grow_nodes(bvh, bvh->totnode + 2);
+
+	pbvh_build_flatten(bvh, &build_node->children[0], children_offset,
+	                   leaf_indices, r_totleaf);
+	pbvh_build_flatten(bvh, &build_node->children[1], children_offset + 1,
+	                   leaf_indices, r_totleaf);
+
+	MEM_freeN(build_node->children);
+}
+
+typedef struct PBVHBuildLeafData {
+	PBVH *bvh;
+	const int *leaf_indices;
+} PBVHBuildLeafData;
+
+/* Vertices are unique to the first leaf which uses them, in depth-first
+ * order, so find the lowest leaf index for every vertex. */
+static void pbvh_build_vert_owner_task_cb(
+        void *__restrict userdata,
+        const int leaf_index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	PBVHBuildLeafData *data = userdata;
+	PBVH *bvh = data->bvh;
+	const PBVHNode *node = &bvh->nodes[data->leaf_indices[leaf_index]];
+
+	for (int i = 0; i < node->totprim; ++i) {
+		const MLoopTri *lt = &bvh->looptri[node->prim_indices[i]];
+		for (int j = 0; j < 3; ++j) {
+			int *owner = &bvh->vert_leaf_owner[bvh->mloop[lt->tri[j]].v];
+			int old_owner = *owner;
+			while (leaf_index < old_owner) {
+				const int found = atomic_cas_int32(owner, old_owner, leaf_index);
+				if (found == old_owner) {
+					break;
+				}
+				old_owner = found;
+			}
+		}
+	}
+}
+
+static void pbvh_build_leaf_task_cb(
+        void *__restrict userdata,
+        const int leaf_index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	PBVHBuildLeafData *data = userdata;
+	PBVH *bvh = data->bvh;
+	PBVHNode *node = &bvh->nodes[data->leaf_indices[leaf_index]];
+
+	if (bvh->looptri)
+		build_mesh_leaf_node(bvh, node, leaf_index);
+	else
+		build_grid_leaf_node(bvh, node);
+}
+
+#ifdef USE_VERIFY
+
+typedef struct PBVHVerifyNode {
+	BB vb;
+	int children_offset;
+	int offset, totprim;
+	bool is_leaf;
+} PBVHVerifyNode;
+
+typedef struct PBVHVerifyData {
+	PBVH *bvh;
+	BBC *prim_bbc;
+	PBVHVerifyNode *nodes;
+	int totnode, node_mem_count;
+	/* Leaf owning every mesh vertex, the first one using it. */
+	BLI_bitmap *vert_bitmap;
+	int *vert_owner;
+} PBVHVerifyData;
+
+/* Recursive single threaded build, in the same node order and with the same
+ * vertex ownership as before subtrees and leaves were built in parallel. */
+static void pbvh_verify_build_sub(PBVHVerifyData *data, int node_index, int offset, int count)
+{
+	PBVH *bvh = data->bvh;
+	BBC *prim_bbc = data->prim_bbc;
+	PBVHVerifyNode *node;
+	int end;
+
+	const bool below_leaf_limit = count <= bvh->leaf_limit;
+	if (below_leaf_limit && !leaf_needs_material_split(bvh, offset, count)) {
+		node = &data->nodes[node_index];
+		node->is_leaf = true;
+		node->offset = offset;
+		node->totprim = count;
+		update_vb(bvh, &node->vb, prim_bbc, offset, count);
+
+		if (bvh->looptri) {
+			for (int i = offset; i < offset + count; ++i) {
+				const MLoopTri *lt = &bvh->looptri[bvh->prim_indices[i]];
+				for (int j = 0; j < 3; ++j) {
+					const int v = bvh->mloop[lt->tri[j]].v;
+					if (!BLI_BITMAP_TEST(data->vert_bitmap, v)) {
+						BLI_BITMAP_ENABLE(data->vert_bitmap, v);
+						data->vert_owner[v] = node_index;
+					}
+				}
+			}
+		}
+		return;
+	}
+
+	/* Add two child nodes */
+	const int children_offset = data->totnode;
+	data->totnode += 2;
+	if (data->totnode > data->node_mem_count) {
+		data->node_mem_count = max_ii(data->node_mem_count * 2, data->totnode);
+		data->nodes = MEM_recallocN(data->nodes, sizeof(PBVHVerifyNode) * data->node_mem_count);
+	}
+
+	node = &data->nodes[node_index];
+	node->children_offset = children_offset;
+	update_vb(bvh, &node->vb, prim_bbc, offset, count);
+
+	if (!below_leaf_limit) {
+		BB cb;
+		BB_reset(&cb);
+		for (int i = offset + count - 1; i >= offset; --i)
+			BB_expand(&cb, prim_bbc[bvh->prim_indices[i]].bcentroid);
+		const int axis = BB_widest_axis(&cb);
+
+		end = partition_indices(bvh->prim_indices,
+		                        offset, offset + count - 1,
+		                        axis,
+		                        (cb.bmax[axis] + cb.bmin[axis]) * 0.5f,
+		                        prim_bbc);
+	}
+	else {
+		end = partition_indices_material(bvh, offset, offset + count - 1);
+	}
+
+	pbvh_verify_build_sub(data, children_offset, offset, end - offset);
+	pbvh_verify_build_sub(data, children_offset + 1, end, offset + count - end);
 }
 
-static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
+/* Check the nodes, primitive order and unique vertices of the built tree
+ * against the reference build, starting from the same primitive order. */
+static void pbvh_build_verify(PBVH *bvh, BBC *prim_bbc, int *prim_indices, int totprim)
+{
+	PBVHVerifyData data = {
+	    .bvh = bvh, .prim_bbc = prim_bbc,
+	    .totnode = 1, .node_mem_count = 100,
+	};
+	data.nodes = MEM_callocN(sizeof(PBVHVerifyNode) * data.node_mem_count, __func__);
+	if (bvh->looptri) {
+		data.vert_bitmap = BLI_BITMAP_NEW(bvh->totvert, __func__);
+		data.vert_owner = MEM_mallocN(sizeof(int) * bvh->totvert, __func__);
+		copy_vn_i(data.vert_owner, bvh->totvert, -1);
+	}
+
+	/* Partitioning works on the primitive indices of the PBVH. */
+	int *built_prim_indices = bvh->prim_indices;
+	bvh->prim_indices = prim_indices;
+	pbvh_verify_build_sub(&data, 0, 0, totprim);
+	bvh->prim_indices = built_prim_indices;
+
+	BLI_assert(data.totnode == bvh->totnode);
+	BLI_assert(memcmp(prim_indices, built_prim_indices, sizeof(int) * totprim) == 0);
+
+	for (int n = 0; n < data.totnode; ++n) {
+		const PBVHVerifyNode *ref = &data.nodes[n];
+		const PBVHNode *node = &bvh->nodes[n];
+
+		BLI_assert(memcmp(&ref->vb, &node->vb, sizeof(BB)) == 0);
+		BLI_assert(ref->is_leaf == ((node->flag & PBVH_Leaf) != 0));
+
+		if (!ref->is_leaf) {
+			BLI_assert(ref->children_offset == node->children_offset);
+			continue;
+		}
+
+		BLI_assert(node->prim_indices == bvh->prim_indices + ref->offset);
+		BLI_assert((int)node->totprim == ref->totprim);
+
+		if (bvh->looptri) {
+			/* Vertices owned by the leaf come first, followed by the ones
+			 * owned by earlier leaves. */
+			const int totvert = (int)(node->uniq_verts + node->face_verts);
+			for (int i = 0; i < totvert; ++i) {
+				const int v = node->vert_indices[i];
+				BLI_assert((data.vert_owner[v] == n) == (i < (int)node->uniq_verts));
+				UNUSED_VARS_NDEBUG(v);
+			}
+		}
+	}
+
+	if (bvh->looptri) {
+		/* Every vertex used by a face is owned by exactly one leaf. */
+		int *totuniq = MEM_callocN(sizeof(int) * data.totnode, __func__);
+		for (int v = 0; v < bvh->totvert; ++v) {
+			if (data.vert_owner[v] != -1) {
+				totuniq[data.vert_owner[v]]++;
+			}
+		}
+		for (int n = 0; n < data.totnode; ++n) {
+			if (data.nodes[n].is_leaf) {
+				BLI_assert(totuniq[n] == (int)bvh->nodes[n].uniq_verts);
+			}
+		}
+		MEM_freeN(totuniq);
+		MEM_freeN(data.vert_bitmap);
+		MEM_freeN(data.vert_owner);
+	}
+
+	MEM_freeN(data.nodes);
+}
+
+#endif  /* USE_VERIFY */
+
+static void pbvh_build(PBVH *bvh, const BB *vb, const BB *cb, BBC *prim_bbc, int totprim)
 {
 	if (totprim != bvh->totprim) {
 		bvh->totprim = totprim;
@@ -511,8 +787,163 @@ static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
 		}
 	}
 
+#ifdef USE_VERIFY
+	int *verify_prim_indices = MEM_dupallocN(bvh->prim_indices);
+#endif
+
+	/* Top levels are split on this thread, subtrees are then built in
+	 * parallel as their primitive ranges don't overlap. */
+	PBVHBuildData data = {
+	    .bvh = bvh, .prim_bbc = prim_bbc, .totleaf = 0,
+	};
+	PBVHBuildNode root = {NULL};
+	root.offset = 0;
+	root.count = totprim;
+
+	if (totprim > bvh->leaf_limit * PBVH_BUILD_TASK_LIMIT) {
+		TaskScheduler *scheduler = BLI_task_scheduler_get();
+		TaskPool *pool = BLI_task_pool_create_suspended(scheduler, &data);
+		pbvh_build_node(&data, pool, 0, &root, vb, cb);
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+	}
+	else {
+		pbvh_build_node(&data, NULL, 0, &root, vb, cb);
+	}
+
+	int *leaf_indices = MEM_mallocN(sizeof(int) * data.totleaf, "bvh leaf indices");
+	int totleaf = 0;
+
 	bvh->totnode = 1;
-	build_sub(bvh, 0, cb, prim_bbc, 0, totprim);
+	pbvh_build_flatten(bvh, &root, 0, leaf_indices, &totleaf);
+	BLI_assert(totleaf == data.totleaf);
+
+	/* Fill in leaves */
+	PBVHBuildLeafData leaf_data = {
+	    .bvh = bvh, .leaf_indices = leaf_indices,
+	};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (totleaf > PBVH_THREADED_LIMIT);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+
+	if (bvh->looptri) {
+		bvh->vert_leaf_owner = MEM_mallocN(sizeof(int) * bvh->totvert, "bvh vert_leaf_owner");
+		copy_vn_i(bvh->vert_leaf_owner, bvh->totvert, INT_MAX);
+		BLI_task_parallel_range(0, totleaf, &leaf_data, pbvh_build_vert_owner_task_cb, &settings);
+	}
+
+	BLI_task_parallel_range(0, totleaf, &leaf_data, pbvh_build_leaf_task_cb, &settings);
+
+	if (bvh->looptri) {
+		MEM_freeN(bvh->vert_leaf_owner);
+		bvh->vert_leaf_owner = NULL;
+	}
+
+	MEM_freeN(leaf_indices);
+
+#ifdef USE_VERIFY
+	pbvh_build_verify(bvh, prim_bbc, verify_prim_indices, totprim);
+	MEM_freeN(verify_prim_indices);
+#endif
+}
+
+typedef struct PBVHBuildBBData {
+	PBVH *bvh;
+	BBC *prim_bbc;
+	/* Bounds of all primitives and of their centroids. */
+	BB vb, cb;
+} PBVHBuildBBData;
+
+typedef struct PBVHBuildBBChunk {
+	BB vb, cb;
+} PBVHBuildBBChunk;
+
+static void pbvh_build_mesh_bbc_task_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	PBVHBuildBBData *data = userdata;
+	PBVHBuildBBChunk *chunk = tls->userdata_chunk;
+	PBVH *bvh = data->bvh;
+	const MLoopTri *lt = &bvh->looptri[i];
+	const int sides = 3;
+	BBC *bbc = data->prim_bbc + i;
+
+	BB_reset((BB *)bbc);
+
+	for (int j = 0; j < sides; ++j)
+		BB_expand((BB *)bbc, bvh->verts[bvh->mloop[lt->tri[j]].v].co);
+
+	BBC_update_centroid(bbc);
+
+	BB_expand_with_bb(&chunk->vb, (BB *)bbc);
+	BB_expand(&chunk->cb, bbc->bcentroid);
+}
+
+static void pbvh_build_grids_bbc_task_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	PBVHBuildBBData *data = userdata;
+	PBVHBuildBBChunk *chunk = tls->userdata_chunk;
+	PBVH *bvh = data->bvh;
+	const CCGKey *key = &bvh->gridkey;
+	const int gridsize = key->grid_size;
+	CCGElem *grid = bvh->grids[i];
+	BBC *bbc = data->prim_bbc + i;
+
+	BB_reset((BB *)bbc);
+
+	for (int j = 0; j < gridsize * gridsize; ++j)
+		BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+
+	BBC_update_centroid(bbc);
+
+	BB_expand_with_bb(&chunk->vb, (BB *)bbc);
+	BB_expand(&chunk->cb, bbc->bcentroid);
+}
+
+static void pbvh_build_bbc_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	PBVHBuildBBData *data = userdata;
+	PBVHBuildBBChunk *chunk = userdata_chunk;
+
+	BB_expand_with_bb(&data->vb, &chunk->vb);
+	BB_expand_with_bb(&data->cb, &chunk->cb);
+}
+
+/* For each primitive, store the AABB and the AABB centroid, and find bounds
+ * of all of them. */
+static BBC *pbvh_build_prim_bbc(PBVH *bvh, int totprim, TaskParallelRangeFunc func,
+                                BB *r_vb, BB *r_cb)
+{
+	PBVHBuildBBData data = {
+	    .bvh = bvh, .prim_bbc = MEM_mallocN(sizeof(BBC) * totprim, "prim_bbc"),
+	};
+	PBVHBuildBBChunk chunk;
+
+	BB_reset(&data.vb);
+	BB_reset(&data.cb);
+	BB_reset(&chunk.vb);
+	BB_reset(&chunk.cb);
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = bvh->leaf_limit;
+	settings.userdata_chunk = &chunk;
+	settings.userdata_chunk_size = sizeof(chunk);
+	settings.func_finalize = pbvh_build_bbc_finalize;
+
+	BLI_task_parallel_range(0, totprim, &data, func, &settings);
+
+	*r_vb = data.vb;
+	*r_cb = data.cb;
+
+	return data.prim_bbc;
 }
 
 /**
@@ -526,44 +957,31 @@ void BKE_pbvh_build_mesh(
         int totvert, struct CustomData *vdata,
         const MLoopTri *looptri, int looptri_num)
 {
-	BBC *prim_bbc = NULL;
-	BB cb;
-
 	bvh->type = PBVH_FACES;
 	bvh->mpoly = mpoly;
 	bvh->mloop = mloop;
 	bvh->looptri = looptri;
 	bvh->verts = verts;
-	bvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
 	bvh->totvert = totvert;
 	bvh->leaf_limit = LEAF_LIMIT;
 	bvh->vdata = vdata;
 
-	BB_reset(&cb);
+#ifdef DEBUG_TIME
+	TIMEIT_START(pbvh_build_mesh);
+#endif
 
 	/* For each face, store the AABB and the AABB centroid */
-	prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
-
-	for (int i = 0; i < looptri_num; ++i) {
-		const MLoopTri *lt = &looptri[i];
-		const int sides = 3;
-		BBC *bbc = prim_bbc + i;
-
-		BB_reset((BB *)bbc);
-
-		for (int j = 0; j < sides; ++j)
-			BB_expand((BB *)bbc, verts[bvh->mloop[lt->tri[j]].v].co);
-
-		BBC_update_centroid(bbc);
-
-		BB_expand(&cb, bbc->bcentroid);
-	}
+	BB vb, cb;
+	BBC *prim_bbc = pbvh_build_prim_bbc(bvh, looptri_num, pbvh_build_mesh_bbc_task_cb, &vb, &cb);
 
 	if (looptri_num)
-		pbvh_build(bvh, &cb, prim_bbc, looptri_num);
+		pbvh_build(bvh, &vb, &cb, prim_bbc, looptri_num);
 
 	MEM_freeN(prim_bbc);
-	MEM_freeN(bvh->vert_bitmap);
+
+#ifdef DEBUG_TIME
+	TIMEIT_END(pbvh_build_mesh);
+#endif
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -581,30 +999,22 @@ void BKE_pbvh_build_grids(PBVH *bvh, CCGElem **grids,
 	bvh->grid_hidden = grid_hidden;
 	bvh->leaf_limit = max_ii(LEAF_LIMIT / ((gridsize - 1) * (gridsize - 1)), 1);
 
-	BB cb;
-	BB_reset(&cb);
+#ifdef DEBUG_TIME
+	TIMEIT_START(pbvh_build_grids);
+#endif
 
 	/* For each grid, store the AABB and the AABB centroid */
-	BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
-
-	for (int i = 0; i < totgrid; ++i) {
-		CCGElem *grid = grids[i];
-		BBC *bbc = prim_bbc + i;
-
-		BB_reset((BB *)bbc);
-
-		for (int j = 0; j < gridsize * gridsize; ++j)
-			BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-
-		BBC_update_centroid(bbc);
-
-		BB_expand(&cb, bbc->bcentroid);
-	}
+	BB vb, cb;
+	BBC *prim_bbc = pbvh_build_prim_bbc(bvh, totgrid, pbvh_build_grids_bbc_task_cb, &vb, &cb);
 
 	if (totgrid)
-		pbvh_build(bvh, &cb, prim_bbc, totgrid);
+		pbvh_build(bvh, &vb, &cb, prim_bbc, totgrid);
 
 	MEM_freeN(prim_bbc);
+
+#ifdef DEBUG_TIME
+	TIMEIT_END(pbvh_build_grids);
+#endif
 }
 
 PBVH *BKE_pbvh_new(void)
@@ -150,9 +150,9 @@ struct PBVH {
 	 * in an opaque pointer per pbvh. See T47637. */
 	struct GridCommonGPUBuffer *grid_common_gpu_buffer;
 
-	/* Only used during BVH build and update,
-	 * don't need to remain valid after */
-	BLI_bitmap *vert_bitmap;
+	/* Only used during BVH build, index of the first leaf in depth-first
+	 * order which uses the vertex */
+	int *vert_leaf_owner;
 
 #ifdef PERFCNTRS
 	int perf_modified;
@@ -62,6 +62,7 @@ typedef struct Depsgraph Depsgraph;
 
 struct EvaluationContext;
 struct Main;
+struct Object;
 
 struct PointerRNA;
 struct PropertyRNA;
@@ -187,6 +188,36 @@ void DEG_evaluate_on_refresh(struct EvaluationContext *eval_ctx,
 
 bool DEG_needs_eval(Depsgraph *graph);
 
+/* Multi-frame Evaluation ------------------------ */
+
+/* Check whether transform of the object can be evaluated for an arbitrary
+ * frame without evaluating the rest of the scene. This is the case when it
+ * is only affected by action animation of the object and its parents.
+ */
+bool DEG_object_supports_multiframe_eval(struct Object *ob);
+
+/* Receives evaluated copy of an object, called from worker threads.
+ * The copy only lives for the duration of the call, and its parent pointer
+ * points to the original (not evaluated) parent.
+ */
+typedef void (*DEG_MultiframeObjectCb)(void *userdata,
+                                       int frame_index,
+                                       int object_index,
+                                       struct Object *ob_eval);
+
+/* Evaluate transform of the objects at all the given times. Frames are
+ * evaluated concurrently on copies of the objects, so neither the scene nor
+ * the objects are modified. All objects must pass
+ * DEG_object_supports_multiframe_eval().
+ * < ctimes: evaluation times, as returned by BKE_scene_frame_get()
+ */
+void DEG_evaluate_objects_multiframe(struct Object **objects,
+                                     int num_objects,
+                                     const float *ctimes,
+                                     int num_frames,
+                                     DEG_MultiframeObjectCb callback,
+                                     void *userdata);
+
 /* Editors Integration  -------------------------- */
 
 /* Mechanism to allow editors to be informed of depsgraph updates,
@@ -40,6 +40,7 @@ struct Depsgraph;
 
 /* ------------------------------------------------ */
 
+struct ID;
 struct Main;
 struct Scene;
 struct Group;
@@ -66,6 +67,13 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update. Unlike tagging all relations,
+ * this allows to only rebuild the part of the graph around the ID.
+ */
+void DEG_graph_id_tag_relations_update(struct Depsgraph *graph,
+                                       struct ID *id);
+void DEG_id_relations_tag_update(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
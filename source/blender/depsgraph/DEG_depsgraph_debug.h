@@ -60,6 +60,11 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* Write timeline of the recent evaluations as Chrome trace JSON. Timeline is
+ * only recorded while depsgraph timing debug is enabled.
+ */
+void DEG_debug_trace_chrome(const struct Depsgraph *graph, FILE *stream);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
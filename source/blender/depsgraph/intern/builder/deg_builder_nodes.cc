@@ -264,6 +264,14 @@ OperationDepsNode *DepsgraphNodeBuilder::find_operation_node(
 void DepsgraphNodeBuilder::begin_build() {
 }
 
+void DepsgraphNodeBuilder::begin_build_partial(Scene *scene)
+{
+	scene_ = scene;
+	foreach (IDDepsNode *id_node, graph_->id_nodes) {
+		built_map_.tagBuild(id_node->id);
+	}
+}
+
 void DepsgraphNodeBuilder::build_id(ID *id)
 {
 	if (id == NULL) {
@@ -72,6 +72,10 @@ struct DepsgraphNodeBuilder {
 	~DepsgraphNodeBuilder();
 
 	void begin_build();
+	/* Prepare for building nodes of some objects in an existing graph, IDs
+	 * which already have nodes are not built again.
+	 */
+	void begin_build_partial(Scene *scene);
 
 	IDDepsNode *add_id_node(ID *id);
 	TimeSourceDepsNode *add_time_source();
@@ -40,6 +40,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 
 extern "C" {
 #include "DNA_action_types.h"
@@ -174,7 +175,8 @@ DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
                                                    Depsgraph *graph)
     : bmain_(bmain),
       graph_(graph),
-      scene_(NULL)
+      scene_(NULL),
+      rebuilt_operations_(NULL)
 {
 }
 
@@ -247,6 +249,12 @@ DepsRelation *DepsgraphRelationBuilder::add_time_relation(
         bool check_unique)
 {
 	if (timesrc && node_to) {
+		if (rebuilt_operations_ != NULL &&
+		    !BLI_gset_haskey(rebuilt_operations_, node_to))
+		{
+			/* Relation is in the graph already. */
+			return NULL;
+		}
 		return graph_->add_new_relation(timesrc, node_to, description, check_unique);
 	}
 	else {
@@ -265,6 +273,13 @@ DepsRelation *DepsgraphRelationBuilder::add_operation_relation(
         bool check_unique)
 {
 	if (node_from && node_to) {
+		if (rebuilt_operations_ != NULL &&
+		    !BLI_gset_haskey(rebuilt_operations_, node_from) &&
+		    !BLI_gset_haskey(rebuilt_operations_, node_to))
+		{
+			/* Relation is in the graph already. */
+			return NULL;
+		}
 		return graph_->add_new_relation(node_from,
 		                                node_to,
 		                                description,
@@ -381,6 +396,60 @@ void DepsgraphRelationBuilder::begin_build()
 {
 }
 
+void DepsgraphRelationBuilder::begin_build_partial(GSet *rebuild_ids,
+                                                   GSet *rebuilt_operations)
+{
+	rebuilt_operations_ = rebuilt_operations;
+	/* Objects which relations are kept are skipped, other IDs are built again
+	 * when they are reached, so relations of their users are all visited.
+	 */
+	foreach (IDDepsNode *id_node, graph_->id_nodes) {
+		ID *id = id_node->id;
+		if (GS(id->name) == ID_OB && !BLI_gset_haskey(rebuild_ids, id)) {
+			built_map_.tagBuild(id);
+		}
+	}
+}
+
+void DepsgraphRelationBuilder::build_id(ID *id)
+{
+	if (id == NULL) {
+		return;
+	}
+	switch (GS(id->name)) {
+		case ID_SCE:
+			build_scene((Scene *)id);
+			break;
+		case ID_GR:
+			build_group(NULL, (Group *)id);
+			break;
+		case ID_OB:
+			build_object((Object *)id);
+			break;
+		case ID_NT:
+			build_nodetree((bNodeTree *)id);
+			break;
+		case ID_MA:
+			build_material((Material *)id);
+			break;
+		case ID_TE:
+			build_texture((Tex *)id);
+			break;
+		case ID_WO:
+			build_world((World *)id);
+			break;
+		case ID_MSK:
+			build_mask((Mask *)id);
+			break;
+		case ID_MC:
+			build_movieclip((MovieClip *)id);
+			break;
+		default:
+			/* fprintf(stderr, "Unhandled ID %s\n", id->name); */
+			break;
+	}
+}
+
 void DepsgraphRelationBuilder::build_group(Object *object, Group *group)
 {
 	const bool group_done = built_map_.checkIsBuiltAndTag(group);
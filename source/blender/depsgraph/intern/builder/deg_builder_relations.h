@@ -53,6 +53,7 @@ struct bGPdata;
 struct CacheFile;
 struct ListBase;
 struct GHash;
+struct GSet;
 struct ID;
 struct FCurve;
 struct Group;
@@ -172,6 +173,12 @@ struct DepsgraphRelationBuilder
 	DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph);
 
 	void begin_build();
+	/* Prepare for rebuilding relations around some IDs of an existing graph.
+	 * Only objects from rebuild_ids are built, and only relations involving
+	 * one of rebuilt_operations are added, all others are in the graph
+	 * already.
+	 */
+	void begin_build_partial(GSet *rebuild_ids, GSet *rebuilt_operations);
 
 	template <typename KeyFrom, typename KeyTo>
 	DepsRelation *add_relation(const KeyFrom& key_from,
@@ -191,6 +198,7 @@ struct DepsgraphRelationBuilder
 	                                       const char *description,
 	                                       bool check_unique = false);
 
+	void build_id(ID *id);
 	void build_scene(Scene *scene);
 	void build_group(Object *object, Group *group);
 	void build_object(Object *object);
@@ -336,6 +344,9 @@ private:
 	Scene *scene_;
 
 	BuilderMap built_map_;
+
+	/* Operations created by partial rebuild, NULL when building whole graph. */
+	GSet *rebuilt_operations_;
 };
 
 struct DepsNodeHandle
@@ -0,0 +1,132 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2018 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/debug/deg_debug_trace_chrome.cc
+ *  \ingroup depsgraph
+ *
+ * Export of the evaluation timeline in the Chrome trace event format, which
+ * can be opened in chrome://tracing.
+ */
+
+#include "DEG_depsgraph_debug.h"
+
+#include "BLI_utildefines.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+#include "intern/eval/deg_eval_trace.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "util/deg_util_foreach.h"
+
+extern "C" {
+#include "DNA_ID.h"
+} /* extern "C" */
+
+namespace DEG {
+namespace {
+
+void write_json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+	for (const char *c = str; *c != '\0'; ++c) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', f);
+			fputc(*c, f);
+		}
+		else if ((unsigned char)*c < 0x20) {
+			fprintf(f, "\\u%04x", (unsigned int)*c);
+		}
+		else {
+			fputc(*c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+void write_trace_event(FILE *f,
+                       const EvalTraceEvent& event,
+                       double start_time)
+{
+	/* Timestamps are in microseconds. */
+	const double ts = (event.start_time - start_time) * 1e6;
+	const double dur = (event.end_time - event.start_time) * 1e6;
+	fprintf(f, "{\"name\": ");
+	if (event.node == NULL) {
+		write_json_string(f, "Depsgraph Evaluation");
+		fprintf(f, ", \"cat\": \"Depsgraph\"");
+	}
+	else {
+		const OperationDepsNode *op_node = event.node;
+		const ComponentDepsNode *comp_node = op_node->owner;
+		const IDDepsNode *id_node = comp_node->owner;
+		write_json_string(f, op_node->identifier().c_str());
+		fprintf(f, ", \"cat\": ");
+		write_json_string(f, deg_type_get_factory(comp_node->type)->tname());
+		fprintf(f, ", \"args\": {\"id\": ");
+		write_json_string(f, id_node->id->name);
+		fprintf(f, ", \"component\": ");
+		write_json_string(f, comp_node->name);
+		fprintf(f, "}");
+	}
+	fprintf(f,
+	        ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f"
+	        ", \"pid\": 0, \"tid\": %d}",
+	        ts, dur, event.thread_id);
+}
+
+void deg_debug_trace_chrome(const Depsgraph *graph, FILE *f)
+{
+	vector<EvalTraceEvent> events;
+	if (graph->eval_trace != NULL) {
+		graph->eval_trace->get_events(&events);
+	}
+	/* Make timeline start at the earliest event. */
+	double start_time = 0.0;
+	foreach (const EvalTraceEvent& event, events) {
+		if (start_time == 0.0 || event.start_time < start_time) {
+			start_time = event.start_time;
+		}
+	}
+	fprintf(f, "{\"traceEvents\": [\n");
+	for (size_t i = 0; i < events.size(); ++i) {
+		write_trace_event(f, events[i], start_time);
+		fprintf(f, (i + 1 < events.size()) ? ",\n" : "\n");
+	}
+	fprintf(f, "], \"displayTimeUnit\": \"ms\"}\n");
+}
+
+}  // namespace
+}  // namespace DEG
+
+void DEG_debug_trace_chrome(const Depsgraph *depsgraph, FILE *f)
+{
+	if (depsgraph == NULL) {
+		return;
+	}
+	DEG::deg_debug_trace_chrome((const DEG::Depsgraph *)depsgraph, f);
+}
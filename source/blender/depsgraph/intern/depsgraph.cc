@@ -58,6 +58,7 @@ extern "C" {
 
 #include "DEG_depsgraph.h"
 
+#include "intern/eval/deg_eval_trace.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_id.h"
@@ -84,11 +85,13 @@ static void remove_from_vector(vector<T> *vector, const T& value)
 Depsgraph::Depsgraph()
   : time_source(NULL),
     need_update(false),
-    layers(0)
+    layers(0),
+    eval_trace(NULL)
 {
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
@@ -96,9 +99,13 @@ Depsgraph::~Depsgraph()
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
+	if (eval_trace != NULL) {
+		OBJECT_GUARDED_DELETE(eval_trace, EvalTrace);
+	}
 	BLI_spin_end(&lock);
 }
 
@@ -316,6 +323,56 @@ void Depsgraph::clear_id_nodes()
 {
 	BLI_ghash_clear(id_hash, NULL, id_node_deleter);
 	id_nodes.clear();
+	if (eval_trace != NULL) {
+		eval_trace->clear();
+	}
+}
+
+void Depsgraph::remove_id_node(IDDepsNode *id_node)
+{
+	/* Unlink relations with nodes of other IDs. Relations between operations
+	 * of this ID are freed together with the operations.
+	 */
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		foreach (OperationDepsNode *op_node, comp_node->operations) {
+			foreach (DepsRelation *rel, op_node->outlinks) {
+				OperationDepsNode *to = (OperationDepsNode *)rel->to;
+				if (to->owner->owner != id_node) {
+					remove_from_vector(&to->inlinks, rel);
+					OBJECT_GUARDED_DELETE(rel, DepsRelation);
+				}
+			}
+			op_node->outlinks.clear();
+			foreach (DepsRelation *rel, op_node->inlinks) {
+				if (rel->from->type != DEG_NODE_TYPE_OPERATION ||
+				    ((OperationDepsNode *)rel->from)->owner->owner != id_node)
+				{
+					remove_from_vector(&rel->from->outlinks, rel);
+				}
+			}
+		}
+	}
+	GHASH_FOREACH_END();
+	/* Remove operations from the graph-wide storage. */
+	size_t num_operations = 0;
+	for (size_t i = 0; i < operations.size(); ++i) {
+		OperationDepsNode *op_node = operations[i];
+		if (op_node->owner->owner == id_node) {
+			BLI_gset_remove(entry_tags, op_node, NULL);
+		}
+		else {
+			operations[num_operations++] = op_node;
+		}
+	}
+	operations.resize(num_operations);
+	/* Trace refers to operations by pointer. */
+	if (eval_trace != NULL) {
+		eval_trace->clear();
+	}
+	BLI_ghash_remove(id_hash, id_node->id, NULL, NULL);
+	remove_from_vector(&id_nodes, id_node);
+	OBJECT_GUARDED_DELETE(id_node, IDDepsNode);
 }
 
 /* Add new relationship between two nodes. */
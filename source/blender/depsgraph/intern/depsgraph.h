@@ -53,6 +53,7 @@ struct TimeSourceDepsNode;
 struct IDDepsNode;
 struct ComponentDepsNode;
 struct OperationDepsNode;
+struct EvalTrace;
 
 /* *************************** */
 /* Relationships Between Nodes */
@@ -117,6 +118,11 @@ struct Depsgraph {
 	IDDepsNode *add_id_node(ID *id, const char *name = "");
 	void clear_id_nodes();
 
+	/* Remove ID node with all its components, operations and relations with
+	 * the rest of the graph.
+	 */
+	void remove_id_node(IDDepsNode *id_node);
+
 	/* Add new relationship between two nodes. */
 	DepsRelation *add_new_relation(OperationDepsNode *from,
 	                               OperationDepsNode *to,
@@ -161,6 +167,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations were tagged for update, used to only rebuild the
+	 * affected part of the graph. Ignored when need_update is set.
+	 */
+	GSet *id_relations_tags;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -182,6 +193,13 @@ struct Depsgraph {
 	/* Visible layers bitfield, used for skipping invisible objects updates. */
 	unsigned int layers;
 
+	/* Debugging .......................... */
+
+	/* Timeline of the recent evaluations, only recorded when timing debug is
+	 * enabled.
+	 */
+	EvalTrace *eval_trace;
+
 	// XXX: additional stuff like eval contexts, mempools for allocating nodes from, etc.
 };
 
@@ -34,12 +34,15 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_stack.h"
 
 #include "PIL_time.h"
 #include "PIL_time_utildefines.h"
 
 extern "C" {
 #include "DNA_cachefile_types.h"
+#include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_object_force_types.h"
@@ -243,6 +246,216 @@ void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 	}
 }
 
+/* Check whether relations of the object can be rebuilt without rebuilding
+ * the whole graph. Objects which are found by other objects with scene wide
+ * queries (colliders, force fields, rigid bodies) might gain relations which
+ * are only created when building those other objects.
+ */
+static bool deg_object_supports_partial_build(Object *object)
+{
+	if (object->proxy != NULL ||
+	    object->proxy_from != NULL ||
+	    object->proxy_group != NULL)
+	{
+		return false;
+	}
+	if (object->rigidbody_object != NULL ||
+	    object->rigidbody_constraint != NULL)
+	{
+		return false;
+	}
+	if (object->pd != NULL &&
+	    (object->pd->forcefield != 0 || object->pd->deflect != 0))
+	{
+		return false;
+	}
+	if (object->type == OB_MBALL ||
+	    !BLI_listbase_is_empty(&object->particlesystem))
+	{
+		return false;
+	}
+	LISTBASE_FOREACH (ModifierData *, md, &object->modifiers) {
+		if (ELEM(md->type,
+		         eModifierType_Collision,
+		         eModifierType_Surface,
+		         eModifierType_DynamicPaint,
+		         eModifierType_Smoke,
+		         eModifierType_Fluidsim))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void deg_graph_gather_rebuild_id(DEG::DepsNode *node,
+                                        GSet *rebuild_ids,
+                                        GSet *visited,
+                                        BLI_Stack *stack)
+{
+	if (node->type != DEG::DEG_NODE_TYPE_OPERATION) {
+		return;
+	}
+	DEG::IDDepsNode *id_node = ((DEG::OperationDepsNode *)node)->owner->owner;
+	if (!BLI_gset_add(visited, id_node)) {
+		return;
+	}
+	switch (GS(id_node->id->name)) {
+		case ID_OB:
+		case ID_NT:
+		case ID_MA:
+		case ID_TE:
+		case ID_WO:
+		case ID_MSK:
+		case ID_MC:
+			BLI_gset_add(rebuild_ids, id_node->id);
+			break;
+		case ID_SCE:
+			/* Scene relations are always visited. */
+			break;
+		default:
+			BLI_stack_push(stack, &id_node);
+			break;
+	}
+}
+
+/* Gather IDs which relations with the given ID node are to be rebuilt.
+ * IDs which relations can only be built as a part of their users, such as
+ * object data, are passed through, so their users are rebuilt instead.
+ */
+static void deg_graph_gather_rebuild_ids(DEG::IDDepsNode *id_node,
+                                         GSet *rebuild_ids,
+                                         GSet *visited)
+{
+	BLI_Stack *stack = BLI_stack_new(sizeof(DEG::IDDepsNode *),
+	                                 "DEG rebuild ids stack");
+	BLI_gset_add(visited, id_node);
+	BLI_stack_push(stack, &id_node);
+	while (!BLI_stack_is_empty(stack)) {
+		DEG::IDDepsNode *current;
+		BLI_stack_pop(stack, &current);
+		GHASH_FOREACH_BEGIN(DEG::ComponentDepsNode *, comp_node, current->components)
+		{
+			foreach (DEG::OperationDepsNode *op_node, comp_node->operations) {
+				foreach (DEG::DepsRelation *rel, op_node->inlinks) {
+					deg_graph_gather_rebuild_id(rel->from, rebuild_ids, visited, stack);
+				}
+				foreach (DEG::DepsRelation *rel, op_node->outlinks) {
+					deg_graph_gather_rebuild_id(rel->to, rebuild_ids, visited, stack);
+				}
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	BLI_stack_free(stack);
+}
+
+/* Rebuild only nodes of objects which relations were tagged for update, and
+ * relations of those objects and their direct neighbors, keeping the rest of
+ * the graph. Returns false when this is not possible, and the whole graph is
+ * to be rebuilt.
+ */
+static bool deg_graph_build_partial(DEG::Depsgraph *graph,
+                                    Main *bmain,
+                                    Scene *scene)
+{
+	if (scene->set != NULL) {
+		return false;
+	}
+	DEG::vector<Object *> objects;
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_tags)
+	{
+		/* Only objects are supported, and tagged IDs might have been freed
+		 * since then, so check without accessing them.
+		 */
+		if (BLI_findindex(&bmain->object, id) == -1 ||
+		    !deg_object_supports_partial_build((Object *)id))
+		{
+			return false;
+		}
+		objects.push_back((Object *)id);
+	}
+	GSET_FOREACH_END();
+
+	/* Gather IDs around the tagged objects before their nodes are removed,
+	 * those nodes are built from scratch.
+	 */
+	GSet *rebuild_ids = BLI_gset_ptr_new("DEG rebuild ids");
+	GSet *visited = BLI_gset_ptr_new("DEG rebuild visited");
+	DEG::vector<bool> objects_in_graph(objects.size(), false);
+	for (size_t i = 0; i < objects.size(); ++i) {
+		DEG::IDDepsNode *id_node = graph->find_id_node(&objects[i]->id);
+		if (id_node != NULL) {
+			deg_graph_gather_rebuild_ids(id_node, rebuild_ids, visited);
+			graph->remove_id_node(id_node);
+			objects_in_graph[i] = true;
+		}
+	}
+	BLI_gset_free(visited, NULL);
+	const size_t num_id_nodes = graph->id_nodes.size();
+	const size_t num_operations = graph->operations.size();
+
+	/* 1) Generate nodes of the tagged objects, and of IDs which are not in
+	 *    the graph yet.
+	 */
+	DEG::DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build_partial(scene);
+	LISTBASE_FOREACH (Base *, base, &scene->base) {
+		if (BLI_gset_haskey(graph->id_relations_tags, base->object)) {
+			node_builder.build_object(base, base->object);
+		}
+	}
+	/* Objects which are not in the scene are only kept when something in the
+	 * graph was using them.
+	 */
+	for (size_t i = 0; i < objects.size(); ++i) {
+		if (objects_in_graph[i] && graph->find_id_node(&objects[i]->id) == NULL) {
+			node_builder.build_object(NULL, objects[i]);
+		}
+	}
+	GSet *rebuilt_operations = BLI_gset_ptr_new("DEG rebuilt operations");
+	for (size_t i = num_id_nodes; i < graph->id_nodes.size(); ++i) {
+		BLI_gset_add(rebuild_ids, graph->id_nodes[i]->id);
+	}
+	for (size_t i = num_operations; i < graph->operations.size(); ++i) {
+		BLI_gset_add(rebuilt_operations, graph->operations[i]);
+	}
+	/* New objects might have been pulled in by the tagged ones, make sure
+	 * they get layers of their bases.
+	 */
+	LISTBASE_FOREACH (Base *, base, &scene->base) {
+		if (BLI_gset_haskey(rebuild_ids, base->object)) {
+			node_builder.build_object(base, base->object);
+		}
+	}
+
+	/* 2) Hook up relationships of the new operations. */
+	DEG::DepsgraphRelationBuilder relation_builder(bmain, graph);
+	relation_builder.begin_build_partial(rebuild_ids, rebuilt_operations);
+	relation_builder.build_scene(scene);
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_ids)
+	{
+		relation_builder.build_id(id);
+	}
+	GSET_FOREACH_END();
+	BLI_gset_free(rebuild_ids, NULL);
+	BLI_gset_free(rebuilt_operations, NULL);
+
+	/* Detect and solve cycles from scratch, new relations might break cycles
+	 * in a different place.
+	 */
+	foreach (DEG::OperationDepsNode *op_node, graph->operations) {
+		foreach (DEG::DepsRelation *rel, op_node->inlinks) {
+			rel->flag &= ~DEG::DEPSREL_FLAG_CYCLIC;
+		}
+	}
+	DEG::deg_graph_detect_cycles(graph);
+
+	/* 3) Flush visibility layer and re-schedule nodes for update. */
+	DEG::deg_graph_build_finalize(graph);
+	return true;
+}
+
 /* Tag graph relations for update. */
 void DEG_graph_tag_relations_update(Depsgraph *graph)
 {
@@ -250,6 +463,15 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
 	deg_graph->need_update = true;
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_graph_id_tag_relations_update(Depsgraph *graph, ID *id)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	if (!deg_graph->need_update) {
+		BLI_gset_add(deg_graph->id_relations_tags, id);
+	}
+}
+
 /* Tag all relations for update. */
 void DEG_relations_tag_update(Main *bmain)
 {
@@ -263,6 +485,19 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of the given ID for update in all graphs. */
+void DEG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph != NULL) {
+			DEG_graph_id_tag_relations_update(scene->depsgraph, id);
+		}
+	}
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -277,8 +512,26 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_len(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		/* Only relations of some IDs changed, try to rebuild just the part of
+		 * the graph around them.
+		 */
+		double start_time;
+		if (G.debug & G_DEBUG_DEPSGRAPH_BUILD) {
+			start_time = PIL_check_seconds_timer();
+		}
+		const bool done = deg_graph_build_partial(graph, bmain, scene);
+		if (done && (G.debug & G_DEBUG_DEPSGRAPH_BUILD)) {
+			printf("Depsgraph partially rebuilt in %f seconds.\n",
+			       PIL_check_seconds_timer() - start_time);
+		}
+		BLI_gset_clear(graph->id_relations_tags, NULL);
+		if (done) {
+			return;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
@@ -292,6 +545,7 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 	                           scene);
 
 	graph->need_update = false;
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 }
 
 /* Rebuild dependency graph only for a given scene. */
@@ -46,6 +46,7 @@ extern "C" {
 
 #include "intern/eval/deg_eval.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_multiframe.h"
 
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -157,3 +158,23 @@ bool DEG_needs_eval(Depsgraph *graph)
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
 	return BLI_gset_len(deg_graph->entry_tags) != 0;
 }
+
+bool DEG_object_supports_multiframe_eval(Object *ob)
+{
+	return DEG::deg_object_supports_multiframe_eval(ob);
+}
+
+void DEG_evaluate_objects_multiframe(Object **objects,
+                                     int num_objects,
+                                     const float *ctimes,
+                                     int num_frames,
+                                     DEG_MultiframeObjectCb callback,
+                                     void *userdata)
+{
+	DEG::deg_evaluate_objects_multiframe(objects,
+	                                     num_objects,
+	                                     ctimes,
+	                                     num_frames,
+	                                     callback,
+	                                     userdata);
+}
@@ -34,9 +34,13 @@
 
 #include "PIL_time.h"
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
+#include "BLI_heap.h"
+#include "BLI_threads.h"
 
 extern "C" {
 #include "BKE_depsgraph.h"
@@ -49,6 +53,7 @@ extern "C" {
 
 #include "intern/eval/deg_eval_flush.h"
 #include "intern/eval/deg_eval_stats.h"
+#include "intern/eval/deg_eval_trace.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_id.h"
@@ -76,25 +81,54 @@ struct DepsgraphEvalState {
 	Depsgraph *graph;
 	unsigned int layers;
 	bool do_stats;
+	/* Timeline of evaluated operations, NULL when it is not recorded. */
+	EvalTrace *trace;
+	/* Operations which are ready for evaluation, ordered by their critical
+	 * path time. Every task pushed to the pool evaluates the top one, so the
+	 * longest remaining chain of operations is always started first.
+	 */
+	Heap *ready_heap;
+	SpinLock ready_lock;
 };
 
+static OperationDepsNode *pop_ready_node(DepsgraphEvalState *state)
+{
+	BLI_spin_lock(&state->ready_lock);
+	OperationDepsNode *node =
+	        (OperationDepsNode *)BLI_heap_pop_min(state->ready_heap);
+	BLI_spin_unlock(&state->ready_lock);
+	return node;
+}
+
+static void push_ready_node(DepsgraphEvalState *state, OperationDepsNode *node)
+{
+	BLI_spin_lock(&state->ready_lock);
+	BLI_heap_insert(state->ready_heap, -(float)node->critical_path_time, node);
+	BLI_spin_unlock(&state->ready_lock);
+}
+
 static void deg_task_run_func(TaskPool *pool,
-                              void *taskdata,
+                              void * /*taskdata*/,
                               int thread_id)
 {
 	void *userdata_v = BLI_task_pool_userdata(pool);
 	DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
-	OperationDepsNode *node = (OperationDepsNode *)taskdata;
+	/* Every task is pushed along with a ready node, so there is always
+	 * one to take here, though not necessarily the same one.
+	 */
+	OperationDepsNode *node = pop_ready_node(state);
 	/* Sanity checks. */
+	BLI_assert(node != NULL);
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
-	/* Perform operation. */
-	if (state->do_stats) {
-		const double start_time = PIL_check_seconds_timer();
-		node->evaluate(state->eval_ctx);
-		node->stats.current_time += PIL_check_seconds_timer() - start_time;
-	}
-	else {
-		node->evaluate(state->eval_ctx);
+	/* Perform operation. Timing is always gathered, it is used to prioritize
+	 * operations on the critical path in the next evaluations.
+	 */
+	const double start_time = PIL_check_seconds_timer();
+	node->evaluate(state->eval_ctx);
+	const double end_time = PIL_check_seconds_timer();
+	node->stats.current_time += end_time - start_time;
+	if (state->trace != NULL) {
+		state->trace->record(node, start_time, end_time, thread_id);
 	}
 	/* Schedule children. */
 	BLI_task_pool_delayed_push_begin(pool, thread_id);
@@ -159,14 +193,12 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 
 static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
-	const bool do_stats = state->do_stats;
+	deg_eval_stats_update_critical_path(graph);
 	calculate_pending_parents(graph, state->layers);
 	/* Clear tags and other things which needs to be clear. */
 	foreach (OperationDepsNode *node, graph->operations) {
 		node->done = 0;
-		if (do_stats) {
-			node->stats.reset_current();
-		}
+		node->stats.reset_current();
 	}
 }
 
@@ -198,9 +230,12 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 				}
 				else {
 					/* children are scheduled once this task is completed */
+					DepsgraphEvalState *state =
+					        (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
+					push_ready_node(state, node);
 					BLI_task_pool_push_from_thread(pool,
 					                               deg_task_run_func,
-					                               node,
+					                               NULL,
 					                               false,
 					                               TASK_PRIORITY_HIGH,
 					                               thread_id);
@@ -265,12 +300,18 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	                 graph->layers);
 	const bool do_time_debug = ((G.debug & G_DEBUG_DEPSGRAPH_TIME) != 0);
 	const double start_time = do_time_debug ? PIL_check_seconds_timer() : 0;
+	if (do_time_debug && graph->eval_trace == NULL) {
+		graph->eval_trace = OBJECT_GUARDED_NEW(EvalTrace);
+	}
 	/* Set up evaluation context for depsgraph itself. */
 	DepsgraphEvalState state;
 	state.eval_ctx = eval_ctx;
 	state.graph = graph;
 	state.layers = layers;
 	state.do_stats = do_time_debug;
+	state.trace = do_time_debug ? graph->eval_trace : NULL;
+	state.ready_heap = BLI_heap_new();
+	BLI_spin_init(&state.ready_lock);
 	/* Set up task scheduler and pull for threaded evaluation. */
 	TaskScheduler *task_scheduler;
 	bool need_free_scheduler;
@@ -289,10 +330,14 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	schedule_graph(task_pool, graph, layers);
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
+	BLI_assert(BLI_heap_is_empty(state.ready_heap));
+	BLI_heap_free(state.ready_heap, NULL);
+	BLI_spin_end(&state.ready_lock);
 	/* Finalize statistics gathering. This is because we only gather single
 	 * operation timing here, without aggregating anything to avoid any extra
 	 * synchronization.
 	 */
+	deg_eval_stats_update_average(graph);
 	if (state.do_stats) {
 		deg_eval_stats_aggregate(graph);
 	}
@@ -302,8 +347,12 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 		BLI_task_scheduler_free(task_scheduler);
 	}
 	if (do_time_debug) {
-		printf("Depsgraph updated in %f seconds.\n",
-		       PIL_check_seconds_timer() - start_time);
+		const double end_time = PIL_check_seconds_timer();
+		/* Whole evaluation goes to the trace as well, so the time spent
+		 * outside of the operations is visible.
+		 */
+		graph->eval_trace->record(NULL, start_time, end_time, 0);
+		printf("Depsgraph updated in %f seconds.\n", end_time - start_time);
 	}
 }
 
@@ -0,0 +1,236 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2018 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_multiframe.cc
+ *  \ingroup depsgraph
+ *
+ * Evaluation of object transforms for multiple frames at once.
+ *
+ * Regular evaluation writes results into the original datablocks, so only one
+ * frame can be evaluated at a time. Objects which are only affected by their
+ * own animation and by their parents are evaluated here on shallow copies
+ * instead, which allows to evaluate different frames in parallel.
+ */
+
+#include "intern/eval/deg_eval_multiframe.h"
+
+#include <cstring>
+
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+
+extern "C" {
+#include "DNA_anim_types.h"
+#include "DNA_curve_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_animsys.h"
+#include "BKE_object.h"
+} /* extern "C" */
+
+namespace DEG {
+
+namespace {
+
+/* Only properties of the object itself are written to the evaluated copy,
+ * anything nested (pose, modifiers, custom properties...) is shared with the
+ * original object.
+ */
+bool fcurve_supports_multiframe_eval(const FCurve *fcu)
+{
+	if (fcu->driver != NULL) {
+		return false;
+	}
+	if (fcu->rna_path == NULL) {
+		return true;
+	}
+	return strpbrk(fcu->rna_path, ".[") == NULL;
+}
+
+bool animdata_supports_multiframe_eval(const AnimData *adt)
+{
+	if (adt == NULL) {
+		return true;
+	}
+	/* Drivers depend on other datablocks, and NLA evaluation stores state
+	 * in the strips.
+	 */
+	if (!BLI_listbase_is_empty(&adt->drivers) ||
+	    !BLI_listbase_is_empty(&adt->nla_tracks) ||
+	    !BLI_listbase_is_empty(&adt->overrides) ||
+	    adt->remap != NULL)
+	{
+		return false;
+	}
+	const bAction *act = adt->action;
+	if (act == NULL) {
+		return true;
+	}
+	/* Action evaluation patches the ID root of actions on the first use,
+	 * avoid doing it from multiple threads.
+	 */
+	if (act->idroot != ID_OB) {
+		return false;
+	}
+	for (const FCurve *fcu = (const FCurve *)act->curves.first;
+	     fcu != NULL;
+	     fcu = fcu->next)
+	{
+		if (!fcurve_supports_multiframe_eval(fcu)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool parent_supports_multiframe_eval(const Object *ob)
+{
+	const Object *par = ob->parent;
+	if (ob->partype & PARSLOW) {
+		return false;
+	}
+	switch (ob->partype & PARTYPE) {
+		case PAROBJECT:
+			/* Follow path needs evaluated curve. */
+			if (par->type == OB_CURVE &&
+			    (((const Curve *)par->data)->flag & CU_PATH))
+			{
+				return false;
+			}
+			return true;
+		case PARSKEL:
+			return true;
+		default:
+			/* Vertex and bone parents need evaluated geometry and pose. */
+			return false;
+	}
+}
+
+/* Evaluate transform of the object at the given time into a copy. Parents
+ * are evaluated into copies on the stack, which are only used to calculate
+ * world matrix of the object.
+ */
+void object_eval_transform(Object *ob, const float ctime, Object *r_ob_eval)
+{
+	*r_ob_eval = *ob;
+	if (ob->adt != NULL) {
+		/* Animation system resets tags in the animation data, so give it a
+		 * copy as well.
+		 */
+		AnimData adt_eval = *ob->adt;
+		r_ob_eval->adt = &adt_eval;
+		BKE_animsys_evaluate_animdata(NULL,
+		                              &r_ob_eval->id,
+		                              &adt_eval,
+		                              ctime,
+		                              ADT_RECALC_ANIM);
+		r_ob_eval->adt = ob->adt;
+	}
+	if (ob->parent != NULL) {
+		Object parent_eval;
+		object_eval_transform(ob->parent, ctime, &parent_eval);
+		r_ob_eval->parent = &parent_eval;
+		BKE_object_where_is_calc_mat4(NULL, r_ob_eval, r_ob_eval->obmat);
+		r_ob_eval->parent = ob->parent;
+	}
+	else {
+		BKE_object_to_mat4(r_ob_eval, r_ob_eval->obmat);
+	}
+	if (is_negative_m4(r_ob_eval->obmat)) {
+		r_ob_eval->transflag |= OB_NEG_SCALE;
+	}
+	else {
+		r_ob_eval->transflag &= ~OB_NEG_SCALE;
+	}
+}
+
+struct MultiframeEvalData {
+	Object **objects;
+	int num_objects;
+	const float *ctimes;
+	DEG_MultiframeObjectCb callback;
+	void *userdata;
+};
+
+void multiframe_eval_func(void *__restrict data_v,
+                          const int frame_index,
+                          const ParallelRangeTLS *__restrict /*tls*/)
+{
+	MultiframeEvalData *data = (MultiframeEvalData *)data_v;
+	const float ctime = data->ctimes[frame_index];
+	for (int i = 0; i < data->num_objects; ++i) {
+		Object ob_eval;
+		object_eval_transform(data->objects[i], ctime, &ob_eval);
+		data->callback(data->userdata, frame_index, i, &ob_eval);
+	}
+}
+
+}  // namespace
+
+bool deg_object_supports_multiframe_eval(Object *ob)
+{
+	for (; ob != NULL; ob = ob->parent) {
+		if (ob->proxy_from != NULL ||
+		    ob->rigidbody_object != NULL ||
+		    !BLI_listbase_is_empty(&ob->constraints))
+		{
+			return false;
+		}
+		if (!animdata_supports_multiframe_eval(ob->adt)) {
+			return false;
+		}
+		if (ob->parent != NULL && !parent_supports_multiframe_eval(ob)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void deg_evaluate_objects_multiframe(Object **objects,
+                                     int num_objects,
+                                     const float *ctimes,
+                                     int num_frames,
+                                     DEG_MultiframeObjectCb callback,
+                                     void *userdata)
+{
+	MultiframeEvalData data;
+	data.objects = objects;
+	data.num_objects = num_objects;
+	data.ctimes = ctimes;
+	data.callback = callback;
+	data.userdata = userdata;
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	BLI_task_parallel_range(0,
+	                        num_frames,
+	                        &data,
+	                        multiframe_eval_func,
+	                        &settings);
+}
+
+}  // namespace DEG
@@ -0,0 +1,53 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2018 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_multiframe.h
+ *  \ingroup depsgraph
+ *
+ * Evaluation of object transforms for multiple frames at once.
+ */
+
+#pragma once
+
+#include "DEG_depsgraph.h"
+
+struct Object;
+
+namespace DEG {
+
+/* Check whether object transform only depends on time and on the object and
+ * its parents own data, so it can be evaluated on a copy of the object.
+ */
+bool deg_object_supports_multiframe_eval(struct Object *ob);
+
+/* Evaluate objects for every given time, frames are evaluated in parallel. */
+void deg_evaluate_objects_multiframe(struct Object **objects,
+                                     int num_objects,
+                                     const float *ctimes,
+                                     int num_frames,
+                                     DEG_MultiframeObjectCb callback,
+                                     void *userdata);
+
+}  // namespace DEG
@@ -32,6 +32,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_stack.h"
 
 #include "intern/depsgraph.h"
 
@@ -67,4 +68,65 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
 	}
 }
 
+void deg_eval_stats_update_average(Depsgraph *graph)
+{
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		if (op_node->scheduled && !op_node->is_noop()) {
+			op_node->stats.update_average();
+		}
+	}
+}
+
+/* Time used for operations which were never timed yet, so on the first
+ * evaluation the longest chain of operations is scheduled first.
+ */
+#define DEG_OPERATION_MIN_TIME 1e-6
+
+void deg_eval_stats_update_critical_path(Depsgraph *graph)
+{
+	/* Count dependent operations which are still to be visited, and start
+	 * from the leaves of the graph. Cyclic relations are ignored, the same
+	 * way as the evaluation engine does.
+	 */
+	BLI_Stack *stack = BLI_stack_new(sizeof(OperationDepsNode *),
+	                                 "DEG critical path stack");
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->critical_path_time = 0.0;
+		node->done = 0;
+		foreach (DepsRelation *rel, node->outlinks) {
+			if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0) {
+				++node->done;
+			}
+		}
+		if (node->done == 0) {
+			BLI_stack_push(stack, &node);
+		}
+	}
+	/* Walk the graph in reverse topological order, so all the children of
+	 * an operation are known once it is reached.
+	 */
+	while (!BLI_stack_is_empty(stack)) {
+		OperationDepsNode *node;
+		BLI_stack_pop(stack, &node);
+		if (!node->is_noop()) {
+			node->critical_path_time += MAX2(node->stats.average_time,
+			                                 DEG_OPERATION_MIN_TIME);
+		}
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type != DEG_NODE_TYPE_OPERATION ||
+			    (rel->flag & DEPSREL_FLAG_CYCLIC) != 0)
+			{
+				continue;
+			}
+			OperationDepsNode *from = (OperationDepsNode *)rel->from;
+			from->critical_path_time = MAX2(from->critical_path_time,
+			                                node->critical_path_time);
+			if (--from->done == 0) {
+				BLI_stack_push(stack, &from);
+			}
+		}
+	}
+	BLI_stack_free(stack);
+}
+
 }  // namespace DEG
@@ -37,4 +37,10 @@ struct Depsgraph;
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Accumulate timing of evaluated operations into their average time. */
+void deg_eval_stats_update_average(Depsgraph *graph);
+
+/* Estimate critical path time of every operation from the average timings. */
+void deg_eval_stats_update_critical_path(Depsgraph *graph);
+
 }  // namespace DEG
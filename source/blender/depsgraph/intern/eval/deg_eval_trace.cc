@@ -0,0 +1,85 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2018 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_trace.cc
+ *  \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_trace.h"
+
+#include "BLI_utildefines.h"
+
+#include "atomic_ops.h"
+
+namespace DEG {
+
+EvalTrace::EvalTrace()
+  : events(DEG_EVAL_TRACE_SIZE),
+    num_recorded(0)
+{
+}
+
+void EvalTrace::record(const OperationDepsNode *node,
+                       double start_time,
+                       double end_time,
+                       int thread_id)
+{
+	const uint32_t index =
+	        atomic_fetch_and_add_uint32(&num_recorded, 1) % DEG_EVAL_TRACE_SIZE;
+	EvalTraceEvent& event = events[index];
+	event.node = node;
+	event.start_time = start_time;
+	event.end_time = end_time;
+	event.thread_id = thread_id;
+}
+
+void EvalTrace::clear()
+{
+	num_recorded = 0;
+}
+
+void EvalTrace::get_events(vector<EvalTraceEvent> *r_events) const
+{
+	r_events->clear();
+	if (num_recorded <= DEG_EVAL_TRACE_SIZE) {
+		r_events->insert(r_events->end(),
+		                 events.begin(),
+		                 events.begin() + num_recorded);
+	}
+	else {
+		/* Buffer wrapped around, oldest event is the one to be overwritten
+		 * next.
+		 */
+		const uint32_t oldest = num_recorded % DEG_EVAL_TRACE_SIZE;
+		r_events->insert(r_events->end(),
+		                 events.begin() + oldest,
+		                 events.end());
+		r_events->insert(r_events->end(),
+		                 events.begin(),
+		                 events.begin() + oldest);
+	}
+}
+
+}  // namespace DEG
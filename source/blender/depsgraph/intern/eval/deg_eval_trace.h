@@ -0,0 +1,75 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2018 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_trace.h
+ *  \ingroup depsgraph
+ *
+ * Timeline of evaluated operations, for debugging threading efficiency.
+ */
+
+#pragma once
+
+#include "BLI_sys_types.h"
+
+#include "intern/depsgraph_types.h"
+
+namespace DEG {
+
+struct OperationDepsNode;
+
+/* Number of the most recent operations kept in the trace. */
+#define DEG_EVAL_TRACE_SIZE (1 << 16)
+
+struct EvalTraceEvent {
+	/* Evaluated operation, NULL for the whole graph evaluation. */
+	const OperationDepsNode *node;
+	/* Timestamps as returned by PIL_check_seconds_timer(). */
+	double start_time;
+	double end_time;
+	int thread_id;
+};
+
+/* Ring buffer of evaluation events, filled in from all evaluation threads.
+ * Events refer to operation nodes, so the trace is cleared whenever nodes
+ * are removed from the graph.
+ */
+struct EvalTrace {
+	EvalTrace();
+
+	void record(const OperationDepsNode *node,
+	            double start_time,
+	            double end_time,
+	            int thread_id);
+
+	void clear();
+
+	/* Get recorded events, oldest first. */
+	void get_events(vector<EvalTraceEvent> *r_events) const;
+
+	vector<EvalTraceEvent> events;
+	uint32_t num_recorded;
+};
+
+}  // namespace DEG
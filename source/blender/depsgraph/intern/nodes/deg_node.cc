@@ -69,6 +69,7 @@ DepsNode::Stats::Stats()
 void DepsNode::Stats::reset()
 {
 	current_time = 0.0;
+	average_time = 0.0;
 }
 
 void DepsNode::Stats::reset_current()
@@ -76,6 +77,19 @@ void DepsNode::Stats::reset_current()
 	current_time = 0.0;
 }
 
+void DepsNode::Stats::update_average()
+{
+	if (average_time == 0.0) {
+		average_time = current_time;
+	}
+	else {
+		/* Favor recent evaluations, but don't let a single slow one throw
+		 * scheduling off completely.
+		 */
+		average_time += (current_time - average_time) * 0.25;
+	}
+}
+
 /*******************************************************************************
  * Node itself.
  */
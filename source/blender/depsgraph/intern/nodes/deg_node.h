@@ -66,8 +66,14 @@ struct DepsNode {
 		 * touch averaging accumulators.
 		 */
 		void reset_current();
+		/* Accumulate time of the current graph evaluation into the average. */
+		void update_average();
 		/* Time spend on this node during current graph evaluation. */
 		double current_time;
+		/* Exponential moving average of the time spent on this node, over
+		 * the evaluations it was part of.
+		 */
+		double average_time;
 	};
 	/* Relationships between nodes
 	 * The reason why all depsgraph nodes are descended from this type (apart
@@ -236,8 +236,14 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
 		op_node = (OperationDepsNode *)factory->create_node(this->owner->id, "", name);
 
 		/* register opnode in this component's operation set */
-		OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey, opcode, name, name_tag);
-		BLI_ghash_insert(operations_map, key, op_node);
+		if (operations_map != NULL) {
+			OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey, opcode, name, name_tag);
+			BLI_ghash_insert(operations_map, key, op_node);
+		}
+		else {
+			/* Component was finalized already, in a partial graph rebuild. */
+			operations.push_back(op_node);
+		}
 
 		/* set backlink */
 		op_node->owner = this;
@@ -348,6 +354,12 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	/* Components of IDs which were kept during partial graph rebuild are
+	 * finalized already.
+	 */
+	if (operations_map == NULL) {
+		return;
+	}
 	operations.reserve(BLI_ghash_len(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
@@ -45,6 +45,9 @@ namespace DEG {
 /* Inner Nodes */
 
 OperationDepsNode::OperationDepsNode() :
+    num_links_pending(0),
+    scheduled(false),
+    critical_path_time(0.0),
     flag(0),
     customdata_mask(0)
 {
@@ -78,6 +78,11 @@ struct OperationDepsNode : public DepsNode {
 	uint32_t num_links_pending;
 	bool scheduled;
 
+	/* Estimated time of the longest chain of operations which starts with
+	 * this one, used to schedule operations on the critical path first.
+	 */
+	double critical_path_time;
+
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
 
@@ -68,6 +68,17 @@ static void rna_Depsgraph_debug_stats_gnuplot(Depsgraph *depsgraph,
 	fclose(f);
 }
 
+static void rna_Depsgraph_debug_trace_chrome(Depsgraph *depsgraph,
+                                            const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) {
+		return;
+	}
+	DEG_debug_trace_chrome(depsgraph, f);
+	fclose(f);
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *depsgraph)
 {
 	DEG_graph_tag_relations_update(depsgraph);
@@ -106,6 +117,12 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	                                "File name where gnuplot script will save the result");
 	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 
+	func = RNA_def_function(srna, "debug_trace_chrome", "rna_Depsgraph_debug_trace_chrome");
+	RNA_def_function_ui_description(func, "Save timeline of recent evaluations, recorded with --debug-depsgraph-time");
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store Chrome trace output");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
 	func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
 	func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");